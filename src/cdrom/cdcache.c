@@ -0,0 +1,388 @@
+/****************************************************************************
+*   NeoCDRX
+*   NeoGeo CD Emulator
+*   NeoCD Redux - Copyright (C) 2007 softdev
+****************************************************************************/
+
+/****************************************************************************
+* Decoded SPR / FIX cache
+*
+* Each cached file holds a header, the decoded planar data exactly as it sits
+* in neogeo_spr_memory / neogeo_fix_memory, and the matching usage bytes from
+* video_spr_usage / video_fix_usage.
+*
+* An entry is only trusted when the source file name and size still match,
+* a CRC of a few blocks sampled across the source file matches the one kept
+* in the header, and the payload CRC checks out. The samples cost a few short
+* reads, where reading the whole source would cost as much as a cold load,
+* and unlike a modification time they also work from ISO images.
+*
+* The cache lives in /NeoCDRX/cache on the SD / ODE save device. It is never
+* created here (mkdir is unsafe on GC) - if the folder is missing, the cache
+* is simply disabled.
+****************************************************************************/
+#include <gccore.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <zlib.h>
+#include "neocdrx.h"
+
+#define CDCACHE_MAGIC   0x4e434443	/*** NCDC ***/
+#define CDCACHE_VERSION 3
+#define CDCACHE_ENTRIES 256
+#define CDCACHE_EXT     ".ncc"
+#define CDCACHE_SAMPLES 8		/*** Source blocks checked on a hit ***/
+#define CDCACHE_SAMPLE  2048
+
+/*** Total bytes on device ***/
+#ifndef CDCACHE_MAX
+#define CDCACHE_MAX     (32 * 1024 * 1024)
+#endif
+
+#ifndef CDCACHE_PATH_A
+#define CDCACHE_PATH_A  "/NeoCDRX/cache/"
+#endif
+#define CDCACHE_PATH_B  "sd:/NeoCDRX/cache/"
+
+typedef struct
+{
+  unsigned int magic;
+  unsigned int version;
+  char name[256];
+  unsigned int type;
+  unsigned int offset;
+  unsigned int srclen;
+  unsigned int srccrc;		/*** Of the sampled blocks ***/
+  unsigned int datalen;
+  unsigned int usagelen;
+  unsigned int datacrc;
+} CDCACHEHDR;
+
+CDCACHESTATS cdcache_stats;
+
+static char cachedir[32];
+static int cachedir_checked = 0;
+
+/****************************************************************************
+* cdcache_dir
+*
+* Locate the cache folder once. Returns NULL when caching is unavailable.
+****************************************************************************/
+static char *
+cdcache_dir (void)
+{
+  DIR *d;
+
+  if (SaveDevice != 1)
+    return NULL;
+
+  if (!cachedir_checked)
+    {
+      cachedir_checked = 1;
+      cachedir[0] = 0;
+
+      d = opendir (CDCACHE_PATH_A);
+      if (d)
+	strcpy (cachedir, CDCACHE_PATH_A);
+      else
+	{
+	  d = opendir (CDCACHE_PATH_B);
+	  if (d)
+	    strcpy (cachedir, CDCACHE_PATH_B);
+	}
+
+      if (d)
+	closedir (d);
+    }
+
+  return cachedir[0] ? cachedir : NULL;
+}
+
+/****************************************************************************
+* cdcache_region
+*
+* Work out where the decoded data and usage bytes live for this load.
+* Decoders always work in whole tiles, so lengths are rounded up.
+****************************************************************************/
+static int
+cdcache_region (int type, unsigned int offset, int flen,
+		unsigned char **data, unsigned int *datalen,
+		unsigned char **usage, unsigned int *usagelen)
+{
+  unsigned int len;
+
+  if (type == CDCACHE_SPR)
+    {
+      len = (flen + 127) & ~127;
+      if ((offset & 127) || (offset + len) > 0x400000)
+	return 0;
+
+      *data = neogeo_spr_memory + offset;
+      *usage = video_spr_usage + (offset >> 7);
+      *usagelen = len >> 7;
+    }
+  else
+    {
+      len = (flen + 31) & ~31;
+      if ((offset & 31) || (offset + len) > 0x20000)
+	return 0;
+
+      *data = neogeo_fix_memory + offset;
+      *usage = video_fix_usage + (offset >> 5);
+      *usagelen = len >> 5;
+    }
+
+  *datalen = len;
+  return 1;
+}
+
+/****************************************************************************
+* cdcache_filename
+****************************************************************************/
+static void
+cdcache_filename (char *out, const char *dir, const char *path, int type,
+		  unsigned int offset)
+{
+  unsigned int key;
+
+  key = crc32 (0, (const unsigned char *) path, strlen (path));
+  key = crc32 (key, (const unsigned char *) &offset, sizeof (offset));
+
+  sprintf (out, "%s%08x%c" CDCACHE_EXT, dir, key,
+	   type == CDCACHE_SPR ? 's' : 'f');
+}
+
+/****************************************************************************
+* cdcache_sample
+*
+* CRC of CDCACHE_SAMPLES blocks spread evenly over the source file, the first
+* and last included, or of the whole file when it is smaller than that.
+* The blocks are taken from the end backwards, so no read looks sequential to
+* the read-ahead and each one fetches only a couple of sectors.
+****************************************************************************/
+static int
+cdcache_sample (GENFILE src, int flen, unsigned int *crc)
+{
+  static unsigned char block[CDCACHE_SAMPLE];
+  unsigned int pos, c = 0;
+  int i, n;
+
+  for (i = CDCACHE_SAMPLES - 1; i >= 0; i--)
+    {
+      if (flen > CDCACHE_SAMPLES * CDCACHE_SAMPLE)
+	{
+	  pos = (unsigned int) ((long long) (flen - CDCACHE_SAMPLE) * i
+				/ (CDCACHE_SAMPLES - 1));
+	  n = CDCACHE_SAMPLE;
+	}
+      else
+	{
+	  pos = i * CDCACHE_SAMPLE;
+	  n = flen - (int) pos;
+	  if (n <= 0)
+	    continue;
+	  if (n > CDCACHE_SAMPLE)
+	    n = CDCACHE_SAMPLE;
+	}
+
+      GEN_fseek (src, pos, SEEK_SET);
+      if (GEN_fread ((char *) block, 1, n, src) != (u32) n)
+	return 0;
+
+      c = crc32 (c, block, n);
+    }
+
+  *crc = c;
+  return 1;
+}
+
+/****************************************************************************
+* cdcache_evict
+*
+* Drop the oldest entries until there is room for newbytes. The entry about
+* to be rewritten, keep, is not counted, as its old bytes go with it.
+****************************************************************************/
+static void
+cdcache_evict (const char *dir, const char *keep, unsigned int newbytes)
+{
+  static char names[CDCACHE_ENTRIES][16];
+  static time_t ages[CDCACHE_ENTRIES];
+  static unsigned int sizes[CDCACHE_ENTRIES];
+  char path[64], *base;
+  struct dirent *ent;
+  struct stat st;
+  unsigned int total = 0;
+  int count = 0;
+  int i, oldest;
+  size_t nl;
+  DIR *d;
+
+  d = opendir (dir);
+  if (!d)
+    return;
+
+  strcpy (path, dir);
+  base = path + strlen (path);
+
+  while ((ent = readdir (d)) != NULL && count < CDCACHE_ENTRIES)
+    {
+      nl = strlen (ent->d_name);
+      if (nl >= 16 || nl < 4
+	  || strcasecmp (ent->d_name + nl - 4, CDCACHE_EXT) != 0
+	  || strcasecmp (ent->d_name, keep) == 0)
+	continue;
+
+      strcpy (base, ent->d_name);
+      if (stat (path, &st) != 0)
+	continue;
+
+      strcpy (names[count], ent->d_name);
+      ages[count] = st.st_mtime;
+      sizes[count] = st.st_size;
+      total += st.st_size;
+      count++;
+    }
+  closedir (d);
+
+  while (count && (total + newbytes) > CDCACHE_MAX)
+    {
+      oldest = 0;
+      for (i = 1; i < count; i++)
+	if (ages[i] < ages[oldest])
+	  oldest = i;
+
+      strcpy (base, names[oldest]);
+      remove (path);
+      total -= sizes[oldest];
+
+      count--;
+      strcpy (names[oldest], names[count]);
+      ages[oldest] = ages[count];
+      sizes[oldest] = sizes[count];
+    }
+}
+
+/****************************************************************************
+* cdcache_load
+*
+* Returns 1 if the decoded data and usage bytes were restored from the cache.
+* The source file src is sampled for its CRC, and is rewound when the entry
+* is not used. On a miss the destination may have been partly overwritten -
+* the caller reloads and decodes the whole region anyway.
+****************************************************************************/
+int
+cdcache_load (const char *path, GENFILE src, int type, unsigned int offset,
+	      int flen)
+{
+  CDCACHEHDR hdr;
+  char cname[64];
+  unsigned char *data, *usage;
+  unsigned int datalen, usagelen, crc;
+  char *dir;
+  FILE *fp;
+  int ok = 0;
+
+  dir = cdcache_dir ();
+  if (!dir || strlen (path) >= sizeof (hdr.name))
+    return 0;
+
+  if (!cdcache_region (type, offset, flen, &data, &datalen, &usage, &usagelen))
+    return 0;
+
+  cdcache_filename (cname, dir, path, type, offset);
+  fp = fopen (cname, "rb");
+  if (!fp)
+    return 0;
+
+  if (fread (&hdr, 1, sizeof (hdr), fp) == sizeof (hdr)
+      && hdr.magic == CDCACHE_MAGIC
+      && hdr.version == CDCACHE_VERSION
+      && hdr.type == (unsigned int) type
+      && hdr.offset == offset
+      && hdr.srclen == (unsigned int) flen
+      && hdr.datalen == datalen
+      && hdr.usagelen == usagelen
+      && strncmp (hdr.name, path, sizeof (hdr.name)) == 0
+      && cdcache_sample (src, flen, &crc) && crc == hdr.srccrc)
+    {
+      if (fread (data, 1, datalen, fp) == datalen
+	  && fread (usage, 1, usagelen, fp) == usagelen)
+	{
+	  crc = crc32 (0, data, datalen);
+	  crc = crc32 (crc, usage, usagelen);
+	  ok = (crc == hdr.datacrc);
+	}
+    }
+
+  fclose (fp);
+
+  /*** Stale or damaged - get rid of it ***/
+  if (!ok)
+    {
+      remove (cname);
+      GEN_fseek (src, 0, SEEK_SET);
+    }
+
+  return ok;
+}
+
+/****************************************************************************
+* cdcache_store
+*
+* Called after a cold load, with the decoded data in place and the source
+* file src still open.
+****************************************************************************/
+void
+cdcache_store (const char *path, GENFILE src, int type, unsigned int offset,
+	       int flen)
+{
+  CDCACHEHDR hdr;
+  char cname[64];
+  unsigned char *data, *usage;
+  unsigned int datalen, usagelen, srccrc;
+  char *dir;
+  FILE *fp;
+  int ok;
+
+  dir = cdcache_dir ();
+  if (!dir || strlen (path) >= sizeof (hdr.name))
+    return;
+
+  if (!cdcache_region (type, offset, flen, &data, &datalen, &usage, &usagelen))
+    return;
+
+  if (!cdcache_sample (src, flen, &srccrc))
+    return;
+
+  memset (&hdr, 0, sizeof (hdr));
+  hdr.magic = CDCACHE_MAGIC;
+  hdr.version = CDCACHE_VERSION;
+  strcpy (hdr.name, path);
+  hdr.type = type;
+  hdr.offset = offset;
+  hdr.srclen = flen;
+  hdr.srccrc = srccrc;
+  hdr.datalen = datalen;
+  hdr.usagelen = usagelen;
+  hdr.datacrc = crc32 (crc32 (0, data, datalen), usage, usagelen);
+
+  cdcache_filename (cname, dir, path, type, offset);
+  cdcache_evict (dir, cname + strlen (dir), sizeof (hdr) + datalen + usagelen);
+
+  fp = fopen (cname, "wb");
+  if (!fp)
+    return;
+
+  ok = fwrite (&hdr, 1, sizeof (hdr), fp) == sizeof (hdr)
+    && fwrite (data, 1, datalen, fp) == datalen
+    && fwrite (usage, 1, usagelen, fp) == usagelen;
+
+  fclose (fp);
+
+  /*** Never leave a truncated entry behind ***/
+  if (!ok)
+    remove (cname);
+}
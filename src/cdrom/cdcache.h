@@ -0,0 +1,34 @@
+/****************************************************************************
+*   NeoCDRX
+*   NeoGeo CD Emulator
+*   NeoCD Redux - Copyright (C) 2007 softdev
+****************************************************************************/
+
+/****************************************************************************
+* Decoded SPR / FIX cache
+*
+* Keeps already decoded sprite and fix data on the save device, so reloading
+* the same title skips neogeo_decode_spr / neogeo_decode_fix.
+****************************************************************************/
+#ifndef __CDCACHE__
+#define __CDCACHE__
+
+#define CDCACHE_SPR 0
+#define CDCACHE_FIX 1
+
+typedef struct
+{
+  int hits;
+  int misses;
+  unsigned int cold_ms;		/*** Read + decode, cache miss ***/
+  unsigned int warm_ms;		/*** Streamed from cache ***/
+} CDCACHESTATS;
+
+extern CDCACHESTATS cdcache_stats;
+
+int cdcache_load (const char *path, GENFILE src, int type,
+		  unsigned int offset, int flen);
+void cdcache_store (const char *path, GENFILE src, int type,
+		    unsigned int offset, int flen);
+
+#endif
@@ -17,6 +17,7 @@
 #include "neocdrx.h"
 #include <dirent.h>
 #include <fat.h>
+#include <ogc/lwp_watchdog.h>
 bool ISO9660_Mount(const char *name, DISC_INTERFACE *iface);
 bool ISO9660_Unmount(const char *name);
 
@@ -55,6 +56,7 @@ char iso_dir[1024];
 /*** Globals ***/
 char cdpath[1024];
 int img_display = 0;
+unsigned int cdrom_bytes_moved = 0;
 
 /*** Locals ***/
 static unsigned char cdrom_buffer[BUFFER_SIZE] ATTRIBUTE_ALIGN(32);
@@ -65,6 +67,7 @@ static void cdrom_apply_patch(short *source, int offset, int bank);
 static int sectorstodo = 0;
 
 /*** Debug ***/
+#define LOADDEBUG 0
 static int totalbytes;
 static char cddebug[128];
 int ipl_in_progress = 0;
@@ -273,9 +276,11 @@ static int cdrom_load_prg_file(char *FileName, unsigned int Offset)
   strcpy(Path, cdpath);
   strcat(Path, FileName);
 
+  loadprof_begin(FileName, PRG);
   fp = GEN_fopen(Path, "rb");
   if (!fp)
     {
+      loadprof_end(fp, 0);
       return 0;
     }
 
@@ -289,6 +294,8 @@ static int cdrom_load_prg_file(char *FileName, unsigned int Offset)
     {
       sprintf(cddebug, "PRG : %08x %d", Offset, flen);
       ActionScreen(cddebug);
+      loadprof_end(fp, 0);
+      GEN_fclose(fp);
       return 1;
     }
 
@@ -304,13 +311,16 @@ static int cdrom_load_prg_file(char *FileName, unsigned int Offset)
       Readed = GEN_fread((char *)Ptr, 1, BUFFER_SIZE, fp);
       Ptr += Readed;
       totalbytes += Readed;
+      cdrom_bytes_moved += Readed;
     }
   while (Readed == BUFFER_SIZE);	//Readed==BUFFER_SIZE &&
 
-  cdrom_inc_progress(totalbytes);
-
+  m68k_cache_invalidate(Offset, totalbytes);
+  loadprof_end(fp, totalbytes);
   GEN_fclose(fp);
 
+  cdrom_inc_progress(totalbytes);
+
   if (Offset == 0 && ipl_in_progress)
     memcpy(neogeo_game_vectors, neogeo_prg_memory, 0x100);
 
@@ -329,9 +339,11 @@ static int cdrom_load_z80_file(char *FileName, unsigned int Offset)
   strcpy(Path, cdpath);
   strcat(Path, FileName);
 
+  loadprof_begin(FileName, Z80);
   fp = GEN_fopen(Path, "rb");
   if (!fp)
     {
+      loadprof_end(fp, 0);
       return 0;
     }
 
@@ -345,10 +357,14 @@ static int cdrom_load_z80_file(char *FileName, unsigned int Offset)
     {
       sprintf(cddebug, "Z80 : %08x %d", Offset, flen);
       ActionScreen(cddebug);
+      loadprof_end(fp, 0);
+      GEN_fclose(fp);
       return 1;
     }
 
   totalbytes = GEN_fread((char *)subcpu_memspace + Offset, 1, 0x10000, fp);
+  cdrom_bytes_moved += totalbytes;
+  loadprof_end(fp, totalbytes);
   GEN_fclose(fp);
 
   cdrom_inc_progress(totalbytes);
@@ -371,17 +387,21 @@ static int cdrom_load_fix_file(char *FileName, unsigned int Offset)
 {
   GENFILE fp;
   char Path[256];
-  unsigned char *Ptr, *Src;
+  unsigned char *Ptr;
   int Readed;
   int flen;
   int restore = 0;
+  unsigned int Start = Offset;
+  u64 t0 = gettime(), td;
 
   strcpy(Path, cdpath);
   strcat(Path, FileName);
 
+  loadprof_begin(FileName, FIX);
   fp = GEN_fopen(Path, "rb");
   if (!fp)
     {
+      loadprof_end(fp, 0);
       return 0;
     }
 
@@ -393,6 +413,8 @@ static int cdrom_load_fix_file(char *FileName, unsigned int Offset)
     {
       sprintf(cddebug, "FIX : %08x %d", Offset, flen);
       ActionScreen(cddebug);
+      loadprof_end(fp, 0);
+      GEN_fclose(fp);
       return 1;
     }
 
@@ -400,25 +422,59 @@ static int cdrom_load_fix_file(char *FileName, unsigned int Offset)
     {
       memcpy(neogeo_ipl_memory, neogeo_fix_memory, 0x6000);
       memcpy(neogeo_ipl_memory + 0x6000, video_fix_usage, 0x300);
+      cdrom_bytes_moved += 0x6300;
       restore = 1;
     }
 
   Ptr = neogeo_fix_memory + Offset;
 
+  /*** Already decoded on a previous run? ***/
+  if (cdcache_load(Path, fp, CDCACHE_FIX, Offset, flen))
+    {
+      loadprof_cached();
+      loadprof_end(fp, flen);
+      GEN_fclose(fp);
+
+      /*** The BIOS expects the raw tiles for the loading screen ***/
+      if ((Offset == 0) && restore)
+        {
+          memcpy(neogeo_prg_memory + 0x115E06, Ptr, 0x6000);
+          neogeo_undecode_fix(neogeo_prg_memory, 0x115E06,
+                              min(((flen + 31) & ~31), 0x6000));
+          m68k_cache_invalidate(0x115E06, 0x6000);
+        }
+
+      if (restore)
+        {
+          memcpy(neogeo_fix_memory, neogeo_ipl_memory, 0x6000);
+          memcpy(video_fix_usage, neogeo_ipl_memory + 0x6000, 0x300);
+          cdrom_bytes_moved += 0x6300;
+        }
+
+      video_fix_flush();
+      cdcache_stats.hits++;
+      cdcache_stats.warm_ms += diff_msec(t0, gettime());
+      cdrom_inc_progress(flen);
+      return 1;
+    }
+
+  /*** Read straight into FIX memory and decode in place ***/
   totalbytes = 0;
   do
     {
-      memset(cdrom_buffer, 0, BUFFER_SIZE);
-      Readed = GEN_fread((char *)cdrom_buffer, 1, BUFFER_SIZE, fp);
-      Src = cdrom_buffer;
-      if (Src == NULL) { }
+      Readed = GEN_fread((char *)Ptr, 1, BUFFER_SIZE, fp);
       if (Readed > 0)
         {
-          memcpy(Ptr, cdrom_buffer, Readed);
           if ((Ptr == neogeo_fix_memory) && restore)
-            memcpy(neogeo_prg_memory + 0x115E06, Ptr,
-                   0x6000);
+            {
+              memcpy(neogeo_prg_memory + 0x115E06, Ptr, 0x6000);
+              m68k_cache_invalidate(0x115E06, 0x6000);
+              cdrom_bytes_moved += 0x6000;
+            }
+          td = gettime();
           neogeo_decode_fix(neogeo_fix_memory, Offset, Readed);
+          loadprof_decode(td);
+          cdrom_bytes_moved += Readed;
         }
 
       Ptr += Readed;
@@ -427,15 +483,23 @@ static int cdrom_load_fix_file(char *FileName, unsigned int Offset)
     }
   while (Readed == BUFFER_SIZE);
 
+  loadprof_end(fp, totalbytes);
+
+  /*** Cache before low memory is reinstated ***/
+  cdcache_store(Path, fp, CDCACHE_FIX, Start, totalbytes);
   GEN_fclose(fp);
+  cdcache_stats.misses++;
+  cdcache_stats.cold_ms += diff_msec(t0, gettime());
 
   /*** Reinstate low memory ***/
   if (restore)
     {
       memcpy(neogeo_fix_memory, neogeo_ipl_memory, 0x6000);
       memcpy(video_fix_usage, neogeo_ipl_memory + 0x6000, 0x300);
+      cdrom_bytes_moved += 0x6300;
     }
 
+  video_fix_flush();
   cdrom_inc_progress(totalbytes);
 
   return 1;
@@ -452,13 +516,17 @@ static int cdrom_load_spr_file(char *FileName, unsigned int Offset)
   unsigned char *Ptr;
   int Readed;
   int flen;
+  unsigned int Start = Offset;
+  u64 t0 = gettime(), td;
 
   strcpy(Path, cdpath);
   strcat(Path, FileName);
 
+  loadprof_begin(FileName, SPR);
   fp = GEN_fopen(Path, "rb");
   if (!fp)
     {
+      loadprof_end(fp, 0);
       return 0;
     }
 
@@ -471,19 +539,35 @@ static int cdrom_load_spr_file(char *FileName, unsigned int Offset)
       ActionScreen(Path);
       sprintf(cddebug, "SPR : %08x %d", Offset, flen);
       ActionScreen(cddebug);
+      loadprof_end(fp, 0);
+      GEN_fclose(fp);
+      return 1;
+    }
+
+  /*** Already decoded on a previous run? ***/
+  if (cdcache_load(Path, fp, CDCACHE_SPR, Offset, flen))
+    {
+      loadprof_cached();
+      loadprof_end(fp, flen);
+      GEN_fclose(fp);
+      cdcache_stats.hits++;
+      cdcache_stats.warm_ms += diff_msec(t0, gettime());
+      cdrom_inc_progress(flen);
       return 1;
     }
 
+  /*** Read straight into SPR memory and decode in place ***/
   Ptr = neogeo_spr_memory + Offset;
   totalbytes = 0;
   do
     {
-      memset(cdrom_buffer, 0, BUFFER_SIZE);
-      Readed = GEN_fread((char *)cdrom_buffer, 1, BUFFER_SIZE, fp);
+      Readed = GEN_fread((char *)Ptr, 1, BUFFER_SIZE, fp);
       if (Readed > 0)
         {
-          memcpy(Ptr, cdrom_buffer, Readed);
+          td = gettime();
           neogeo_decode_spr(neogeo_spr_memory, Offset, Readed);
+          loadprof_decode(td);
+          cdrom_bytes_moved += Readed;
           Offset += Readed;
           Ptr += Readed;
           totalbytes += Readed;
@@ -491,7 +575,12 @@ static int cdrom_load_spr_file(char *FileName, unsigned int Offset)
     }
   while (Readed == BUFFER_SIZE);
 
+  loadprof_end(fp, totalbytes);
+  cdcache_store(Path, fp, CDCACHE_SPR, Start, totalbytes);
   GEN_fclose(fp);
+  cdcache_stats.misses++;
+  cdcache_stats.cold_ms += diff_msec(t0, gettime());
+
   cdrom_inc_progress(totalbytes);
 
   return 1;
@@ -515,9 +604,11 @@ static int cdrom_load_pcm_file(char *FileName, unsigned int Offset)
   if (Offset > 0x100000)
     return 1;
 
+  loadprof_begin(FileName, PCM);
   fp = GEN_fopen(Path, "rb");
   if (!fp)
     {
+      loadprof_end(fp, 0);
       return 0;
     }
 
@@ -531,12 +622,16 @@ static int cdrom_load_pcm_file(char *FileName, unsigned int Offset)
     {
       sprintf(cddebug, "PCM : %08x %d", Offset, flen);
       ActionScreen(cddebug);
+      loadprof_end(fp, 0);
+      GEN_fclose(fp);
       return 1;
     }
 
   Ptr = neogeo_pcm_memory + Offset;
   bread = GEN_fread((char *)Ptr, 1, flen, fp);
+  cdrom_bytes_moved += bread;
   totalbytes = bread;
+  loadprof_end(fp, bread);
   GEN_fclose(fp);
 
   cdrom_inc_progress(totalbytes);
@@ -557,17 +652,21 @@ cdrom_load_pat_file(char *FileName, unsigned int Offset, unsigned int Bank)
   strcpy(Path, cdpath);
   strcat(Path, FileName);
 
+  loadprof_begin(FileName, PAT);
   fp = GEN_fopen(Path, "rb");
   if (!fp)
     {
+      loadprof_end(fp, 0);
       return 0;
     }
 
   Readed = GEN_fread((char *)cdrom_buffer, 1, BUFFER_SIZE, fp);
   cdrom_apply_patch((short *) cdrom_buffer, Offset, Bank);
+  cdrom_bytes_moved += Readed;
 
   totalbytes = Readed;
 
+  loadprof_end(fp, Readed);
   GEN_fclose(fp);
   cdrom_inc_progress(totalbytes);
 
@@ -647,6 +746,9 @@ void cdrom_load_files(void)
   char *p;
   int showscreen = 0;
   int address;
+#if LOADDEBUG
+  unsigned int moved = cdrom_bytes_moved;
+#endif
 
   /*** Don't let it go near the CDROM ***/
   m68k_write_memory_8(0x10F6C2, 7);
@@ -678,10 +780,13 @@ void cdrom_load_files(void)
 
       fix_disable = 0;
       video_clear();
-      video_draw_fix();
+      video_draw_load_fix();
       blitter();
     }
 
+  /*** The render thread may still be drawing from SPR/FIX memory ***/
+  video_render_sync();
+
   /*** Decode file to load ***/
   /*** Fix filename ***/
   strcpy(FileName, lfile->fname);
@@ -727,6 +832,12 @@ void cdrom_load_files(void)
       break;
     }
 
+#if LOADDEBUG
+  sprintf(cddebug, "%s : %u bytes moved", FileName,
+          cdrom_bytes_moved - moved);
+  ActionScreen(cddebug);
+#endif
+
 }
 
 /****************************************************************************
@@ -738,6 +849,7 @@ void neogeo_start_upload(void)
 
   if (m68k_read_memory_8(0x10FDDC))
     {
+      video_render_sync();
       neogeo_undecode_fix(neogeo_fix_memory, 0, 0x6000);
     }
 
@@ -767,7 +879,7 @@ void neogeo_progress_show(void)
     {
       fix_disable = 0;
       video_clear();
-      video_draw_fix();
+      video_draw_load_fix();
       blitter();
     }
 }
@@ -777,8 +889,10 @@ void neogeo_progress_show(void)
 ****************************************************************************/
 void neogeo_end_upload(void)
 {
+  loadprof_flush();
+
   video_clear();
-  video_draw_fix();
+  video_draw_load_fix();
   blitter();
 
   m68k_write_memory_32(0x10F68C, 0x00000000);
@@ -826,6 +940,8 @@ void neogeo_upload(void)
       Taille = m68k_read_memory_32(0x10FEFC);
 
       memcpy(Dest, Source, Taille);
+      m68k_cache_invalidate(Dest - neogeo_prg_memory, Taille);
+      cdrom_bytes_moved += Taille;
 
       m68k_write_memory_32(0x10FEF4,
                            m68k_read_memory_32(0x10FEF4) + Taille);
@@ -836,11 +952,11 @@ void neogeo_upload(void)
       Banque = m68k_read_memory_8(0x10FEDB);
       Source = neogeo_prg_memory + m68k_read_memory_32(0x10FEF8);
       Offset = m68k_read_memory_32(0x10FEF4) + (Banque << 20);
-      Dest = neogeo_spr_memory + Offset;
       Taille = m68k_read_memory_32(0x10FEFC);
 
-      memcpy(Dest, Source, Taille);
-      neogeo_decode_spr(neogeo_spr_memory, Offset, Taille);
+      video_render_sync();
+      neogeo_copy_spr(neogeo_spr_memory, Offset, Source, Taille);
+      cdrom_bytes_moved += Taille;
 
       // Mise \E0 jour des valeurs
       Offset = m68k_read_memory_32(0x10FEF4);
@@ -863,11 +979,11 @@ void neogeo_upload(void)
     case 1:			// FIX
       Source = neogeo_prg_memory + m68k_read_memory_32(0x10FEF8);
       Offset = m68k_read_memory_32(0x10FEF4) >> 1;
-      Dest = neogeo_fix_memory + Offset;
       Taille = m68k_read_memory_32(0x10FEFC);
 
-      memcpy( Dest, Source, Taille );
-      neogeo_decode_fix(neogeo_fix_memory, Offset, Taille);
+      video_render_sync();
+      neogeo_copy_fix(neogeo_fix_memory, Offset, Source, Taille);
+      cdrom_bytes_moved += Taille;
 
       Offset = m68k_read_memory_32(0x10FEF4);
       Taille = m68k_read_memory_32(0x10FEFC);
@@ -904,6 +1020,7 @@ void neogeo_upload(void)
       Taille = m68k_read_memory_32(0x10FEFC);
 
       memcpy(Dest, Source, Taille);
+      cdrom_bytes_moved += Taille;
 
       // Mise \E0 jour des valeurs
       Offset = m68k_read_memory_32(0x10FEF4);
@@ -947,6 +1064,7 @@ static void cdrom_load_logo(void)
   if (fp)
     {
       GEN_fread(((char *)neogeo_prg_memory + 0x120000), 1, 0x20000, fp);
+      m68k_cache_invalidate(0x120000, 0x20000);
       GEN_fclose(fp);
     }
 }
@@ -1010,6 +1128,7 @@ void neogeo_ipl(void)
   memset(buf, 26, 2048);
   len = GEN_fread(buf, 1, 2048, fp);
   memcpy(neogeo_prg_memory + 0x111204, buf, len + 2);
+  m68k_cache_invalidate(0x111204, len + 2);
   GEN_fclose(fp);
 
   ipl_in_progress = 1;
@@ -16,6 +16,8 @@
 extern char cdpath[1024];
 extern int img_display;
 extern int ipl_in_progress;
+extern bool iso_mounted;
+extern unsigned int cdrom_bytes_moved;	/*** Bytes written to emulated memory by loads ***/
 
 /*** Prototypes ***/
 int cdrom_process_ipl(void);
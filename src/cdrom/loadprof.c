@@ -0,0 +1,285 @@
+/****************************************************************************
+*   NeoCDRX
+*   NeoGeo CD Emulator
+*   NeoCD Redux - Copyright (C) 2007 softdev
+****************************************************************************/
+
+/****************************************************************************
+* Load profiler
+*
+* Each cdrom_load_*_file call is bracketed by loadprof_begin / loadprof_end.
+* Open and read timings come from the GEN_* layer, decode time is added by
+* the loaders themselves.
+*
+* Records are held in memory while the BIOS is loading and appended to
+* /NeoCDRX/loadstats.csv when the upload ends, so the SD card is not touched
+* in the middle of a load. As with the prefs, the folder is never created.
+*
+* The overlay also carries the decoded SPR / FIX cache totals for the load,
+* which the loaders only add once the file is closed.
+****************************************************************************/
+#include <gccore.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <ogc/lwp_watchdog.h>
+#include "neocdrx.h"
+
+#define LOADPROF_MAX    128
+#define LOADPROF_FRAMES 180	/*** Overlay stays up ~3s after loading ***/
+#define LOADPROF_LINES  4
+
+#define LOADPROF_PATH_A "/NeoCDRX/loadstats.csv"
+#define LOADPROF_PATH_B "sd:/NeoCDRX/loadstats.csv"
+
+extern u8 console_font_8x16[];
+
+int loadprof_frames = 0;
+
+static LOADPROFREC records[LOADPROF_MAX];
+static LOADPROFREC *current = NULL;
+static int count = 0;
+static u64 file_start;
+static unsigned int moved_start;
+
+/*** Running totals for the overlay ***/
+static int session_open = 0;
+static unsigned int session_id;
+static unsigned int session_files;
+static unsigned int session_bytes;
+static unsigned int session_us;
+static char overlay[LOADPROF_LINES][41];
+
+/****************************************************************************
+* loadprof_device
+*
+* Name of the device handler files are coming from.
+****************************************************************************/
+static const char *
+loadprof_device (void)
+{
+  static char device[8];
+  const char *base = "?";
+
+  if (use_SD)
+    base = "SD";
+  else if (use_USB)
+    base = "USB";
+  else if (use_IDE)
+    base = "IDE";
+  else if (use_WKF)
+    base = "WKF";
+  else if (use_DVD)
+    base = "DVD";
+
+  sprintf (device, "%s%s", base, iso_mounted ? "+ISO" : "");
+  return device;
+}
+
+/****************************************************************************
+* loadprof_kbps
+****************************************************************************/
+static unsigned int
+loadprof_kbps (unsigned int bytes, unsigned int us)
+{
+  if (!us)
+    return 0;
+
+  return (unsigned int) (((u64) bytes * 1000000) / us / 1024);
+}
+
+/****************************************************************************
+* loadprof_begin
+*
+* Called before the file is opened.
+****************************************************************************/
+void
+loadprof_begin (const char *name, const char *type)
+{
+  current = NULL;
+  GEN_profile = (LoadStats != LOADSTATS_OFF);
+
+  if (!GEN_profile)
+    return;
+
+  if (count == LOADPROF_MAX)
+    loadprof_flush ();
+
+  if (!session_open)
+    {
+      session_open = 1;
+      session_id = (unsigned int) time (NULL);
+      session_files = session_bytes = session_us = 0;
+      memset (&cdcache_stats, 0, sizeof (CDCACHESTATS));
+      overlay[3][0] = 0;
+    }
+
+  current = &records[count];
+  memset (current, 0, sizeof (LOADPROFREC));
+  strncpy (current->name, name, sizeof (current->name) - 1);
+  strncpy (current->type, type, sizeof (current->type) - 1);
+
+  moved_start = cdrom_bytes_moved;
+  file_start = gettime ();
+}
+
+/****************************************************************************
+* loadprof_decode
+*
+* Add the time since start to the decode total of the current file.
+****************************************************************************/
+void
+loadprof_decode (u64 start)
+{
+  if (current)
+    current->decode_us += diff_usec (start, gettime ());
+}
+
+/****************************************************************************
+* loadprof_cached
+****************************************************************************/
+void
+loadprof_cached (void)
+{
+  if (current)
+    current->cached = 1;
+}
+
+/****************************************************************************
+* loadprof_end
+*
+* Called before the file is closed, while its GEN statistics still exist.
+****************************************************************************/
+void
+loadprof_end (GENFILE fp, int bytes)
+{
+  GENSTATS gs;
+
+  if (!current)
+    return;
+
+  if (GEN_getstats (fp, &gs))
+    {
+      current->open_us = gs.open_us;
+      current->read_us = gs.read_us;
+      current->reads = gs.reads;
+      current->seeks = gs.seeks;
+    }
+
+  current->bytes = bytes;
+  current->moved = cdrom_bytes_moved - moved_start;
+  current->total_us = diff_usec (file_start, gettime ());
+
+  session_files++;
+  session_bytes += current->bytes;
+  session_us += current->total_us;
+
+  snprintf (overlay[0], 41, "LOAD %u files %uKB %u.%02us %s",
+	    session_files, session_bytes >> 10, session_us / 1000000,
+	    (session_us / 10000) % 100, loadprof_device ());
+  snprintf (overlay[1], 41, "%-12s %5uKB %6uKB/s", current->name,
+	    current->bytes >> 10,
+	    loadprof_kbps (current->bytes, current->read_us));
+  snprintf (overlay[2], 41, "open %ums read %ums dec %ums%s",
+	    current->open_us / 1000, current->read_us / 1000,
+	    current->decode_us / 1000, current->cached ? " cache" : "");
+
+  count++;
+  current = NULL;
+}
+
+/****************************************************************************
+* loadprof_flush
+*
+* Append the collected records to the CSV file.
+****************************************************************************/
+void
+loadprof_flush (void)
+{
+  LOADPROFREC *r;
+  FILE *fp = NULL;
+  int i;
+
+  if (!count)
+    return;
+
+  if (SaveDevice == 1)
+    {
+      fp = fopen (LOADPROF_PATH_A, "a");
+      if (!fp)
+	fp = fopen (LOADPROF_PATH_B, "a");
+    }
+
+  if (fp)
+    {
+      if (ftell (fp) == 0)
+	fprintf (fp, "session,name,type,device,bytes,moved,open_us,read_us,"
+		 "decode_us,total_us,reads,seeks,read_kbps,cached\n");
+
+      for (i = 0, r = records; i < count; i++, r++)
+	{
+	  fprintf (fp, "%u,%s,%s,%s,%u,%u,%u,%u,%u,%u,%u,%u,%u,%d\n",
+		   session_id, r->name, r->type, loadprof_device (),
+		   r->bytes, r->moved, r->open_us, r->read_us, r->decode_us,
+		   r->total_us, r->reads, r->seeks,
+		   loadprof_kbps (r->bytes, r->read_us), r->cached);
+	}
+
+      fclose (fp);
+    }
+
+  count = 0;
+  session_open = 0;
+
+  if (LoadStats == LOADSTATS_OVERLAY)
+    loadprof_frames = LOADPROF_FRAMES;
+}
+
+/****************************************************************************
+* loadprof_print
+*
+* 8x16 console font, straight into the 320 pixel wide RGB565 frame.
+****************************************************************************/
+static void
+loadprof_print (unsigned short *buffer, int x, int y, const char *text)
+{
+  unsigned short *p;
+  unsigned char bits;
+  int xx, yy;
+
+  for (; *text && x <= (320 - 8); text++, x += 8)
+    {
+      for (yy = 0; yy < 16; yy++)
+	{
+	  bits = console_font_8x16[((unsigned char) *text << 4) + yy];
+	  p = buffer + ((y + yy) * 320) + x;
+
+	  for (xx = 0; xx < 8; xx++, bits <<= 1)
+	    *p++ = (bits & 0x80) ? 0xffff : 0x0000;
+	}
+    }
+}
+
+/****************************************************************************
+* loadprof_draw
+****************************************************************************/
+void
+loadprof_draw (unsigned short *buffer)
+{
+  int i;
+
+  if (LoadStats != LOADSTATS_OVERLAY)
+    return;
+
+  if (cdcache_stats.hits || cdcache_stats.misses)
+    snprintf (overlay[3], 41, "cache %d hit %ums %d miss %ums",
+	      cdcache_stats.hits, cdcache_stats.warm_ms,
+	      cdcache_stats.misses, cdcache_stats.cold_ms);
+
+  for (i = 0; i < LOADPROF_LINES; i++)
+    {
+      if (overlay[i][0])
+	loadprof_print (buffer, 16, 8 + (i << 4), overlay[i]);
+    }
+}
@@ -0,0 +1,44 @@
+/****************************************************************************
+*   NeoCDRX
+*   NeoGeo CD Emulator
+*   NeoCD Redux - Copyright (C) 2007 softdev
+****************************************************************************/
+
+/****************************************************************************
+* Load profiler
+*
+* Per-file timing for everything cdrom_load_files pulls in, written to a CSV
+* on the save device and optionally drawn over the loading screen.
+****************************************************************************/
+#ifndef __LOADPROF__
+#define __LOADPROF__
+
+#define LOADSTATS_OFF     0
+#define LOADSTATS_CSV     1
+#define LOADSTATS_OVERLAY 2
+
+typedef struct
+{
+  char name[16];
+  char type[4];
+  unsigned int bytes;
+  unsigned int moved;		/*** cdrom_bytes_moved for this file ***/
+  unsigned int open_us;
+  unsigned int read_us;
+  unsigned int decode_us;
+  unsigned int total_us;
+  unsigned int reads;
+  unsigned int seeks;
+  int cached;
+} LOADPROFREC;
+
+extern int loadprof_frames;
+
+void loadprof_begin (const char *name, const char *type);
+void loadprof_decode (u64 start);
+void loadprof_cached (void);
+void loadprof_end (GENFILE fp, int bytes);
+void loadprof_flush (void);
+void loadprof_draw (unsigned short *buffer);
+
+#endif
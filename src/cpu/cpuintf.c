@@ -29,6 +29,11 @@ static int inited = 0;
 static int raster_interrupt_enabled = 0;
 int scanline = 0;
 
+#if Z80_IDLE_STATS
+/*** Frames by idle share, in tenths of the frame ***/
+static unsigned int idle_frames[11];
+#endif
+
 /****************************************************************************
 * Individual Game Configs
 *
@@ -94,6 +99,17 @@ neogeo_configure_game (char *gamename)
   CPU_Z80.boost = CPU_M68K.boost = 0;
 }
 
+/****************************************************************************
+* neogeo_m68k_cycles
+*
+* 68K cycles run so far, including the current timeslice
+****************************************************************************/
+double
+neogeo_m68k_cycles (void)
+{
+  return CPU_M68K.total_cycles + m68k_cycles_run ();
+}
+
 /****************************************************************************
 * neogeo_runframe
 *
@@ -126,6 +142,7 @@ neogeo_runframe (void)
 
 	/*** Clear done cycles ***/
   CPU_Z80.cycles_done = CPU_M68K.cycles_done = 0;
+  z80_idle_cycles = 0;
 
   for (scanline = TIMESLICE - 1; scanline >= 0; scanline--)
     {
@@ -171,6 +188,16 @@ neogeo_runframe (void)
 	}
     }
 
+	/*** Z80 cycles skipped in HALT and wait loops ***/
+  CPU_Z80.cycles_idle = z80_idle_cycles;
+#if Z80_IDLE_STATS
+  if (CPU_Z80.cycles_done > 0)
+    {
+      int share = (int) (10.0 * CPU_Z80.cycles_idle / CPU_Z80.cycles_done);
+      idle_frames[share > 10 ? 10 : share]++;
+    }
+#endif
+
 	/*** Adjust processors ***/
   CPU_Z80.total_time_us = (CPU_Z80.total_cycles * Z80_USEC);
   CPU_M68K.total_time_us = (CPU_M68K.total_cycles * M68K_USEC);
@@ -186,3 +213,24 @@ neogeo_runframe (void)
 	     (CPU_M68K.total_time_us - CPU_Z80.total_time_us));
 
 }
+
+/****************************************************************************
+* neogeo_z80_idle_stats
+*
+* CSV of the frames since the last time by the share of Z80 cycles skipped
+* in HALT and sound driver wait loops, with Z80_IDLE_STATS.
+****************************************************************************/
+void
+neogeo_z80_idle_stats (FILE * fp)
+{
+#if Z80_IDLE_STATS
+  int i;
+
+  fprintf (fp, "idle_percent,frames\n");
+  for (i = 0; i <= 10; i++)
+    {
+      fprintf (fp, "%d,%u\n", i * 10, idle_frames[i]);
+      idle_frames[i] = 0;
+    }
+#endif
+}
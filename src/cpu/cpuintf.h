@@ -12,15 +12,21 @@
 #ifndef __CPUINTF__
 #define __CPUINTF__
 
+#include <stdio.h>
+
 #define Z80_USEC   ((1.0 / 4000000.0))
 #define M68K_USEC ((1.0 / 12000000.0 ))
 
+/*** Write the Z80 idle cycles per frame to z80idle.csv ***/
+#define Z80_IDLE_STATS 0
+
 typedef struct
 {
   int cycles_done;
   int cycles_frame;
   int cycles_scanline;
   int cycles_overrun;
+  int cycles_idle;
   int irq_state;
   double total_cycles;
   double total_time_us;
@@ -36,5 +42,7 @@ typedef struct
 
 void neogeo_runframe (void);
 void neogeo_configure_game (char *gamename);
+double neogeo_m68k_cycles (void);
+void neogeo_z80_idle_stats (FILE * fp);
 
 #endif
@@ -8,15 +8,277 @@
 * Generic File I/O
 *
 * This module attempts to provide a single interface for file I/O.
+*
+* Files opened for reading get a read-ahead window, so small or unaligned
+* reads (MP3 streaming, PAT files, IPL.TXT) turn into large aligned reads on
+* the device handler. Reads at least as big as the window go straight to the
+* caller's buffer. Until reads are seen to be sequential, only a couple of
+* sectors are fetched, so random access does not drag in the whole window.
+* The window size starts at GEN_READAHEAD and is set with GEN_SetReadAhead.
 ****************************************************************************/
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <malloc.h>
 #include <gccore.h>
+#include <ogc/lwp_watchdog.h>
 #include "fileio.h"
 
+#define GEN_MAXSTATS 32
+#define GEN_MAXBUFS  8
+#define GEN_ALIGN    2048	/*** Window start, in bytes ***/
+#define GEN_RANDOM   (GEN_ALIGN * 2)	/*** Window for non-sequential reads ***/
+
+typedef struct
+{
+  u32 handle;
+  int size;			/*** Window size ***/
+  int pos;			/*** Position seen by the caller ***/
+  int devpos;			/*** Position of the device handler ***/
+  int last;			/*** Where the previous read ended ***/
+  int start;			/*** File offset of data[0] ***/
+  int len;			/*** Valid bytes in data ***/
+  u8 *data;
+} GENBUF;
+
 static GENHANDLER genhandler;
 
+static GENBUF genbufs[GEN_MAXBUFS];
+static int genbuf_size = GEN_READAHEAD;
+
+int GEN_profile = 0;
+static GENSTATS genstats[GEN_MAXSTATS];
+
+/****************************************************************************
+* GEN_findstats
+*
+* Statistics slot for an open handle, or a free one when handle is 0.
+****************************************************************************/
+static GENSTATS *
+GEN_findstats (u32 handle)
+{
+  int i;
+
+  for (i = 0; i < GEN_MAXSTATS; i++)
+    {
+      if (genstats[i].handle == handle)
+	return &genstats[i];
+    }
+
+  return NULL;
+}
+
+/****************************************************************************
+* GEN_getstats
+*
+* Copy out the statistics for an open handle. Returns 0 if none were kept.
+****************************************************************************/
+int
+GEN_getstats (u32 fp, GENSTATS * stats)
+{
+  GENSTATS *gs;
+
+  if (!fp || (gs = GEN_findstats (fp)) == NULL)
+    return 0;
+
+  memcpy (stats, gs, sizeof (GENSTATS));
+  return 1;
+}
+
+/****************************************************************************
+* GEN_SetReadAhead
+*
+* Window size for files opened from now on. 0 turns read-ahead off.
+****************************************************************************/
+void
+GEN_SetReadAhead (int size)
+{
+  if (size < 0)
+    size = 0;
+
+  genbuf_size = (size + GEN_ALIGN - 1) & ~(GEN_ALIGN - 1);
+}
+
+/****************************************************************************
+* GEN_findbuf
+****************************************************************************/
+static GENBUF *
+GEN_findbuf (u32 handle)
+{
+  int i;
+
+  if (!handle)
+    return NULL;
+
+  for (i = 0; i < GEN_MAXBUFS; i++)
+    {
+      if (genbufs[i].handle == handle)
+	return &genbufs[i];
+    }
+
+  return NULL;
+}
+
+/****************************************************************************
+* GEN_allocbuf
+*
+* Attach a read-ahead window to a newly opened handle. Without a free slot or
+* memory the file is simply unbuffered.
+****************************************************************************/
+static void
+GEN_allocbuf (u32 handle, const char *mode)
+{
+  GENBUF *gb = NULL;
+  int i;
+
+  if (!genbuf_size || strpbrk (mode, "wa+"))
+    return;
+
+  for (i = 0; i < GEN_MAXBUFS; i++)
+    {
+      if (genbufs[i].handle == 0)
+	{
+	  gb = &genbufs[i];
+	  break;
+	}
+    }
+
+  if (!gb)
+    return;
+
+  if (gb->data && gb->size != genbuf_size)
+    {
+      free (gb->data);
+      gb->data = NULL;
+    }
+
+  if (!gb->data)
+    {
+      gb->data = memalign (32, genbuf_size);
+      if (!gb->data)
+	return;
+    }
+
+  gb->handle = handle;
+  gb->size = genbuf_size;
+  gb->pos = gb->devpos = gb->last = 0;
+  gb->start = gb->len = 0;
+}
+
+/****************************************************************************
+* GEN_devread
+*
+* Read from the device handler at a given file offset.
+****************************************************************************/
+static int
+GEN_devread (GENBUF * gb, char *buffer, int offset, int length)
+{
+  int done;
+
+  if (gb->devpos != offset)
+    {
+      if (genhandler.gen_fseek)
+	(genhandler.gen_fseek) (gb->handle, offset, SEEK_SET);
+      gb->devpos = offset;
+    }
+
+  done = (int) (genhandler.gen_fread) (buffer, 1, length, gb->handle);
+  if (done < 0)
+    done = 0;
+
+  gb->devpos += done;
+  return done;
+}
+
+/****************************************************************************
+* GEN_bufread
+****************************************************************************/
+static u32
+GEN_bufread (GENBUF * gb, char *buffer, int length)
+{
+  int sequential = (gb->pos == gb->last);
+  int done = 0;
+  int n, window;
+
+  while (length > 0)
+    {
+      /*** Whatever is already in the window ***/
+      if (gb->pos >= gb->start && gb->pos < gb->start + gb->len)
+	{
+	  n = gb->start + gb->len - gb->pos;
+	  if (n > length)
+	    n = length;
+
+	  memcpy (buffer, gb->data + (gb->pos - gb->start), n);
+	  buffer += n;
+	  gb->pos += n;
+	  done += n;
+	  length -= n;
+	  continue;
+	}
+
+      /*** Big reads bypass the window ***/
+      if (length >= gb->size)
+	{
+	  n = GEN_devread (gb, buffer, gb->pos, length);
+	  gb->pos += n;
+	  done += n;
+	  break;
+	}
+
+      /*** Refill from an aligned offset ***/
+      gb->start = gb->pos & ~(GEN_ALIGN - 1);
+
+      if (sequential)
+	window = gb->size;
+      else
+	{
+	  window = (gb->pos - gb->start + length + GEN_ALIGN - 1)
+	    & ~(GEN_ALIGN - 1);
+	  if (window < GEN_RANDOM)
+	    window = GEN_RANDOM;
+	  if (window > gb->size)
+	    window = gb->size;
+	}
+
+      gb->len = GEN_devread (gb, (char *) gb->data, gb->start, window);
+
+      /*** End of file ***/
+      if (gb->pos >= gb->start + gb->len)
+	break;
+    }
+
+  gb->last = gb->pos;
+  return done;
+}
+
+/****************************************************************************
+* GEN_read
+****************************************************************************/
+static u32
+GEN_read (char *buffer, int block, int length, u32 fp)
+{
+  GENBUF *gb = GEN_findbuf (fp);
+  u32 ret;
+
+  if (!gb)
+    return (genhandler.gen_fread) (buffer, block, length, fp);
+
+  if (block == 1)
+    return GEN_bufread (gb, buffer, length);
+
+  /*** Handlers differ on what they return here, so pass it through ***/
+  if (gb->devpos != gb->pos && genhandler.gen_fseek)
+    (genhandler.gen_fseek) (fp, gb->pos, SEEK_SET);
+
+  ret = (genhandler.gen_fread) (buffer, block, length, fp);
+
+  gb->pos = gb->devpos = gb->last =
+    genhandler.gen_ftell ? (genhandler.gen_ftell) (fp) : 0;
+
+  return ret;
+}
+
 /****************************************************************************
 * GEN_SetHandler
 *
@@ -36,24 +298,57 @@ GEN_SetHandler (GENHANDLER * g)
 u32
 GEN_fopen (const char *filename, const char *mode)
 {
+  GENSTATS *gs;
+  u64 start;
+  u32 fp;
+
   if (genhandler.gen_fopen == NULL)
     return 0;			/*** NULL - no file or handler ***/
 
-  return (genhandler.gen_fopen) (filename, mode);
+  start = GEN_profile ? gettime () : 0;
+  fp = (genhandler.gen_fopen) (filename, mode);
+
+  if (!fp)
+    return 0;
+
+  if (GEN_profile && (gs = GEN_findstats (0)) != NULL)
+    {
+      memset (gs, 0, sizeof (GENSTATS));
+      gs->handle = fp;
+      gs->open_us = diff_usec (start, gettime ());
+    }
+
+  GEN_allocbuf (fp, mode);
+
+  return fp;
 }
 
 /****************************************************************************
 * GEN_fread
 *
-* Passthrough fread
+* Buffered fread
 ****************************************************************************/
 u32
 GEN_fread (char *buffer, int block, int length, u32 fp)
 {
+  GENSTATS *gs;
+  u64 start;
+  u32 ret;
+
   if (genhandler.gen_fread == NULL)
     return 0;
 
-  return (genhandler.gen_fread) (buffer, block, length, fp);
+  if (!GEN_profile || (gs = GEN_findstats (fp)) == NULL)
+    return GEN_read (buffer, block, length, fp);
+
+  start = gettime ();
+  ret = GEN_read (buffer, block, length, fp);
+
+  gs->read_us += diff_usec (start, gettime ());
+  gs->bytes += ret;
+  gs->reads++;
+
+  return ret;
 }
 
 /****************************************************************************
@@ -78,24 +373,58 @@ GEN_fwrite (char *buffer, int block, int length, u32 fp)
 int
 GEN_fclose (u32 fp)
 {
+  GENSTATS *gs;
+  GENBUF *gb;
+
   if (genhandler.gen_fclose == NULL)
     return 0;
 
+  if (fp && (gs = GEN_findstats (fp)) != NULL)
+    gs->handle = 0;
+
+  /*** The window memory is kept for the next file ***/
+  if ((gb = GEN_findbuf (fp)) != NULL)
+    gb->handle = 0;
+
   return (genhandler.gen_fclose) (fp);
 }
 
 /****************************************************************************
 * GEN_fseek
 *
-* Passthrough fseek
+* The device handler always seeks, so each keeps its own return convention.
+* The window stays valid - it is tied to file offsets, not to the handle.
 ****************************************************************************/
 int
 GEN_fseek (u32 fp, int where, int whence)
 {
+  GENSTATS *gs;
+  GENBUF *gb;
+  int ret;
+
   if (genhandler.gen_fseek == NULL)
     return 0;
 
-  return (genhandler.gen_fseek) (fp, where, whence);
+  if (GEN_profile && (gs = GEN_findstats (fp)) != NULL)
+    gs->seeks++;
+
+  gb = GEN_findbuf (fp);
+  if (!gb)
+    return (genhandler.gen_fseek) (fp, where, whence);
+
+  /*** The device is ahead of the caller by the read-ahead ***/
+  if (whence == SEEK_CUR)
+    {
+      where += gb->pos;
+      whence = SEEK_SET;
+    }
+
+  ret = (genhandler.gen_fseek) (fp, where, whence);
+
+  gb->pos = gb->devpos =
+    genhandler.gen_ftell ? (genhandler.gen_ftell) (fp) : where;
+
+  return ret;
 }
 
 /****************************************************************************
@@ -106,6 +435,11 @@ GEN_fseek (u32 fp, int where, int whence)
 int
 GEN_ftell (u32 fp)
 {
+  GENBUF *gb;
+
+  if ((gb = GEN_findbuf (fp)) != NULL)
+    return gb->pos;
+
   if (genhandler.gen_ftell == NULL)
     return -1;
 
@@ -118,6 +452,13 @@ GEN_ftell (u32 fp)
 void
 GEN_fcloseall (void)
 {
+  int i;
+
+  memset (genstats, 0, sizeof (genstats));
+
+  for (i = 0; i < GEN_MAXBUFS; i++)
+    genbufs[i].handle = 0;
+
   if (genhandler.gen_fcloseall == NULL)
     return;
 
@@ -15,6 +15,11 @@
 #define GEN_MODE_READ 1
 #define GEN_MODE_WRITE 2
 
+/*** Default read-ahead window per open file, see GEN_SetReadAhead ***/
+#ifndef GEN_READAHEAD
+#define GEN_READAHEAD 65536
+#endif
+
 typedef struct
   {
     u32 handle;
@@ -41,6 +46,20 @@ GENHANDLER;
 
 typedef u32 GENFILE;
 
+/*** Per-handle I/O statistics, gathered while GEN_profile is set ***/
+typedef struct
+  {
+    u32 handle;
+    u32 open_us;
+    u32 read_us;
+    u32 bytes;
+    u32 reads;
+    u32 seeks;
+  }
+GENSTATS;
+
+extern int GEN_profile;
+
 extern u32 GEN_fopen (const char *filename, const char *mode);
 extern u32 GEN_fread (char *buffer, int block, int length, u32 fp);
 extern u32 GEN_fwrite (char *buffer, int block, int length, u32 fp);
@@ -52,5 +71,7 @@ extern void GEN_mount ( void );
 extern void GEN_fcloseall (void);
 
 extern void GEN_SetHandler (GENHANDLER * g);
+extern void GEN_SetReadAhead (int size);
+extern int GEN_getstats (u32 fp, GENSTATS * stats);
 
 #endif
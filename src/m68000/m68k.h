@@ -324,6 +324,113 @@ unsigned int m68k_get_reg(void* context, m68k_register_t reg);
 /* Poke values into the internals of the currently running CPU context */
 void m68k_set_reg(m68k_register_t reg, unsigned int value);
 
+/* Block cache (M68K_BLOCK_CACHE in m68kconf.h).
+ * Cached memory is tracked in pages of 1 << M68K_CACHE_PAGE_SHIFT bytes.
+ * m68k_cache_write() is the cheap check for the host's memory handlers, call
+ * it for every CPU write to cached memory.  Anything the host itself copies
+ * or loads into cached memory must be passed to m68k_cache_invalidate().
+ * m68k_cache_flush() throws away every block.
+ * m68k_cache_enable() switches between the cache and the plain interpreter
+ * at runtime.
+ */
+#define M68K_CACHE_PAGE_SHIFT 10
+
+#if M68K_BLOCK_CACHE && (M68K_EMULATE_PREFETCH || M68K_EMULATE_TRACE || \
+                         M68K_INSTRUCTION_HOOK || M68K_EMULATE_ADDRESS_ERROR)
+#undef M68K_BLOCK_CACHE
+#define M68K_BLOCK_CACHE OPT_OFF
+#endif
+
+#if M68K_DEAD_FLAGS && !M68K_BLOCK_CACHE
+#undef M68K_DEAD_FLAGS
+#define M68K_DEAD_FLAGS OPT_OFF
+#endif
+
+#if M68K_BLOCK_CACHE
+extern unsigned char m68k_cache_pages[];
+void m68k_cache_invalidate(unsigned int address, unsigned int length);
+void m68k_cache_flush(void);
+void m68k_cache_enable(int enable);
+
+#define m68k_cache_write(A, L) \
+	do { \
+		if(m68k_cache_pages[((A) & 0xffffff) >> M68K_CACHE_PAGE_SHIFT] | \
+		   m68k_cache_pages[(((A) & 0xffffff) + (L) - 1) >> M68K_CACHE_PAGE_SHIFT]) \
+			m68k_cache_invalidate(A, L); \
+	} while(0)
+#else
+#define m68k_cache_invalidate(A, L)
+#define m68k_cache_flush()
+#define m68k_cache_enable(E)
+#define m68k_cache_write(A, L)
+#endif /* M68K_BLOCK_CACHE */
+
+/* Recompiler (M68K_DRC in m68kconf.h).
+ * m68k_drc_enable() runs code through the recompiler instead of the block
+ * cache or the interpreter, and back.  It shares the cache's page tracking,
+ * so the same rules apply to writes, and m68k_cache_flush() throws away the
+ * recompiled blocks too.
+ * m68k_drc_map() lets the generated code read, and if writable also write,
+ * the 68000 addresses address..address+size-1 straight from host memory.
+ * Both must be multiples of 64KB, the memory in 68000 byte order, and every
+ * write must still go to m68k_cache_write().
+ * M68K_DRC_EMULATED builds leave running the code to the host:
+ * m68k_drc_host() gives the address the emulated PowerPC sees host memory
+ * at, and m68k_drc_run() calls the entry code with the block in r3.
+ */
+#if M68K_DRC && (!M68K_BLOCK_CACHE || !(defined(__PPC__) || M68K_DRC_EMULATED))
+#undef M68K_DRC
+#define M68K_DRC OPT_OFF
+#endif
+
+#if M68K_DRC
+void m68k_drc_enable(int enable);
+void m68k_drc_map(unsigned int address, unsigned int size, void* host, int writable);
+#if M68K_DRC_EMULATED
+unsigned int m68k_drc_host(const void* host);
+void m68k_drc_run(unsigned int entry, unsigned int code);
+#endif /* M68K_DRC_EMULATED */
+#else
+#define m68k_drc_enable(E)
+#define m68k_drc_map(A, S, H, W)
+#endif /* M68K_DRC */
+
+/* Fast RAM reads (M68K_FAST_RAM in m68kconf.h).
+ * m68k_fast_ram_stats() writes the hit and miss counts of each opcode
+ * handler to a file as CSV, busiest first, and clears them.
+ */
+#if M68K_FAST_RAM && (M68K_EMULATE_ADDRESS_ERROR || M68K_SEPARATE_READS || \
+                      M68K_EMULATE_FC)
+#undef M68K_FAST_RAM
+#define M68K_FAST_RAM OPT_OFF
+#endif
+
+#if M68K_FAST_RAM_STATS && !M68K_FAST_RAM
+#undef M68K_FAST_RAM_STATS
+#define M68K_FAST_RAM_STATS OPT_OFF
+#endif
+
+#if M68K_FAST_RAM_STATS
+#include <stdio.h>
+void m68k_fast_ram_stats(FILE* file);
+#endif /* M68K_FAST_RAM_STATS */
+
+/* Profiler (M68K_PROFILE in m68kconf.h).
+ * m68k_profile_write() writes the opcode counts and the PC histogram in the
+ * folded stack format read by flamegraph.pl and speedscope: one
+ * "op;<handler>;<opcode> <count>" line per opcode that ran, and one
+ * "pc;<64KB region>;<256 byte region> <count>" line per region instructions
+ * started in.  m68k_profile_handlers() writes the counts by handler as CSV,
+ * busiest first, which m68kmake takes as a dispatch profile (see the
+ * Makefile).  Neither clears the counts, m68k_profile_reset() does.
+ */
+#if M68K_PROFILE
+#include <stdio.h>
+void m68k_profile_write(FILE* file);
+void m68k_profile_handlers(FILE* file);
+void m68k_profile_reset(void);
+#endif /* M68K_PROFILE */
+
 /* Check if an instruction is valid for the specified CPU type */
 unsigned int m68k_is_valid_instruction(unsigned int instruction, unsigned int cpu_type);
 
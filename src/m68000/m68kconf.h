@@ -138,6 +138,95 @@
 #define M68K_EMULATE_ADDRESS_ERROR  OPT_OFF
 
 
+/* If ON, straight-line code is recorded into blocks the first time it runs
+ * and replayed from the block cache afterwards, skipping the opcode and
+ * extension word fetches and the jump table lookup.  Only addresses for
+ * which M68K_BLOCK_CACHE_RANGE is true are cached (NeoCD: PRG RAM and the
+ * BIOS), and the host must report writes to them with m68k_cache_write()
+ * or m68k_cache_invalidate() (see m68k.h).
+ * Turned off automatically with prefetch, trace, address error or the
+ * instruction hook, as those need to see every fetch.
+ */
+#ifndef M68K_BLOCK_CACHE
+#define M68K_BLOCK_CACHE            OPT_ON
+#endif /* M68K_BLOCK_CACHE */
+#define M68K_BLOCK_CACHE_RANGE(A)   ((A) < 0x200000 || ((A) >= 0xc00000 && (A) < 0xc80000))
+
+/* If ON, m68kmake also generates a copy of each handler that doesn't compute
+ * N, Z, V and C, and cached blocks use it when the next instruction in the
+ * block sets all four without looking at them.  The dropped flags can only be
+ * seen stale in between the two instructions: by the host between two calls
+ * to m68k_execute(), or in the SR stacked by an interrupt taken there, which
+ * is overwritten as soon as the ISR returns into the second one.
+ * Needs M68K_BLOCK_CACHE.
+ */
+#ifndef M68K_DEAD_FLAGS
+#define M68K_DEAD_FLAGS             OPT_ON
+#endif /* M68K_DEAD_FLAGS */
+
+/* If ON, blocks of cached code can also be recompiled to PowerPC code (see
+ * m68kdrc.c), selected at runtime with m68k_drc_enable().  The 68000
+ * registers live in host registers, flags are only computed where a later
+ * instruction may read them, blocks jump straight into each other, and
+ * memory mapped with m68k_drc_map() (NeoCD: PRG RAM and the BIOS) is read
+ * and written without calling the host.  Instructions it doesn't translate,
+ * the NeoCD BIOS calls among them, run through their handler.
+ * Needs M68K_BLOCK_CACHE, for its page tracking, and a PowerPC host.
+ * M68K_DRC_EMULATED builds it anywhere, for a host that runs the generated
+ * code on a PowerPC emulator (tests/m68k_drc.c).
+ */
+#ifndef M68K_DRC
+#define M68K_DRC                    OPT_ON
+#endif /* M68K_DRC */
+#ifndef M68K_DRC_EMULATED
+#define M68K_DRC_EMULATED           OPT_OFF
+#endif /* M68K_DRC_EMULATED */
+
+
+/* If ON, operands read through the absolute and PC relative addressing modes
+ * come straight from M68K_FAST_RAM_BASE when the address is below
+ * M68K_FAST_RAM_SIZE, and from m68k_read_memory_xx() otherwise.  Words and
+ * longs are read natively, so the host must keep that RAM the way its own
+ * handler reads it (NeoCD: PRG RAM, stored in 68000 byte order).
+ * M68K_FAST_RAM_SWAP byte swaps them after the read, for a little-endian
+ * host that keeps the RAM in 68000 byte order all the same (the host tests).
+ * M68K_FAST_RAM_STATS counts hits and misses for each opcode handler, for
+ * m68k_fast_ram_stats() (see m68k.h).
+ * Turned off automatically with address error, separate reads or function
+ * codes, as those need to see every read.
+ */
+#ifndef M68K_FAST_RAM
+#define M68K_FAST_RAM               OPT_ON
+#endif /* M68K_FAST_RAM */
+#ifndef M68K_FAST_RAM_SWAP
+#define M68K_FAST_RAM_SWAP          OPT_OFF
+#endif /* M68K_FAST_RAM_SWAP */
+#define M68K_FAST_RAM_BASE          neogeo_prg_memory
+#define M68K_FAST_RAM_SIZE          0x200000
+#define M68K_FAST_RAM_STATS         OPT_OFF
+
+
+/* If ON, opcodes are dispatched through a two level table: pages of 64 opcodes,
+ * with identical pages shared, holding 16 bit indexes into an array of
+ * handler and cycle pairs.  That is around 50KB against the 448KB of the
+ * flat jump and cycle tables, which matters with a 32KB data cache.
+ * Handlers named in the profile given to m68kmake (see the Makefile) get
+ * the first, adjacent entries.
+ */
+#define M68K_COMPACT_DISPATCH       OPT_ON
+
+
+/* If ON, the CPU counts how often each opcode runs and how many instructions
+ * start in each 256 byte region of the address space, cached blocks
+ * included, for m68k_profile_write() and m68k_profile_handlers() (see
+ * m68k.h).  Costs two increments per instruction and 512KB of counters, so
+ * it is meant for profiling builds only.
+ */
+#ifndef M68K_PROFILE
+#define M68K_PROFILE                OPT_OFF
+#endif /* M68K_PROFILE */
+
+
 /* Turn ON to enable logging of illegal instruction calls.
  * M68K_LOG_FILEHANDLE must be #defined to a stdio file stream.
  * Turn on M68K_LOG_1010_1111 to log all 1010 and 1111 calls.
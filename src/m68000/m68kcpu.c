@@ -32,6 +32,8 @@ static const char* copyright_notice =
 /* ================================ INCLUDES ============================== */
 /* ======================================================================== */
 
+#include <stdlib.h>
+#include <string.h>
 #include "m68kops.h"
 #include "m68kcpu.h"
 
@@ -70,6 +72,127 @@ uint    m68ki_aerr_address;
 uint    m68ki_aerr_write_mode;
 uint    m68ki_aerr_fc;
 
+#if M68K_BLOCK_CACHE
+/* Block cache.
+ * A block is recorded while its instructions run through the interpreter
+ * and is replayed from then on.  Each instruction keeps its handler, opcode,
+ * base cycles, the PC it left behind and the extension words that follow it.
+ * During replay m68ki_read_imm_16/32 take the extension words from the block.
+ * Replay leaves the block as soon as the PC differs from the recorded one, so
+ * taken branches, exceptions and interrupts need no special handling.
+ *
+ * A block never starts an instruction outside the page it began in, and is
+ * valid while the generation of that page (and of the next one, if the last
+ * instruction may run into it) is unchanged.  Writes to a page holding code
+ * bump its generation.
+ */
+#define BC_PAGES    ((0x1000000 >> M68K_CACHE_PAGE_SHIFT) + 1)
+#define BC_PAGE(A)  (ADDRESS_68K(A) >> M68K_CACHE_PAGE_SHIFT)
+#define BC_HASH     4096		/* Direct mapped on the block's PC */
+#define BC_BLOCKS   2048
+#define BC_OPS      8192
+#define BC_MAX_OPS  64
+#define BC_EXT      4			/* Longest 68000 instruction is 5 words */
+
+typedef struct
+{
+	void (*handler)(void);
+	uint16 ir;
+	uint16 cycles;
+	uint next;					/* PC after the instruction */
+	uint16 ext[BC_EXT];
+} m68ki_bc_op;
+
+typedef struct m68ki_bc_block
+{
+	uint pc;
+	uint page;
+	uint gen;
+	uint span;					/* Also depends on page + 1 */
+	uint span_gen;
+	uint count;
+	m68ki_bc_op* op;
+	struct m68ki_bc_block* link[2];	/* Blocks last seen to follow this one */
+} m68ki_bc_block;
+
+unsigned char m68k_cache_pages[BC_PAGES];	/* Page holds cached code */
+uint16* m68ki_bc_ext = NULL;
+
+uint m68ki_bc_gen[BC_PAGES];
+static m68ki_bc_block* m68ki_bc_hash[BC_HASH];
+static m68ki_bc_block m68ki_bc_blocks[BC_BLOCKS];
+static m68ki_bc_op m68ki_bc_ops[BC_OPS];
+static uint m68ki_bc_num_blocks = 0;
+static uint m68ki_bc_num_ops = 0;
+uint m68ki_bc_stop = 0;	/* Set when code was invalidated */
+static uint m68ki_bc_enabled = 1;
+#endif /* M68K_BLOCK_CACHE */
+
+#if M68K_DEAD_FLAGS
+/* m68ki_flag_handler_table sorted by handler, for m68ki_bc_flag_info() */
+#define BC_FLAGS    2048
+static const m68ki_flag_handler_struct* m68ki_bc_flags[BC_FLAGS];
+static uint m68ki_bc_num_flags = 0;
+#endif /* M68K_DEAD_FLAGS */
+
+#if M68K_COMPACT_DISPATCH
+/* Two level dispatch (see m68kconf.h).
+ * m68ki_dispatch_page gives where each page of 64 opcodes starts in
+ * m68ki_dispatch_index, and pages with the same contents share the same
+ * entries.  The index picks a handler and its base cycles for the current
+ * CPU type.  The tables are built from the flat ones whenever the CPU type
+ * changes.
+ */
+#define DISPATCH_PAGE_SHIFT 6
+#define DISPATCH_PAGE_SIZE  (1 << DISPATCH_PAGE_SHIFT)
+#define DISPATCH_PAGES      (0x10000 >> DISPATCH_PAGE_SHIFT)
+#define DISPATCH_HANDLERS   4096		/* About 2100 for the 68000 */
+#define DISPATCH_HASH       8192
+
+typedef struct
+{
+	void (*handler)(void);
+	uint cycles;
+} m68ki_dispatch_entry;
+
+static m68ki_dispatch_entry m68ki_dispatch_handlers[DISPATCH_HANDLERS];
+static uint16 m68ki_dispatch_page[DISPATCH_PAGES];
+static uint16 m68ki_dispatch_index[0x10000];
+static uint m68ki_dispatch_num_handlers = 0;
+static uint m68ki_dispatch_cpu = 0;	/* CPU type the tables were built for */
+
+static void m68ki_build_dispatch(void);
+
+#define m68ki_dispatch(IR) (&m68ki_dispatch_handlers[m68ki_dispatch_index[ \
+	m68ki_dispatch_page[(IR) >> DISPATCH_PAGE_SHIFT] + ((IR) & (DISPATCH_PAGE_SIZE - 1))]])
+
+/* Call the handler for REG_IR and take its base cycles */
+#define m68ki_execute_ir() \
+	do { \
+		const m68ki_dispatch_entry* entry_ = m68ki_dispatch(REG_IR); \
+		entry_->handler(); \
+		USE_CYCLES(entry_->cycles); \
+	} while(0)
+#else
+#define m68ki_execute_ir() \
+	do { \
+		m68ki_instruction_jump_table[REG_IR](); \
+		USE_CYCLES(CYC_INSTRUCTION[REG_IR]); \
+	} while(0)
+#endif /* M68K_COMPACT_DISPATCH */
+
+#if M68K_PROFILE
+/* Instructions run, by opcode and by 256 byte region of the address space */
+uint m68ki_profile_ops[0x10000];
+uint m68ki_profile_pc[0x10000];
+#endif /* M68K_PROFILE */
+
+#if M68K_FAST_RAM_STATS
+/* Fast RAM reads by opcode */
+uint m68ki_fast_ram_hits[0x10000];
+uint m68ki_fast_ram_misses[0x10000];
+#endif /* M68K_FAST_RAM_STATS */
+
 /* Used by shift & rotate instructions */
 uint8 m68ki_shift_8_table[65] =
 {
@@ -629,6 +752,478 @@ void m68k_set_cpu_type(unsigned int cpu_type)
 	}
 }
 
+#if M68K_BLOCK_CACHE
+
+/* Throw away every block */
+void m68k_cache_flush(void)
+{
+	uint i;
+
+	for(i = 0; i < BC_HASH; i++)
+		m68ki_bc_hash[i] = NULL;
+
+	m68ki_bc_num_blocks = 0;
+	m68ki_bc_num_ops = 0;
+	m68ki_bc_stop = 1;
+	m68ki_bc_ext = NULL;
+#if M68K_DRC
+	m68ki_drc_flush();
+#endif /* M68K_DRC */
+}
+
+/* Switch between the block cache and the plain interpreter */
+void m68k_cache_enable(int enable)
+{
+	m68k_cache_flush();
+	m68ki_bc_enabled = enable != 0;
+}
+
+/* Invalidate the blocks in every page touched by address..address+length-1 */
+void m68k_cache_invalidate(unsigned int address, unsigned int length)
+{
+	uint page;
+	uint last;
+
+	if(!length)
+		return;
+
+	address &= 0xffffff;
+	page = address >> M68K_CACHE_PAGE_SHIFT;
+	last = (address + length - 1) >> M68K_CACHE_PAGE_SHIFT;
+	if(last >= BC_PAGES)
+		last = BC_PAGES - 1;
+
+	for(; page <= last; page++)
+	{
+		if(m68k_cache_pages[page])
+		{
+			m68k_cache_pages[page] = 0;
+			m68ki_bc_gen[page]++;
+			m68ki_bc_stop = 1;
+		}
+	}
+}
+
+/* Instructions that always end a block.  Anything that jumps, traps or
+ * writes SR - the NeoCD BIOS calls are line 1111 opcodes, and may load new
+ * code into PRG RAM.
+ */
+int m68ki_bc_ends_block(uint ir)
+{
+	switch(ir >> 12)
+	{
+		case 0x0:	/* ORI, ANDI, EORI to SR */
+			return ir == 0x007c || ir == 0x027c || ir == 0x0a7c;
+		case 0x4:
+			if((ir & 0xff80) == 0x4e80)	/* JSR, JMP */
+				return 1;
+			if((ir & 0xfff0) == 0x4e40)	/* TRAP */
+				return 1;
+			if(ir >= 0x4e60 && ir <= 0x4e7f)	/* MOVE USP, RESET .. RTR */
+				return 1;
+			if((ir & 0xffc0) == 0x46c0)	/* MOVE to SR */
+				return 1;
+			if((ir & 0xf1c0) == 0x4180)	/* CHK */
+				return 1;
+			return ir == 0x4afc;		/* ILLEGAL */
+		case 0x5:	/* DBcc */
+			return (ir & 0xf8) == 0xc8;
+		case 0x6:	/* Bcc, BRA, BSR */
+		case 0xa:
+		case 0xf:
+			return 1;
+	}
+	return 0;
+}
+
+#if M68K_DEAD_FLAGS
+static int m68ki_bc_flag_compare(const void* a, const void* b)
+{
+	size_t x = (size_t)(*(const m68ki_flag_handler_struct* const*)a)->opcode_handler;
+	size_t y = (size_t)(*(const m68ki_flag_handler_struct* const*)b)->opcode_handler;
+
+	return x < y ? -1 : x > y;
+}
+
+static void m68ki_bc_build_flag_index(void)
+{
+	const m68ki_flag_handler_struct* info;
+
+	m68ki_bc_num_flags = 0;
+	for(info = m68ki_flag_handler_table; info->opcode_handler != NULL; info++)
+		if(m68ki_bc_num_flags < BC_FLAGS)
+			m68ki_bc_flags[m68ki_bc_num_flags++] = info;
+
+	qsort(m68ki_bc_flags, m68ki_bc_num_flags, sizeof(m68ki_bc_flags[0]), m68ki_bc_flag_compare);
+}
+
+static const m68ki_flag_handler_struct* m68ki_bc_flag_info(void (*handler)(void))
+{
+	uint low = 0;
+	uint high = m68ki_bc_num_flags;
+	uint mid;
+
+	while(low < high)
+	{
+		mid = (low + high) >> 1;
+		if(m68ki_bc_flags[mid]->opcode_handler == handler)
+			return m68ki_bc_flags[mid];
+		if((size_t)m68ki_bc_flags[mid]->opcode_handler < (size_t)handler)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	return NULL;
+}
+
+/* Where the next instruction in the block sets N, Z, V and C without
+ * looking at them, use the handler that doesn't compute them.
+ */
+static void m68ki_bc_dead_flags(m68ki_bc_block* block)
+{
+	const m68ki_flag_handler_struct* info;
+	uint i;
+
+	for(i = 0; i + 1 < block->count; i++)
+	{
+		info = m68ki_bc_flag_info(block->op[i + 1].handler);
+		if(info == NULL || !info->kill)
+			continue;
+		info = m68ki_bc_flag_info(block->op[i].handler);
+		if(info != NULL && info->nf_handler != NULL)
+			block->op[i].handler = info->nf_handler;
+	}
+}
+#endif /* M68K_DEAD_FLAGS */
+
+/* Run one instruction the normal way */
+static void m68ki_bc_step(void)
+{
+	REG_PPC = REG_PC;
+	REG_IR = m68ki_read_imm_16();
+	m68ki_profile_instr(); /* auto-disable (see m68kcpu.h) */
+	m68ki_execute_ir();
+}
+
+/* Interpret from REG_PC, recording what runs as a new block */
+static void m68ki_bc_record(void)
+{
+	uint pc = REG_PC;
+	uint page = BC_PAGE(pc);
+	m68ki_bc_block* block;
+	m68ki_bc_op* op;
+	uint address;
+	uint i;
+
+	if((pc & 1) || !M68K_BLOCK_CACHE_RANGE(ADDRESS_68K(pc)))
+	{
+		m68ki_bc_step();
+		return;
+	}
+
+	if(m68ki_bc_num_blocks == BC_BLOCKS || m68ki_bc_num_ops + BC_MAX_OPS > BC_OPS)
+		m68k_cache_flush();
+
+	block = &m68ki_bc_blocks[m68ki_bc_num_blocks];
+	block->pc = pc;
+	block->page = page;
+	block->gen = m68ki_bc_gen[page];
+	block->span = 0;
+	block->span_gen = m68ki_bc_gen[page + 1];
+	block->count = 0;
+	block->op = &m68ki_bc_ops[m68ki_bc_num_ops];
+	block->link[0] = block->link[1] = NULL;
+
+	/* From here on, any write to the code sets m68ki_bc_stop */
+	m68k_cache_pages[page] = m68k_cache_pages[page + 1] = 1;
+	m68ki_bc_stop = 0;
+
+	do
+	{
+		op = &block->op[block->count++];
+		pc = REG_PC;
+
+		for(i = 0; i < BC_EXT; i++)
+		{
+			address = ADDRESS_68K(pc + 2 + (i << 1));
+			op->ext[i] = M68K_BLOCK_CACHE_RANGE(address) ? m68k_read_immediate_16(address) : 0;
+		}
+		if(BC_PAGE(pc + 2 + (BC_EXT << 1) - 1) != page)
+			block->span = 1;
+
+		REG_PPC = pc;
+		REG_IR = m68ki_read_imm_16();
+#if M68K_COMPACT_DISPATCH
+		op->handler = m68ki_dispatch(REG_IR)->handler;
+		op->cycles = m68ki_dispatch(REG_IR)->cycles;
+#else
+		op->handler = m68ki_instruction_jump_table[REG_IR];
+		op->cycles = CYC_INSTRUCTION[REG_IR];
+#endif /* M68K_COMPACT_DISPATCH */
+		op->ir = REG_IR;
+
+		m68ki_profile_instr(); /* auto-disable (see m68kcpu.h) */
+		op->handler();
+		USE_CYCLES(op->cycles);
+		op->next = REG_PC;
+
+		if(m68ki_bc_ends_block(op->ir) || BC_PAGE(REG_PC) != page)
+			break;
+	} while(block->count < BC_MAX_OPS && !m68ki_bc_stop && GET_CYCLES() > 0);
+
+	/* Code changed under us, this recording can't be trusted */
+	if(m68ki_bc_stop)
+		return;
+
+#if M68K_DEAD_FLAGS
+	m68ki_bc_dead_flags(block);
+#endif /* M68K_DEAD_FLAGS */
+
+	m68ki_bc_hash[(block->pc >> 1) & (BC_HASH - 1)] = block;
+	m68ki_bc_num_blocks++;
+	m68ki_bc_num_ops += block->count;
+}
+
+#define BC_VALID(B, PC) ((B) != NULL && (B)->pc == (PC) \
+	&& (B)->gen == m68ki_bc_gen[(B)->page] \
+	&& (!(B)->span || (B)->span_gen == m68ki_bc_gen[(B)->page + 1]))
+
+/* Run the block at REG_PC, recording it first if need be.
+ * A block that runs to its end goes straight on to the block it is linked
+ * to, and only falls back to the hash table when the link doesn't match.
+ */
+static void m68ki_bc_execute(void)
+{
+	m68ki_bc_block* block = m68ki_bc_hash[(REG_PC >> 1) & (BC_HASH - 1)];
+	m68ki_bc_block* next;
+	m68ki_bc_op* op;
+	uint count;
+
+	if(!BC_VALID(block, REG_PC))
+	{
+		m68ki_bc_record();
+		return;
+	}
+
+	m68ki_bc_stop = 0;
+
+	for(;;)
+	{
+		for(op = block->op, count = block->count; ; op++)
+		{
+			REG_PPC = REG_PC;
+			REG_IR = op->ir;
+			REG_PC += 2;
+			m68ki_bc_ext = op->ext;
+			m68ki_profile_instr(); /* auto-disable (see m68kcpu.h) */
+			op->handler();
+			USE_CYCLES(op->cycles);
+
+			/* Wherever the last one went, a link may follow it */
+			if(--count == 0)
+				break;
+			if(REG_PC != op->next || m68ki_bc_stop || GET_CYCLES() <= 0)
+				goto done;
+		}
+
+		if(m68ki_bc_stop || GET_CYCLES() <= 0)
+			break;
+
+		next = block->link[0];
+		if(!BC_VALID(next, REG_PC))
+		{
+			next = block->link[1];
+			if(!BC_VALID(next, REG_PC))
+			{
+				next = m68ki_bc_hash[(REG_PC >> 1) & (BC_HASH - 1)];
+				if(!BC_VALID(next, REG_PC))
+					break;
+				block->link[1] = block->link[0];
+				block->link[0] = next;
+			}
+		}
+		block = next;
+	}
+
+done:
+	m68ki_bc_ext = NULL;
+}
+
+#endif /* M68K_BLOCK_CACHE */
+
+#if M68K_FAST_RAM_STATS
+typedef struct
+{
+	const char* name;
+	uint hits;
+	uint misses;
+} m68ki_fast_ram_count;
+
+static int m68ki_fast_ram_compare(const void* a, const void* b)
+{
+	const m68ki_fast_ram_count* x = a;
+	const m68ki_fast_ram_count* y = b;
+	uint total_x = x->hits + x->misses;
+	uint total_y = y->hits + y->misses;
+
+	return total_x < total_y ? 1 : -(total_x > total_y);
+}
+
+void m68k_fast_ram_stats(FILE* file)
+{
+	m68ki_fast_ram_count* counts;
+	uint num;
+	uint i;
+	uint j;
+
+	for(num = 0; m68ki_ram_handler_table[num].opcode_handler != NULL; num++)
+		;
+	counts = calloc(num, sizeof(*counts));
+	if(counts == NULL)
+		return;
+
+	/* Handlers are shared by many opcodes */
+	for(i = 0; i < 0x10000; i++)
+	{
+		if(!m68ki_fast_ram_hits[i] && !m68ki_fast_ram_misses[i])
+			continue;
+		for(j = 0; j < num; j++)
+		{
+			if(m68ki_ram_handler_table[j].opcode_handler == m68ki_instruction_jump_table[i])
+			{
+				counts[j].hits += m68ki_fast_ram_hits[i];
+				counts[j].misses += m68ki_fast_ram_misses[i];
+				break;
+			}
+		}
+		m68ki_fast_ram_hits[i] = m68ki_fast_ram_misses[i] = 0;
+	}
+
+	for(j = 0; j < num; j++)
+		counts[j].name = m68ki_ram_handler_table[j].name;
+	qsort(counts, num, sizeof(*counts), m68ki_fast_ram_compare);
+
+	fprintf(file, "handler,hits,misses\n");
+	for(j = 0; j < num && counts[j].hits + counts[j].misses; j++)
+		fprintf(file, "%s,%u,%u\n", counts[j].name, counts[j].hits, counts[j].misses);
+
+	free(counts);
+}
+#endif /* M68K_FAST_RAM_STATS */
+
+#if M68K_PROFILE
+typedef struct
+{
+	void (*handler)(void);
+	const char* name;
+	uint count;
+} m68ki_profile_count;
+
+static int m68ki_profile_compare_handler(const void* x, const void* y)
+{
+	size_t handler_x = (size_t)((const m68ki_profile_count*)x)->handler;
+	size_t handler_y = (size_t)((const m68ki_profile_count*)y)->handler;
+
+	return handler_x < handler_y ? -1 : handler_x > handler_y;
+}
+
+static int m68ki_profile_compare_count(const void* x, const void* y)
+{
+	uint count_x = ((const m68ki_profile_count*)x)->count;
+	uint count_y = ((const m68ki_profile_count*)y)->count;
+
+	return count_x < count_y ? 1 : -(count_x > count_y);
+}
+
+/* The generated handlers sorted by address, with their counts when
+ * with_counts is set.  *num gets the length.
+ */
+static m68ki_profile_count* m68ki_profile_by_handler(uint* num, int with_counts)
+{
+	m68ki_profile_count* counts;
+	m68ki_profile_count key;
+	m68ki_profile_count* entry;
+	uint i;
+
+	for(*num = 0; m68ki_handler_name_table[*num].opcode_handler != NULL; (*num)++)
+		;
+	counts = calloc(*num, sizeof(*counts));
+	if(counts == NULL)
+		return NULL;
+
+	for(i = 0; i < *num; i++)
+	{
+		counts[i].handler = m68ki_handler_name_table[i].opcode_handler;
+		counts[i].name = m68ki_handler_name_table[i].name;
+	}
+	qsort(counts, *num, sizeof(*counts), m68ki_profile_compare_handler);
+
+	for(i = 0; with_counts && i < 0x10000; i++)
+	{
+		if(!m68ki_profile_ops[i])
+			continue;
+		key.handler = m68ki_instruction_jump_table[i];
+		entry = bsearch(&key, counts, *num, sizeof(*counts), m68ki_profile_compare_handler);
+		if(entry != NULL)
+			entry->count += m68ki_profile_ops[i];
+	}
+	return counts;
+}
+
+void m68k_profile_write(FILE* file)
+{
+	m68ki_profile_count* counts;
+	m68ki_profile_count key;
+	m68ki_profile_count* entry;
+	uint num;
+	uint i;
+
+	counts = m68ki_profile_by_handler(&num, 0);
+	if(counts == NULL)
+		return;
+
+	for(i = 0; i < 0x10000; i++)
+	{
+		if(!m68ki_profile_ops[i])
+			continue;
+		key.handler = m68ki_instruction_jump_table[i];
+		entry = bsearch(&key, counts, num, sizeof(*counts), m68ki_profile_compare_handler);
+		fprintf(file, "op;%s;%04x %u\n", entry != NULL ? entry->name : "illegal", i, m68ki_profile_ops[i]);
+	}
+
+	for(i = 0; i < 0x10000; i++)
+		if(m68ki_profile_pc[i])
+			fprintf(file, "pc;%06x;%06x %u\n", (i >> 8) << 16, i << 8, m68ki_profile_pc[i]);
+
+	free(counts);
+}
+
+void m68k_profile_handlers(FILE* file)
+{
+	m68ki_profile_count* counts;
+	uint num;
+	uint i;
+
+	counts = m68ki_profile_by_handler(&num, 1);
+	if(counts == NULL)
+		return;
+
+	qsort(counts, num, sizeof(*counts), m68ki_profile_compare_count);
+
+	fprintf(file, "handler,count\n");
+	for(i = 0; i < num && counts[i].count; i++)
+		fprintf(file, "%s,%u\n", counts[i].name, counts[i].count);
+
+	free(counts);
+}
+
+void m68k_profile_reset(void)
+{
+	memset(m68ki_profile_ops, 0, sizeof(m68ki_profile_ops));
+	memset(m68ki_profile_pc, 0, sizeof(m68ki_profile_pc));
+}
+#endif /* M68K_PROFILE */
+
 /* Execute some instructions until we use up num_cycles clock cycles */
 /* ASG: removed per-instruction interrupt checks */
 int m68k_execute(int num_cycles)
@@ -636,6 +1231,11 @@ int m68k_execute(int num_cycles)
 	/* Make sure we're not stopped */
 	if(!CPU_STOPPED)
 	{
+#if M68K_COMPACT_DISPATCH
+		if(m68ki_dispatch_cpu != CPU_TYPE)
+			m68ki_build_dispatch();
+#endif /* M68K_COMPACT_DISPATCH */
+
 		/* Set our pool of clock cycles available */
 		SET_CYCLES(num_cycles);
 		m68ki_initial_cycles = num_cycles;
@@ -659,13 +1259,31 @@ int m68k_execute(int num_cycles)
 			/* Call external hook to peek at CPU */
 			m68ki_instr_hook(); /* auto-disable (see m68kcpu.h) */
 
+#if M68K_DRC
+			/* Run recompiled blocks */
+			if(m68ki_drc_enabled)
+			{
+				m68ki_drc_execute();
+				continue;
+			}
+#endif /* M68K_DRC */
+
+#if M68K_BLOCK_CACHE
+			/* Run blocks out of the cache */
+			if(m68ki_bc_enabled)
+			{
+				m68ki_bc_execute();
+				continue;
+			}
+#endif /* M68K_BLOCK_CACHE */
+
 			/* Record previous program counter */
 			REG_PPC = REG_PC;
 
 			/* Read an instruction and call its handler */
 			REG_IR = m68ki_read_imm_16();
-			m68ki_instruction_jump_table[REG_IR]();
-			USE_CYCLES(CYC_INSTRUCTION[REG_IR]);
+			m68ki_profile_instr(); /* auto-disable (see m68kcpu.h) */
+			m68ki_execute_ir();
 
 			/* Trace m68k_exception, if necessary */
 			m68ki_exception_if_trace(); /* auto-disable (see m68kcpu.h) */
@@ -733,6 +1351,75 @@ void m68k_set_irq(unsigned int int_level)
 }
 
 
+#if M68K_COMPACT_DISPATCH
+
+/* Hash of a handler pointer, for building the tables */
+#define DISPATCH_KEY(H, C) ((((uint)(size_t)(H) >> 2) * 31 + (C)) & (DISPATCH_HASH - 1))
+
+static uint16 m68ki_dispatch_hash[DISPATCH_HASH];
+
+/* Index of a handler and cycles pair, adding it if it is new */
+static uint m68ki_dispatch_add(void (*handler)(void), uint cycles)
+{
+	uint key = DISPATCH_KEY(handler, cycles);
+	m68ki_dispatch_entry* entry;
+
+	for(; m68ki_dispatch_hash[key]; key = (key + 1) & (DISPATCH_HASH - 1))
+	{
+		entry = &m68ki_dispatch_handlers[m68ki_dispatch_hash[key] - 1];
+		if(entry->handler == handler && entry->cycles == cycles)
+			return m68ki_dispatch_hash[key] - 1;
+	}
+
+	/* Can't happen with the generated handlers, see DISPATCH_HANDLERS */
+	if(m68ki_dispatch_num_handlers == DISPATCH_HANDLERS)
+		return 0;
+
+	entry = &m68ki_dispatch_handlers[m68ki_dispatch_num_handlers];
+	entry->handler = handler;
+	entry->cycles = cycles;
+	m68ki_dispatch_hash[key] = ++m68ki_dispatch_num_handlers;
+	return m68ki_dispatch_num_handlers - 1;
+}
+
+static void m68ki_build_dispatch(void)
+{
+	void (*const *hot)(void);
+	uint pages = 0;
+	uint page;
+	uint prev;
+	uint i;
+
+	memset(m68ki_dispatch_hash, 0, sizeof(m68ki_dispatch_hash));
+	m68ki_dispatch_num_handlers = 0;
+
+	/* The profiled handlers first, so the busy entries share cache lines */
+	for(hot = m68ki_hot_handler_table; *hot != NULL; hot++)
+		for(i = 0; i < 0x10000; i++)
+			if(m68ki_instruction_jump_table[i] == *hot)
+				m68ki_dispatch_add(*hot, CYC_INSTRUCTION[i]);
+
+	for(i = 0; i < 0x10000; i++)
+		m68ki_dispatch_index[i] = m68ki_dispatch_add(m68ki_instruction_jump_table[i], CYC_INSTRUCTION[i]);
+
+	/* Share identical pages, moving each new one down into place */
+	for(page = 0; page < DISPATCH_PAGES; page++)
+	{
+		uint16* entries = m68ki_dispatch_index + (page << DISPATCH_PAGE_SHIFT);
+
+		for(prev = 0; prev < pages; prev++)
+			if(memcmp(m68ki_dispatch_index + (prev << DISPATCH_PAGE_SHIFT), entries, DISPATCH_PAGE_SIZE * sizeof(uint16)) == 0)
+				break;
+		if(prev == pages)
+			memmove(m68ki_dispatch_index + (pages++ << DISPATCH_PAGE_SHIFT), entries, DISPATCH_PAGE_SIZE * sizeof(uint16));
+		m68ki_dispatch_page[page] = prev << DISPATCH_PAGE_SHIFT;
+	}
+
+	m68ki_dispatch_cpu = CPU_TYPE;
+}
+
+#endif /* M68K_COMPACT_DISPATCH */
+
 /* Pulse the RESET line on the CPU */
 void m68k_pulse_reset(void)
 {
@@ -742,6 +1429,9 @@ void m68k_pulse_reset(void)
 	if(!emulation_initialized)
 	{
 		m68ki_build_opcode_table();
+#if M68K_DEAD_FLAGS
+		m68ki_bc_build_flag_index();
+#endif /* M68K_DEAD_FLAGS */
 		m68k_set_int_ack_callback(NULL);
 		m68k_set_bkpt_ack_callback(NULL);
 		m68k_set_reset_instr_callback(NULL);
@@ -756,6 +1446,9 @@ void m68k_pulse_reset(void)
 	if(CPU_TYPE == 0)	/* KW 990319 */
 		m68k_set_cpu_type(M68K_CPU_TYPE_68000);
 
+	/* Memory is about to be reloaded, and the cycle table may have changed */
+	m68k_cache_flush();
+
 	/* Clear all stop levels and eat up all remaining cycles */
 	CPU_STOPPED = 0;
 	SET_CYCLES(0);
@@ -854,6 +854,96 @@ extern uint8          m68ki_ea_idx_cycle_table[];
 extern uint           m68ki_aerr_address;
 extern uint           m68ki_aerr_write_mode;
 extern uint           m68ki_aerr_fc;
+#if M68K_BLOCK_CACHE
+extern uint16*        m68ki_bc_ext;
+extern uint           m68ki_bc_gen[];
+extern uint           m68ki_bc_stop;
+int m68ki_bc_ends_block(uint ir);
+#endif /* M68K_BLOCK_CACHE */
+
+#if M68K_DRC
+/* Recompiler (m68kdrc.c) */
+#define DRC_BANKS     256		/* 64KB banks */
+#define DRC_HELPERS   8
+#define DRC_CODE_SIZE 0x80000
+
+/* What the generated code finds through r30 */
+typedef struct
+{
+	uint read[DRC_BANKS];		/* Host minus 68000 address, 0: call the host */
+	uint write[DRC_BANKS];
+	uint helper[DRC_HELPERS];	/* C functions the code calls */
+	uint pages;					/* m68k_cache_pages */
+	sint cycles;				/* GET_CYCLES() while in generated code */
+	uint link;					/* Link site the code left by, 0: none */
+} m68ki_drc_state;
+
+extern uint            m68ki_drc_enabled;
+extern m68ki_drc_state m68ki_drc;
+extern uint            m68ki_drc_code[];
+void m68ki_drc_execute(void);
+void m68ki_drc_flush(void);
+
+#if M68K_DRC_EMULATED
+/* The emulator calls helper[i] when the code branches to DRC_HELPER_BASE + 4 * i */
+#define DRC_HELPER_BASE 0xfff00000
+extern uint (*const m68ki_drc_helpers[DRC_HELPERS])(uint, uint, uint);
+#endif /* M68K_DRC_EMULATED */
+#endif /* M68K_DRC */
+
+#if M68K_DEAD_FLAGS
+/* Generated by m68kmake into m68kopnz.c */
+typedef struct
+{
+	void (*opcode_handler)(void); /* handler function */
+	void (*nf_handler)(void);     /* same, without the N, Z, V and C results */
+	unsigned char kill;           /* sets N, Z, V and C without reading them */
+} m68ki_flag_handler_struct;
+
+extern const m68ki_flag_handler_struct m68ki_flag_handler_table[];
+#endif /* M68K_DEAD_FLAGS */
+
+#if M68K_FAST_RAM
+extern unsigned char* M68K_FAST_RAM_BASE;
+#endif /* M68K_FAST_RAM */
+
+#if M68K_COMPACT_DISPATCH
+/* Generated by m68kmake into m68kopnz.c */
+extern void (*const m68ki_hot_handler_table[])(void);
+#endif /* M68K_COMPACT_DISPATCH */
+
+#if M68K_FAST_RAM_STATS || M68K_PROFILE
+/* Generated by m68kmake into m68kopnz.c */
+typedef struct
+{
+	void (*opcode_handler)(void); /* handler function */
+	const char* name;
+} m68ki_handler_name_struct;
+#endif /* M68K_FAST_RAM_STATS || M68K_PROFILE */
+
+#if M68K_PROFILE
+extern const m68ki_handler_name_struct m68ki_handler_name_table[];
+extern uint m68ki_profile_ops[0x10000];
+extern uint m68ki_profile_pc[0x10000];
+#define m68ki_profile_instr() \
+	do { \
+		m68ki_profile_ops[REG_IR]++; \
+		m68ki_profile_pc[(REG_PPC >> 8) & 0xffff]++; \
+	} while(0)
+#else
+#define m68ki_profile_instr()
+#endif /* M68K_PROFILE */
+
+#if M68K_FAST_RAM_STATS
+extern const m68ki_handler_name_struct m68ki_ram_handler_table[];
+extern uint m68ki_fast_ram_hits[0x10000];
+extern uint m68ki_fast_ram_misses[0x10000];
+#define m68ki_fast_ram_hit()  m68ki_fast_ram_hits[REG_IR]++
+#define m68ki_fast_ram_miss() m68ki_fast_ram_misses[REG_IR]++
+#else
+#define m68ki_fast_ram_hit()
+#define m68ki_fast_ram_miss()
+#endif /* M68K_FAST_RAM_STATS */
 
 /* Read data immediately after the program counter */
 INLINE uint m68ki_read_imm_16(void);
@@ -864,6 +954,17 @@ INLINE uint m68ki_read_8_fc  (uint address, uint fc);
 INLINE uint m68ki_read_16_fc (uint address, uint fc);
 INLINE uint m68ki_read_32_fc (uint address, uint fc);
 
+/* Read data, trying the host's RAM first (M68K_FAST_RAM) */
+#if M68K_FAST_RAM
+INLINE uint m68ki_read_ram_8 (uint address);
+INLINE uint m68ki_read_ram_16(uint address);
+INLINE uint m68ki_read_ram_32(uint address);
+#else
+#define m68ki_read_ram_8(A)  m68ki_read_8(A)
+#define m68ki_read_ram_16(A) m68ki_read_16(A)
+#define m68ki_read_ram_32(A) m68ki_read_32(A)
+#endif /* M68K_FAST_RAM */
+
 /* Write data with specific function code */
 INLINE void m68ki_write_8_fc (uint address, uint fc, uint value);
 INLINE void m68ki_write_16_fc(uint address, uint fc, uint value);
@@ -998,6 +1099,14 @@ INLINE uint m68ki_read_imm_16(void)
 	REG_PC += 2;
 	return MASK_OUT_ABOVE_16(CPU_PREF_DATA >> ((2-((REG_PC-2)&2))<<3));
 #else
+#if M68K_BLOCK_CACHE
+	/* Replaying a cached block: the extension words were saved with it */
+	if(m68ki_bc_ext)
+	{
+		REG_PC += 2;
+		return *m68ki_bc_ext++;
+	}
+#endif /* M68K_BLOCK_CACHE */
 	REG_PC += 2;
 	return m68k_read_immediate_16(ADDRESS_68K(REG_PC-2));
 #endif /* M68K_EMULATE_PREFETCH */
@@ -1028,6 +1137,14 @@ INLINE uint m68ki_read_imm_32(void)
 #else
 	m68ki_set_fc(FLAG_S | FUNCTION_CODE_USER_PROGRAM); /* auto-disable (see m68kcpu.h) */
 	m68ki_check_address_error(REG_PC, MODE_READ, FLAG_S | FUNCTION_CODE_USER_PROGRAM); /* auto-disable (see m68kcpu.h) */
+#if M68K_BLOCK_CACHE
+	if(m68ki_bc_ext)
+	{
+		REG_PC += 4;
+		m68ki_bc_ext += 2;
+		return (m68ki_bc_ext[-2] << 16) | m68ki_bc_ext[-1];
+	}
+#endif /* M68K_BLOCK_CACHE */
 	REG_PC += 4;
 	return m68k_read_immediate_32(ADDRESS_68K(REG_PC-4));
 #endif /* M68K_EMULATE_PREFETCH */
@@ -1061,6 +1178,47 @@ INLINE uint m68ki_read_32_fc(uint address, uint fc)
 	return m68k_read_memory_32(ADDRESS_68K(address));
 }
 
+#if M68K_FAST_RAM
+#if M68K_FAST_RAM_SWAP
+#define m68ki_fast_ram_16(A) __builtin_bswap16(*(unsigned short*)(M68K_FAST_RAM_BASE + (A)))
+#define m68ki_fast_ram_32(A) __builtin_bswap32(*(unsigned int*)(M68K_FAST_RAM_BASE + (A)))
+#else
+#define m68ki_fast_ram_16(A) (*(unsigned short*)(M68K_FAST_RAM_BASE + (A)))
+#define m68ki_fast_ram_32(A) (*(unsigned int*)(M68K_FAST_RAM_BASE + (A)))
+#endif /* M68K_FAST_RAM_SWAP */
+
+INLINE uint m68ki_read_ram_8(uint address)
+{
+	if(ADDRESS_68K(address) < M68K_FAST_RAM_SIZE)
+	{
+		m68ki_fast_ram_hit();
+		return M68K_FAST_RAM_BASE[ADDRESS_68K(address)];
+	}
+	m68ki_fast_ram_miss();
+	return m68ki_read_8(address);
+}
+INLINE uint m68ki_read_ram_16(uint address)
+{
+	if(ADDRESS_68K(address) < M68K_FAST_RAM_SIZE - 1)
+	{
+		m68ki_fast_ram_hit();
+		return m68ki_fast_ram_16(ADDRESS_68K(address));
+	}
+	m68ki_fast_ram_miss();
+	return m68ki_read_16(address);
+}
+INLINE uint m68ki_read_ram_32(uint address)
+{
+	if(ADDRESS_68K(address) <= M68K_FAST_RAM_SIZE - 4)
+	{
+		m68ki_fast_ram_hit();
+		return m68ki_fast_ram_32(ADDRESS_68K(address));
+	}
+	m68ki_fast_ram_miss();
+	return m68ki_read_32(address);
+}
+#endif /* M68K_FAST_RAM */
+
 INLINE void m68ki_write_8_fc(uint address, uint fc, uint value)
 {
 	m68ki_set_fc(fc); /* auto-disable (see m68kcpu.h) */
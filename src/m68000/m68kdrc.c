@@ -0,0 +1,2481 @@
+/* ======================================================================== */
+/* ======================== 68000 TO POWERPC BLOCKS ======================= */
+/* ======================================================================== */
+/*
+ * Recompiler for cached 68000 code (M68K_DRC in m68kconf.h).
+ *
+ * A block is the same run of instructions the block cache records: from
+ * its PC up to a branch, a jump, a trap or the end of its page.  It is
+ * decoded once, flags are tracked backwards through it, and it is turned
+ * into PowerPC code that does what the handlers would do:
+ *
+ *  - D0-D7 and A0-A7 live in r14-r29 while the code runs, r30 points to
+ *    m68ki_drc and r31 to m68ki_cpu.  r5-r10 hold values within an
+ *    instruction, r0, r3, r4, r11 and r12 are scratch.
+ *  - Flags are kept in m68ki_cpu in the handlers' format, and only stored
+ *    where a later instruction in the block, or anything after the block,
+ *    may read them.  A Bcc, DBcc or Scc right after a compare or a test
+ *    branches on the compared values instead of loading them back.
+ *  - Reads and writes to memory passed to m68k_drc_map() go straight to
+ *    host memory, through a table by 64KB bank.  Anything else, and writes
+ *    to pages holding cached code, calls the host's handlers.  Interrupts
+ *    they raise are held back until the block ends.
+ *  - Instructions it doesn't translate run through their handler, with the
+ *    registers stored.  If the PC isn't where it should be after that, the
+ *    block is left.  The NeoCD BIOS calls (line 1111) always end a block.
+ *  - A block that runs to its end with cycles left jumps straight into the
+ *    next one, once that has run: the exit is a nop until it is patched
+ *    into a branch.  The links into a block are undone when its code is
+ *    overwritten, found through the same page generations as the cache.
+ *
+ * A block doesn't check the cycles until it ends, so m68k_execute() can
+ * run up to one block past the cycles it was given.  Flags a later
+ * instruction in the block sets without reading are dropped, as with
+ * M68K_DEAD_FLAGS.
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include "m68kops.h"
+#include "m68kcpu.h"
+
+#if M68K_DRC
+
+#define DRC_BLOCKS     4096
+#define DRC_HASH       4096			/* Chained on the block's PC */
+#define DRC_LINKS      8192
+#define DRC_MAX_INSNS  64
+#define DRC_MAX_SLOW   (DRC_MAX_INSNS * 2)	/* At most two accesses an instruction */
+#define DRC_BLOCK_ROOM 0x8000		/* Most code one block can need, in bytes */
+#define DRC_PAGE(A)    (ADDRESS_68K(A) >> M68K_CACHE_PAGE_SHIFT)
+
+#if M68K_DRC_EMULATED
+#define DRC_HOST(P)    m68k_drc_host(P)
+#else
+#define DRC_HOST(P)    ((uint)(size_t)(P))
+#endif /* M68K_DRC_EMULATED */
+
+/* Host registers */
+#define R_REG(N)       (14 + (N))	/* D0-D7, then A0-A7 */
+#define R_SP           R_REG(15)
+#define R_STATE        30
+#define R_CPU          31
+#define R_TEMP         5			/* r5-r10 */
+#define R_TEMPS        6
+
+/* Stack frame of the entry code, which every helper call runs in */
+#define FRAME          112
+#define FRAME_SPILL    8			/* r5-r10 across a call */
+#define FRAME_LR       36			/* Return address of the interpreter stub */
+#define FRAME_SAVE     40			/* r14-r31 */
+
+#define CPU(F)         ((uint)offsetof(m68ki_cpu_core, F))
+#define STATE(F)       ((uint)offsetof(m68ki_drc_state, F))
+#define HELPER(I)      (STATE(helper) + (I) * 4)
+
+/* Flags, for the liveness pass */
+#define F_N            1
+#define F_Z            2
+#define F_V            4
+#define F_C            8
+#define F_X            16
+#define F_NZVC         15
+#define F_ALL          31
+
+/* Helpers the generated code calls: address, value, cycles into the block */
+enum
+{
+	H_READ_8, H_READ_16, H_READ_32, H_WRITE_8, H_WRITE_16, H_WRITE_32, H_INTERP
+};
+
+/* Operand modes */
+enum
+{
+	EA_D, EA_A, EA_AI, EA_PI, EA_PD, EA_DI, EA_IX, EA_ABS, EA_PCIX, EA_IMM
+};
+
+/* Translated instructions, anything else is DRC_FALLBACK */
+enum
+{
+	DRC_FALLBACK, DRC_MOVE, DRC_MOVEA, DRC_MOVEQ, DRC_LEA, DRC_PEA, DRC_CLR,
+	DRC_TST, DRC_NOT, DRC_NEG, DRC_EXT, DRC_SWAP, DRC_ADD, DRC_SUB, DRC_CMP,
+	DRC_AND, DRC_OR, DRC_EOR, DRC_ADDA, DRC_SUBA, DRC_CMPA, DRC_MULU,
+	DRC_MULS, DRC_SHIFT, DRC_BTST, DRC_BCHG, DRC_BCLR, DRC_BSET, DRC_BCC,
+	DRC_BSR, DRC_DBCC, DRC_SCC, DRC_JMP, DRC_JSR, DRC_RTS, DRC_NOP
+};
+
+/* Shift kinds, as in bits 3-4 of the opcode */
+#define SHIFT_AS       0
+#define SHIFT_LS       1
+#define SHIFT_RO       3
+
+typedef struct
+{
+	uint mode;
+	uint reg;		/* 0-15, address registers from 8 */
+	uint index;		/* Index register 0-15, 16 set for a long index */
+	sint disp;
+	uint value;		/* Address, immediate, or PC relative base */
+} m68ki_drc_ea;
+
+typedef struct
+{
+	uint pc;
+	uint next;		/* PC after it, 0 when not known */
+	uint ir;
+	uint op;
+	uint size;		/* 1, 2 or 4 */
+	uint cycles;	/* Base cycles */
+	uint cc;
+	uint target;	/* Branch target */
+	uint shift;		/* DRC_SHIFT: kind, 4 set for left, count from bit 8 */
+	m68ki_drc_ea src;
+	m68ki_drc_ea dst;
+	uint use;		/* Flags read */
+	uint def;		/* Flags set */
+	uint live;		/* Flags read later */
+	uint writes;	/* Writes memory, so may end the block */
+} m68ki_drc_insn;
+
+typedef struct m68ki_drc_block
+{
+	uint pc;
+	uint page;
+	uint gen;
+	uint span;					/* Also depends on page + 1 */
+	uint span_gen;
+	uint dead;					/* Code changed, links into it undone */
+	uint* code;
+	int in;						/* First link into it, -1: none */
+	struct m68ki_drc_block* next;
+} m68ki_drc_block;
+
+typedef struct
+{
+	uint* site;
+	int next;
+} m68ki_drc_link;
+
+/* Out of line call to the host for a memory access */
+typedef struct
+{
+	uint* from[3];	/* Branches to it */
+	uint froms;
+	uint* back;		/* Where it returns to */
+	uint helper;
+	uint addr;		/* Address register */
+	uint value;		/* Register read into or written from */
+	uint spill;		/* Temps to keep across the call */
+	uint k;			/* Cycles into the block */
+	uint stop_cycles;	/* Writes: leaving after this instruction */
+	uint stop_pc;
+	int stop_reg;
+} m68ki_drc_slow;
+
+/* Compares and tests a Bcc, DBcc or Scc right after can branch on */
+enum
+{
+	FUSE_NONE, FUSE_CMP, FUSE_LOGIC, FUSE_ARITH
+};
+
+typedef struct
+{
+	uint kind;
+	uint size;
+	uint a;			/* FUSE_CMP: destination, else result, zero extended */
+	uint b;			/* FUSE_CMP: source */
+} m68ki_drc_fuse;
+
+/* Conditions as a CR0 bit: BO << 8 | BI */
+#define BO_TRUE        12
+#define BO_FALSE       4
+#define BI_LT          0
+#define BI_GT          1
+#define BI_EQ          2
+#define COND(BO, BI)   (((BO) << 8) | (BI))
+#define COND_ALWAYS    0x10000
+#define COND_NEVER     0x20000
+
+/* PowerPC instructions */
+#define PPC_D(OP, D, A, I)          (((uint)(OP) << 26) | ((D) << 21) | ((A) << 16) | ((I) & 0xffff))
+#define PPC_X(XO, D, A, B)          ((31u << 26) | ((D) << 21) | ((A) << 16) | ((B) << 11) | ((XO) << 1))
+#define PPC_M(OP, S, A, SH, MB, ME) (((uint)(OP) << 26) | ((S) << 21) | ((A) << 16) | (((SH) & 31) << 11) | (((MB) & 31) << 6) | (((ME) & 31) << 1))
+
+#define ADDI(D, A, I)               PPC_D(14, D, A, I)
+#define ADDIS(D, A, I)              PPC_D(15, D, A, I)
+#define ADDIC_(D, A, I)             PPC_D(13, D, A, I)
+#define LI(D, I)                    ADDI(D, 0, I)
+#define LIS(D, I)                   ADDIS(D, 0, I)
+#define ORI(A, S, I)                PPC_D(24, S, A, I)
+#define ORIS(A, S, I)               PPC_D(25, S, A, I)
+#define XORI(A, S, I)               PPC_D(26, S, A, I)
+#define XORIS(A, S, I)              PPC_D(27, S, A, I)
+#define ANDI_(A, S, I)              PPC_D(28, S, A, I)
+#define CMPWI(A, I)                 PPC_D(11, 0, A, I)
+#define CMPLWI(A, I)                PPC_D(10, 0, A, I)
+#define LWZ(D, I, A)                PPC_D(32, D, A, I)
+#define LBZ(D, I, A)                PPC_D(34, D, A, I)
+#define LHZ(D, I, A)                PPC_D(40, D, A, I)
+#define STW(S, I, A)                PPC_D(36, S, A, I)
+#define STWU(S, I, A)               PPC_D(37, S, A, I)
+#define LMW(D, I, A)                PPC_D(46, D, A, I)
+#define STMW(S, I, A)               PPC_D(47, S, A, I)
+#define RLWINM(A, S, SH, MB, ME)    PPC_M(21, S, A, SH, MB, ME)
+#define RLWINM_(A, S, SH, MB, ME)   (PPC_M(21, S, A, SH, MB, ME) | 1)
+#define RLWIMI(A, S, SH, MB, ME)    PPC_M(20, S, A, SH, MB, ME)
+#define CLRLWI(A, S, N)             RLWINM(A, S, 0, N, 31)
+#define SLWI(A, S, N)               RLWINM(A, S, N, 0, 31 - (N))
+#define SRWI(A, S, N)               RLWINM(A, S, 32 - (N), N, 31)
+#define ADD(D, A, B)                PPC_X(266, D, A, B)
+#define ADDC(D, A, B)               PPC_X(10, D, A, B)
+#define ADDZE(D, A)                 PPC_X(202, D, A, 0)
+#define SUBF(D, A, B)               PPC_X(40, D, A, B)		/* D = B - A */
+#define SUBFC(D, A, B)              PPC_X(8, D, A, B)
+#define SUBFE(D, A, B)              PPC_X(136, D, A, B)
+#define NEG(D, A)                   PPC_X(104, D, A, 0)
+#define MULLW(D, A, B)              PPC_X(235, D, A, B)
+#define AND(A, S, B)                PPC_X(28, S, A, B)
+#define ANDC(A, S, B)               PPC_X(60, S, A, B)
+#define OR(A, S, B)                 PPC_X(444, S, A, B)
+#define OR_(A, S, B)                (PPC_X(444, S, A, B) | 1)
+#define XOR(A, S, B)                PPC_X(316, S, A, B)
+#define NOR(A, S, B)                PPC_X(124, S, A, B)
+#define SLW(A, S, B)                PPC_X(24, S, A, B)
+#define SRAWI(A, S, N)              PPC_X(824, S, A, N)
+#define CNTLZW(A, S)                PPC_X(26, S, A, 0)
+#define EXTSB(A, S)                 PPC_X(954, S, A, 0)
+#define EXTSH(A, S)                 PPC_X(922, S, A, 0)
+#define CMPW(A, B)                  PPC_X(0, 0, A, B)
+#define CMPLW(A, B)                 PPC_X(32, 0, A, B)
+#define LWZX(D, A, B)               PPC_X(23, D, A, B)
+#define LHZX(D, A, B)               PPC_X(279, D, A, B)
+#define LBZX(D, A, B)               PPC_X(87, D, A, B)
+#define STWX(S, A, B)               PPC_X(151, S, A, B)
+#define STHX(S, A, B)               PPC_X(407, S, A, B)
+#define STBX(S, A, B)               PPC_X(215, S, A, B)
+#define MR(A, S)                    OR(A, S, S)
+#define MFLR(D)                     PPC_X(339, D, 8, 0)
+#define MTLR(S)                     PPC_X(467, S, 8, 0)
+#define MTCTR(S)                    PPC_X(467, S, 9, 0)
+#define B(D)                        ((18u << 26) | ((D) & 0x3fffffc))
+#define BL(D)                       (B(D) | 1)
+#define BC(BO, BI, D)               ((16u << 26) | ((BO) << 21) | ((BI) << 16) | ((D) & 0xfffc))
+#define BCTR                        0x4e800420
+#define BCTRL                       0x4e800421
+#define BLR                         0x4e800020
+#define NOP                         0x60000000
+
+uint m68ki_drc_enabled = 0;
+m68ki_drc_state m68ki_drc;
+uint m68ki_drc_code[DRC_CODE_SIZE / 4];
+
+static m68ki_drc_block m68ki_drc_blocks[DRC_BLOCKS];
+static m68ki_drc_block* m68ki_drc_hash[DRC_HASH];
+static m68ki_drc_link m68ki_drc_links[DRC_LINKS];
+static uint m68ki_drc_num_blocks = 0;
+static uint m68ki_drc_num_links = 0;
+static uint* m68ki_drc_ptr = NULL;		/* NULL until the stubs are written */
+static uint* m68ki_drc_enter;
+static uint* m68ki_drc_exit;
+static uint* m68ki_drc_interp;
+static uint* m68ki_drc_pending = NULL;	/* Link site the last block left by */
+static uint m68ki_drc_pending_pc;
+
+/* The block being compiled */
+static m68ki_drc_insn m68ki_drc_insns[DRC_MAX_INSNS];
+static m68ki_drc_slow m68ki_drc_slows[DRC_MAX_SLOW];
+static uint m68ki_drc_num_slows;
+static uint m68ki_drc_temps;			/* r5-r10 in use */
+static uint m68ki_drc_k;				/* Cycles of the instructions before this one */
+static m68ki_drc_insn* m68ki_drc_in;
+static m68ki_drc_fuse m68ki_drc_fused;	/* Set up by the last instruction */
+static uint m68ki_drc_stop_pc;			/* Where a write that ends the block leaves */
+static int m68ki_drc_stop_reg;
+
+#define EMIT(W) (*m68ki_drc_ptr++ = (W))
+
+/* Flags read by each condition */
+static const uint8 m68ki_drc_cc_use[16] =
+{
+	0, 0, F_C | F_Z, F_C | F_Z, F_C, F_C, F_Z, F_Z,
+	F_V, F_V, F_N, F_N, F_N | F_V, F_N | F_V, F_N | F_V | F_Z, F_N | F_V | F_Z
+};
+
+
+/* ======================================================================== */
+/* ============================== HOST SIDE =============================== */
+/* ======================================================================== */
+
+/* Make freshly written code visible to instruction fetch */
+static void m68ki_drc_sync(uint* code, uint words)
+{
+#if M68K_DRC_EMULATED
+	(void)code;
+	(void)words;
+#else
+	char* p = (char*)((size_t)code & ~31);
+	char* end = (char*)(code + words);
+
+	for(; p < end; p += 32)
+		__asm__ volatile("dcbst 0,%0\n\tsync\n\ticbi 0,%0" : : "r"(p) : "memory");
+	__asm__ volatile("sync\n\tisync" : : : "memory");
+#endif /* M68K_DRC_EMULATED */
+}
+
+/* Interrupts the host raises in a memory access wait for the end of the
+ * block, as the registers are in host registers and the PC isn't set.
+ * While in the host, the cycles are as the interpreter would have them.
+ */
+static uint m68ki_drc_hold(uint k)
+{
+	uint mask = FLAG_INT_MASK;
+
+	SET_CYCLES(m68ki_drc.cycles - (sint)k);
+	FLAG_INT_MASK = 0x0700;
+	return mask;
+}
+
+/* Nonzero when the block must end: code changed or an interrupt is due */
+static uint m68ki_drc_release(uint mask, uint k)
+{
+	FLAG_INT_MASK = mask;
+	m68ki_drc.cycles = GET_CYCLES() + (sint)k;
+	return m68ki_bc_stop || CPU_INT_LEVEL > FLAG_INT_MASK;
+}
+
+static uint m68ki_drc_read_8(uint address, uint unused, uint k)
+{
+	uint mask = m68ki_drc_hold(k);
+	uint value = m68ki_read_8(address);
+
+	m68ki_drc_release(mask, k);
+	return value;
+}
+
+static uint m68ki_drc_read_16(uint address, uint unused, uint k)
+{
+	uint mask = m68ki_drc_hold(k);
+	uint value = m68ki_read_16(address);
+
+	m68ki_drc_release(mask, k);
+	return value;
+}
+
+static uint m68ki_drc_read_32(uint address, uint unused, uint k)
+{
+	uint mask = m68ki_drc_hold(k);
+	uint value = m68ki_read_32(address);
+
+	m68ki_drc_release(mask, k);
+	return value;
+}
+
+static uint m68ki_drc_write_8(uint address, uint value, uint k)
+{
+	uint mask = m68ki_drc_hold(k);
+
+	m68ki_write_8(address, value);
+	return m68ki_drc_release(mask, k);
+}
+
+static uint m68ki_drc_write_16(uint address, uint value, uint k)
+{
+	uint mask = m68ki_drc_hold(k);
+
+	m68ki_write_16(address, value);
+	return m68ki_drc_release(mask, k);
+}
+
+static uint m68ki_drc_write_32(uint address, uint value, uint k)
+{
+	uint mask = m68ki_drc_hold(k);
+
+	m68ki_write_32(address, value);
+	return m68ki_drc_release(mask, k);
+}
+
+/* Run the instruction at pc through its handler, with the registers stored.
+ * Its extra cycles go into m68ki_drc.cycles.  Nonzero when the block must
+ * end, REG_PC is then where to go on.
+ */
+static uint m68ki_drc_interp_insn(uint pc, uint next, uint k)
+{
+	uint cycles;
+
+	SET_CYCLES(m68ki_drc.cycles - (sint)k);
+	REG_PPC = pc;
+	REG_PC = pc;
+	REG_IR = m68ki_read_imm_16();
+	cycles = CYC_INSTRUCTION[REG_IR];
+	m68ki_profile_instr(); /* auto-disable (see m68kcpu.h) */
+	m68ki_instruction_jump_table[REG_IR]();
+	USE_CYCLES(cycles);
+	m68ki_drc.cycles = GET_CYCLES() + (sint)(k + cycles);
+	return REG_PC != next || m68ki_bc_stop || CPU_INT_LEVEL > FLAG_INT_MASK;
+}
+
+#if M68K_DRC_EMULATED
+uint (*const m68ki_drc_helpers[DRC_HELPERS])(uint, uint, uint) =
+#else
+static uint (*const m68ki_drc_helpers[DRC_HELPERS])(uint, uint, uint) =
+#endif /* M68K_DRC_EMULATED */
+{
+	m68ki_drc_read_8, m68ki_drc_read_16, m68ki_drc_read_32,
+	m68ki_drc_write_8, m68ki_drc_write_16, m68ki_drc_write_32,
+	m68ki_drc_interp_insn
+};
+
+
+/* ======================================================================== */
+/* ================================ DECODER =============================== */
+/* ======================================================================== */
+
+/* Opcode word at address, 0 if it can't be cached */
+static int m68ki_drc_word(uint address, uint* word)
+{
+	if(!M68K_BLOCK_CACHE_RANGE(ADDRESS_68K(address)))
+		return 0;
+	*word = m68k_read_immediate_16(ADDRESS_68K(address));
+	return 1;
+}
+
+/* Extension words of an effective address, -1 if there is no such mode */
+static int m68ki_drc_ea_words(uint mode, uint reg, uint size)
+{
+	if(mode < 5)
+		return 0;
+	if(mode < 7)
+		return 1;
+	switch(reg)
+	{
+		case 0: case 2: case 3:
+			return 1;
+		case 1:
+			return 2;
+		case 4:
+			return size == 4 ? 2 : 1;
+	}
+	return -1;
+}
+
+/* Decode the effective address in mode and reg, reading any extension
+ * words at *pc.  0 if they can't be read or there is no such mode.
+ */
+static int m68ki_drc_decode_ea(m68ki_drc_ea* ea, uint mode, uint reg, uint size, uint* pc)
+{
+	uint word;
+	uint low;
+
+	ea->reg = mode == 0 ? reg : reg + 8;
+	ea->disp = 0;
+	ea->index = 0;
+	ea->value = 0;
+
+	switch(mode)
+	{
+		case 0: ea->mode = EA_D; return 1;
+		case 1: ea->mode = EA_A; return 1;
+		case 2: ea->mode = EA_AI; return 1;
+		case 3: ea->mode = EA_PI; return 1;
+		case 4: ea->mode = EA_PD; return 1;
+		case 5:
+			if(!m68ki_drc_word(*pc, &word))
+				return 0;
+			ea->mode = EA_DI;
+			ea->disp = MAKE_INT_16(word);
+			*pc += 2;
+			return 1;
+		case 6:
+			if(!m68ki_drc_word(*pc, &word))
+				return 0;
+			ea->mode = EA_IX;
+			ea->index = (word >> 12) | (word & 0x800 ? 16 : 0);
+			ea->disp = MAKE_INT_8(word & 0xff);
+			*pc += 2;
+			return 1;
+	}
+
+	if(!m68ki_drc_word(*pc, &word))
+		return 0;
+	switch(reg)
+	{
+		case 0:		/* (xxx).W */
+			ea->mode = EA_ABS;
+			ea->value = MAKE_INT_16(word);
+			*pc += 2;
+			return 1;
+		case 1:		/* (xxx).L */
+			if(!m68ki_drc_word(*pc + 2, &low))
+				return 0;
+			ea->mode = EA_ABS;
+			ea->value = (word << 16) | low;
+			*pc += 4;
+			return 1;
+		case 2:		/* (d16,PC) */
+			ea->mode = EA_ABS;
+			ea->value = *pc + MAKE_INT_16(word);
+			*pc += 2;
+			return 1;
+		case 3:		/* (d8,PC,Xn) */
+			ea->mode = EA_PCIX;
+			ea->value = *pc;
+			ea->index = (word >> 12) | (word & 0x800 ? 16 : 0);
+			ea->disp = MAKE_INT_8(word & 0xff);
+			*pc += 2;
+			return 1;
+		case 4:		/* #imm */
+			ea->mode = EA_IMM;
+			if(size == 4)
+			{
+				if(!m68ki_drc_word(*pc + 2, &low))
+					return 0;
+				ea->value = (word << 16) | low;
+				*pc += 4;
+				return 1;
+			}
+			ea->value = size == 1 ? word & 0xff : word;
+			*pc += 2;
+			return 1;
+	}
+	return 0;
+}
+
+/* Sizes in bits 6-7 of most opcodes, 0 for the invalid one */
+static const uint m68ki_drc_sizes[4] = {1, 2, 4, 0};
+
+/* Length of an instruction the recompiler leaves to the interpreter, from
+ * its opcode and effective address.  0 when not known, the block then ends
+ * after it.
+ */
+static uint m68ki_drc_length(uint ir)
+{
+	uint mode = (ir >> 3) & 7;
+	uint reg = ir & 7;
+	int words;
+
+	switch(ir >> 12)
+	{
+		case 0x0:
+			if((ir & 0xf138) == 0x0108)	/* MOVEP */
+				return 4;
+			if((ir & 0xf5bf) == 0x003c)	/* ORI, ANDI, EORI to CCR, SR */
+				return 4;
+			return 0;
+		case 0x4:
+			if((ir & 0xfff0) == 0x4e50)	/* LINK, UNLK */
+				return ir & 8 ? 2 : 4;
+			words = m68ki_drc_ea_words(mode, reg, 2);
+			if(words < 0)
+				return 0;
+			if((ir & 0xfb80) == 0x4880)	/* MOVEM */
+				return 4 + words * 2;
+			if((ir & 0xff00) == 0x4000 || (ir & 0xf9c0) == 0x40c0 ||
+			   (ir & 0xffc0) == 0x4800 || (ir & 0xffc0) == 0x4ac0)
+				return 2 + words * 2;	/* NEGX, MOVE SR, CCR, NBCD, TAS */
+			return 0;
+		case 0x8:
+			if((ir & 0x00c0) == 0x00c0)	/* DIVU, DIVS */
+			{
+				words = m68ki_drc_ea_words(mode, reg, 2);
+				return words < 0 ? 0 : 2 + words * 2;
+			}
+			return (ir & 0x1f0) == 0x100 ? 2 : 0;	/* SBCD */
+		case 0x9:
+		case 0xd:
+			return (ir & 0x130) == 0x100 ? 2 : 0;	/* SUBX, ADDX */
+		case 0xc:
+			return (ir & 0x130) == 0x100 ? 2 : 0;	/* ABCD, EXG */
+		case 0xe:
+			if((ir & 0xc0) != 0xc0)
+				return 2;						/* Register shifts */
+			words = m68ki_drc_ea_words(mode, reg, 2);
+			return words < 0 ? 0 : 2 + words * 2;
+	}
+	return 0;
+}
+
+/* Decode the instruction at pc.  0 if its words can't be read. */
+static int m68ki_drc_decode_insn(m68ki_drc_insn* in, uint pc)
+{
+	void (*handler)(void);
+	uint ir;
+	uint word;
+	uint mode;
+	uint reg;
+	uint size;
+	uint opmode;
+	uint next = pc + 2;
+
+	if(!m68ki_drc_word(pc, &ir))
+		return 0;
+
+	memset(in, 0, sizeof(*in));
+	in->pc = pc;
+	in->ir = ir;
+	in->cycles = CYC_INSTRUCTION[ir];
+	in->op = DRC_FALLBACK;
+	in->use = F_ALL;
+
+	mode = (ir >> 3) & 7;
+	reg = ir & 7;
+	size = m68ki_drc_sizes[(ir >> 6) & 3];
+	opmode = (ir >> 6) & 7;
+
+	handler = m68ki_instruction_jump_table[ir];
+	if(handler == m68k_op_illegal || handler == m68k_op_1010 || handler == m68k_op_1111)
+		goto fallback;
+
+	switch(ir >> 12)
+	{
+		case 0x0:
+			if(ir & 0x100)
+			{
+				if(mode == 1)			/* MOVEP */
+					goto fallback;
+				in->op = DRC_BTST + ((ir >> 6) & 3);
+				in->size = mode ? 1 : 4;
+				m68ki_drc_decode_ea(&in->src, 0, (ir >> 9) & 7, 4, &next);
+				if(!m68ki_drc_decode_ea(&in->dst, mode, reg, in->size, &next))
+					return 0;
+				break;
+			}
+			if((ir & 0xff00) == 0x0800)	/* Static bit operations */
+			{
+				in->op = DRC_BTST + ((ir >> 6) & 3);
+				in->size = mode ? 1 : 4;
+				if(!m68ki_drc_decode_ea(&in->src, 7, 4, 1, &next) ||
+				   !m68ki_drc_decode_ea(&in->dst, mode, reg, in->size, &next))
+					return 0;
+				break;
+			}
+			if((ir & 0x3f) == 0x3c || !size)	/* To CCR, SR */
+				goto fallback;
+			switch((ir >> 9) & 7)
+			{
+				case 0: in->op = DRC_OR; break;
+				case 1: in->op = DRC_AND; break;
+				case 2: in->op = DRC_SUB; break;
+				case 3: in->op = DRC_ADD; break;
+				case 5: in->op = DRC_EOR; break;
+				case 6: in->op = DRC_CMP; break;
+				default: goto fallback;
+			}
+			in->size = size;
+			if(!m68ki_drc_decode_ea(&in->src, 7, 4, size, &next) ||
+			   !m68ki_drc_decode_ea(&in->dst, mode, reg, size, &next))
+				return 0;
+			break;
+
+		case 0x1:
+		case 0x2:
+		case 0x3:
+			in->size = (ir >> 12) == 1 ? 1 : (ir >> 12) == 3 ? 2 : 4;
+			in->op = opmode == 1 ? DRC_MOVEA : DRC_MOVE;
+			if(!m68ki_drc_decode_ea(&in->src, mode, reg, in->size, &next) ||
+			   !m68ki_drc_decode_ea(&in->dst, opmode, (ir >> 9) & 7, in->size, &next))
+				return 0;
+			break;
+
+		case 0x4:
+			if((ir & 0xf1c0) == 0x41c0)
+			{
+				in->op = DRC_LEA;
+				in->size = 4;
+				m68ki_drc_decode_ea(&in->dst, 1, (ir >> 9) & 7, 4, &next);
+				if(!m68ki_drc_decode_ea(&in->src, mode, reg, 4, &next))
+					return 0;
+				break;
+			}
+			if((ir & 0xf900) == 0x4000 && (ir & 0x0600) && size)
+			{
+				/* CLR, NEG, NOT */
+				in->op = (ir & 0x0600) == 0x0200 ? DRC_CLR : (ir & 0x0600) == 0x0400 ? DRC_NEG : DRC_NOT;
+				in->size = size;
+				if(!m68ki_drc_decode_ea(&in->dst, mode, reg, size, &next))
+					return 0;
+				break;
+			}
+			if((ir & 0xff00) == 0x4a00 && size)
+			{
+				in->op = DRC_TST;
+				in->size = size;
+				if(!m68ki_drc_decode_ea(&in->src, mode, reg, size, &next))
+					return 0;
+				break;
+			}
+			if((ir & 0xfff8) == 0x4840)
+			{
+				in->op = DRC_SWAP;
+				in->size = 4;
+				m68ki_drc_decode_ea(&in->dst, 0, reg, 4, &next);
+				break;
+			}
+			if((ir & 0xffc0) == 0x4840)
+			{
+				in->op = DRC_PEA;
+				in->size = 4;
+				if(!m68ki_drc_decode_ea(&in->src, mode, reg, 4, &next))
+					return 0;
+				break;
+			}
+			if((ir & 0xffb8) == 0x4880)
+			{
+				in->op = DRC_EXT;
+				in->size = ir & 0x40 ? 4 : 2;
+				m68ki_drc_decode_ea(&in->dst, 0, reg, 4, &next);
+				break;
+			}
+			if(ir == 0x4e71)
+			{
+				in->op = DRC_NOP;
+				break;
+			}
+			if(ir == 0x4e75)
+			{
+				in->op = DRC_RTS;
+				in->size = 4;
+				break;
+			}
+			if((ir & 0xff80) == 0x4e80)
+			{
+				in->op = ir & 0x40 ? DRC_JMP : DRC_JSR;
+				in->size = 4;
+				if(!m68ki_drc_decode_ea(&in->src, mode, reg, 4, &next))
+					return 0;
+				break;
+			}
+			goto fallback;
+
+		case 0x5:
+			if(!size)
+			{
+				in->cc = (ir >> 8) & 15;
+				if(mode == 1)
+				{
+					if(!m68ki_drc_word(next, &word))
+						return 0;
+					in->op = DRC_DBCC;
+					in->size = 2;
+					in->target = next + MAKE_INT_16(word);
+					next += 2;
+					m68ki_drc_decode_ea(&in->dst, 0, reg, 2, &next);
+					break;
+				}
+				in->op = DRC_SCC;
+				in->size = 1;
+				if(!m68ki_drc_decode_ea(&in->dst, mode, reg, 1, &next))
+					return 0;
+				break;
+			}
+			in->op = ir & 0x100 ? DRC_SUB : DRC_ADD;
+			in->size = size;
+			in->src.mode = EA_IMM;
+			in->src.value = (((ir >> 9) - 1) & 7) + 1;
+			if(!m68ki_drc_decode_ea(&in->dst, mode, reg, size, &next))
+				return 0;
+			if(mode == 1)
+			{
+				/* All 32 bits, no flags */
+				in->op = in->op == DRC_SUB ? DRC_SUBA : DRC_ADDA;
+				in->size = 4;
+			}
+			break;
+
+		case 0x6:
+			in->cc = (ir >> 8) & 15;
+			word = ir & 0xff;
+			if(word == 0xff)
+				goto fallback;
+			in->op = in->cc == 1 ? DRC_BSR : DRC_BCC;
+			if(in->cc == 1)
+				in->cc = 0;
+			if(word)
+				in->target = next + MAKE_INT_8(word);
+			else
+			{
+				if(!m68ki_drc_word(next, &word))
+					return 0;
+				in->target = next + MAKE_INT_16(word);
+				in->size = 2;		/* Bcc.W, for the cycles when not taken */
+				next += 2;
+			}
+			break;
+
+		case 0x7:
+			in->op = DRC_MOVEQ;
+			in->size = 4;
+			in->src.mode = EA_IMM;
+			in->src.value = MAKE_INT_8(ir & 0xff);
+			m68ki_drc_decode_ea(&in->dst, 0, (ir >> 9) & 7, 4, &next);
+			break;
+
+		case 0x8:
+		case 0x9:
+		case 0xb:
+		case 0xc:
+		case 0xd:
+			if((opmode & 3) == 3)
+			{
+				/* ADDA, SUBA, CMPA, MULU, MULS */
+				switch(ir >> 12)
+				{
+					case 0x9: in->op = DRC_SUBA; break;
+					case 0xb: in->op = DRC_CMPA; break;
+					case 0xc: in->op = opmode == 3 ? DRC_MULU : DRC_MULS; break;
+					case 0xd: in->op = DRC_ADDA; break;
+					default: goto fallback;
+				}
+				in->size = opmode == 7 && (ir >> 12) != 0xc ? 4 : 2;
+				if(!m68ki_drc_decode_ea(&in->src, mode, reg, in->size, &next))
+					return 0;
+				m68ki_drc_decode_ea(&in->dst, (ir >> 12) == 0xc ? 0 : 1, (ir >> 9) & 7, 4, &next);
+				break;
+			}
+			switch(ir >> 12)
+			{
+				case 0x8: in->op = DRC_OR; break;
+				case 0x9: in->op = DRC_SUB; break;
+				case 0xb: in->op = opmode & 4 ? DRC_EOR : DRC_CMP; break;
+				case 0xc: in->op = DRC_AND; break;
+				case 0xd: in->op = DRC_ADD; break;
+			}
+			in->size = m68ki_drc_sizes[opmode & 3];
+			if((ir >> 12) == 0xb && (opmode & 4) && mode == 1)
+			{
+				/* CMPM (Ay)+,(Ax)+ */
+				in->op = DRC_CMP;
+				m68ki_drc_decode_ea(&in->src, 3, reg, in->size, &next);
+				m68ki_drc_decode_ea(&in->dst, 3, (ir >> 9) & 7, in->size, &next);
+				break;
+			}
+			if(opmode & 4)
+			{
+				/* Dn,<ea>; ABCD, SBCD, ADDX, SUBX and EXG here */
+				if(mode < 2 && in->op != DRC_EOR)
+					goto fallback;
+				m68ki_drc_decode_ea(&in->src, 0, (ir >> 9) & 7, in->size, &next);
+				if(!m68ki_drc_decode_ea(&in->dst, mode, reg, in->size, &next))
+					return 0;
+				break;
+			}
+			if(!m68ki_drc_decode_ea(&in->src, mode, reg, in->size, &next))
+				return 0;
+			m68ki_drc_decode_ea(&in->dst, 0, (ir >> 9) & 7, in->size, &next);
+			break;
+
+		case 0xe:
+			/* Shifts and rotates of a register by an immediate count */
+			if(!size || (ir & 0x20) || mode == 2 || mode == 6)
+				goto fallback;
+			in->op = DRC_SHIFT;
+			in->size = size;
+			in->shift = ((ir >> 3) & 3) | (ir & 0x100 ? 4 : 0) | (((((ir >> 9) - 1) & 7) + 1) << 8);
+			m68ki_drc_decode_ea(&in->dst, 0, reg, size, &next);
+			break;
+
+		default:
+			goto fallback;
+	}
+
+	in->next = next;
+
+	/* Flags */
+	switch(in->op)
+	{
+		case DRC_MOVE: case DRC_MOVEQ: case DRC_CLR: case DRC_TST: case DRC_NOT:
+		case DRC_EXT: case DRC_SWAP: case DRC_AND: case DRC_OR: case DRC_EOR:
+		case DRC_MULU: case DRC_MULS: case DRC_CMP: case DRC_CMPA:
+			in->use = 0;
+			in->def = F_NZVC;
+			break;
+		case DRC_ADD: case DRC_SUB: case DRC_NEG:
+			in->use = 0;
+			in->def = F_ALL;
+			break;
+		case DRC_SHIFT:
+			in->use = 0;
+			in->def = (in->shift & 3) == SHIFT_RO ? F_NZVC : F_ALL;
+			break;
+		case DRC_BTST: case DRC_BCHG: case DRC_BCLR: case DRC_BSET:
+			in->use = 0;
+			in->def = F_Z;
+			break;
+		case DRC_BCC: case DRC_DBCC: case DRC_SCC:
+			in->use = m68ki_drc_cc_use[in->cc];
+			in->def = 0;
+			break;
+		default:
+			in->use = 0;
+			in->def = 0;
+			break;
+	}
+	switch(in->op)
+	{
+		case DRC_MOVE: case DRC_CLR: case DRC_NOT: case DRC_NEG: case DRC_ADD:
+		case DRC_SUB: case DRC_AND: case DRC_OR: case DRC_EOR: case DRC_BCHG:
+		case DRC_BCLR: case DRC_BSET: case DRC_SCC:
+			in->writes = in->dst.mode >= EA_AI;
+			break;
+		case DRC_PEA:
+			in->writes = 1;
+			break;
+	}
+	return 1;
+
+fallback:
+	in->op = DRC_FALLBACK;
+	in->use = F_ALL;
+	in->def = 0;
+	in->next = m68ki_drc_length(ir);
+	if(in->next)
+		in->next += pc;
+	return 1;
+}
+
+/* Decode a block from pc and work out the flags each instruction must
+ * leave.  Returns the number of instructions, 0 if none could be read.
+ */
+static uint m68ki_drc_decode(uint pc, uint* span)
+{
+	uint page = DRC_PAGE(pc);
+	m68ki_drc_insn* in;
+	uint count = 0;
+	uint live;
+	int i;
+
+	*span = 0;
+	while(count < DRC_MAX_INSNS)
+	{
+		in = &m68ki_drc_insns[count];
+		if(!m68ki_drc_decode_insn(in, pc))
+			break;
+		count++;
+		if(!in->next || m68ki_bc_ends_block(in->ir))
+		{
+			if(DRC_PAGE(pc + 9) != page)	/* Longest 68000 instruction */
+				*span = 1;
+			break;
+		}
+		if(DRC_PAGE(in->next - 1) != page)
+			*span = 1;
+		pc = in->next;
+		if(DRC_PAGE(pc) != page)
+			break;
+	}
+
+	live = F_ALL;
+	for(i = count - 1; i >= 0; i--)
+	{
+		/* A write to code ends the block after it, with every flag set */
+		if(m68ki_drc_insns[i].writes)
+			live = F_ALL;
+		m68ki_drc_insns[i].live = live;
+		live = (live & ~m68ki_drc_insns[i].def) | m68ki_drc_insns[i].use;
+	}
+	return count;
+}
+
+
+/* ======================================================================== */
+/* ================================ EMITTER =============================== */
+/* ======================================================================== */
+
+/* Load a constant */
+static void m68ki_drc_li(uint r, uint value)
+{
+	if((sint)value == (sint)MAKE_INT_16(value))
+		EMIT(LI(r, value));
+	else
+	{
+		EMIT(LIS(r, value >> 16));
+		if(value & 0xffff)
+			EMIT(ORI(r, r, value));
+	}
+}
+
+/* Forward branches, pointed at the current position by m68ki_drc_land() */
+static uint* m68ki_drc_bc(uint bo, uint bi)
+{
+	EMIT(BC(bo, bi, 0));
+	return m68ki_drc_ptr - 1;
+}
+
+static void m68ki_drc_land(uint* at)
+{
+	uint d = (uint)((char*)m68ki_drc_ptr - (char*)at);
+
+	*at |= (*at >> 26) == 18 ? d & 0x3fffffc : d & 0xfffc;
+}
+
+static void m68ki_drc_jump(uint* to, uint link)
+{
+	uint d = (uint)((char*)to - (char*)m68ki_drc_ptr);
+
+	EMIT(link ? BL(d) : B(d));
+}
+
+/* Call a helper through the table in m68ki_drc */
+static void m68ki_drc_call(uint helper)
+{
+	EMIT(LWZ(0, HELPER(helper), R_STATE));
+	EMIT(MTCTR(0));
+	EMIT(BCTRL);
+}
+
+static uint m68ki_drc_temp(void)
+{
+	uint i;
+
+	for(i = 0; i < R_TEMPS; i++)
+	{
+		if(!(m68ki_drc_temps & (1 << i)))
+		{
+			m68ki_drc_temps |= 1 << i;
+			return R_TEMP + i;
+		}
+	}
+	return R_TEMP;	/* Can't happen, an instruction needs five at most */
+}
+
+static void m68ki_drc_free(uint r)
+{
+	if(r >= R_TEMP && r < R_TEMP + R_TEMPS)
+		m68ki_drc_temps &= ~(1 << (r - R_TEMP));
+}
+
+/* Copy a 68000 register operand into a temp */
+static uint m68ki_drc_copy(uint r)
+{
+	uint t;
+
+	if(r >= R_TEMP && r < R_TEMP + R_TEMPS)
+		return r;
+	t = m68ki_drc_temp();
+	EMIT(MR(t, r));
+	return t;
+}
+
+static void m68ki_drc_save_regs(void)
+{
+	uint i;
+
+	for(i = 0; i < 16; i++)
+		EMIT(STW(R_REG(i), CPU(dar) + i * 4, R_CPU));
+}
+
+static void m68ki_drc_load_regs(void)
+{
+	uint i;
+
+	for(i = 0; i < 16; i++)
+		EMIT(LWZ(R_REG(i), CPU(dar) + i * 4, R_CPU));
+}
+
+/* The code every block is entered by and left through, and the stub that
+ * runs an instruction through the interpreter.
+ */
+static void m68ki_drc_start(void)
+{
+	uint i;
+
+	m68ki_drc_ptr = m68ki_drc_code;
+	for(i = 0; i < DRC_HELPERS; i++)
+#if M68K_DRC_EMULATED
+		m68ki_drc.helper[i] = DRC_HELPER_BASE + i * 4;
+#else
+		m68ki_drc.helper[i] = (uint)(size_t)m68ki_drc_helpers[i];
+#endif /* M68K_DRC_EMULATED */
+	m68ki_drc.pages = DRC_HOST(m68k_cache_pages);
+
+	/* Offset 0 is never a link site */
+	m68ki_drc_exit = m68ki_drc_ptr;
+	EMIT(STW(3, CPU(pc), R_CPU));
+	EMIT(STW(4, STATE(link), R_STATE));
+	m68ki_drc_save_regs();
+	EMIT(LWZ(0, FRAME + 4, 1));
+	EMIT(MTLR(0));
+	EMIT(LMW(14, FRAME_SAVE, 1));
+	EMIT(ADDI(1, 1, FRAME));
+	EMIT(BLR);
+
+	/* void enter(uint* code) */
+	m68ki_drc_enter = m68ki_drc_ptr;
+	EMIT(MFLR(0));
+	EMIT(STW(0, 4, 1));
+	EMIT(STWU(1, -FRAME, 1));
+	EMIT(STMW(14, FRAME_SAVE, 1));
+	m68ki_drc_li(R_STATE, DRC_HOST(&m68ki_drc));
+	m68ki_drc_li(R_CPU, DRC_HOST(&m68ki_cpu));
+	m68ki_drc_load_regs();
+	EMIT(MTCTR(3));
+	EMIT(BCTR);
+
+	/* bl with pc, next and cycles into the block in r3-r5 */
+	m68ki_drc_interp = m68ki_drc_ptr;
+	EMIT(MFLR(0));
+	EMIT(STW(0, FRAME_LR, 1));
+	m68ki_drc_save_regs();
+	m68ki_drc_call(H_INTERP);
+	m68ki_drc_load_regs();
+	EMIT(LWZ(0, FRAME_LR, 1));
+	EMIT(MTLR(0));
+	EMIT(BLR);
+
+	m68ki_drc_sync(m68ki_drc_code, m68ki_drc_ptr - m68ki_drc_code);
+}
+
+/* ------------------------------- Exits -------------------------------- */
+
+/* Leave for pc, or go straight on to its block once linked */
+static void m68ki_drc_exit_static(uint pc, uint cycles)
+{
+	uint* out;
+	uint* site;
+
+	EMIT(LWZ(3, STATE(cycles), R_STATE));
+	EMIT(ADDIC_(3, 3, -(sint)cycles));
+	EMIT(STW(3, STATE(cycles), R_STATE));
+	out = m68ki_drc_bc(BO_FALSE, BI_GT);
+	site = m68ki_drc_ptr;
+	EMIT(NOP);
+	m68ki_drc_land(out);
+	m68ki_drc_li(3, pc);
+	m68ki_drc_li(4, (uint)((char*)site - (char*)m68ki_drc_code));
+	m68ki_drc_jump(m68ki_drc_exit, 0);
+}
+
+/* Leave for the PC in register r, or in REG_PC when r is 0 */
+static void m68ki_drc_exit_dynamic(uint r, uint cycles)
+{
+	EMIT(LWZ(4, STATE(cycles), R_STATE));
+	EMIT(ADDI(4, 4, -(sint)cycles));
+	EMIT(STW(4, STATE(cycles), R_STATE));
+	if(r == 0)
+		EMIT(LWZ(3, CPU(pc), R_CPU));
+	else if(r != 3)
+		EMIT(MR(3, r));
+	EMIT(LI(4, 0));
+	m68ki_drc_jump(m68ki_drc_exit, 0);
+}
+
+/* BRA or JMP to itself: the interpreter uses up every cycle */
+static void m68ki_drc_exit_self(uint pc, uint cycles)
+{
+	EMIT(LI(4, -(sint)cycles));
+	EMIT(STW(4, STATE(cycles), R_STATE));
+	m68ki_drc_li(3, pc);
+	EMIT(LI(4, 0));
+	m68ki_drc_jump(m68ki_drc_exit, 0);
+}
+
+/* ------------------------------- Memory ------------------------------- */
+
+static m68ki_drc_slow* m68ki_drc_slow_path(uint helper, uint addr, uint value)
+{
+	m68ki_drc_slow* slow = &m68ki_drc_slows[m68ki_drc_num_slows++];
+
+	slow->froms = 0;
+	slow->helper = helper;
+	slow->addr = addr;
+	slow->value = value;
+	slow->spill = m68ki_drc_temps;
+	slow->k = m68ki_drc_k;
+	return slow;
+}
+
+/* The host minus 68000 address of the bank at the address in register addr,
+ * from table, into r11, and the 24 bit address into r12.  Accesses across
+ * two banks and to banks that aren't mapped go to slow.
+ */
+static void m68ki_drc_bank(m68ki_drc_slow* slow, uint addr, uint size, uint table)
+{
+	EMIT(CLRLWI(12, addr, 8));
+	if(size > 1)
+	{
+		EMIT(ADDI(11, 12, size - 1));
+		EMIT(XOR(0, 11, 12));
+		EMIT(RLWINM_(0, 0, 0, 0, 15));
+		slow->from[slow->froms++] = m68ki_drc_bc(BO_FALSE, BI_EQ);
+	}
+	EMIT(RLWINM(11, 12, 18, 22, 29));
+	if(table)
+		EMIT(ADDI(11, 11, table));
+	EMIT(LWZX(11, R_STATE, 11));
+	EMIT(CMPWI(11, 0));
+	slow->from[slow->froms++] = m68ki_drc_bc(BO_TRUE, BI_EQ);
+}
+
+/* value = the size bytes at the address in register addr */
+static void m68ki_drc_read(uint value, uint addr, uint size)
+{
+	m68ki_drc_slow* slow = m68ki_drc_slow_path(H_READ_8 + (size >> 1), addr, value);
+
+	slow->spill &= ~(1 << (value - R_TEMP));
+	m68ki_drc_bank(slow, addr, size, 0);
+	EMIT(size == 1 ? LBZX(value, 11, 12) : size == 2 ? LHZX(value, 11, 12) : LWZX(value, 11, 12));
+	slow->back = m68ki_drc_ptr;
+}
+
+/* Write the register value to the address in register addr.  Writes to
+ * pages holding cached code go to the host, and end the block there.
+ */
+static void m68ki_drc_write(uint addr, uint value, uint size)
+{
+	m68ki_drc_slow* slow = m68ki_drc_slow_path(H_WRITE_8 + (size >> 1), addr, value);
+
+	slow->stop_cycles = m68ki_drc_k + m68ki_drc_in->cycles;
+	slow->stop_pc = m68ki_drc_stop_pc;
+	slow->stop_reg = m68ki_drc_stop_reg;
+	m68ki_drc_bank(slow, addr, size, STATE(write));
+
+	EMIT(LWZ(0, STATE(pages), R_STATE));
+	EMIT(SRWI(3, 12, M68K_CACHE_PAGE_SHIFT));
+	EMIT(LBZX(3, 3, 0));
+	if(size > 1)
+	{
+		EMIT(ADDI(4, 12, size - 1));
+		EMIT(SRWI(4, 4, M68K_CACHE_PAGE_SHIFT));
+		EMIT(LBZX(4, 4, 0));
+		EMIT(OR(3, 3, 4));
+	}
+	EMIT(CMPWI(3, 0));
+	slow->from[slow->froms++] = m68ki_drc_bc(BO_FALSE, BI_EQ);
+
+	EMIT(size == 1 ? STBX(value, 11, 12) : size == 2 ? STHX(value, 11, 12) : STWX(value, 11, 12));
+	slow->back = m68ki_drc_ptr;
+}
+
+/* The calls to the host, after the block's code */
+static void m68ki_drc_emit_slow(m68ki_drc_slow* slow)
+{
+	uint* done;
+	uint i;
+
+	for(i = 0; i < slow->froms; i++)
+		m68ki_drc_land(slow->from[i]);
+	for(i = 0; i < R_TEMPS; i++)
+		if(slow->spill & (1 << i))
+			EMIT(STW(R_TEMP + i, FRAME_SPILL + i * 4, 1));
+	if(slow->helper >= H_WRITE_8)
+		EMIT(MR(4, slow->value));
+	EMIT(MR(3, slow->addr));
+	m68ki_drc_li(5, slow->k);
+	m68ki_drc_call(slow->helper);
+	for(i = 0; i < R_TEMPS; i++)
+		if(slow->spill & (1 << i))
+			EMIT(LWZ(R_TEMP + i, FRAME_SPILL + i * 4, 1));
+
+	if(slow->helper < H_WRITE_8)
+	{
+		EMIT(MR(slow->value, 3));
+		m68ki_drc_jump(slow->back, 0);
+		return;
+	}
+
+	EMIT(CMPWI(3, 0));
+	done = m68ki_drc_bc(BO_TRUE, BI_EQ);
+	if(slow->stop_reg >= 0)
+		m68ki_drc_exit_dynamic(slow->stop_reg, slow->stop_cycles);
+	else
+	{
+		EMIT(LWZ(4, STATE(cycles), R_STATE));
+		EMIT(ADDI(4, 4, -(sint)slow->stop_cycles));
+		EMIT(STW(4, STATE(cycles), R_STATE));
+		m68ki_drc_li(3, slow->stop_pc);
+		EMIT(LI(4, 0));
+		m68ki_drc_jump(m68ki_drc_exit, 0);
+	}
+	m68ki_drc_land(done);
+	m68ki_drc_jump(slow->back, 0);
+}
+
+/* ------------------------------ Operands ------------------------------ */
+
+/* Xn of an indexed mode added to base, into t */
+static void m68ki_drc_index(uint t, uint base, const m68ki_drc_ea* ea)
+{
+	uint xn = R_REG(ea->index & 15);
+
+	if(ea->index & 16)
+		EMIT(ADD(t, base, xn));
+	else
+	{
+		EMIT(EXTSH(t, xn));
+		EMIT(ADD(t, t, base));
+	}
+	if(ea->disp)
+		EMIT(ADDI(t, t, ea->disp));
+}
+
+/* Register with the address of a memory operand, updating An for (An)+ and
+ * -(An).  That can be An itself, which mustn't be written.
+ */
+static uint m68ki_drc_address(const m68ki_drc_ea* ea, uint size)
+{
+	uint an = R_REG(ea->reg);
+	uint step = size == 1 && ea->reg == 15 ? 2 : size;
+	uint t;
+
+	switch(ea->mode)
+	{
+		case EA_AI:
+			return an;
+		case EA_PI:
+			t = m68ki_drc_temp();
+			EMIT(MR(t, an));
+			EMIT(ADDI(an, an, step));
+			return t;
+		case EA_PD:
+			EMIT(ADDI(an, an, -(sint)step));
+			return an;
+		case EA_DI:
+			t = m68ki_drc_temp();
+			EMIT(ADDI(t, an, ea->disp));
+			return t;
+		case EA_IX:
+			t = m68ki_drc_temp();
+			m68ki_drc_index(t, an, ea);
+			return t;
+		case EA_PCIX:
+			t = m68ki_drc_temp();
+			m68ki_drc_li(0, ea->value);
+			m68ki_drc_index(t, 0, ea);
+			return t;
+	}
+	t = m68ki_drc_temp();
+	m68ki_drc_li(t, ea->value);
+	return t;
+}
+
+/* Host address of a constant 68000 address, 0 if it isn't mapped */
+static uint m68ki_drc_direct(uint address, uint size)
+{
+	uint first = ADDRESS_68K(address);
+
+	if(!m68ki_drc.read[first >> 16] || (first >> 16) != ((first + size - 1) >> 16))
+		return 0;
+	return m68ki_drc.read[first >> 16] + first;
+}
+
+/* Operand value, zero extended from size bytes.  Long register operands
+ * come back as the 68000 register, which mustn't be written.  With addr,
+ * the address of a memory operand is kept there for writing it back.
+ */
+static uint m68ki_drc_load(const m68ki_drc_ea* ea, uint size, uint* addr)
+{
+	uint host;
+	uint a;
+	uint t;
+
+	switch(ea->mode)
+	{
+		case EA_D:
+		case EA_A:
+			if(size == 4)
+				return R_REG(ea->reg);
+			t = m68ki_drc_temp();
+			EMIT(CLRLWI(t, R_REG(ea->reg), 32 - size * 8));
+			return t;
+		case EA_IMM:
+			t = m68ki_drc_temp();
+			m68ki_drc_li(t, ea->value);
+			return t;
+		case EA_ABS:
+			host = addr ? 0 : m68ki_drc_direct(ea->value, size);
+			if(host)
+			{
+				t = m68ki_drc_temp();
+				EMIT(LIS(t, (host + 0x8000) >> 16));
+				EMIT(size == 1 ? LBZ(t, host, t) : size == 2 ? LHZ(t, host, t) : LWZ(t, host, t));
+				return t;
+			}
+			break;
+	}
+
+	a = m68ki_drc_address(ea, size);
+	t = m68ki_drc_temp();
+	m68ki_drc_read(t, a, size);
+	if(addr)
+		*addr = a;
+	else
+		m68ki_drc_free(a);
+	return t;
+}
+
+/* Put a result in a data register, or write it to addr */
+static void m68ki_drc_put(const m68ki_drc_ea* ea, uint size, uint value, uint addr)
+{
+	uint dn = R_REG(ea->reg);
+
+	if(ea->mode != EA_D)
+		m68ki_drc_write(addr, value, size);
+	else if(size == 4)
+	{
+		if(value != dn)
+			EMIT(MR(dn, value));
+	}
+	else
+		EMIT(RLWIMI(dn, value, 0, 32 - size * 8, 31));
+}
+
+/* ------------------------------- Flags -------------------------------- */
+
+static void m68ki_drc_flag(uint r, uint flag)
+{
+	EMIT(STW(r, flag, R_CPU));
+}
+
+/* N and Z from a zero extended result */
+static void m68ki_drc_flags_nz(uint res, uint size, uint live)
+{
+	if(live & F_N)
+	{
+		if(size == 1)
+			m68ki_drc_flag(res, CPU(n_flag));
+		else
+		{
+			EMIT(SRWI(0, res, size * 8 - 8));
+			m68ki_drc_flag(0, CPU(n_flag));
+		}
+	}
+	if(live & F_Z)
+		m68ki_drc_flag(res, CPU(not_z_flag));
+}
+
+/* Moves, logic and tests: V and C cleared */
+static void m68ki_drc_flags_logic(uint res, uint size, uint live)
+{
+	m68ki_drc_flags_nz(res, size, live);
+	if(live & (F_V | F_C))
+	{
+		EMIT(LI(0, 0));
+		if(live & F_V)
+			m68ki_drc_flag(0, CPU(v_flag));
+		if(live & F_C)
+			m68ki_drc_flag(0, CPU(c_flag));
+	}
+}
+
+/* Additions and subtractions of s and d, raw result r, zero extended result
+ * m.  Long ones must have come from ADDC or SUBFC when C or X is live.
+ */
+static void m68ki_drc_flags_arith(uint sub, uint s, uint d, uint r, uint m, uint size, uint live)
+{
+	m68ki_drc_flags_nz(m, size, live);
+
+	if(live & F_V)
+	{
+		if(sub)
+		{
+			EMIT(XOR(11, s, d));
+			EMIT(XOR(12, r, d));
+		}
+		else
+		{
+			EMIT(XOR(11, s, r));
+			EMIT(XOR(12, d, r));
+		}
+		EMIT(AND(11, 11, 12));
+		if(size > 1)
+			EMIT(SRWI(11, 11, size * 8 - 8));
+		m68ki_drc_flag(11, CPU(v_flag));
+	}
+
+	if(live & (F_C | F_X))
+	{
+		if(size < 4)
+		{
+			if(size > 1)
+				EMIT(SRWI(11, r, size * 8 - 8));
+			else
+				EMIT(MR(11, r));
+		}
+		else if(sub)
+			EMIT(SUBFE(11, 11, 11));	/* -1 on a borrow */
+		else
+		{
+			EMIT(LI(11, 0));
+			EMIT(ADDZE(11, 11));
+			EMIT(SLWI(11, 11, 8));
+		}
+		if(live & F_C)
+			m68ki_drc_flag(11, CPU(c_flag));
+		if(live & F_X)
+			m68ki_drc_flag(11, CPU(x_flag));
+	}
+}
+
+static void m68ki_drc_set_fuse(uint kind, uint size, uint a, uint b)
+{
+	m68ki_drc_fused.kind = kind;
+	m68ki_drc_fused.size = size;
+	m68ki_drc_fused.a = a;
+	m68ki_drc_fused.b = b;
+}
+
+/* Set CR0 for condition cc, from the compare just before if it can */
+static uint m68ki_drc_cond(uint cc, const m68ki_drc_fuse* f)
+{
+	uint a;
+	uint b;
+
+	if(cc < 2)
+		return cc == 0 ? COND_ALWAYS : COND_NEVER;
+
+	if(f->kind == FUSE_CMP && (cc < 8 || cc >= 12))
+	{
+		a = f->a;
+		b = f->b;
+		if(f->size < 4)
+		{
+			EMIT(RLWINM(11, a, 32 - f->size * 8, 0, f->size * 8 - 1));
+			EMIT(RLWINM(12, b, 32 - f->size * 8, 0, f->size * 8 - 1));
+			a = 11;
+			b = 12;
+		}
+		switch(cc)
+		{
+			case 2:  EMIT(CMPLW(a, b)); return COND(BO_TRUE, BI_GT);	/* HI */
+			case 3:  EMIT(CMPLW(a, b)); return COND(BO_FALSE, BI_GT);	/* LS */
+			case 4:  EMIT(CMPLW(a, b)); return COND(BO_FALSE, BI_LT);	/* CC */
+			case 5:  EMIT(CMPLW(a, b)); return COND(BO_TRUE, BI_LT);	/* CS */
+			case 6:  EMIT(CMPW(a, b)); return COND(BO_FALSE, BI_EQ);	/* NE */
+			case 7:  EMIT(CMPW(a, b)); return COND(BO_TRUE, BI_EQ);	/* EQ */
+			case 12: EMIT(CMPW(a, b)); return COND(BO_FALSE, BI_LT);	/* GE */
+			case 13: EMIT(CMPW(a, b)); return COND(BO_TRUE, BI_LT);	/* LT */
+			case 14: EMIT(CMPW(a, b)); return COND(BO_TRUE, BI_GT);	/* GT */
+			default: EMIT(CMPW(a, b)); return COND(BO_FALSE, BI_GT);	/* LE */
+		}
+	}
+
+	if((f->kind == FUSE_LOGIC || (f->kind == FUSE_ARITH && (cc == 6 || cc == 7 || cc == 10 || cc == 11))))
+	{
+		if(f->size < 4)
+			EMIT(RLWINM_(11, f->a, 32 - f->size * 8, 0, f->size * 8 - 1));
+		else
+			EMIT(CMPWI(f->a, 0));
+		switch(cc)
+		{
+			case 2:  return COND(BO_FALSE, BI_EQ);	/* HI: C clear */
+			case 3:  return COND(BO_TRUE, BI_EQ);
+			case 4:  return COND_ALWAYS;
+			case 5:  return COND_NEVER;
+			case 6:  return COND(BO_FALSE, BI_EQ);
+			case 7:  return COND(BO_TRUE, BI_EQ);
+			case 8:  return COND_ALWAYS;			/* VC: V clear */
+			case 9:  return COND_NEVER;
+			case 10: return COND(BO_FALSE, BI_LT);
+			case 11: return COND(BO_TRUE, BI_LT);
+			case 12: return COND(BO_FALSE, BI_LT);	/* GE: N == V */
+			case 13: return COND(BO_TRUE, BI_LT);
+			case 14: return COND(BO_TRUE, BI_GT);
+			default: return COND(BO_FALSE, BI_GT);
+		}
+	}
+
+	/* From the flags in m68ki_cpu */
+	switch(cc)
+	{
+		case 2:
+		case 3:		/* HI, LS: C or Z */
+			EMIT(LWZ(11, CPU(c_flag), R_CPU));
+			EMIT(RLWINM(11, 11, 29, 26, 26));
+			EMIT(LWZ(12, CPU(not_z_flag), R_CPU));
+			EMIT(CNTLZW(12, 12));
+			EMIT(RLWINM(12, 12, 0, 26, 26));
+			EMIT(OR_(11, 11, 12));
+			return COND(cc == 2 ? BO_TRUE : BO_FALSE, BI_EQ);
+		case 4:
+		case 5:
+			EMIT(LWZ(11, CPU(c_flag), R_CPU));
+			EMIT(ANDI_(11, 11, 0x100));
+			break;
+		case 6:
+		case 7:
+			EMIT(LWZ(11, CPU(not_z_flag), R_CPU));
+			EMIT(CMPWI(11, 0));
+			return COND(cc == 7 ? BO_TRUE : BO_FALSE, BI_EQ);
+		case 8:
+		case 9:
+			EMIT(LWZ(11, CPU(v_flag), R_CPU));
+			EMIT(ANDI_(11, 11, 0x80));
+			break;
+		case 10:
+		case 11:
+			EMIT(LWZ(11, CPU(n_flag), R_CPU));
+			EMIT(ANDI_(11, 11, 0x80));
+			break;
+		case 12:
+		case 13:
+			EMIT(LWZ(11, CPU(n_flag), R_CPU));
+			EMIT(LWZ(12, CPU(v_flag), R_CPU));
+			EMIT(XOR(11, 11, 12));
+			EMIT(ANDI_(11, 11, 0x80));
+			break;
+		default:	/* GT, LE: N != V or Z */
+			EMIT(LWZ(11, CPU(n_flag), R_CPU));
+			EMIT(LWZ(12, CPU(v_flag), R_CPU));
+			EMIT(XOR(11, 11, 12));
+			EMIT(RLWINM(11, 11, 30, 26, 26));
+			EMIT(LWZ(12, CPU(not_z_flag), R_CPU));
+			EMIT(CNTLZW(12, 12));
+			EMIT(RLWINM(12, 12, 0, 26, 26));
+			EMIT(OR_(11, 11, 12));
+			return COND(cc == 14 ? BO_TRUE : BO_FALSE, BI_EQ);
+	}
+	/* The odd conditions hold when the bit is set */
+	return COND(cc & 1 ? BO_FALSE : BO_TRUE, BI_EQ);
+}
+
+/* Branch forward when the condition holds, or when it doesn't */
+static uint* m68ki_drc_branch(uint cond, uint when)
+{
+	uint bo = cond >> 8;
+
+	if(!when)
+		bo = bo == BO_TRUE ? BO_FALSE : BO_TRUE;
+	return m68ki_drc_bc(bo, cond & 0xff);
+}
+
+/* ---------------------------- Instructions ---------------------------- */
+
+/* ADD, SUB, CMP, AND, OR, EOR in all their forms */
+static void m68ki_drc_alu(m68ki_drc_insn* in)
+{
+	uint size = in->size;
+	uint live = in->live & in->def;
+	uint op = in->op;
+	uint addr = 0;
+	uint s;
+	uint d;
+	uint r;
+	uint m;
+
+	s = m68ki_drc_load(&in->src, size, NULL);
+	d = m68ki_drc_load(&in->dst, size, in->dst.mode != EA_D && op != DRC_CMP ? &addr : NULL);
+
+	if(op == DRC_AND || op == DRC_OR || op == DRC_EOR)
+	{
+		r = in->dst.mode == EA_D && size == 4 ? R_REG(in->dst.reg) : m68ki_drc_temp();
+		EMIT(op == DRC_AND ? AND(r, s, d) : op == DRC_OR ? OR(r, s, d) : XOR(r, s, d));
+		m68ki_drc_flags_logic(r, size, live);
+		m68ki_drc_put(&in->dst, size, r, addr);
+		m68ki_drc_set_fuse(FUSE_LOGIC, size, r, 0);
+		return;
+	}
+
+	/* Straight into Dn when nothing needs the operands after */
+	if(op == DRC_ADD && in->dst.mode == EA_D && size == 4 && !(live & (F_V | F_C | F_X)))
+		r = R_REG(in->dst.reg);
+	else if(op == DRC_SUB && in->dst.mode == EA_D && size == 4 && !(live & (F_V | F_C | F_X)))
+		r = R_REG(in->dst.reg);
+	else
+		r = m68ki_drc_temp();
+
+	if(op == DRC_ADD)
+		EMIT(size == 4 && (live & (F_C | F_X)) ? ADDC(r, s, d) : ADD(r, s, d));
+	else
+		EMIT(size == 4 && (live & (F_C | F_X)) ? SUBFC(r, s, d) : SUBF(r, s, d));
+
+	m = r;
+	if(size < 4)
+	{
+		m = m68ki_drc_temp();
+		EMIT(CLRLWI(m, r, 32 - size * 8));
+	}
+	m68ki_drc_flags_arith(op != DRC_ADD, s, d, r, m, size, live);
+
+	if(op == DRC_CMP)
+	{
+		m68ki_drc_set_fuse(FUSE_CMP, size, d, s);
+		return;
+	}
+	m68ki_drc_put(&in->dst, size, m, addr);
+	m68ki_drc_set_fuse(FUSE_ARITH, size, m, 0);
+}
+
+static void m68ki_drc_shift(m68ki_drc_insn* in)
+{
+	uint size = in->size;
+	uint bits = size * 8;
+	uint live = in->live & in->def;
+	uint kind = in->shift & 3;
+	uint left = in->shift & 4;
+	uint count = in->shift >> 8;
+	uint dn = R_REG(in->dst.reg);
+	uint src = dn;
+	uint m = m68ki_drc_temp();
+	uint t;
+
+	if(size < 4)
+	{
+		src = m68ki_drc_temp();
+		EMIT(CLRLWI(src, dn, 32 - bits));
+	}
+
+	if(kind == SHIFT_RO)
+	{
+		/* Rotate a register holding the value twice, at both ends */
+		t = src;
+		if(size < 4)
+		{
+			t = m68ki_drc_temp();
+			EMIT(RLWINM(t, src, 32 - bits, 0, bits - 1));
+			EMIT(OR(t, t, src));
+		}
+		EMIT(RLWINM(m, t, left ? count : bits - count, 32 - bits, 31));
+		if(live & F_C)
+		{
+			if(left)
+				EMIT(RLWINM(11, m, 8, 23, 23));
+			else
+				EMIT(RLWINM(11, src, 9 - count, 23, 23));
+		}
+	}
+	else
+	{
+		if(count == bits && (left || kind == SHIFT_LS))
+			EMIT(LI(m, 0));		/* ASL.B, LSL.B, LSR.B #8 */
+		else if(left)
+			EMIT(RLWINM(m, src, count, 32 - bits, 31 - count));
+		else if(kind == SHIFT_LS)
+			EMIT(RLWINM(m, src, 32 - count, 32 - bits + count, 31));
+		else if(size == 4)
+			EMIT(SRAWI(m, src, count));
+		else
+		{
+			EMIT(RLWINM(m, src, 32 - bits, 0, bits - 1));
+			EMIT(SRAWI(m, m, count));
+			EMIT(RLWINM(m, m, bits, 32 - bits, 31));
+		}
+		if(live & (F_C | F_X))
+			EMIT(RLWINM(11, src, left ? 8 - bits + count : 9 - count, 23, 23));
+	}
+
+	m68ki_drc_flags_nz(m, size, live);
+	if(live & F_V)
+	{
+		if(kind == SHIFT_AS && left)
+		{
+			/* Set when the top count + 1 bits weren't all the same */
+			if(size < 4)
+				EMIT(RLWINM(12, src, 32 - bits, 0, bits - 1));
+			else
+				EMIT(MR(12, src));
+			EMIT(SRAWI(12, 12, 31 - count));
+			EMIT(ADDI(12, 12, 1));
+			EMIT(RLWINM(12, 12, 0, 0, 30));
+			EMIT(CNTLZW(12, 12));
+			EMIT(RLWINM(12, 12, 2, 24, 24));
+			EMIT(XORI(12, 12, 0x80));
+		}
+		else
+			EMIT(LI(12, 0));
+		m68ki_drc_flag(12, CPU(v_flag));
+	}
+	if(live & F_C)
+		m68ki_drc_flag(11, CPU(c_flag));
+	if((live & F_X) && kind != SHIFT_RO)
+		m68ki_drc_flag(11, CPU(x_flag));
+
+	m68ki_drc_put(&in->dst, size, m, 0);
+	m68ki_drc_set_fuse(FUSE_ARITH, size, m, 0);
+}
+
+static void m68ki_drc_bitop(m68ki_drc_insn* in)
+{
+	uint live = in->live & in->def;
+	uint addr = 0;
+	uint bit = 0;
+	uint d;
+	uint t;
+
+	d = m68ki_drc_load(&in->dst, in->size, in->dst.mode != EA_D && in->op != DRC_BTST ? &addr : NULL);
+	if(in->dst.mode == EA_D)
+		d = R_REG(in->dst.reg);
+
+	t = m68ki_drc_temp();
+	if(in->src.mode == EA_IMM)
+	{
+		bit = in->src.value & (in->size == 4 ? 31 : 7);
+		EMIT(RLWINM(t, d, 0, 31 - bit, 31 - bit));
+	}
+	else
+	{
+		EMIT(RLWINM(12, R_REG(in->src.reg), 0, in->size == 4 ? 27 : 29, 31));
+		EMIT(LI(0, 1));
+		EMIT(SLW(12, 0, 12));
+		EMIT(AND(t, d, 12));
+	}
+	if(live & F_Z)
+		m68ki_drc_flag(t, CPU(not_z_flag));
+
+	if(in->op == DRC_BTST)
+		return;
+	if(in->src.mode == EA_IMM)
+	{
+		switch(in->op)
+		{
+			case DRC_BCHG:
+				EMIT(bit < 16 ? XORI(d, d, 1 << bit) : XORIS(d, d, 1 << (bit - 16)));
+				break;
+			case DRC_BSET:
+				EMIT(bit < 16 ? ORI(d, d, 1 << bit) : ORIS(d, d, 1 << (bit - 16)));
+				break;
+			default:
+				EMIT(RLWINM(d, d, 0, 32 - bit, 30 - bit));
+				break;
+		}
+	}
+	else
+		EMIT(in->op == DRC_BCHG ? XOR(d, d, 12) : in->op == DRC_BSET ? OR(d, d, 12) : ANDC(d, d, 12));
+
+	if(in->dst.mode != EA_D)
+		m68ki_drc_write(addr, d, 1);
+}
+
+/* Push a register on the 68000 stack */
+static void m68ki_drc_push(uint value)
+{
+	EMIT(ADDI(R_SP, R_SP, -4));
+	m68ki_drc_write(R_SP, value, 4);
+}
+
+/* Translate one instruction, k cycles into the block */
+static void m68ki_drc_emit_insn(m68ki_drc_insn* in, const m68ki_drc_fuse* f)
+{
+	uint size = in->size;
+	uint live = in->live & in->def;
+	uint total = m68ki_drc_k + in->cycles;
+	uint addr = 0;
+	uint cond;
+	uint* at;
+	uint* out;
+	uint s;
+	uint t;
+
+	m68ki_drc_in = in;
+	m68ki_drc_stop_pc = in->next;
+	m68ki_drc_stop_reg = -1;
+
+	switch(in->op)
+	{
+		case DRC_MOVE:
+			s = m68ki_drc_load(&in->src, size, NULL);
+			if(in->src.mode == EA_A && (in->dst.mode == EA_PI || in->dst.mode == EA_PD) && in->src.reg == in->dst.reg)
+				s = m68ki_drc_copy(s);
+			if(in->dst.mode != EA_D)
+				addr = m68ki_drc_address(&in->dst, size);
+			m68ki_drc_flags_logic(s, size, live);
+			m68ki_drc_put(&in->dst, size, s, addr);
+			m68ki_drc_set_fuse(FUSE_LOGIC, size, s, 0);
+			break;
+
+		case DRC_MOVEA:
+			s = m68ki_drc_load(&in->src, size, NULL);
+			if(size == 2)
+				EMIT(EXTSH(R_REG(in->dst.reg), s));
+			else if(s != R_REG(in->dst.reg))
+				EMIT(MR(R_REG(in->dst.reg), s));
+			break;
+
+		case DRC_MOVEQ:
+			m68ki_drc_li(R_REG(in->dst.reg), in->src.value);
+			m68ki_drc_flags_logic(R_REG(in->dst.reg), 4, live);
+			m68ki_drc_set_fuse(FUSE_LOGIC, 4, R_REG(in->dst.reg), 0);
+			break;
+
+		case DRC_LEA:
+			if(in->src.mode == EA_DI)
+				EMIT(ADDI(R_REG(in->dst.reg), R_REG(in->src.reg), in->src.disp));
+			else if(in->src.mode == EA_ABS)
+				m68ki_drc_li(R_REG(in->dst.reg), in->src.value);
+			else
+			{
+				s = m68ki_drc_address(&in->src, 4);
+				if(s != R_REG(in->dst.reg))
+					EMIT(MR(R_REG(in->dst.reg), s));
+			}
+			break;
+
+		case DRC_PEA:
+			s = m68ki_drc_address(&in->src, 4);
+			if(s == R_SP)
+				s = m68ki_drc_copy(s);
+			m68ki_drc_push(s);
+			break;
+
+		case DRC_CLR:
+			if(in->dst.mode != EA_D)
+				addr = m68ki_drc_address(&in->dst, size);
+			if(live)
+			{
+				EMIT(LI(0, 0));
+				if(live & F_N)
+					m68ki_drc_flag(0, CPU(n_flag));
+				if(live & F_Z)
+					m68ki_drc_flag(0, CPU(not_z_flag));
+				if(live & F_V)
+					m68ki_drc_flag(0, CPU(v_flag));
+				if(live & F_C)
+					m68ki_drc_flag(0, CPU(c_flag));
+			}
+			if(in->dst.mode == EA_D)
+			{
+				if(size == 4)
+					EMIT(LI(R_REG(in->dst.reg), 0));
+				else
+					EMIT(RLWINM(R_REG(in->dst.reg), R_REG(in->dst.reg), 0, 0, 31 - size * 8));
+				break;
+			}
+			t = m68ki_drc_temp();
+			EMIT(LI(t, 0));
+			m68ki_drc_write(addr, t, size);
+			break;
+
+		case DRC_TST:
+			s = m68ki_drc_load(&in->src, size, NULL);
+			m68ki_drc_flags_logic(s, size, live);
+			m68ki_drc_set_fuse(FUSE_LOGIC, size, s, 0);
+			break;
+
+		case DRC_NOT:
+			s = m68ki_drc_load(&in->dst, size, in->dst.mode != EA_D ? &addr : NULL);
+			t = m68ki_drc_temp();
+			EMIT(NOR(t, s, s));
+			if(size < 4)
+				EMIT(CLRLWI(t, t, 32 - size * 8));
+			m68ki_drc_flags_logic(t, size, live);
+			m68ki_drc_put(&in->dst, size, t, addr);
+			m68ki_drc_set_fuse(FUSE_LOGIC, size, t, 0);
+			break;
+
+		case DRC_NEG:
+			s = m68ki_drc_load(&in->dst, size, in->dst.mode != EA_D ? &addr : NULL);
+			t = m68ki_drc_temp();
+			if(size == 4)
+			{
+				EMIT(LI(0, 0));
+				EMIT(SUBFC(t, s, 0));
+				m68ki_drc_flags_arith(1, s, 0, t, t, size, live);
+				m68ki_drc_put(&in->dst, size, t, addr);
+				m68ki_drc_set_fuse(FUSE_ARITH, size, t, 0);
+				break;
+			}
+			/* A subtraction from 0, in r0 */
+			EMIT(NEG(t, s));
+			cond = m68ki_drc_temp();
+			EMIT(CLRLWI(cond, t, 32 - size * 8));
+			EMIT(LI(0, 0));
+			m68ki_drc_flags_arith(1, s, 0, t, cond, size, live);
+			m68ki_drc_put(&in->dst, size, cond, addr);
+			m68ki_drc_set_fuse(FUSE_ARITH, size, cond, 0);
+			break;
+
+		case DRC_EXT:
+			s = R_REG(in->dst.reg);
+			if(size == 2)
+			{
+				t = m68ki_drc_temp();
+				EMIT(EXTSB(t, s));
+				EMIT(RLWIMI(s, t, 0, 16, 31));
+				EMIT(CLRLWI(t, t, 16));
+				s = t;
+			}
+			else
+				EMIT(EXTSH(s, s));
+			m68ki_drc_flags_logic(s, size, live);
+			m68ki_drc_set_fuse(FUSE_LOGIC, size, s, 0);
+			break;
+
+		case DRC_SWAP:
+			s = R_REG(in->dst.reg);
+			EMIT(RLWINM(s, s, 16, 0, 31));
+			m68ki_drc_flags_logic(s, 4, live);
+			m68ki_drc_set_fuse(FUSE_LOGIC, 4, s, 0);
+			break;
+
+		case DRC_ADD:
+		case DRC_SUB:
+		case DRC_CMP:
+		case DRC_AND:
+		case DRC_OR:
+		case DRC_EOR:
+			m68ki_drc_alu(in);
+			break;
+
+		case DRC_ADDA:
+		case DRC_SUBA:
+		case DRC_CMPA:
+			t = R_REG(in->dst.reg);
+			if(in->src.mode == EA_IMM && in->op != DRC_CMPA)
+			{
+				s = size == 2 ? (uint)MAKE_INT_16(in->src.value) : in->src.value;
+				if(in->op == DRC_SUBA)
+					s = -s;
+				if((sint)s == (sint)MAKE_INT_16(s))
+				{
+					EMIT(ADDI(t, t, s));
+					break;
+				}
+			}
+			s = m68ki_drc_load(&in->src, size, NULL);
+			if(size == 2)
+			{
+				s = m68ki_drc_copy(s);
+				EMIT(EXTSH(s, s));
+			}
+			if(in->op == DRC_ADDA)
+				EMIT(ADD(t, t, s));
+			else if(in->op == DRC_SUBA)
+				EMIT(SUBF(t, s, t));
+			else
+			{
+				addr = m68ki_drc_temp();
+				EMIT(live & F_C ? SUBFC(addr, s, t) : SUBF(addr, s, t));
+				m68ki_drc_flags_arith(1, s, t, addr, addr, 4, live);
+				m68ki_drc_free(addr);
+				m68ki_drc_set_fuse(FUSE_CMP, 4, t, s);
+			}
+			break;
+
+		case DRC_MULU:
+		case DRC_MULS:
+			s = m68ki_drc_load(&in->src, 2, NULL);
+			t = m68ki_drc_temp();
+			if(in->op == DRC_MULS)
+			{
+				s = m68ki_drc_copy(s);
+				EMIT(EXTSH(s, s));
+				EMIT(EXTSH(t, R_REG(in->dst.reg)));
+			}
+			else
+				EMIT(CLRLWI(t, R_REG(in->dst.reg), 16));
+			EMIT(MULLW(R_REG(in->dst.reg), s, t));
+			m68ki_drc_flags_logic(R_REG(in->dst.reg), 4, live);
+			m68ki_drc_set_fuse(FUSE_LOGIC, 4, R_REG(in->dst.reg), 0);
+			break;
+
+		case DRC_SHIFT:
+			m68ki_drc_shift(in);
+			break;
+
+		case DRC_BTST:
+		case DRC_BCHG:
+		case DRC_BCLR:
+		case DRC_BSET:
+			m68ki_drc_bitop(in);
+			break;
+
+		case DRC_SCC:
+			/* Before -(An) changes a register the compare may use */
+			cond = m68ki_drc_cond(in->cc, f);
+			if(in->dst.mode != EA_D)
+				addr = m68ki_drc_address(&in->dst, 1);
+			if(in->dst.mode == EA_D)
+			{
+				s = R_REG(in->dst.reg);
+				if(cond == COND_ALWAYS)
+					EMIT(ORI(s, s, 0xff));
+				else if(cond == COND_NEVER)
+					EMIT(RLWINM(s, s, 0, 0, 23));
+				else
+				{
+					EMIT(LI(0, 0));
+					at = m68ki_drc_branch(cond, 0);
+					EMIT(LI(0, 0xff));
+					m68ki_drc_land(at);
+					EMIT(RLWIMI(s, 0, 0, 24, 31));
+				}
+				break;
+			}
+			t = m68ki_drc_temp();
+			if(cond == COND_ALWAYS || cond == COND_NEVER)
+				EMIT(LI(t, cond == COND_ALWAYS ? 0xff : 0));
+			else
+			{
+				EMIT(LI(t, 0));
+				at = m68ki_drc_branch(cond, 0);
+				EMIT(LI(t, 0xff));
+				m68ki_drc_land(at);
+			}
+			m68ki_drc_write(addr, t, 1);
+			break;
+
+		case DRC_BCC:
+			if(in->cc == 0 && in->target == in->pc)
+			{
+				m68ki_drc_exit_self(in->pc, in->cycles);
+				break;
+			}
+			cond = m68ki_drc_cond(in->cc, f);
+			if(cond == COND_ALWAYS)
+			{
+				m68ki_drc_exit_static(in->target, total);
+				break;
+			}
+			s = total + (sint)(in->size ? CYC_BCC_NOTAKE_W : CYC_BCC_NOTAKE_B);
+			if(cond == COND_NEVER)
+			{
+				m68ki_drc_exit_static(in->next, s);
+				break;
+			}
+			at = m68ki_drc_branch(cond, 1);
+			m68ki_drc_exit_static(in->next, s);
+			m68ki_drc_land(at);
+			m68ki_drc_exit_static(in->target, total);
+			break;
+
+		case DRC_BSR:
+			t = m68ki_drc_temp();
+			m68ki_drc_li(t, in->next);
+			m68ki_drc_stop_pc = in->target;
+			m68ki_drc_push(t);
+			m68ki_drc_exit_static(in->target, total);
+			break;
+
+		case DRC_DBCC:
+			out = NULL;
+			if(in->cc != 1)
+			{
+				cond = m68ki_drc_cond(in->cc, f);
+				if(cond == COND_ALWAYS)
+				{
+					m68ki_drc_exit_static(in->next, total);
+					break;
+				}
+				if(cond != COND_NEVER)
+					out = m68ki_drc_branch(cond, 1);
+			}
+			s = R_REG(in->dst.reg);
+			EMIT(ADDI(12, s, -1));
+			EMIT(RLWIMI(s, 12, 0, 16, 31));
+			EMIT(CLRLWI(12, 12, 16));
+			EMIT(CMPLWI(12, 0xffff));
+			at = m68ki_drc_bc(BO_TRUE, BI_EQ);
+			m68ki_drc_exit_static(in->target, total + (in->cc != 1 ? (sint)CYC_DBCC_F_NOEXP : 0));
+			m68ki_drc_land(at);
+			m68ki_drc_exit_static(in->next, total + (in->cc != 1 ? (sint)CYC_DBCC_F_EXP : 0));
+			if(out)
+			{
+				m68ki_drc_land(out);
+				m68ki_drc_exit_static(in->next, total);
+			}
+			break;
+
+		case DRC_JMP:
+		case DRC_JSR:
+			if(in->src.mode == EA_ABS)
+			{
+				if(in->op == DRC_JSR)
+				{
+					t = m68ki_drc_temp();
+					m68ki_drc_li(t, in->next);
+					m68ki_drc_stop_pc = in->src.value;
+					m68ki_drc_push(t);
+				}
+				else if(in->src.value == in->pc)
+				{
+					m68ki_drc_exit_self(in->pc, in->cycles);
+					break;
+				}
+				m68ki_drc_exit_static(in->src.value, total);
+				break;
+			}
+			s = m68ki_drc_copy(m68ki_drc_address(&in->src, 4));
+			if(in->op == DRC_JSR)
+			{
+				t = m68ki_drc_temp();
+				m68ki_drc_li(t, in->next);
+				m68ki_drc_stop_reg = s;
+				m68ki_drc_push(t);
+			}
+			else
+			{
+				m68ki_drc_li(12, in->pc);
+				EMIT(CMPLW(s, 12));
+				at = m68ki_drc_bc(BO_FALSE, BI_EQ);
+				EMIT(MR(3, s));
+				EMIT(LI(4, -(sint)in->cycles));
+				EMIT(STW(4, STATE(cycles), R_STATE));
+				EMIT(LI(4, 0));
+				m68ki_drc_jump(m68ki_drc_exit, 0);
+				m68ki_drc_land(at);
+			}
+			m68ki_drc_exit_dynamic(s, total);
+			break;
+
+		case DRC_RTS:
+			t = m68ki_drc_temp();
+			m68ki_drc_read(t, R_SP, 4);
+			EMIT(ADDI(R_SP, R_SP, 4));
+			m68ki_drc_exit_dynamic(t, total);
+			break;
+
+		case DRC_NOP:
+			break;
+
+		default:
+			/* Through the interpreter, leaving when it didn't go on to next */
+			m68ki_drc_li(3, in->pc);
+			m68ki_drc_li(4, in->next ? in->next : 1);
+			m68ki_drc_li(5, m68ki_drc_k);
+			m68ki_drc_jump(m68ki_drc_interp, 1);
+			if(in->next)
+			{
+				EMIT(CMPWI(3, 0));
+				at = m68ki_drc_bc(BO_TRUE, BI_EQ);
+				m68ki_drc_exit_dynamic(0, total);
+				m68ki_drc_land(at);
+			}
+			else
+				m68ki_drc_exit_dynamic(0, total);
+			break;
+	}
+}
+
+/* Translate the decoded block */
+static void m68ki_drc_emit_block(uint count)
+{
+	m68ki_drc_fuse f;
+	m68ki_drc_insn* in;
+	uint i;
+
+	m68ki_drc_k = 0;
+	m68ki_drc_num_slows = 0;
+	m68ki_drc_temps = 0;
+	m68ki_drc_fused.kind = FUSE_NONE;
+
+	for(i = 0; i < count; i++)
+	{
+		in = &m68ki_drc_insns[i];
+
+		/* Only the instruction right after may use the compare */
+		f = m68ki_drc_fused;
+		m68ki_drc_fused.kind = FUSE_NONE;
+		m68ki_drc_temps = 0;
+		if(f.kind != FUSE_NONE)
+		{
+			m68ki_drc_temps |= f.a >= R_TEMP && f.a < R_TEMP + R_TEMPS ? 1 << (f.a - R_TEMP) : 0;
+			if(f.kind == FUSE_CMP)
+				m68ki_drc_temps |= f.b >= R_TEMP && f.b < R_TEMP + R_TEMPS ? 1 << (f.b - R_TEMP) : 0;
+		}
+
+		m68ki_drc_emit_insn(in, &f);
+		m68ki_drc_k += in->cycles;
+
+		/* Keep a fused result safe from the next instruction's writes */
+		if(m68ki_drc_fused.kind != FUSE_NONE && i + 1 < count)
+		{
+			uint use = m68ki_drc_insns[i + 1].op;
+
+			if(use != DRC_BCC && use != DRC_DBCC && use != DRC_SCC)
+				m68ki_drc_fused.kind = FUSE_NONE;
+		}
+	}
+
+	/* Ran off the end of the block */
+	in = &m68ki_drc_insns[count - 1];
+	if(in->op != DRC_BCC && in->op != DRC_BSR && in->op != DRC_DBCC &&
+	   in->op != DRC_JMP && in->op != DRC_JSR && in->op != DRC_RTS &&
+	   (in->op != DRC_FALLBACK || in->next))
+		m68ki_drc_exit_static(in->next, m68ki_drc_k);
+
+	for(i = 0; i < m68ki_drc_num_slows; i++)
+		m68ki_drc_emit_slow(&m68ki_drc_slows[i]);
+}
+
+
+/* ======================================================================== */
+/* ============================== DISPATCHER ============================== */
+/* ======================================================================== */
+
+#define DRC_VALID(B) (!(B)->dead && (B)->gen == m68ki_bc_gen[(B)->page] \
+	&& (!(B)->span || (B)->span_gen == m68ki_bc_gen[(B)->page + 1]))
+
+/* Throw away every block */
+void m68ki_drc_flush(void)
+{
+	memset(m68ki_drc_hash, 0, sizeof(m68ki_drc_hash));
+	m68ki_drc_num_blocks = 0;
+	m68ki_drc_num_links = 0;
+	m68ki_drc_pending = NULL;
+	m68ki_drc_ptr = NULL;
+}
+
+/* Undo the links into blocks whose code changed */
+static void m68ki_drc_sweep(void)
+{
+	m68ki_drc_block* block;
+	uint i;
+	int link;
+
+	for(i = 0; i < m68ki_drc_num_blocks; i++)
+	{
+		block = &m68ki_drc_blocks[i];
+		if(block->dead || DRC_VALID(block))
+			continue;
+		block->dead = 1;
+		for(link = block->in; link >= 0; link = m68ki_drc_links[link].next)
+		{
+			*m68ki_drc_links[link].site = NOP;
+			m68ki_drc_sync(m68ki_drc_links[link].site, 1);
+		}
+		block->in = -1;
+	}
+	m68ki_drc_pending = NULL;
+	m68ki_bc_stop = 0;
+}
+
+/* Patch a block's exit into a branch to the block it leads to */
+static void m68ki_drc_link_block(uint* site, m68ki_drc_block* block)
+{
+	m68ki_drc_link* link;
+
+	if(*site != NOP || m68ki_drc_num_links == DRC_LINKS)
+		return;
+	link = &m68ki_drc_links[m68ki_drc_num_links];
+	link->site = site;
+	link->next = block->in;
+	block->in = m68ki_drc_num_links++;
+	*site = B((uint)((char*)block->code - (char*)site));
+	m68ki_drc_sync(site, 1);
+}
+
+static m68ki_drc_block* m68ki_drc_find(uint pc)
+{
+	m68ki_drc_block* block;
+
+	for(block = m68ki_drc_hash[(pc >> 1) & (DRC_HASH - 1)]; block != NULL; block = block->next)
+		if(block->pc == pc && DRC_VALID(block))
+			return block;
+	return NULL;
+}
+
+static m68ki_drc_block* m68ki_drc_compile(uint pc)
+{
+	m68ki_drc_block* block;
+	uint count;
+	uint span;
+	uint page = DRC_PAGE(pc);
+
+	if((pc & 1) || !M68K_BLOCK_CACHE_RANGE(ADDRESS_68K(pc)))
+		return NULL;
+
+	count = m68ki_drc_decode(pc, &span);
+	if(!count)
+		return NULL;
+
+	if(m68ki_drc_num_blocks == DRC_BLOCKS ||
+	   (char*)m68ki_drc_ptr + DRC_BLOCK_ROOM > (char*)m68ki_drc_code + DRC_CODE_SIZE)
+	{
+		m68ki_drc_flush();
+		m68ki_drc_start();
+	}
+
+	block = &m68ki_drc_blocks[m68ki_drc_num_blocks++];
+	block->pc = pc;
+	block->page = page;
+	block->gen = m68ki_bc_gen[page];
+	block->span = span;
+	block->span_gen = m68ki_bc_gen[page + 1];
+	block->dead = 0;
+	block->in = -1;
+	block->code = m68ki_drc_ptr;
+
+	/* From here on, any write to the code ends the block and kills it */
+	m68k_cache_pages[page] = m68k_cache_pages[page + 1] = 1;
+
+	m68ki_drc_emit_block(count);
+	m68ki_drc_sync(block->code, m68ki_drc_ptr - block->code);
+
+	block->next = m68ki_drc_hash[(pc >> 1) & (DRC_HASH - 1)];
+	m68ki_drc_hash[(pc >> 1) & (DRC_HASH - 1)] = block;
+	return block;
+}
+
+/* Run one instruction the normal way */
+static void m68ki_drc_step(void)
+{
+	REG_PPC = REG_PC;
+	REG_IR = m68ki_read_imm_16();
+	m68ki_profile_instr(); /* auto-disable (see m68kcpu.h) */
+	m68ki_instruction_jump_table[REG_IR]();
+	USE_CYCLES(CYC_INSTRUCTION[REG_IR]);
+}
+
+/* Run the block at REG_PC, and whatever it is linked to, compiling it first
+ * if need be
+ */
+void m68ki_drc_execute(void)
+{
+	m68ki_drc_block* block;
+
+	if(m68ki_drc_ptr == NULL)
+		m68ki_drc_start();
+	if(m68ki_bc_stop)
+		m68ki_drc_sweep();
+
+	block = m68ki_drc_find(REG_PC);
+	if(block == NULL)
+	{
+		block = m68ki_drc_compile(REG_PC);
+		if(block == NULL)
+		{
+			m68ki_drc_pending = NULL;
+			m68ki_drc_step();
+			return;
+		}
+	}
+
+	if(m68ki_drc_pending != NULL && m68ki_drc_pending_pc == REG_PC)
+		m68ki_drc_link_block(m68ki_drc_pending, block);
+	m68ki_drc_pending = NULL;
+
+	m68ki_drc.cycles = GET_CYCLES();
+	m68ki_drc.link = 0;
+#if M68K_DRC_EMULATED
+	m68k_drc_run(DRC_HOST(m68ki_drc_enter), DRC_HOST(block->code));
+#else
+	((void (*)(uint*))m68ki_drc_enter)(block->code);
+#endif /* M68K_DRC_EMULATED */
+	SET_CYCLES(m68ki_drc.cycles);
+
+	if(m68ki_drc.link)
+	{
+		m68ki_drc_pending = m68ki_drc_code + m68ki_drc.link / 4;
+		m68ki_drc_pending_pc = REG_PC;
+	}
+
+	/* Interrupts a memory access raised were held back to here */
+	m68ki_check_interrupts();
+}
+
+void m68k_drc_enable(int enable)
+{
+	m68ki_drc_enabled = enable != 0;
+
+	/* Code may have changed while the cache consumed the news */
+	m68ki_bc_stop = 1;
+}
+
+void m68k_drc_map(unsigned int address, unsigned int size, void* host, int writable)
+{
+	uint base = host ? DRC_HOST(host) - address : 0;
+	uint bank;
+
+	for(bank = address >> 16; bank < (address + size) >> 16 && bank < DRC_BANKS; bank++)
+	{
+		m68ki_drc.read[bank] = base;
+		m68ki_drc.write[bank] = writable ? base : 0;
+	}
+
+	/* Constant address reads went straight to the old memory */
+	m68k_cache_flush();
+}
+
+#endif /* M68K_DRC */
+
+/* ======================================================================== */
+/* ============================== END OF FILE ============================= */
+/* ======================================================================== */
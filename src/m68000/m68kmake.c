@@ -84,6 +84,8 @@ const char* g_version = "3.3";
 #define EA_ALLOWED_LENGTH                11	/* Max length of ea allowed str */
 #define MAX_OPCODE_INPUT_TABLE_LENGTH  1000	/* Max length of opcode handler tbl */
 #define MAX_OPCODE_OUTPUT_TABLE_LENGTH 3000	/* Max length of opcode handler tbl */
+#define MAX_FLAG_TABLE_LENGTH          3000	/* Max length of flag handler tbl */
+#define MAX_HOT_TABLE_LENGTH            256	/* Max handlers taken from a profile */
 
 /* Default filenames */
 #define FILENAME_INPUT      "m68k_in.c"
@@ -192,6 +194,7 @@ typedef struct
 	const char* ea_add;
 	unsigned int mask_add;
 	unsigned int match_add;
+	int ram;	/* Usually reads the host's RAM, see M68K_FAST_RAM */
 } ea_info_struct;
 
 
@@ -203,6 +206,15 @@ typedef struct
 } body_struct;
 
 
+/* Flag information for an opcode handler (see M68K_DEAD_FLAGS in m68kconf.h) */
+typedef struct
+{
+	char name[MAX_NAME_LENGTH];           /* opcode handler name */
+	unsigned char nf;                     /* Has a _nf variant */
+	unsigned char kill;                   /* Overwrites N, Z, V and C before reading them */
+} flag_struct;
+
+
 /* Holds a sequence of search / replace strings */
 typedef struct
 {
@@ -225,7 +237,26 @@ opcode_struct* find_opcode(char* name, int size, char* spec_proc, char* spec_ea)
 opcode_struct* find_illegal_opcode(void);
 int extract_opcode_info(char* src, char* name, int* size, char* spec_proc, char* spec_ea);
 void add_replace_string(replace_struct* replace, const char* search_str, const char* replace_str);
-void write_body(FILE* filep, body_struct* body, replace_struct* replace);
+void expand_body(body_struct* output, body_struct* body, replace_struct* replace);
+void write_body(FILE* filep, body_struct* body);
+int flag_token(const char* line, const char* ptr);
+int flags_read(const char* str);
+int flag_assignment(const char* line, const char** rhs);
+int side_effect_free(const char* str);
+int strip_dead_flags(body_struct* output, body_struct* body);
+int uses_name(const char* str, const char* name);
+int local_declaration(const char* line, char* name, const char** rhs);
+void strip_unused_locals(body_struct* body);
+int kills_flags(body_struct* body);
+int replace_all(char* line, const char* search_str, const char* replace_str);
+int fast_ram_reads(body_struct* body);
+void add_flag_table_entry(char* name, int nf, int kill);
+void print_flag_table(FILE* filep);
+void add_ram_table_entry(char* name);
+void print_ram_table(FILE* filep);
+void print_name_table(FILE* filep);
+void read_profile(char* filename);
+void print_hot_table(FILE* filep);
 void get_base_name(char* base_name, opcode_struct* op);
 void write_prototype(FILE* filep, char* base_name);
 void write_function_name(FILE* filep, char* base_name);
@@ -250,6 +281,9 @@ void read_insert(char* insert);
 /* Name of the input file */
 char g_input_filename[M68K_MAX_PATH] = FILENAME_INPUT;
 
+/* Optional handler profile, used to order the dispatch table */
+char g_profile_filename[M68K_MAX_PATH] = "";
+
 /* File handles */
 FILE* g_input_file = NULL;
 FILE* g_prototype_file = NULL;
@@ -268,21 +302,33 @@ opcode_struct g_opcode_input_table[MAX_OPCODE_INPUT_TABLE_LENGTH];
 opcode_struct g_opcode_output_table[MAX_OPCODE_OUTPUT_TABLE_LENGTH];
 int g_opcode_output_table_length = 0;
 
+/* Flag information table */
+flag_struct g_flag_table[MAX_FLAG_TABLE_LENGTH];
+int g_flag_table_length = 0;
+
+/* Handlers named in the profile, busiest first */
+char g_hot_table[MAX_HOT_TABLE_LENGTH][MAX_NAME_LENGTH];
+int g_hot_table_length = 0;
+
+/* Handlers using m68ki_read_ram_xx() */
+char g_ram_table[MAX_OPCODE_OUTPUT_TABLE_LENGTH][MAX_NAME_LENGTH];
+int g_ram_table_length = 0;
+
 ea_info_struct g_ea_info_table[13] =
-{/* fname    ea        mask  match */
-	{"",     "",       0x00, 0x00}, /* EA_MODE_NONE */
-	{"ai",   "AY_AI",  0x38, 0x10}, /* EA_MODE_AI   */
-	{"pi",   "AY_PI",  0x38, 0x18}, /* EA_MODE_PI   */
-	{"pi7",  "A7_PI",  0x3f, 0x1f}, /* EA_MODE_PI7  */
-	{"pd",   "AY_PD",  0x38, 0x20}, /* EA_MODE_PD   */
-	{"pd7",  "A7_PD",  0x3f, 0x27}, /* EA_MODE_PD7  */
-	{"di",   "AY_DI",  0x38, 0x28}, /* EA_MODE_DI   */
-	{"ix",   "AY_IX",  0x38, 0x30}, /* EA_MODE_IX   */
-	{"aw",   "AW",     0x3f, 0x38}, /* EA_MODE_AW   */
-	{"al",   "AL",     0x3f, 0x39}, /* EA_MODE_AL   */
-	{"pcdi", "PCDI",   0x3f, 0x3a}, /* EA_MODE_PCDI */
-	{"pcix", "PCIX",   0x3f, 0x3b}, /* EA_MODE_PCIX */
-	{"i",    "I",      0x3f, 0x3c}, /* EA_MODE_I    */
+{/* fname    ea        mask  match ram */
+	{"",     "",       0x00, 0x00, 0}, /* EA_MODE_NONE */
+	{"ai",   "AY_AI",  0x38, 0x10, 0}, /* EA_MODE_AI   */
+	{"pi",   "AY_PI",  0x38, 0x18, 0}, /* EA_MODE_PI   */
+	{"pi7",  "A7_PI",  0x3f, 0x1f, 0}, /* EA_MODE_PI7  */
+	{"pd",   "AY_PD",  0x38, 0x20, 0}, /* EA_MODE_PD   */
+	{"pd7",  "A7_PD",  0x3f, 0x27, 0}, /* EA_MODE_PD7  */
+	{"di",   "AY_DI",  0x38, 0x28, 0}, /* EA_MODE_DI   */
+	{"ix",   "AY_IX",  0x38, 0x30, 0}, /* EA_MODE_IX   */
+	{"aw",   "AW",     0x3f, 0x38, 1}, /* EA_MODE_AW   */
+	{"al",   "AL",     0x3f, 0x39, 1}, /* EA_MODE_AL   */
+	{"pcdi", "PCDI",   0x3f, 0x3a, 1}, /* EA_MODE_PCDI */
+	{"pcix", "PCIX",   0x3f, 0x3b, 1}, /* EA_MODE_PCIX */
+	{"i",    "I",      0x3f, 0x3c, 0}, /* EA_MODE_I    */
 };
 
 
@@ -714,27 +760,26 @@ void add_replace_string(replace_struct* replace, const char* search_str, const c
 	strcpy(replace->replace[replace->length++][1], replace_str);
 }
 
-/* Write a function body while replacing any selected strings */
-void write_body(FILE* filep, body_struct* body, replace_struct* replace)
+/* Expand a function body, replacing any selected strings */
+void expand_body(body_struct* output, body_struct* body, replace_struct* replace)
 {
 	int i;
 	int j;
 	char* ptr;
-	char output[MAX_LINE_LENGTH+1];
 	char temp_buff[MAX_LINE_LENGTH+1];
 	int found;
 
 	for(i=0;i<body->length;i++)
 	{
-		strcpy(output, body->body[i]);
+		strcpy(output->body[i], body->body[i]);
 		/* Check for the base directive header */
-		if(strstr(output, ID_BASE) != NULL)
+		if(strstr(output->body[i], ID_BASE) != NULL)
 		{
 			/* Search for any text we need to replace */
 			found = 0;
 			for(j=0;j<replace->length;j++)
 			{
-				ptr = strstr(output, replace->replace[j][0]);
+				ptr = strstr(output->body[i], replace->replace[j][0]);
 				if(ptr)
 				{
 					/* We found something to replace */
@@ -748,11 +793,527 @@ void write_body(FILE* filep, body_struct* body, replace_struct* replace)
 			if(!found)
 				error_exit("Unknown " ID_BASE " directive");
 		}
-		fprintf(filep, "%s\n", output);
 	}
+	output->length = body->length;
+}
+
+/* Write an expanded function body */
+void write_body(FILE* filep, body_struct* body)
+{
+	int i;
+
+	for(i=0;i<body->length;i++)
+		fprintf(filep, "%s\n", body->body[i]);
 	fprintf(filep, "\n\n");
 }
 
+
+/* Replace every occurrence of a string in a line, returns the count */
+int replace_all(char* line, const char* search_str, const char* replace_str)
+{
+	char temp_buff[MAX_LINE_LENGTH+1];
+	char* ptr = line;
+	int count = 0;
+
+	while((ptr = strstr(ptr, search_str)) != NULL)
+	{
+		if(strlen(line) - strlen(search_str) + strlen(replace_str) > MAX_LINE_LENGTH)
+			error_exit("Line too long after replacing %s", search_str);
+		strcpy(temp_buff, ptr+strlen(search_str));
+		strcpy(ptr, replace_str);
+		strcat(ptr, temp_buff);
+		ptr += strlen(replace_str);
+		count++;
+	}
+	return count;
+}
+
+/* Send reads through the addressing modes that usually hit the host's RAM
+ * to m68ki_read_ram_xx(), which tries the RAM inline before falling back to
+ * the memory handlers (see M68K_FAST_RAM in m68kconf.h).
+ */
+int fast_ram_reads(body_struct* body)
+{
+	static const char* const sizes[] = {"8", "16", "32"};
+	char search[MAX_LINE_LENGTH+1];
+	char replace[MAX_LINE_LENGTH+1];
+	int ram_ea = 0;
+	int count = 0;
+	int mode;
+	int i;
+	int j;
+
+	for(i=0;i<body->length;i++)
+	{
+		for(mode=0;mode<(int)(sizeof(g_ea_info_table)/sizeof(g_ea_info_table[0]));mode++)
+		{
+			if(!g_ea_info_table[mode].ram)
+				continue;
+			for(j=0;j<3;j++)
+			{
+				sprintf(search, "OPER_%s_%s()", g_ea_info_table[mode].ea_add, sizes[j]);
+				sprintf(replace, "m68ki_read_ram_%s(EA_%s_%s())", sizes[j], g_ea_info_table[mode].ea_add, sizes[j]);
+				count += replace_all(body->body[i], search, replace);
+
+				sprintf(search, "EA_%s_%s()", g_ea_info_table[mode].ea_add, sizes[j]);
+				if(strstr(body->body[i], search) && !strstr(body->body[i], "m68ki_read_ram_"))
+					ram_ea = 1;
+			}
+		}
+	}
+
+	/* Memory operands addressed the same way */
+	if(!ram_ea)
+		return count;
+	for(i=0;i<body->length;i++)
+	{
+		for(j=0;j<3;j++)
+		{
+			sprintf(search, "m68ki_read_%s(", sizes[j]);
+			sprintf(replace, "m68ki_read_ram_%s(", sizes[j]);
+			count += replace_all(body->body[i], search, replace);
+		}
+	}
+	return count;
+}
+
+
+/* ------------------------------------------------------------------------ */
+/* Flag analysis for M68K_DEAD_FLAGS.
+ * This works on the text of the expanded handlers, so it is deliberately
+ * conservative: anything it doesn't fully understand counts as reading the
+ * flags.
+ */
+
+#define FLAG_BIT_N    1
+#define FLAG_BIT_Z    2
+#define FLAG_BIT_V    4
+#define FLAG_BIT_C    8
+#define FLAG_BIT_X    16
+#define FLAG_BITS_NZVC (FLAG_BIT_N | FLAG_BIT_Z | FLAG_BIT_V | FLAG_BIT_C)
+
+/* Which flag the FLAG_x token at ptr names, or 0 if there isn't one */
+int flag_token(const char* line, const char* ptr)
+{
+	if(ptr > line && (isalnum((unsigned char)ptr[-1]) || ptr[-1] == '_'))
+		return 0;
+	if(strncmp(ptr, "FLAG_", 5) != 0 || ptr[5] == 0)
+		return 0;
+	if(isalnum((unsigned char)ptr[6]) || ptr[6] == '_')
+		return 0;
+	switch(ptr[5])
+	{
+		case 'N': return FLAG_BIT_N;
+		case 'Z': return FLAG_BIT_Z;
+		case 'V': return FLAG_BIT_V;
+		case 'C': return FLAG_BIT_C;
+		case 'X': return FLAG_BIT_X;
+	}
+	return 0;
+}
+
+/* Flags read by a piece of code, including through macros and functions */
+int flags_read(const char* str)
+{
+	const char* ptr;
+	int mask = 0;
+
+	for(ptr = str;*ptr;ptr++)
+		mask |= flag_token(str, ptr);
+
+	if(strstr(str, "COND_") || strstr(str, "FLAG_AS_1") ||
+		strstr(str, "m68ki_get_") || strstr(str, "m68ki_exception") ||
+		strstr(str, "m68ki_init_exception") || strstr(str, "m68ki_stack_frame"))
+		mask |= FLAG_BITS_NZVC | FLAG_BIT_X;
+
+	return mask;
+}
+
+/* If line is "FLAG_a = FLAG_b = ... = expr;" with a side effect free expr,
+ * return the flags assigned and point rhs at expr.  Otherwise return 0.
+ */
+int flag_assignment(const char* line, const char** rhs)
+{
+	const char* ptr = line;
+	const char* end;
+	int mask = 0;
+	int bit;
+
+	while(*ptr == '\t' || *ptr == ' ')
+		ptr++;
+
+	for(;;)
+	{
+		const char* next;
+
+		bit = flag_token(line, ptr);
+		if(!bit)
+			break;
+		next = ptr + 6;
+		while(*next == ' ')
+			next++;
+		if(*next != '=' || next[1] == '=')
+			break;
+		mask |= bit;
+		ptr = next + 1;
+		while(*ptr == ' ')
+			ptr++;
+	}
+
+	if(!mask)
+		return 0;
+
+	/* One complete statement */
+	end = strchr(ptr, ';');
+	if(end == NULL || end[1] != 0)
+		return 0;
+
+	if(!side_effect_free(ptr))
+		return 0;
+
+	*rhs = ptr;
+	return mask;
+}
+
+/* No calls, memory accesses or assignments in str */
+int side_effect_free(const char* str)
+{
+	const char* end;
+
+	if(strstr(str, "++") || strstr(str, "--") || strstr(str, "OPER_") ||
+		strstr(str, "EA_") || strstr(str, "m68k"))
+		return 0;
+	for(end = str;*end;end++)
+	{
+		if(*end == '=' && end[1] != '=' && end > str &&
+			(!strchr("=!<>", end[-1]) || (end > str+1 && end[-2] == end[-1])))
+			return 0;
+		if(*end == '=' && end[1] == '=')
+			end++;
+	}
+	return 1;
+}
+
+/* Produce a copy of an expanded handler body that doesn't compute N, Z, V or
+ * C, for use when the next instruction overwrites them anyway.  Only plain
+ * flag assignments are removed, and only for flags the handler never reads.
+ * Returns 0 if there was nothing to remove.
+ */
+int strip_dead_flags(body_struct* output, body_struct* body)
+{
+	const char* rhs;
+	int read = 0;
+	int changed = 0;
+	int mask;
+	int keep;
+	int i;
+
+	for(i=0;i<body->length;i++)
+	{
+		if(flag_assignment(body->body[i], &rhs))
+			read |= flags_read(rhs);
+		else
+			read |= flags_read(body->body[i]);
+	}
+
+	output->length = 0;
+	for(i=0;i<body->length;i++)
+	{
+		char* line = output->body[output->length];
+
+		strcpy(line, body->body[i]);
+		output->length++;
+
+		mask = flag_assignment(body->body[i], &rhs);
+		keep = mask & (read | FLAG_BIT_X);
+		if(keep == mask)
+			continue;
+
+		changed = 1;
+		if(!keep)
+		{
+			/* Keep an empty statement if this was the body of an if or else */
+			const char* prev = body->body[i-1] + strlen(body->body[i-1]);
+			while(prev > body->body[i-1] && isspace((unsigned char)prev[-1]))
+				prev--;
+			if(prev == body->body[i-1] || strchr(";{}", prev[-1]))
+				output->length--;
+			else
+				strcpy(line + strspn(line, "\t "), ";");
+			continue;
+		}
+
+		/* Rewrite the assignment chain with the flags we keep */
+		line[strspn(line, "\t ")] = 0;
+		if(keep & FLAG_BIT_N) strcat(line, "FLAG_N = ");
+		if(keep & FLAG_BIT_Z) strcat(line, "FLAG_Z = ");
+		if(keep & FLAG_BIT_V) strcat(line, "FLAG_V = ");
+		if(keep & FLAG_BIT_C) strcat(line, "FLAG_C = ");
+		if(keep & FLAG_BIT_X) strcat(line, "FLAG_X = ");
+		strcat(line, rhs);
+	}
+
+	if(changed)
+		strip_unused_locals(output);
+
+	return changed;
+}
+
+/* Is name used as a whole word in str? */
+int uses_name(const char* str, const char* name)
+{
+	size_t len = strlen(name);
+	const char* ptr;
+
+	for(ptr = strstr(str, name);ptr;ptr = strstr(ptr+1, name))
+		if((ptr == str || !(isalnum((unsigned char)ptr[-1]) || ptr[-1] == '_')) &&
+			!(isalnum((unsigned char)ptr[len]) || ptr[len] == '_'))
+			return 1;
+	return 0;
+}
+
+/* If line is "type name = expr;" at the top of the body, copy name and
+ * point rhs at expr.  Otherwise return 0.
+ */
+int local_declaration(const char* line, char* name, const char** rhs)
+{
+	const char* ptr = line;
+	const char* start;
+
+	if(*ptr++ != '\t' || !(isalpha((unsigned char)*ptr) || *ptr == '_'))
+		return 0;
+	while(isalnum((unsigned char)*ptr) || *ptr == '_')
+		ptr++;
+	while(*ptr == '*' || *ptr == ' ')
+		ptr++;
+
+	start = ptr;
+	if(!(isalpha((unsigned char)*ptr) || *ptr == '_'))
+		return 0;
+	while(isalnum((unsigned char)*ptr) || *ptr == '_')
+		ptr++;
+	if(ptr - start >= MAX_NAME_LENGTH || strncmp(ptr, " = ", 3) != 0)
+		return 0;
+	if(ptr[strlen(ptr)-1] != ';')
+		return 0;
+
+	memcpy(name, start, ptr - start);
+	name[ptr - start] = 0;
+	*rhs = ptr + 3;
+	return 1;
+}
+
+/* Drop the locals that only fed the flags stripped from a handler.  A side
+ * effect free initializer goes with its declaration; any other is kept as
+ * a plain statement, so the reads and address register updates still
+ * happen.
+ */
+void strip_unused_locals(body_struct* body)
+{
+	char name[MAX_NAME_LENGTH];
+	char temp[MAX_LINE_LENGTH+1];
+	const char* rhs;
+	int changed = 1;
+	int used;
+	int i;
+	int j;
+
+	while(changed)
+	{
+		changed = 0;
+		for(i=body->length-1;i>=0;i--)
+		{
+			if(!local_declaration(body->body[i], name, &rhs))
+				continue;
+
+			for(used=0,j=0;j<body->length && !used;j++)
+				if(j != i)
+					used = uses_name(body->body[j], name);
+			if(used)
+				continue;
+
+			changed = 1;
+			if(!side_effect_free(rhs))
+			{
+				sprintf(temp, "\t(void)(%.*s);", (int)strlen(rhs) - 1, rhs);
+				strcpy(body->body[i], temp);
+				continue;
+			}
+
+			for(j=i;j<body->length-1;j++)
+				strcpy(body->body[j], body->body[j+1]);
+			body->length--;
+		}
+	}
+}
+
+/* Does a handler always set N, Z, V and C before reading any of them, without
+ * taking an exception or leaving through anything but the end of the body?
+ */
+int kills_flags(body_struct* body)
+{
+	static const char* const unsafe[] =
+	{
+		"m68ki_exception", "m68ki_init_exception", "m68ki_set_sr",
+		"m68ki_set_ccr", "m68ki_set_s_flag", "m68ki_jump", "m68ki_branch",
+		"return", "goto", "USE_ALL_CYCLES",
+		"CPU_STOPPED", NULL
+	};
+	const char* rhs;
+	int killed = 0;
+	int mask;
+	int read;
+	int i;
+	int j;
+
+	for(i=0;i<body->length;i++)
+		for(j=0;unsafe[j];j++)
+			if(strstr(body->body[i], unsafe[j]))
+				return 0;
+
+	for(i=0;i<body->length && killed != FLAG_BITS_NZVC;i++)
+	{
+		const char* line = body->body[i];
+
+		mask = flag_assignment(line, &rhs);
+		read = mask ? flags_read(rhs) : flags_read(line);
+
+		/* A flag used before it is set is live */
+		if(read & FLAG_BITS_NZVC & ~killed)
+			return 0;
+
+		/* Only unconditional statements count */
+		if(mask && line[0] == '\t' && line[1] != '\t' && line[1] != ' ')
+			killed |= mask & FLAG_BITS_NZVC;
+		else if(mask & FLAG_BITS_NZVC & ~killed)
+			return 0;
+	}
+
+	return killed == FLAG_BITS_NZVC;
+}
+
+void add_flag_table_entry(char* name, int nf, int kill)
+{
+	flag_struct* ptr;
+	if(g_flag_table_length >= MAX_FLAG_TABLE_LENGTH)
+		error_exit("Flag table overflow");
+
+	ptr = g_flag_table + g_flag_table_length++;
+	strcpy(ptr->name, name);
+	ptr->nf = nf;
+	ptr->kill = kill;
+}
+
+/* Write the table m68kcpu.c uses to pick the _nf handlers */
+void print_flag_table(FILE* filep)
+{
+	char name[MAX_NAME_LENGTH+4];
+	int i;
+
+	fprintf(filep, "/* ======================================================================== */\n");
+	fprintf(filep, "/* ========================= HANDLER INFORMATION ========================== */\n");
+	fprintf(filep, "/* ======================================================================== */\n\n");
+	fprintf(filep, "#include \"m68kops.h\"\n\n");
+	fprintf(filep, "#if M68K_DEAD_FLAGS\n\n");
+	fprintf(filep, "const m68ki_flag_handler_struct m68ki_flag_handler_table[] =\n{\n");
+	fprintf(filep, "/*   function                      no flags                           kill */\n");
+	for(i=0;i<g_flag_table_length;i++)
+	{
+		if(g_flag_table[i].nf)
+			sprintf(name, "%s_nf", g_flag_table[i].name);
+		else
+			strcpy(name, "0");
+		fprintf(filep, "\t{%-28s, %-32s, %d},\n", g_flag_table[i].name, name, g_flag_table[i].kill);
+	}
+	fprintf(filep, "\t{0, 0, 0}\n};\n\n");
+	fprintf(filep, "#endif /* M68K_DEAD_FLAGS */\n\n\n");
+}
+
+void add_ram_table_entry(char* name)
+{
+	if(g_ram_table_length >= MAX_OPCODE_OUTPUT_TABLE_LENGTH)
+		error_exit("RAM handler table overflow");
+
+	strcpy(g_ram_table[g_ram_table_length++], name);
+}
+
+/* Read a handler profile: CSV with the handler name in the first column,
+ * busiest first (m68k_fast_ram_stats() and the profiler both write this).
+ * Names may leave out the m68k_op_ prefix.  Lines that don't name a handler,
+ * like the header, are skipped.
+ */
+void read_profile(char* filename)
+{
+	FILE* filep;
+	char line[MAX_LINE_LENGTH+1];
+	char name[MAX_LINE_LENGTH+1];
+	int i;
+
+	if((filep = fopen(filename, "r")) == NULL)
+		perror_exit("can't open profile %s", filename);
+
+	while(g_hot_table_length < MAX_HOT_TABLE_LENGTH && fgetline(line, MAX_LINE_LENGTH, filep) >= 0)
+	{
+		line[strcspn(line, ", \t")] = 0;
+		if(strncmp(line, "m68k_op_", 8) == 0)
+			strcpy(name, line);
+		else
+			sprintf(name, "m68k_op_%.*s", MAX_NAME_LENGTH-9, line);
+
+		for(i=0;i<g_opcode_output_table_length;i++)
+			if(strcmp(g_opcode_output_table[i].name, name) == 0)
+				break;
+		if(i == g_opcode_output_table_length)
+			continue;
+		for(i=0;i<g_hot_table_length;i++)
+			if(strcmp(g_hot_table[i], name) == 0)
+				break;
+		if(i == g_hot_table_length)
+			strcpy(g_hot_table[g_hot_table_length++], name);
+	}
+
+	fclose(filep);
+}
+
+/* Write the handlers m68kcpu.c puts first in the dispatch table */
+void print_hot_table(FILE* filep)
+{
+	int i;
+
+	fprintf(filep, "#if M68K_COMPACT_DISPATCH\n\n");
+	fprintf(filep, "void (*const m68ki_hot_handler_table[])(void) =\n{\n");
+	for(i=0;i<g_hot_table_length;i++)
+		fprintf(filep, "\t%s,\n", g_hot_table[i]);
+	fprintf(filep, "\t0\n};\n\n");
+	fprintf(filep, "#endif /* M68K_COMPACT_DISPATCH */\n\n\n");
+}
+
+/* Write the names m68k_fast_ram_stats() reports its counts under */
+void print_ram_table(FILE* filep)
+{
+	int i;
+
+	fprintf(filep, "#if M68K_FAST_RAM_STATS\n\n");
+	fprintf(filep, "const m68ki_handler_name_struct m68ki_ram_handler_table[] =\n{\n");
+	for(i=0;i<g_ram_table_length;i++)
+		fprintf(filep, "\t{%-28s, \"%s\"},\n", g_ram_table[i], g_ram_table[i] + 8);
+	fprintf(filep, "\t{0, 0}\n};\n\n");
+	fprintf(filep, "#endif /* M68K_FAST_RAM_STATS */\n\n\n");
+}
+
+/* Write the names the profiler (M68K_PROFILE) reports handlers under */
+void print_name_table(FILE* filep)
+{
+	int i;
+
+	fprintf(filep, "#if M68K_PROFILE\n\n");
+	fprintf(filep, "const m68ki_handler_name_struct m68ki_handler_name_table[] =\n{\n");
+	for(i=0;i<g_opcode_output_table_length;i++)
+		fprintf(filep, "\t{%-28s, \"%s\"},\n", g_opcode_output_table[i].name, g_opcode_output_table[i].name + 8);
+	fprintf(filep, "\t{0, 0}\n};\n\n");
+	fprintf(filep, "#endif /* M68K_PROFILE */\n\n\n");
+}
+
 /* Generate a base function name from an opcode struct */
 void get_base_name(char* base_name, opcode_struct* op)
 {
@@ -853,6 +1414,10 @@ void generate_opcode_handler(FILE* filep, body_struct* body, replace_struct* rep
 {
 	char str[MAX_LINE_LENGTH+1];
 	opcode_struct* op = malloc(sizeof(opcode_struct));
+	body_struct* expanded = malloc(sizeof(body_struct));
+	body_struct* stripped = malloc(sizeof(body_struct));
+	int nf;
+	int kill;
 
 	/* Set the opcode structure and write the tables, prototypes, etc */
 	set_opcode_struct(opinfo, op, ea_mode);
@@ -879,8 +1444,31 @@ void generate_opcode_handler(FILE* filep, body_struct* body, replace_struct* rep
 	}
 
 	/* Now write the function body with the selected replace strings */
-	write_body(filep, body, replace);
+	get_base_name(str, op);
+	expand_body(expanded, body, replace);
+	if(fast_ram_reads(expanded))
+		add_ram_table_entry(str);
+	write_body(filep, expanded);
+
+	/* And the variant that skips dead flags */
+	nf = strip_dead_flags(stripped, expanded);
+	kill = kills_flags(expanded);
+	get_base_name(str, op);
+	if(nf || kill)
+		add_flag_table_entry(str, nf, kill);
+	if(nf)
+	{
+		strcat(str, "_nf");
+		write_prototype(g_prototype_file, str);
+		fprintf(filep, "#if M68K_DEAD_FLAGS\n");
+		write_function_name(filep, str);
+		write_body(filep, stripped);
+		fprintf(filep, "#endif /* M68K_DEAD_FLAGS */\n\n\n");
+	}
+
 	g_num_functions++;
+	free(stripped);
+	free(expanded);
 	free(op);
 }
 
@@ -1254,6 +1842,9 @@ int main(int argc, char **argv)
 
 		if(argc > 2)
 			strcpy(g_input_filename, argv[2]);
+
+		if(argc > 3)
+			strcpy(g_profile_filename, argv[3]);
 	}
 
 
@@ -1429,6 +2020,12 @@ int main(int argc, char **argv)
 			fprintf(g_table_file, "%s\n\n", table_footer_insert);
 			fprintf(g_ops_ac_file, "%s\n\n", ophandler_footer_insert);
 			fprintf(g_ops_dm_file, "%s\n\n", ophandler_footer_insert);
+			print_flag_table(g_ops_nz_file);
+			print_ram_table(g_ops_nz_file);
+			print_name_table(g_ops_nz_file);
+			if(g_profile_filename[0])
+				read_profile(g_profile_filename);
+			print_hot_table(g_ops_nz_file);
 			fprintf(g_ops_nz_file, "%s\n\n", ophandler_footer_insert);
 
 			break;
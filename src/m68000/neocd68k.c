@@ -280,6 +280,8 @@ void neogeo_progress_show( void );
 void neogeo_trace( void );
 void neogeo_ipl(void);
 void neogeo_ipl_end(void);
+void neogeo_exit(void);
+int neogeo_bios_hle(unsigned int trap);
 extern int img_display;
 
 /* ======================================================================== */
@@ -901,6 +903,8 @@ M68KMAKE_OP(1010, 0, ., .)
 
 M68KMAKE_OP(1111, 0, ., .)
 {
+	int cycles;
+
 	switch (REG_IR) {
 	case 0xfabe: neogeo_exit(); break;
 
@@ -921,7 +925,13 @@ M68KMAKE_OP(1111, 0, ., .)
 	case 0xfac7: neogeo_ipl(); break;
 	case 0xfac8: neogeo_ipl_end(); break;
 	case 0xface: neogeo_trace(); break;
-	default: m68ki_exception_1111(); break;
+	default:
+		/*** 0xfad0 - 0xfadf: BIOS HLE (ncdr_rom.c), takes its own cycles ***/
+		if((REG_IR & 0xfff0) != 0xfad0 || (cycles = neogeo_bios_hle(REG_IR)) < 0)
+			m68ki_exception_1111();
+		else
+			USE_CYCLES(cycles);
+		break;
 	}
 }
 
@@ -88,41 +88,92 @@ static READ16_HANDLER (neogeo_hardcontrol_16_r);
 static WRITE16_HANDLER (neogeo_hardcontrol_16_w);
 static READ16_HANDLER (neogeo_externalmem_16_r);
 static WRITE16_HANDLER (neogeo_externalmem_16_w);
+static READ8_HANDLER (neogeo_controller1_8_r);
+static READ8_HANDLER (neogeo_controller2_8_r);
+static READ8_HANDLER (neogeo_controller3_8_r);
+static READ8_HANDLER (neogeo_memcard8_r);
+static WRITE8_HANDLER (neogeo_memcard8_w);
+static READ8_HANDLER (neogeo_hardcontrol_8_r);
+static READ32_HANDLER (neogeo_paletteram32_r);
+static WRITE32_HANDLER (neogeo_paletteram32_w);
+static WRITE32_HANDLER (neogeo_video_32_w);
 
 static void update_interrupts (void);
+static void neogeo_decode_init (void);
 
+/*** 0 leaves the 8 and 32 bit handlers out of the map, as before they were
+     added, to compare handler calls (tests/mem_calls.c) ***/
+#ifndef MEM_SIZED_HANDLERS
+#define MEM_SIZED_HANDLERS 1
+#endif
+
+/*** The 8 and 32 bit handlers are optional. Without them, byte accesses go
+     through the 16 bit handler with a mask, and long ones make two calls ***/
 static READMEM neogeo_readmem[] = {
-  {MEM_RAM, 0x000000, 0x1fffff, NULL},
-  {MEM_MAP, 0x300000, 0x31ffff, neogeo_controller1_16_r},
-  {MEM_MAP, 0x320000, 0x33ffff, neogeo_z80_r},
-  {MEM_MAP, 0x340000, 0x35ffff, neogeo_controller2_16_r},
-  {MEM_MAP, 0x380000, 0x39ffff, neogeo_controller3_16_r},
-  {MEM_MAP, 0x3c0000, 0x3dffff, neogeo_video_16_r},
-  {MEM_MAP, 0x400000, 0x7fffff, neogeo_paletteram16_r},
-  {MEM_MAP, 0x800000, 0x803fff, neogeo_memcard16_r},
-  {MEM_ROM, 0xc00000, 0xc7ffff, NULL},
-  {MEM_MAP, 0xe00000, 0xefffff, neogeo_externalmem_16_r},
-  {MEM_MAP, 0xff0000, 0xffffff, neogeo_hardcontrol_16_r},
+  {MEM_RAM, 0x000000, 0x1fffff, NULL, NULL, NULL, "prg_ram"},
+  {MEM_MAP, 0x300000, 0x31ffff, neogeo_controller1_16_r,
+   neogeo_controller1_8_r, NULL, "neogeo_controller1_16_r"},
+  {MEM_MAP, 0x320000, 0x33ffff, neogeo_z80_r, NULL, NULL, "neogeo_z80_r"},
+  {MEM_MAP, 0x340000, 0x35ffff, neogeo_controller2_16_r,
+   neogeo_controller2_8_r, NULL, "neogeo_controller2_16_r"},
+  {MEM_MAP, 0x380000, 0x39ffff, neogeo_controller3_16_r,
+   neogeo_controller3_8_r, NULL, "neogeo_controller3_16_r"},
+  {MEM_MAP, 0x3c0000, 0x3dffff, neogeo_video_16_r, NULL, NULL,
+   "neogeo_video_16_r"},
+  {MEM_MAP, 0x400000, 0x7fffff, neogeo_paletteram16_r, NULL,
+   neogeo_paletteram32_r, "neogeo_paletteram16_r"},
+  {MEM_MAP, 0x800000, 0x803fff, neogeo_memcard16_r, neogeo_memcard8_r, NULL,
+   "neogeo_memcard16_r"},
+  {MEM_ROM, 0xc00000, 0xc7ffff, NULL, NULL, NULL, "bios_rom"},
+  {MEM_MAP, 0xe00000, 0xefffff, neogeo_externalmem_16_r, NULL, NULL,
+   "neogeo_externalmem_16_r"},
+  {MEM_MAP, 0xff0000, 0xffffff, neogeo_hardcontrol_16_r,
+   neogeo_hardcontrol_8_r, NULL, "neogeo_hardcontrol_16_r"},
   {MEM_END,}
 };
 
 static WRITEMEM neogeo_writemem[] = {
-  {MEM_RAM, 0x000000, 0x1fffff, NULL},
-  {MEM_MAP, 0x300000, 0x31ffff, watchdog_reset_16_w},
-  {MEM_MAP, 0x320000, 0x33ffff, neogeo_z80_w},
-  {MEM_MAP, 0x380000, 0x39ffff, neogeo_syscontrol1_16_w},
-  {MEM_MAP, 0x3a0000, 0x3affff, neogeo_syscontrol2_16_w},
-  {MEM_MAP, 0x3c0000, 0x3dffff, neogeo_video_16_w},
-  {MEM_MAP, 0x400000, 0x7fffff, neogeo_paletteram16_w},
-  {MEM_MAP, 0x800000, 0x803fff, neogeo_memcard16_w},
-  {MEM_MAP, 0xe00000, 0xefffff, neogeo_externalmem_16_w},
-  {MEM_MAP, 0xff0000, 0xffffff, neogeo_hardcontrol_16_w},
+  {MEM_RAM, 0x000000, 0x1fffff, NULL, NULL, NULL, "prg_ram"},
+  {MEM_MAP, 0x300000, 0x31ffff, watchdog_reset_16_w, NULL, NULL,
+   "watchdog_reset_16_w"},
+  {MEM_MAP, 0x320000, 0x33ffff, neogeo_z80_w, NULL, NULL, "neogeo_z80_w"},
+  {MEM_MAP, 0x380000, 0x39ffff, neogeo_syscontrol1_16_w, NULL, NULL,
+   "neogeo_syscontrol1_16_w"},
+  {MEM_MAP, 0x3a0000, 0x3affff, neogeo_syscontrol2_16_w, NULL, NULL,
+   "neogeo_syscontrol2_16_w"},
+  {MEM_MAP, 0x3c0000, 0x3dffff, neogeo_video_16_w, NULL, neogeo_video_32_w,
+   "neogeo_video_16_w"},
+  {MEM_MAP, 0x400000, 0x7fffff, neogeo_paletteram16_w, NULL,
+   neogeo_paletteram32_w, "neogeo_paletteram16_w"},
+  {MEM_MAP, 0x800000, 0x803fff, neogeo_memcard16_w, neogeo_memcard8_w, NULL,
+   "neogeo_memcard16_w"},
+  {MEM_MAP, 0xe00000, 0xefffff, neogeo_externalmem_16_w, NULL, NULL,
+   "neogeo_externalmem_16_w"},
+  {MEM_MAP, 0xff0000, 0xffffff, neogeo_hardcontrol_16_w, NULL, NULL,
+   "neogeo_hardcontrol_16_w"},
   {MEM_END,}
 };
 
 static READMAP read_map[0x100];
 static WRITEMAP write_map[0x100];
 
+#if M68K_PROFILE
+/*** Accesses and handler calls by 64KB page, for neogeo_memory_profile ***/
+static unsigned int read_count[0x100];
+static unsigned int write_count[0x100];
+static unsigned int read_calls[0x100];
+static unsigned int write_calls[0x100];
+#define profile_read(address)	read_count[(address) >> 16]++
+#define profile_write(address)	write_count[(address) >> 16]++
+#define profile_read_call(map, n)	read_calls[(map) - read_map] += (n)
+#define profile_write_call(map, n)	write_calls[(map) - write_map] += (n)
+#else
+#define profile_read(address)
+#define profile_write(address)
+#define profile_read_call(map, n)
+#define profile_write_call(map, n)
+#endif
+
 static inline u32
 FLIP32 (u32 b)
 {
@@ -222,11 +273,15 @@ initialise_memmap ()
       read_map[i].start = start;
       read_map[i].end = end;
       read_map[i].func = NULL;
+      read_map[i].func8 = NULL;
+      read_map[i].func32 = NULL;
 
       write_map[i].type = MEM_BAD;
       write_map[i].start = start;
       write_map[i].end = end;
       write_map[i].func = NULL;
+      write_map[i].func8 = NULL;
+      write_map[i].func32 = NULL;
     }
 
 	/*** Set read mapping ***/
@@ -242,6 +297,8 @@ initialise_memmap ()
 	  read_map[i].type = neoread->type;
 	  read_map[i].base = neoread->start;
 	  read_map[i].func = neoread->func;
+	  read_map[i].func8 = MEM_SIZED_HANDLERS ? neoread->func8 : NULL;
+	  read_map[i].func32 = MEM_SIZED_HANDLERS ? neoread->func32 : NULL;
 	  if (i == end)
 	    read_map[i].end = neoread->end;
 	}
@@ -262,6 +319,8 @@ initialise_memmap ()
 	  write_map[i].type = neowrite->type;
 	  write_map[i].base = neowrite->start;
 	  write_map[i].func = neowrite->func;
+	  write_map[i].func8 = MEM_SIZED_HANDLERS ? neowrite->func8 : NULL;
+	  write_map[i].func32 = MEM_SIZED_HANDLERS ? neowrite->func32 : NULL;
 	  if (i == end)
 	    write_map[i].end = neowrite->end;
 	}
@@ -269,6 +328,7 @@ initialise_memmap ()
       neowrite++;
     }
 
+  neogeo_decode_init ();
   memreset ();
 
   time (&ltime);
@@ -294,6 +354,7 @@ m68k_read_memory_8 (unsigned int address)
 
   address &= MEM_AMASK;
   neoread = &read_map[address >> 16];
+  profile_read (address);
 
   if (address <= neoread->end)
     {
@@ -311,6 +372,9 @@ m68k_read_memory_8 (unsigned int address)
 	  return neogeo_prg_memory[address];
 
 	case MEM_MAP:
+	  profile_read_call (neoread, 1);
+	  if (neoread->func8)
+	    return (neoread->func8) (address);
 	  shift = (~address & 1) << 3;
 	  return (((neoread->func) (address >> 1,
 				    ~(0xff << shift)) >> shift));
@@ -330,6 +394,7 @@ m68k_read_memory_16 (unsigned int address)
 
   address &= MEM_AMASK;
   neoread = &read_map[address >> 16];
+  profile_read (address);
 
   if (address <= neoread->end)
     {
@@ -338,15 +403,20 @@ m68k_read_memory_16 (unsigned int address)
       switch (neoread->type)
 	{
 	case MEM_ROM:
-	  return *(unsigned short *) (neogeo_rom_memory + address);
+	  if (address + neoread->base < neoread->end)
+	    return *(unsigned short *) (neogeo_rom_memory + address);
+	  break;
 
 	case MEM_RAM:
 	  /*** PRG 01
 	  return FLIP16 (*(unsigned short *) (neogeo_prg_memory + address));
 	   ***/
-	  return *(unsigned short *) (neogeo_prg_memory + address);
+	  if (address + neoread->base < neoread->end)
+	    return *(unsigned short *) (neogeo_prg_memory + address);
+	  break;
 
 	case MEM_MAP:
+	  profile_read_call (neoread, 1);
 	  return ((neoread->func) (address >> 1, 0));
 	}
     }
@@ -367,6 +437,7 @@ m68k_read_memory_32 (unsigned int address)
 
   address &= MEM_AMASK;
   neoread = &read_map[address >> 16];
+  profile_read (address);
 
   if (address <= neoread->end)
     {
@@ -375,7 +446,9 @@ m68k_read_memory_32 (unsigned int address)
       switch (neoread->type)
 	{
 	case MEM_ROM:
-	  return *(unsigned int *) (neogeo_rom_memory + address);
+	  if (address + neoread->base + 3 <= neoread->end)
+	    return *(unsigned int *) (neogeo_rom_memory + address);
+	  break;
 
 	case MEM_RAM:
 	  /*** PRG 01
@@ -383,14 +456,24 @@ m68k_read_memory_32 (unsigned int address)
 	  data |= (FLIP16(*(unsigned short *)(neogeo_prg_memory + address + 2)));
 	  return data;
 	  ***/
-	  return *(unsigned int *) (neogeo_prg_memory + address);
+	  if (address + neoread->base + 3 <= neoread->end)
+	    return *(unsigned int *) (neogeo_prg_memory + address);
+	  break;
 
 	case MEM_MAP:
 	  address >>= 1;
+	  profile_read_call (neoread, neoread->func32 ? 1 : 2);
+	  if (neoread->func32)
+	    return (neoread->func32) (address);
 	  return (((neoread->func) (address,
 				    0) << 16) | (neoread->func) (address + 1,
 								 0));
 	}
+
+      /*** Runs off the end of the region, one word at a time ***/
+      address += neoread->base;
+      return (m68k_read_memory_16 (address) << 16) |
+	m68k_read_memory_16 (address + 2);
     }
 
   return 0xffffffff;
@@ -408,6 +491,7 @@ m68k_write_memory_8 (unsigned int address, unsigned int value)
   address &= MEM_AMASK;
   value &= 0xff;
   neowrite = &write_map[address >> 16];
+  profile_write (address);
 
   if (address <= neowrite->end)
     {
@@ -420,9 +504,16 @@ m68k_write_memory_8 (unsigned int address, unsigned int value)
 	  neogeo_prg_memory[address ^ 1] = value;
 		***/
 	  neogeo_prg_memory[address] = value;
+	  m68k_cache_write (address, 1);
 	  break;
 
 	case MEM_MAP:
+	  profile_write_call (neowrite, 1);
+	  if (neowrite->func8)
+	    {
+	      (neowrite->func8) (address, value);
+	      break;
+	    }
 	  shift = (~address & 1) << 3;
 	  (neowrite->func) (address >> 1, (value << shift), ~(0xff << shift));
 	  break;
@@ -441,6 +532,7 @@ m68k_write_memory_16 (unsigned int address, unsigned int value)
   address &= MEM_AMASK;
   value &= 0xffff;
   neowrite = &write_map[address >> 16];
+  profile_write (address);
 
   if (address <= neowrite->end)
     {
@@ -452,10 +544,14 @@ m68k_write_memory_16 (unsigned int address, unsigned int value)
 		/*** PRG 01
 	  *(unsigned short *) (neogeo_prg_memory + address) = FLIP16 (value);
 		***/
+	  if (address + neowrite->base >= neowrite->end)
+	    break;
 	  *(unsigned short *) (neogeo_prg_memory + address) = value;
+	  m68k_cache_write (address, 2);
 	  break;
 
 	case MEM_MAP:
+	  profile_write_call (neowrite, 1);
 	  (neowrite->func) (address >> 1, value, 0);
 	  break;
 	}
@@ -472,6 +568,7 @@ m68k_write_memory_32 (unsigned int address, unsigned int value)
 
   address &= MEM_AMASK;
   neowrite = &write_map[address >> 16];
+  profile_write (address);
 
   if (address <= neowrite->end)
     {
@@ -484,11 +581,26 @@ m68k_write_memory_32 (unsigned int address, unsigned int value)
 	  *(unsigned short *)(neogeo_prg_memory + address) = FLIP16((value >> 16));
 	  *(unsigned short *)(neogeo_prg_memory + address + 2) = FLIP16(value & 0xffff);
 		***/
+	  if (address + neowrite->base + 3 > neowrite->end)
+	    {
+	      /*** Runs off the end of the region ***/
+	      address += neowrite->base;
+	      m68k_write_memory_16 (address, value >> 16);
+	      m68k_write_memory_16 (address + 2, value & 0xffff);
+	      break;
+	    }
 	  *(unsigned int *) (neogeo_prg_memory + address) = value;
+	  m68k_cache_write (address, 4);
 	  break;
 
 	case MEM_MAP:
 	  address >>= 1;
+	  profile_write_call (neowrite, neowrite->func32 ? 1 : 2);
+	  if (neowrite->func32)
+	    {
+	      (neowrite->func32) (address, value);
+	      break;
+	    }
 	  (neowrite->func) (address, value >> 16, 0);
 	  (neowrite->func) (address + 1, value & 0xffff, 0);
 	  break;
@@ -496,6 +608,62 @@ m68k_write_memory_32 (unsigned int address, unsigned int value)
     }
 }
 
+#if M68K_PROFILE
+/****************************************************************************
+* neogeo_memory_profile
+*
+* 68K accesses through each READMEM / WRITEMEM entry, in the folded stack
+* format of m68k_profile_write, then the handler calls they made under
+* "calls". Reads the core serves from PRG RAM itself (M68K_FAST_RAM) never
+* get here.
+****************************************************************************/
+void
+neogeo_memory_profile (FILE * fp)
+{
+  READMEM *neoread;
+  WRITEMEM *neowrite;
+  unsigned int count, calls;
+  int i;
+
+  for (neoread = neogeo_readmem; neoread->type != MEM_END; neoread++)
+    {
+      count = calls = 0;
+      for (i = (neoread->start >> 16) & 0xff; i <= ((neoread->end >> 16) & 0xff); i++)
+	{
+	  count += read_count[i];
+	  calls += read_calls[i];
+	}
+      if (count)
+	fprintf (fp, "read;%s %u\n", neoread->name, count);
+      if (calls)
+	fprintf (fp, "calls;read;%s %u\n", neoread->name, calls);
+    }
+
+  for (neowrite = neogeo_writemem; neowrite->type != MEM_END; neowrite++)
+    {
+      count = calls = 0;
+      for (i = (neowrite->start >> 16) & 0xff; i <= ((neowrite->end >> 16) & 0xff); i++)
+	{
+	  count += write_count[i];
+	  calls += write_calls[i];
+	}
+      if (count)
+	fprintf (fp, "write;%s %u\n", neowrite->name, count);
+      if (calls)
+	fprintf (fp, "calls;write;%s %u\n", neowrite->name, calls);
+    }
+}
+
+void
+neogeo_memory_profile_reset (void)
+{
+  memset (read_count, 0, sizeof (read_count));
+  memset (write_count, 0, sizeof (write_count));
+  memset (read_calls, 0, sizeof (read_calls));
+  memset (write_calls, 0, sizeof (write_calls));
+}
+#endif
+
 /****************************************************************************
 * Read Player 1
 ****************************************************************************/
@@ -523,6 +691,27 @@ READ16_HANDLER (neogeo_controller3_16_r)
   return (u16) ((read_pl12_startsel () << 8) & 0x0f00);
 }
 
+/****************************************************************************
+* Byte reads of the controllers, which only drive the even byte
+****************************************************************************/
+static
+READ8_HANDLER (neogeo_controller1_8_r)
+{
+  return (offset & 1) ? 0 : read_player1 ();
+}
+
+static
+READ8_HANDLER (neogeo_controller2_8_r)
+{
+  return (offset & 1) ? 0 : read_player2 ();
+}
+
+static
+READ8_HANDLER (neogeo_controller3_8_r)
+{
+  return (offset & 1) ? 0 : read_pl12_startsel () & 0x0f;
+}
+
 /****************************************************************************
 * Read coin, Z80 etc
 ****************************************************************************/
@@ -622,6 +811,13 @@ READ16_HANDLER (neogeo_paletteram16_r)
   return v[offset];
 }
 
+static
+READ32_HANDLER (neogeo_paletteram32_r)
+{
+  unsigned short *v = (unsigned short *) video_paletteram_ng;
+  return (v[offset & 0xfff] << 16) | v[(offset + 1) & 0xfff];
+}
+
 /****************************************************************************
 * Memory card handlers
 ****************************************************************************/
@@ -641,6 +837,23 @@ WRITE16_HANDLER (neogeo_memcard16_w)
     }
 }
 
+/*** The card is on the odd bytes ***/
+static
+READ8_HANDLER (neogeo_memcard8_r)
+{
+  return (offset & 1) ? neogeo_memorycard[offset >> 1] : 0xff;
+}
+
+static
+WRITE8_HANDLER (neogeo_memcard8_w)
+{
+  if (offset & 1)
+    {
+      neogeo_memorycard[offset >> 1] = data;
+      mcard_written = 1;
+    }
+}
+
 /****************************************************************************
 * Read video palette RAM
 ****************************************************************************/
@@ -693,6 +906,7 @@ static void
 neogeo_select_bios_vectors (void)
 {
   memcpy (neogeo_prg_memory, neogeo_rom_memory, 0x100);
+  m68k_cache_invalidate (0, 0x100);
 	/*** PRG 01
   neogeo_swab(neogeo_prg_memory, neogeo_prg_memory, 0x100);
 	***/
@@ -705,6 +919,7 @@ static void
 neogeo_select_game_vectors (void)
 {
   memcpy (neogeo_prg_memory, neogeo_game_vectors, 0x100);
+  m68k_cache_invalidate (0, 0x100);
 }
 
 /****************************************************************************
@@ -715,6 +930,8 @@ neogeo_setpalbank0 (void)
 {
   video_paletteram_ng = video_palette_bank0_ng;
   video_paletteram_pc = video_palette_bank0_pc;
+  video_paldirty = video_palette_dirty[0];
+  video_fix_paldirty = 0xffff;
 }
 
 /****************************************************************************
@@ -725,6 +942,8 @@ neogeo_setpalbank1 (void)
 {
   video_paletteram_ng = video_palette_bank1_ng;
   video_paletteram_pc = video_palette_bank1_pc;
+  video_paldirty = video_palette_dirty[1];
+  video_fix_paldirty = 0xffff;
 }
 
 /****************************************************************************
@@ -788,10 +1007,25 @@ WRITE16_HANDLER (neogeo_paletteram16_w)
   newword = video_paletteram_ng[offset];
   COMBINE_DATA (&newword);
   video_paletteram_ng[offset] = newword;
-  video_paletteram_pc[offset] = video_color_lut[newword & 0x7fff];
+  VIDEO_PALETTE_W (offset);
 
 }
 
+/****************************************************************************
+* Update two palette entries
+****************************************************************************/
+static
+WRITE32_HANDLER (neogeo_paletteram32_w)
+{
+  offset &= 0xfff;
+  video_paletteram_ng[offset] = data >> 16;
+  VIDEO_PALETTE_W (offset);
+
+  offset = (offset + 1) & 0xfff;
+  video_paletteram_ng[offset] = data & 0xffff;
+  VIDEO_PALETTE_W (offset);
+}
+
 /****************************************************************************
 * Neogeo Video Pointer
 ****************************************************************************/
@@ -829,6 +1063,8 @@ WRITE16_HANDLER (neogeo_vidram16_data_w)
 {
   unsigned short *v = (unsigned short *) video_vidram;
   COMBINE_DATA (&v[video_pointer]);
+  VIDEO_FIX_MAP_W (video_pointer);
+  VIDEO_SCB_W (video_pointer);
 
   video_pointer = (video_pointer & 0x8000)	/* gururin fix */
     | ((video_pointer + video_modulo) & 0x7fff);
@@ -845,60 +1081,93 @@ READ16_HANDLER (neogeo_hardcontrol_16_r)
   return mem[offset];
 }
 
-#define decode_spr(n, s)						\
-{												\
-	*dst |= (*(s) & 0x01) << ((n +  0) - 0);	\
-	*dst |= (*(s) & 0x02) << ((n +  4) - 1);	\
-	*dst |= (*(s) & 0x04) << ((n +  8) - 2);	\
-	*dst |= (*(s) & 0x08) << ((n + 12) - 3);	\
-	*dst |= (*(s) & 0x10) << ((n + 16) - 4);	\
-	*dst |= (*(s) & 0x20) << ((n + 20) - 5);	\
-	*dst |= (*(s) & 0x40) << ((n + 24) - 6);	\
-	*dst |= (*(s) & 0x80) << ((n + 28) - 7);	\
-	(s)++;										\
+static
+READ8_HANDLER (neogeo_hardcontrol_8_r)
+{
+  unsigned short *mem = (unsigned short *) hwcontrol;
+  unsigned short data = mem[(offset >> 1) & 0xff];
+  return (offset & 1) ? data & 0xff : data >> 8;
 }
 
-void
-neogeo_decode_spr (unsigned char *mem, unsigned int offset,
-		   unsigned int length)
+/****************************************************************************
+* Sprite decoding
+*
+* Each source byte holds one bitplane for eight pixels. decode_spr_lut moves
+* bit k of a byte to bit 4k of a word, so a decoded row of eight pixels is four
+* lookups and shifts instead of 32 shift-and-or steps.
+*
+* A pixel is opaque when any of its four planes is set, so OR-ing the four
+* source bytes and counting bits gives the opaque pixels for the whole row.
+****************************************************************************/
+static unsigned int decode_spr_lut[256];
+static unsigned char decode_spr_bits[256];
+
+static void
+neogeo_decode_init (void)
 {
-  unsigned char buf[128], *usage;
-  unsigned int *dst;
-  int i, j, k;
+  int i, k;
+
+  for (i = 0; i < 256; i++)
+    {
+      decode_spr_lut[i] = 0;
+      decode_spr_bits[i] = 0;
 
-  dst = (unsigned int *) (mem + offset);
+      for (k = 0; k < 8; k++)
+	{
+	  if (i & (1 << k))
+	    {
+	      decode_spr_lut[i] |= 1 << (k << 2);
+	      decode_spr_bits[i]++;
+	    }
+	}
+    }
+}
+
+#define decode_spr(s)						\
+{								\
+	*dst = (decode_spr_lut[(s)[0]] << 1) |			\
+	       (decode_spr_lut[(s)[1]]) |			\
+	       (decode_spr_lut[(s)[2]] << 3) |			\
+	       (decode_spr_lut[(s)[3]] << 2);			\
+	opaque += decode_spr_bits[(s)[0] | (s)[1] | (s)[2] | (s)[3]];	\
+	(s) += 4;						\
+	dst++;							\
+}
 
-  usage = video_spr_usage + (offset >> 7);
+/****************************************************************************
+* decode_spr_tiles
+*
+* Decode whole tiles into dst. With no source, each tile is decoded in place.
+****************************************************************************/
+static void
+decode_spr_tiles (unsigned int *dst, const unsigned char *from,
+		  unsigned char *usage, unsigned int tiles)
+{
+  unsigned char buf[128];
+  const unsigned char *src, *src2;
+  int j;
 
-  for (i = 0; i < length; i += 128)
+  while (tiles--)
     {
       int opaque = 0;
-      unsigned char *src, *src2;
 
-      memcpy (buf, dst, 128);
+      if (from)
+	{
+	  src = from;
+	  from += 128;
+	}
+      else
+	{
+	  memcpy (buf, dst, 128);
+	  src = buf;
+	}
 
-      src = buf;
-      src2 = buf + 64;
+      src2 = src + 64;
 
       for (j = 0; j < 16; j++)
 	{
-	  *dst = 0;
-	  decode_spr (1, src2);
-	  decode_spr (0, src2);
-	  decode_spr (3, src2);
-	  decode_spr (2, src2);
-	  for (k = 0; k < 32; k += 4)
-	    opaque += (*dst & (0x0f << k)) != 0;
-	  dst++;
-
-	  *dst = 0;
-	  decode_spr (1, src);
-	  decode_spr (0, src);
-	  decode_spr (3, src);
-	  decode_spr (2, src);
-	  for (k = 0; k < 32; k += 4)
-	    opaque += (*dst & (0x0f << k)) != 0;
-	  dst++;
+	  decode_spr (src2);
+	  decode_spr (src);
 	}
 
       if (opaque)
@@ -909,6 +1178,37 @@ neogeo_decode_spr (unsigned char *mem, unsigned int offset,
     }
 }
 
+void
+neogeo_decode_spr (unsigned char *mem, unsigned int offset,
+		   unsigned int length)
+{
+  decode_spr_tiles ((unsigned int *) (mem + offset), NULL,
+		    video_spr_usage + (offset >> 7), (length + 127) >> 7);
+}
+
+/****************************************************************************
+* neogeo_copy_spr
+*
+* Same result as memcpy followed by neogeo_decode_spr, but whole tiles are
+* decoded straight from the source. Only a trailing part tile is copied.
+****************************************************************************/
+void
+neogeo_copy_spr (unsigned char *mem, unsigned int offset,
+		 const unsigned char *src, unsigned int length)
+{
+  unsigned int tiles = length >> 7;
+
+  decode_spr_tiles ((unsigned int *) (mem + offset), src,
+		    video_spr_usage + (offset >> 7), tiles);
+
+  if (length & 127)
+    {
+      offset += tiles << 7;
+      memcpy (mem + offset, src + (tiles << 7), length & 127);
+      neogeo_decode_spr (mem, offset, length & 127);
+    }
+}
+
 #define undecode_fix(n)				\
 {									\
 	tile = *(mem2 + (ofs++));		\
@@ -939,32 +1239,49 @@ neogeo_undecode_fix (unsigned char *mem, int offset, unsigned int length)
 
       mem2 += 32;
     }
+
+  if (mem == neogeo_fix_memory)
+    video_fix_flush ();
 }
 
 #define decode_fix(n)				\
 {									\
-	tile = buf[n];					\
+	tile = src[n];					\
 	*mem++ = tile;					\
 	opaque += (tile & 0x0f) != 0;	\
 	opaque += (tile >> 4) != 0;		\
 }
 
-void
-neogeo_decode_fix (unsigned char *mem, unsigned int offset,
-		   unsigned int length)
+/****************************************************************************
+* decode_fix_tiles
+*
+* As decode_spr_tiles, for 32 byte fix tiles.
+****************************************************************************/
+static void
+decode_fix_tiles (unsigned char *mem, const unsigned char *from,
+		  unsigned char *usage, unsigned int tiles)
 {
-  int i, j;
+  int j;
   unsigned char tile, opaque;
-  unsigned char buf[32], *usage;
+  unsigned char buf[32];
+  const unsigned char *src;
 
-  mem += offset;
-  usage = video_fix_usage + (offset >> 5);
+  video_fix_flush ();
 
-  for (i = 0; i < length; i += 32)
+  while (tiles--)
     {
       opaque = 0;
 
-      memcpy (buf, mem, 32);
+      if (from)
+	{
+	  src = from;
+	  from += 32;
+	}
+      else
+	{
+	  memcpy (buf, mem, 32);
+	  src = buf;
+	}
 
       for (j = 0; j < 8; j++)
 	{
@@ -982,6 +1299,197 @@ neogeo_decode_fix (unsigned char *mem, unsigned int offset,
     }
 }
 
+void
+neogeo_decode_fix (unsigned char *mem, unsigned int offset,
+		   unsigned int length)
+{
+  decode_fix_tiles (mem + offset, NULL, video_fix_usage + (offset >> 5),
+		    (length + 31) >> 5);
+}
+
+/****************************************************************************
+* neogeo_copy_fix
+****************************************************************************/
+void
+neogeo_copy_fix (unsigned char *mem, unsigned int offset,
+		 const unsigned char *src, unsigned int length)
+{
+  unsigned int tiles = length >> 5;
+
+  decode_fix_tiles (mem + offset, src, video_fix_usage + (offset >> 5),
+		    tiles);
+
+  if (length & 31)
+    {
+      offset += tiles << 5;
+      memcpy (mem + offset, src + (tiles << 5), length & 31);
+      neogeo_decode_fix (mem, offset, length & 31);
+    }
+}
+
+/****************************************************************************
+* Palette bulk upload
+*
+* Same result as a run of neogeo_paletteram16_w word writes, without going
+* through the memory map for every colour. The colours are copied in runs up
+* to the end of the bank and marked a bitmap word at a time, and converted
+* with the rest in video_update_palette.
+****************************************************************************/
+static void
+neogeo_palette_copy (unsigned int offset, const unsigned short *src,
+		     unsigned int count)
+{
+  unsigned int run, n = count;
+
+  offset &= 0xfff;
+  video_palette_mark (offset, count);
+
+  /*** Only the last 4096 colours stay ***/
+  if (n > 4096)
+    {
+      src += n - 4096;
+      offset = (offset + n - 4096) & 0xfff;
+      n = 4096;
+    }
+
+  while (n)
+    {
+      run = 0x1000 - offset;
+      if (run > n)
+	run = n;
+      memcpy (video_paletteram_ng + offset, src, run << 1);
+      src += run;
+      n -= run;
+      offset = 0;
+    }
+}
+
+static void
+neogeo_palette_fill (unsigned int offset, unsigned short colour,
+		     unsigned int count)
+{
+  unsigned int i;
+
+  offset &= 0xfff;
+  video_palette_mark (offset, count);
+
+  if (count > 4096)
+    count = 4096;
+  for (i = 0; i < count; i++)
+    video_paletteram_ng[(offset + i) & 0xfff] = colour;
+}
+
+/****************************************************************************
+* upload_fill
+*
+* Pattern upload of count words. The common targets are filled directly in
+* their backing arrays, and tiles are decoded once the fill is complete -
+* exactly the tiles whose last byte the word writes would have reached.
+* Anything unusual still goes through m68k_write_memory_16.
+****************************************************************************/
+static void
+upload_fill (unsigned int address, unsigned int count, unsigned short value)
+{
+  unsigned short *dst;
+  unsigned char *mem, save[2] = { 0, 0 };
+  unsigned int i, offset;
+
+  if (!(address & 1))
+    {
+      /*** 68K RAM ***/
+      if (address < 0x200000 && count <= ((0x200000 - address) >> 1))
+	{
+	  dst = (unsigned short *) (neogeo_prg_memory + address);
+	  for (i = 0; i < count; i++)
+	    dst[i] = value;
+	  m68k_cache_invalidate (address, count << 1);
+	  cdrom_bytes_moved += count << 1;
+	  return;
+	}
+
+      /*** Palette ***/
+      if (address >= 0x400000 && address < 0x800000
+	  && count <= ((0x800000 - address) >> 1))
+	{
+	  neogeo_palette_fill ((address - 0x400000) >> 1, value, count);
+	  cdrom_bytes_moved += count << 2;
+	  return;
+	}
+
+      /*** External memory ***/
+      if (address >= 0xe00000 && address < 0xf00000
+	  && count <= ((0xf00000 - address) >> 1))
+	{
+	  offset = (address - 0xe00000) >> 1;
+
+	  switch (exmem[exmem_counter])
+	    {
+	    case EXMEM_OBJ:
+	      offset = (offset << 1) + (exmem_bank[EXMEM_OBJ] << 20);
+	      if (offset >= 0x400000 || count > ((0x400000 - offset) >> 1))
+		break;
+
+	      video_render_sync ();
+	      dst = (unsigned short *) (neogeo_spr_memory + offset);
+	      for (i = 0; i < count; i++)
+		dst[i] = (unsigned short) ((value << 8) | (value >> 8));
+
+	      i = ((offset + (count << 1)) >> 7) - (offset >> 7);
+	      if (i)
+		neogeo_decode_spr (neogeo_spr_memory, offset & ~0x7f, i << 7);
+
+	      cdrom_bytes_moved += count << 1;
+	      return;
+
+	    case EXMEM_PCMA:
+	      offset += exmem_bank[EXMEM_PCMA] << 19;
+	      if (offset >= 0x100000 || count > 0x100000 - offset)
+		break;
+
+	      memset (neogeo_pcm_memory + offset, value & 0xff, count);
+	      cdrom_bytes_moved += count;
+	      return;
+
+	    case EXMEM_Z80:
+	      if (offset >= 0x10000 || count > 0x10000 - offset)
+		break;
+
+	      /*** The CDDA offset is never written ***/
+	      mem = subcpu_memspace;
+	      for (i = 0; i < 2; i++)
+		if (z80_cdda_offset && z80_cdda_offset + i < 0x10000)
+		  save[i] = mem[z80_cdda_offset + i];
+
+	      memset (mem + offset, value & 0xff, count);
+
+	      for (i = 0; i < 2; i++)
+		if (z80_cdda_offset && z80_cdda_offset + i < 0x10000)
+		  mem[z80_cdda_offset + i] = save[i];
+
+	      cdrom_bytes_moved += count;
+	      return;
+
+	    case EXMEM_FIX:
+	      if (offset >= 0x20000 || count > 0x20000 - offset)
+		break;
+
+	      video_render_sync ();
+	      memset (neogeo_fix_memory + offset, value & 0xff, count);
+
+	      i = ((offset + count) >> 5) - (offset >> 5);
+	      if (i)
+		neogeo_decode_fix (neogeo_fix_memory, offset & ~0x1f, i << 5);
+
+	      cdrom_bytes_moved += count;
+	      return;
+	    }
+	}
+    }
+
+  for (i = 0; i < count; i++)
+    m68k_write_memory_16 (address + (i * 2), value);
+}
+
 static
 WRITE16_HANDLER (upload_offset1_16_w)
 {
@@ -1091,22 +1599,14 @@ WRITE16_HANDLER (hardware_upload_16_w)
 	      case Z80_TYPE:
 	      case PCM_TYPE:
 	      case BACKUP_RAM:
-		for (i = 0; i < upload_length; i++)
-		  {
-		    offset = upload_offset1 + (i * 2);
-		    m68k_write_memory_16 (offset,
-					  (upload_pattern & 0xff) | 0xff00);
-		  }
+		upload_fill (upload_offset1, upload_length,
+			     (upload_pattern & 0xff) | 0xff00);
 		break;
 
 	      case PRG_TYPE:
 	      case PAL_TYPE:
 	      case SPR_TYPE:
-		for (i = 0; i < upload_length; i++)
-		  {
-		    offset = upload_offset1 + (i * 2);
-		    m68k_write_memory_16 (offset, upload_pattern);
-		  }
+		upload_fill (upload_offset1, upload_length, upload_pattern);
 		break;
 	      }
 	  }
@@ -1124,6 +1624,8 @@ WRITE16_HANDLER (hardware_upload_16_w)
 	      case PRG_TYPE:
 		dst = neogeo_prg_memory;
 		memcpy (dst + upload_offset2, src, length);
+		m68k_cache_invalidate (upload_offset2, length);
+		cdrom_bytes_moved += length;
 		break;
 
 	      case FIX_TYPE:
@@ -1132,8 +1634,9 @@ WRITE16_HANDLER (hardware_upload_16_w)
 			/*** PRG 02
 		neogeo_swab (src, dst + (offset >> 1), length);
 	                     ***/
-		memcpy (dst + (offset >> 1), src, length);
-		neogeo_decode_fix (dst, offset >> 1, length);
+		video_render_sync ();
+		neogeo_copy_fix (dst, offset >> 1, src, length);
+		cdrom_bytes_moved += length;
 		break;
 
 	      case SPR_TYPE:
@@ -1143,8 +1646,9 @@ WRITE16_HANDLER (hardware_upload_16_w)
 			/*** PRG 02
 		neogeo_swab (src, dst + offset, length);
 			***/
-		memcpy (dst + offset, src, length);
-		neogeo_decode_spr (dst, offset, length);
+		video_render_sync ();
+		neogeo_copy_spr (dst, offset, src, length);
+		cdrom_bytes_moved += length;
 		exmem_bank[EXMEM_OBJ] =
 		  ((offset + upload_get_length ()) >> 20) & 0x03;
 		break;
@@ -1156,9 +1660,22 @@ WRITE16_HANDLER (hardware_upload_16_w)
 		neogeo_swab (src, dst + (offset >> 1), length);
 			***/
 		memcpy (dst + (offset >> 1), src, length);
+		cdrom_bytes_moved += length;
 		break;
 
 	      case PAL_TYPE:
+		if (!(upload_offset1 & 1) && !(upload_offset2 & 1)
+		    && upload_offset1 < 0x200000
+		    && length <= ((0x200000 - upload_offset1) >> 1)
+		    && upload_offset2 >= 0x400000 && upload_offset2 < 0x800000
+		    && length <= ((0x800000 - upload_offset2) >> 1))
+		  {
+		    neogeo_palette_copy ((upload_offset2 - 0x400000) >> 1,
+					 (unsigned short *) src, length);
+		    cdrom_bytes_moved += length << 2;
+		    break;
+		  }
+
 		for (i = 0; i < length; i++)
 		  {
 		    data = m68k_read_memory_16 (upload_offset1 + i * 2);
@@ -1308,6 +1825,7 @@ WRITE16_HANDLER (neogeo_externalmem_16_w)
       offset = (offset << 1) + (exmem_bank[EXMEM_OBJ] << 20);
       data = (data << 8) | (data >> 8);
       dst = neogeo_spr_memory;
+      video_render_sync ();
       COMBINE_SWABDATA ((unsigned short *) (dst + offset));
       if ((offset & 0x7f) == 0x7e)
 	neogeo_decode_spr (dst, (offset & ~0x7f), 128);
@@ -1333,6 +1851,7 @@ WRITE16_HANDLER (neogeo_externalmem_16_w)
 
     case EXMEM_FIX:
       dst = neogeo_fix_memory;
+      video_render_sync ();
       dst[offset] = data & 0xff;
       if ((offset & 0x1f) == 0x1f)
 	neogeo_decode_fix (dst, (offset & ~0x1f), 32);
@@ -1526,6 +2045,30 @@ WRITE16_HANDLER (neogeo_video_16_w)
     }
 }
 
+/****************************************************************************
+* Long writes to the video registers. VRAM address + data and data + modulo
+* are the usual pairs.
+****************************************************************************/
+static
+WRITE32_HANDLER (neogeo_video_32_w)
+{
+  switch ((offset & 0x7) << 1)
+    {
+    case 0x0:
+      video_pointer = data >> 16;
+      neogeo_vidram16_data_w (0, data & 0xffff, 0);
+      break;
+    case 0x2:
+      neogeo_vidram16_data_w (0, data >> 16, 0);
+      video_modulo = data & 0xffff;
+      break;
+    default:
+      neogeo_video_16_w (offset, data >> 16, 0);
+      neogeo_video_16_w (offset + 1, data & 0xffff, 0);
+      break;
+    }
+}
+
 /****************************************************************************
 * Ma,me Z80 sound irq
 ****************************************************************************/
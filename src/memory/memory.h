@@ -70,6 +70,9 @@ typedef struct
   unsigned int start;
   unsigned int end;
   unsigned short (*func) (unsigned int offset, unsigned short mask);
+  unsigned char (*func8) (unsigned int offset);		/*** optional ***/
+  unsigned int (*func32) (unsigned int offset);		/*** optional ***/
+  const char *name;
 } READMEM;
 
 typedef struct
@@ -79,6 +82,9 @@ typedef struct
   unsigned int end;
   void (*func) (unsigned int offset, unsigned short data,
 		unsigned short mask);
+  void (*func8) (unsigned int offset, unsigned char data);	/*** optional ***/
+  void (*func32) (unsigned int offset, unsigned int data);	/*** optional ***/
+  const char *name;
 } WRITEMEM;
 
 typedef struct
@@ -88,6 +94,8 @@ typedef struct
   unsigned int end;
   unsigned int base;
   unsigned short (*func) (unsigned int offset, unsigned short mask);
+  unsigned char (*func8) (unsigned int offset);
+  unsigned int (*func32) (unsigned int offset);
 } READMAP;
 
 typedef struct
@@ -98,6 +106,8 @@ typedef struct
   unsigned int base;
   void (*func) (unsigned int offset, unsigned short data,
 		unsigned short mask);
+  void (*func8) (unsigned int offset, unsigned char data);
+  void (*func32) (unsigned int offset, unsigned int data);
 } WRITEMAP;
 
 void initialise_memmap (void);
@@ -115,9 +125,17 @@ void neogeo_decode_spr (unsigned char *mem, unsigned int offset,
 			unsigned int length);
 void neogeo_decode_fix (unsigned char *mem, unsigned int offset,
 			unsigned int length);
+void neogeo_copy_spr (unsigned char *mem, unsigned int offset,
+		      const unsigned char *src, unsigned int length);
+void neogeo_copy_fix (unsigned char *mem, unsigned int offset,
+		      const unsigned char *src, unsigned int length);
 void neogeo_undecode_fix (unsigned char *mem, int offset,
 			  unsigned int length);
 void memreset (void);
+#if M68K_PROFILE
+void neogeo_memory_profile (FILE * fp);
+void neogeo_memory_profile_reset (void);
+#endif
 
 extern int watchdog_counter;
 extern int scanline;
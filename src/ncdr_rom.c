@@ -8,6 +8,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <ogc/lwp_watchdog.h>
 #include "neocdrx.h"
 #include "ncdr_rom.h"
 
@@ -20,6 +21,8 @@
 #define NEOGEO_IPL			0xFAC7
 #define NEOGEO_IPL_END		0xFAC8
 #define NEOGEO_TRACE		0xFACE
+#define BIOS_HLE		0xFAD0	/*** + index in bioshle ***/
+#define BIOS_HLE_RETURN		0xFADF
 
 typedef struct {
     unsigned short offset;
@@ -101,11 +104,865 @@ static ROMPATCH rompatch[] = {
     {0xAD36, 5}
 };
 
+/****************************************************************************
+* BIOS HLE
+*
+* Native versions of BIOS calls, each switched at runtime with
+* neogeo_bios_hle_set. A call made through the BIOS jump table (JMP abs.l)
+* gets its entry replaced with a trap and an RTS, and the last word of the
+* JMP becomes the return trap. Memory fills and copies are loops rather than
+* calls: the BIOS is searched for MOVE or CLR to (An)+ followed by a DBRA back
+* to it, and the trap goes over the MOVE.
+*
+* HLE_OFF   - BIOS code, entry left alone
+* HLE_ON    - native code, timed on the host
+* HLE_CHECK - the native code runs on a copy of RAM, VRAM and the palette,
+*             then the BIOS code runs, counting the 68K cycles it takes to
+*             return. The two are compared when it does, less the stack.
+*
+* A native call hands back to the BIOS when it meets something it doesn't
+* handle, such as an unknown MESS_OUT command, and those calls are measured
+* as HLE_CHECK ones. Calls take no 68K cycles. Loops take the cycles the
+* BIOS would, and stop at the end of the timeslice as the 68K would take an
+* interrupt there. A loop has no BIOS code left to check it against once it
+* is patched, so it has no HLE_CHECK.
+*
+* FIX_CLEAR, LSP_1ST, MESS_OUT and SYSTEM_IO are written from the BIOS call
+* documentation: run a title with HLE_CHECK before trusting one with HLE_ON.
+* Palette fades stay in the BIOS, only the copies they make are native.
+****************************************************************************/
+#define VRAM_ADDR	0x3C0000
+#define VRAM_RW		0x3C0002
+#define VRAM_MOD	0x3C0004
+
+#define HLE_RAM		0x200000	/*** PRG RAM ***/
+#define HLE_BIOS	0x80000
+#define HLE_STACK	0x400		/*** Below SP, left out of HLE_CHECK ***/
+
+typedef struct {
+    unsigned int offset;	/*** Of the MOVE or CLR ***/
+    unsigned short op;		/*** The MOVE or CLR ***/
+    unsigned short dbra;
+    int call;			/*** Index in bioshle ***/
+} HLESITE;
+
+typedef struct {
+    unsigned short offset;	/*** Jump table entry, 0 for a loop ***/
+    int (*func) (const HLESITE * site);	/*** 68K cycles, -1 for the BIOS ***/
+    void (*bios_return) (void);	/*** When the BIOS code returns ***/
+    const char *name;
+    int mode;
+    unsigned int target;	/*** Where the entry jumps in the BIOS ***/
+    unsigned short operand[2];	/*** The JMP's operand words, as found ***/
+    unsigned int calls;
+    unsigned int native;	/*** Calls run by func ***/
+    u64 time;			/*** Host time in func, in ticks ***/
+    unsigned int bios;		/*** Calls run by the BIOS, and returned ***/
+    double cycles;		/*** 68K cycles they took ***/
+    unsigned int mismatches;	/*** HLE_CHECK calls that differed ***/
+    char mismatch[20];		/*** Where the last one did ***/
+} BIOSHLE;
+
+/*** BIOS calls waiting to return ***/
+#define HLE_DEPTH 8
+
+typedef struct {
+    BIOSHLE *hle;
+    unsigned int ret;
+    unsigned int sp;
+    double start;
+    int check;			/*** Compare with the shadows on return ***/
+} HLECALL;
+
+static HLECALL hlecalls[HLE_DEPTH];
+static int hledepth = 0;
+
+#define HLE_SITES 64
+
+static HLESITE hlesites[HLE_SITES];
+static int hlenumsites = 0;
+static int hlepatched = 0;
+
+/*** HLE_CHECK copies, the native code's view while hle_shadow is set ***/
+static unsigned char *shadow_ram = NULL;
+static unsigned short *shadow_vram = NULL;
+static unsigned short *shadow_pal = NULL;
+static int shadow_pointer, shadow_modulo;
+static int hle_shadow = 0;
+static int hle_checking = 0;
+
+/****************************************************************************
+* HLE bus
+*
+* What the native code reads and writes: the 68K memory map, or the
+* shadows of PRG RAM, the VRAM port and the palette for HLE_CHECK. Reads of
+* anything else, such as the controllers, are live either way.
+****************************************************************************/
+static unsigned int hle_r8(unsigned int a)
+{
+    a &= 0xFFFFFF;
+    if (hle_shadow && a < HLE_RAM)
+	return shadow_ram[a];
+    return m68k_read_memory_8(a);
+}
+
+static unsigned int hle_r16(unsigned int a)
+{
+    a &= 0xFFFFFF;
+    if (hle_shadow && a < HLE_RAM)
+	return *(unsigned short *) (shadow_ram + a);
+    return m68k_read_memory_16(a);
+}
+
+static unsigned int hle_r32(unsigned int a)
+{
+    a &= 0xFFFFFF;
+    if (hle_shadow && a + 3 < HLE_RAM)
+	return *(unsigned int *) (shadow_ram + a);
+    return m68k_read_memory_32(a);
+}
+
+static void hle_w8(unsigned int a, unsigned int v)
+{
+    a &= 0xFFFFFF;
+    if (!hle_shadow)
+	m68k_write_memory_8(a, v);
+    else if (a < HLE_RAM)
+	shadow_ram[a] = v;
+}
+
+static void hle_w16(unsigned int a, unsigned int v)
+{
+    a &= 0xFFFFFF;
+    v &= 0xFFFF;
+    if (!hle_shadow)
+	m68k_write_memory_16(a, v);
+    else if (a < HLE_RAM)
+	*(unsigned short *) (shadow_ram + a) = v;
+    else if (a == VRAM_ADDR)
+	shadow_pointer = v;
+    else if (a == VRAM_MOD)
+	shadow_modulo = v;
+    else if (a == VRAM_RW) {
+	shadow_vram[shadow_pointer] = v;
+	shadow_pointer = (shadow_pointer & 0x8000)
+	    | ((shadow_pointer + shadow_modulo) & 0x7FFF);
+    } else if (a >= 0x400000 && a < 0x800000)
+	shadow_pal[(a >> 1) & 0xFFF] = v;
+}
+
+static void hle_w32(unsigned int a, unsigned int v)
+{
+    a &= 0xFFFFFF;
+    if (!hle_shadow)
+	m68k_write_memory_32(a, v);
+    else if (a + 3 < HLE_RAM)
+	*(unsigned int *) (shadow_ram + a) = v;
+}
+
+/****************************************************************************
+* FIX_CLEAR
+*
+* Fills the fix layer with tile $20, and the leftmost and rightmost columns
+* with tile $FF, palette 0.
+****************************************************************************/
+static int bios_fix_clear(const HLESITE * site)
+{
+    int i;
+
+    hle_w16(VRAM_MOD, 1);
+    hle_w16(VRAM_ADDR, 0x7000);
+    for (i = 0; i < 0x500; i++)
+	hle_w16(VRAM_RW, (i < 0x20 || i >= 0x4E0) ? 0x00FF : 0x0020);
+    return 0;
+}
+
+/****************************************************************************
+* LSP_1ST
+*
+* Clears the sprites: full size in SCB2, height and Y of 0 in SCB3.
+****************************************************************************/
+static int bios_lsp_1st(const HLESITE * site)
+{
+    int i;
+
+    hle_w16(VRAM_MOD, 1);
+    hle_w16(VRAM_ADDR, 0x8000);
+    for (i = 0; i < 0x200; i++)
+	hle_w16(VRAM_RW, 0x0FFF);
+
+    hle_w16(VRAM_ADDR, 0x8200);
+    for (i = 0; i < 0x200; i++)
+	hle_w16(VRAM_RW, 0);
+    return 0;
+}
+
+/****************************************************************************
+* MESS_OUT
+*
+* Writes FIX text from the message buffer, a list of pointers to command
+* lists that ends at BIOS_MESS_POINT, then empties it. Nothing is done while
+* BIOS_MESS_BUSY is set. The buffer's start is taken from BIOS_MESS_POINT
+* after the BIOS code has run once.
+*
+* Commands are words, with their arguments after them:
+*   00       end of the list          06       resume the data
+*   01 UUEE  tile upper byte, end     07 ...   data in the list, to the end
+*            code of the data                  code, then word aligned
+*   02 NNNN  auto-increment           0A LLLL  call a list
+*   03 AAAA  VRAM address             0B       return from it
+*   04 PPPP  write the data at PPPP   05 NNNN  add to the VRAM address
+* Data is bytes, each one the low byte of a tile. Each list in the buffer is
+* checked to the end first, and any other command or runaway list leaves the
+* whole call to the BIOS.
+****************************************************************************/
+#define BIOS_MESS_POINT	0x10FDBE
+#define BIOS_MESS_BUSY	0x10FDC2
+#define MESS_LISTS	64
+#define MESS_DEPTH	8
+#define MESS_LENGTH	0x1000	/*** Longest list or data, in words or bytes ***/
+
+typedef struct {
+    unsigned int data;		/*** Where the next data starts ***/
+    unsigned int addr;		/*** Last VRAM address set ***/
+    unsigned int upper;
+    int end;			/*** -1 until set ***/
+    int write;			/*** 0 for the checking pass ***/
+} MESSOUT;
+
+static unsigned int mess_buffer = 0;
+static int mess_learn = 0;
+
+static int mess_data(MESSOUT * m)
+{
+    unsigned int c;
+    int n;
+
+    if (m->end < 0)
+	return -1;
+
+    for (n = 0; n < MESS_LENGTH; n++) {
+	c = hle_r8(m->data++);
+	if (c == m->end)
+	    return 0;
+	if (m->write)
+	    hle_w16(VRAM_RW, m->upper | c);
+    }
+    return -1;
+}
+
+static int mess_list(MESSOUT * m, unsigned int list, int depth)
+{
+    unsigned int arg;
+    int n;
+
+    for (n = 0; n < MESS_LENGTH; n++) {
+	switch (hle_r16(list)) {
+	case 0x00:
+	case 0x0B:
+	    return 0;
+
+	case 0x01:
+	    arg = hle_r16(list + 2);
+	    m->upper = arg & 0xFF00;
+	    m->end = arg & 0xFF;
+	    list += 4;
+	    break;
+
+	case 0x02:
+	    if (m->write)
+		hle_w16(VRAM_MOD, hle_r16(list + 2));
+	    list += 4;
+	    break;
+
+	case 0x03:
+	    m->addr = hle_r16(list + 2);
+	    if (m->write)
+		hle_w16(VRAM_ADDR, m->addr);
+	    list += 4;
+	    break;
+
+	case 0x04:
+	    m->data = hle_r32(list + 2);
+	    if (mess_data(m))
+		return -1;
+	    list += 6;
+	    break;
+
+	case 0x05:
+	    m->addr = (m->addr + hle_r16(list + 2)) & 0xFFFF;
+	    if (m->write)
+		hle_w16(VRAM_ADDR, m->addr);
+	    list += 4;
+	    break;
+
+	case 0x06:
+	    if (mess_data(m))
+		return -1;
+	    list += 2;
+	    break;
+
+	case 0x07:
+	    m->data = list + 2;
+	    if (mess_data(m))
+		return -1;
+	    list = (m->data + 1) & ~1;
+	    break;
+
+	case 0x0A:
+	    if (depth == MESS_DEPTH
+		|| mess_list(m, hle_r32(list + 2), depth + 1))
+		return -1;
+	    list += 6;
+	    break;
+
+	default:
+	    return -1;
+	}
+    }
+    return -1;
+}
+
+static int bios_mess_out(const HLESITE * site)
+{
+    MESSOUT m;
+    unsigned int point, a;
+
+    if (hle_r8(BIOS_MESS_BUSY))
+	return 0;
+
+    point = hle_r32(BIOS_MESS_POINT);
+    if (!mess_buffer || point < mess_buffer
+	|| point > mess_buffer + MESS_LISTS * 4 || (point - mess_buffer) & 3) {
+	mess_learn = 1;
+	return -1;
+    }
+
+    for (m.write = 0; m.write < 2; m.write++) {
+	m.data = m.addr = m.upper = 0;
+	m.end = -1;
+	for (a = mess_buffer; a < point; a += 4)
+	    if (mess_list(&m, hle_r32(a), 0))
+		return -1;
+    }
+
+    hle_w32(BIOS_MESS_POINT, mess_buffer);
+    return 0;
+}
+
+/*** The BIOS leaves BIOS_MESS_POINT at the start of the buffer ***/
+static void bios_mess_return(void)
+{
+    unsigned int point = m68k_read_memory_32(BIOS_MESS_POINT);
+
+    if (mess_learn && point < HLE_RAM && !(point & 1))
+	mess_buffer = point;
+    mess_learn = 0;
+}
+
+/****************************************************************************
+* SYSTEM_IO
+*
+* Reads the controllers into the BIOS variables for players 1 and 2: 6 bytes
+* each of status (left alone), previous, current, change, repeat and timer,
+* all active high. A held input repeats after 16 frames, then every 8.
+* Start and select go to BIOS_STATCURNT and BIOS_STATCHANGE.
+****************************************************************************/
+#define BIOS_P1STATUS	0x10FD94
+#define BIOS_STATCURNT	0x10FDAC
+#define BIOS_STATCHANGE	0x10FDAD
+#define REPEAT_DELAY	16
+#define REPEAT_RATE	8
+
+static void system_io_player(unsigned int a, unsigned int current)
+{
+    unsigned int previous = hle_r8(a + 2);
+    unsigned int timer = hle_r8(a + 5);
+    unsigned int repeat;
+
+    current &= 0xFF;
+    if (current && current == previous) {
+	timer = (timer + 1) & 0xFF;
+	repeat = 0;
+	if (timer >= REPEAT_DELAY) {
+	    timer = REPEAT_DELAY - REPEAT_RATE;
+	    repeat = current;
+	}
+    } else {
+	timer = 0;
+	repeat = current & ~previous;
+    }
+
+    hle_w8(a + 1, previous);
+    hle_w8(a + 2, current);
+    hle_w8(a + 3, current & ~previous);
+    hle_w8(a + 4, repeat);
+    hle_w8(a + 5, timer);
+}
+
+static int bios_system_io(const HLESITE * site)
+{
+    unsigned int current, previous;
+
+    system_io_player(BIOS_P1STATUS, ~hle_r8(0x300000));
+    system_io_player(BIOS_P1STATUS + 6, ~hle_r8(0x340000));
+
+    current = ~hle_r8(0x380000) & 0x0F;
+    previous = hle_r8(BIOS_STATCURNT);
+    hle_w8(BIOS_STATCURNT, current);
+    hle_w8(BIOS_STATCHANGE, current & ~previous);
+    return 0;
+}
+
+/****************************************************************************
+* MEM_FILL, MEM_COPY
+*
+* The loop at a site: MOVE.W/L Dx,(Ay)+ or CLR.W/L (Ay)+ to fill, or
+* MOVE.W/L (Ax)+,(Ay)+ to copy, and DBRA Dz back to it. Runs to the end of
+* the loop or of the timeslice, leaving the registers, flags, PC and cycles
+* as the 68K would. Runs in PRG RAM are done in place, like the memory map
+* does them, anything else goes through it.
+****************************************************************************/
+static int bios_mem_loop(const HLESITE * site)
+{
+    unsigned int op = site->op;
+    int clr = (op >> 12) == 4;
+    int copy = !clr && (op & 0x38) == 0x18;
+    int size = clr ? (op >> 5) & 6 : (op >> 12) == 2 ? 4 : 2;
+    int dst = M68K_REG_A0 + ((clr ? op : op >> 9) & 7);
+    int src = (copy ? M68K_REG_A0 : M68K_REG_D0) + (op & 7);
+    int dbra = M68K_REG_D0 + (site->dbra & 7);
+    int each = (copy || clr ? (size == 4 ? 20 : 12) : (size == 4 ? 12 : 8))
+	+ 14;
+    unsigned int count = (m68k_get_reg(NULL, dbra) & 0xFFFF) + 1;
+    unsigned int d = m68k_get_reg(NULL, dst);
+    unsigned int s = copy ? m68k_get_reg(NULL, src) : 0;
+    unsigned int mask = size == 4 ? 0xFFFFFFFF : 0xFFFF;
+    unsigned int value = clr || copy ? 0 : m68k_get_reg(NULL, src) & mask;
+    unsigned int n = count, i, sr, da, sa;
+    int left = m68k_cycles_remaining();
+
+    /*** The 68K takes interrupts between iterations ***/
+    if (left < (int) (count * each))
+	n = left < each ? 1 : left / each;
+
+    da = d & 0xFFFFFF;
+    sa = s & 0xFFFFFF;
+    if (!((da | sa) & 1) && da + n * size <= HLE_RAM
+	&& (!copy || sa + n * size <= HLE_RAM)) {
+	for (i = 0; i < n; i++, da += size, sa += size) {
+	    if (size == 4) {
+		if (copy)
+		    value = *(unsigned int *) (neogeo_prg_memory + sa);
+		*(unsigned int *) (neogeo_prg_memory + da) = value;
+	    } else {
+		if (copy)
+		    value = *(unsigned short *) (neogeo_prg_memory + sa);
+		*(unsigned short *) (neogeo_prg_memory + da) = value;
+	    }
+	}
+	m68k_cache_invalidate(d, n * size);
+    } else {
+	for (i = 0; i < n; i++, d += size, s += size) {
+	    if (copy)
+		value = size == 4 ? m68k_read_memory_32(s) :
+		    m68k_read_memory_16(s);
+	    if (size == 4)
+		m68k_write_memory_32(d, value);
+	    else
+		m68k_write_memory_16(d, value);
+	}
+	d -= n * size;
+	s -= n * size;
+    }
+
+    m68k_set_reg(dst, d + n * size);
+    if (copy)
+	m68k_set_reg(src, s + n * size);
+
+    /*** N and Z of the last move, V and C clear ***/
+    sr = m68k_get_reg(NULL, M68K_REG_SR) & ~0x0F;
+    if (!(value & mask))
+	sr |= 0x04;
+    if (value & (mask ^ (mask >> 1)))
+	sr |= 0x08;
+
+    if (n == count) {
+	m68k_set_reg(dbra, m68k_get_reg(NULL, dbra) | 0xFFFF);
+	m68k_set_reg(M68K_REG_PC, 0xC00000 + site->offset + 6);
+    } else {
+	m68k_set_reg(dbra, (m68k_get_reg(NULL, dbra) & 0xFFFF0000) | (count - 1 - n));
+	m68k_set_reg(M68K_REG_PC, 0xC00000 + site->offset);
+    }
+    m68k_set_reg(M68K_REG_SR, sr);
+
+    /*** DBRA takes 14 either way in this core, less the 4 of the trap ***/
+    return n * each - 4;
+}
+
+/*** BIOS_HLE + index must stay below BIOS_HLE_RETURN ***/
+static BIOSHLE bioshle[BIOS_HLE_CALLS] = {
+    {0x4C2, bios_fix_clear, NULL, "FIX_CLEAR"},
+    {0x4C8, bios_lsp_1st, NULL, "LSP_1ST"},
+    {0x4CE, bios_mess_out, bios_mess_return, "MESS_OUT"},
+    {0x44A, bios_system_io, NULL, "SYSTEM_IO"},
+    {0, bios_mem_loop, NULL, "MEM_FILL"},
+    {0, bios_mem_loop, NULL, "MEM_COPY"}
+};
+
+#define MEM_FILL 4
+#define MEM_COPY 5
+
+/****************************************************************************
+* Loop sites
+*
+* A MOVE or CLR to (Ay)+ and a DBRA back to it. The stack pointer, and a
+* fill with the loop counter, aren't taken.
+****************************************************************************/
+static int bios_hle_loop(unsigned int op, unsigned int dbra)
+{
+    unsigned int z = dbra & 7;
+
+    if ((dbra & 0xFFF8) != 0x51C8)
+	return -1;
+
+    if (((op & 0xFFF8) == 0x4258 || (op & 0xFFF8) == 0x4298) && (op & 7) != 7)
+	return MEM_FILL;
+
+    if (((op & 0xF1F8) == 0x20C0 || (op & 0xF1F8) == 0x30C0)
+	&& ((op >> 9) & 7) != 7 && (op & 7) != z)
+	return MEM_FILL;
+
+    if (((op & 0xF1F8) == 0x20D8 || (op & 0xF1F8) == 0x30D8)
+	&& ((op >> 9) & 7) != 7 && (op & 7) != 7
+	&& ((op >> 9) & 7) != (op & 7))
+	return MEM_COPY;
+
+    return -1;
+}
+
+/*** Words under the ROM patches and the jump table entries are kept ***/
+static int bios_hle_patched(unsigned int offset)
+{
+    int i;
+
+    for (i = 0; rompatch[i].offset != 0xFFFF; i++)
+	if (rompatch[i].offset >= offset && rompatch[i].offset < offset + 6)
+	    return 1;
+
+    for (i = 0; i < BIOS_HLE_CALLS; i++)
+	if (bioshle[i].offset && bioshle[i].offset + 6 > offset
+	    && bioshle[i].offset < offset + 6)
+	    return 1;
+
+    return 0;
+}
+
+static void bios_hle_scan(void)
+{
+    unsigned short *rom = (unsigned short *) neogeo_rom_memory;
+    unsigned int i;
+    int call;
+
+    hlenumsites = 0;
+    for (i = 0; i + 2 < HLE_BIOS / 2 && hlenumsites < HLE_SITES; i++) {
+	if (rom[i + 2] != 0xFFFC)
+	    continue;
+	call = bios_hle_loop(rom[i], rom[i + 1]);
+	if (call < 0 || bios_hle_patched(i << 1))
+	    continue;
+
+	hlesites[hlenumsites].offset = i << 1;
+	hlesites[hlenumsites].op = rom[i];
+	hlesites[hlenumsites].dbra = rom[i + 1];
+	hlesites[hlenumsites].call = call;
+	hlenumsites++;
+    }
+}
+
+/*** Puts the BIOS code or the traps in place for a call's mode ***/
+static void bios_hle_patch(int i)
+{
+    BIOSHLE *hle = &bioshle[i];
+    unsigned short *entry;
+    int on = hle->mode != HLE_OFF;
+    int s;
+
+    if (hle->offset) {
+	/*** Not a JMP abs.l in this BIOS ***/
+	if (!hle->target)
+	    return;
+
+	entry = (unsigned short *) (neogeo_rom_memory + hle->offset);
+	entry[0] = on ? BIOS_HLE + i : 0x4EF9;
+	entry[1] = on ? 0x4E75 : hle->operand[0];
+	entry[2] = on ? BIOS_HLE_RETURN : hle->operand[1];
+	m68k_cache_invalidate(0xC00000 + hle->offset, 6);
+	return;
+    }
+
+    for (s = 0; s < hlenumsites; s++)
+	if (hlesites[s].call == i) {
+	    *(unsigned short *) (neogeo_rom_memory + hlesites[s].offset) =
+		on ? BIOS_HLE + i : hlesites[s].op;
+	    m68k_cache_invalidate(0xC00000 + hlesites[s].offset, 2);
+	}
+}
+
+/****************************************************************************
+* HLE_CHECK
+****************************************************************************/
+static int bios_hle_snapshot(void)
+{
+    if (!shadow_ram) {
+	shadow_ram = malloc(HLE_RAM);
+	shadow_vram = malloc(0x20000);
+	shadow_pal = malloc(0x2000);
+	if (!shadow_ram || !shadow_vram || !shadow_pal) {
+	    free(shadow_ram);
+	    free(shadow_vram);
+	    free(shadow_pal);
+	    shadow_ram = NULL;
+	    return 0;
+	}
+    }
+
+    memcpy(shadow_ram, neogeo_prg_memory, HLE_RAM);
+    memcpy(shadow_vram, video_vidram, 0x20000);
+    memcpy(shadow_pal, video_paletteram_ng, 0x2000);
+    shadow_pointer = video_pointer;
+    shadow_modulo = video_modulo;
+    return 1;
+}
+
+/*** Offset of the first difference, or -1 ***/
+static int bios_hle_differ(const void *a, const void *b, int len)
+{
+    const unsigned char *x = a, *y = b;
+    int i;
+
+    if (len <= 0 || !memcmp(a, b, len))
+	return -1;
+    for (i = 0; x[i] == y[i]; i++);
+    return i;
+}
+
+static void bios_hle_compare(BIOSHLE * hle, unsigned int sp)
+{
+    unsigned int low, high;
+    int d;
+
+    sp &= HLE_RAM - 1;
+    low = sp > HLE_STACK ? sp - HLE_STACK : 0;
+    high = sp + 4;
+
+    if ((d = bios_hle_differ(shadow_ram, neogeo_prg_memory, low)) >= 0)
+	sprintf(hle->mismatch, "ram:%06X", d);
+    else if ((d = bios_hle_differ(shadow_ram + high, neogeo_prg_memory + high,
+				  HLE_RAM - high)) >= 0)
+	sprintf(hle->mismatch, "ram:%06X", d + high);
+    else if ((d = bios_hle_differ(shadow_vram, video_vidram, 0x20000)) >= 0)
+	sprintf(hle->mismatch, "vram:%04X", d >> 1);
+    else if ((d = bios_hle_differ(shadow_pal, video_paletteram_ng,
+				  0x2000)) >= 0)
+	sprintf(hle->mismatch, "palette:%03X", d >> 1);
+    else
+	return;
+
+    hle->mismatches++;
+}
+
+/*** Runs the BIOS code of a call, returning through BIOS_HLE_RETURN ***/
+static void bios_hle_call(BIOSHLE * hle, int check)
+{
+    HLECALL *call;
+    unsigned int sp = m68k_get_reg(NULL, M68K_REG_SP);
+
+    if (hledepth < HLE_DEPTH) {
+	call = &hlecalls[hledepth++];
+	call->hle = hle;
+	call->ret = m68k_read_memory_32(sp);
+	call->sp = sp;
+	call->start = neogeo_m68k_cycles();
+	call->check = check;
+	m68k_write_memory_32(sp, 0xC00000 + hle->offset + 4);
+    } else
+	hle_checking = 0;
+
+    m68k_set_reg(M68K_REG_PC, hle->target);
+}
+
+static int bios_hle_return(void)
+{
+    HLECALL *call;
+    unsigned int sp = m68k_get_reg(NULL, M68K_REG_SP);
+
+    /*** The RTS popped sp - 4, skip calls that never returned ***/
+    while (hledepth > 0) {
+	call = &hlecalls[--hledepth];
+	if (call->check)
+	    hle_checking = 0;
+	if (call->sp + 4 != sp)
+	    continue;
+
+	call->hle->bios++;
+	call->hle->cycles += neogeo_m68k_cycles() - call->start;
+	if (call->check)
+	    bios_hle_compare(call->hle, call->sp);
+	if (call->hle->bios_return)
+	    call->hle->bios_return();
+	m68k_set_reg(M68K_REG_PC, call->ret);
+	return 0;
+    }
+    return -1;
+}
+
+/****************************************************************************
+* neogeo_bios_hle
+*
+* Called from the F-line handler for BIOS_HLE to BIOS_HLE_RETURN. Returns
+* the 68K cycles taken on top of the trap's, or -1 for traps that aren't
+* ours, which get the F-line exception.
+****************************************************************************/
+int neogeo_bios_hle(unsigned int trap)
+{
+    BIOSHLE *hle;
+    HLESITE *site;
+    unsigned int pc;
+    int cycles, check = 0;
+    u64 start;
+
+    if (trap == BIOS_HLE_RETURN)
+	return bios_hle_return();
+
+    if (trap - BIOS_HLE >= BIOS_HLE_CALLS)
+	return -1;
+    hle = &bioshle[trap - BIOS_HLE];
+    if (hle->mode == HLE_OFF)
+	return -1;
+    hle->calls++;
+
+    /*** Loops ***/
+    if (!hle->offset) {
+	pc = m68k_get_reg(NULL, M68K_REG_PPC) - 0xC00000;
+	for (site = hlesites; site < hlesites + hlenumsites; site++)
+	    if (site->offset == pc) {
+		start = gettime();
+		cycles = hle->func(site);
+		hle->time += gettime() - start;
+		hle->native++;
+		return cycles;
+	    }
+	return -1;
+    }
+
+    if (hle->mode == HLE_CHECK && !hle_checking && bios_hle_snapshot()) {
+	hle_shadow = 1;
+	start = gettime();
+	check = hle->func(NULL) >= 0;
+	hle->time += gettime() - start;
+	hle_shadow = 0;
+	hle->native += check;
+	hle_checking = check;
+    } else if (hle->mode == HLE_ON) {
+	start = gettime();
+	cycles = hle->func(NULL);
+	if (cycles >= 0) {
+	    hle->time += gettime() - start;
+	    hle->native++;
+	    return cycles;
+	}
+    }
+
+    bios_hle_call(hle, check);
+    return 0;
+}
+
+/****************************************************************************
+* neogeo_bios_hle_set
+*
+* Switches a call between HLE_OFF, HLE_ON and HLE_CHECK, and returns the
+* mode it ends up in: HLE_CHECK is HLE_OFF for the loops. Can be called
+* before neogeo_patch_rom.
+****************************************************************************/
+int neogeo_bios_hle_set(int i, int mode)
+{
+    BIOSHLE *hle = &bioshle[i];
+    int n, k;
+
+    if (mode == HLE_CHECK && !hle->offset)
+	mode = HLE_OFF;
+    if (mode == hle->mode)
+	return mode;
+
+    /*** Calls in the BIOS code return straight to their callers ***/
+    if (mode == HLE_OFF) {
+	for (n = k = 0; n < hledepth; n++)
+	    if (hlecalls[n].hle == hle) {
+		m68k_write_memory_32(hlecalls[n].sp, hlecalls[n].ret);
+		if (hlecalls[n].check)
+		    hle_checking = 0;
+	    } else
+		hlecalls[k++] = hlecalls[n];
+	hledepth = k;
+    }
+
+    hle->mode = mode;
+    if (hlepatched)
+	bios_hle_patch(i);
+    return mode;
+}
+
+int neogeo_bios_hle_get(int i)
+{
+    return bioshle[i].mode;
+}
+
+const char *neogeo_bios_hle_name(int i)
+{
+    return bioshle[i].name;
+}
+
+/****************************************************************************
+* neogeo_bios_hle_stats
+*
+* CSV of the calls since the last time: host microseconds per native call,
+* 68K cycles per call run by the BIOS code, and for HLE_CHECK the calls
+* where the two differed.
+****************************************************************************/
+void neogeo_bios_hle_stats(FILE *fp)
+{
+    static const char *modes[] = { "off", "hle", "check" };
+    BIOSHLE *hle;
+
+    fprintf(fp, "call,mode,calls,native,usec_per_native,bios,cycles_per_bios,"
+	    "mismatches,last_mismatch\n");
+    for (hle = bioshle; hle < bioshle + BIOS_HLE_CALLS; hle++) {
+	if (hle->mode != HLE_OFF)
+	    fprintf(fp, "%s,%s,%u,%u,%.2f,%u,%.0f,%u,%s\n", hle->name,
+		    modes[hle->mode], hle->calls, hle->native,
+		    hle->native ?
+		    (double) diff_usec(0, hle->time) / hle->native : 0.0,
+		    hle->bios, hle->bios ? hle->cycles / hle->bios : 0.0,
+		    hle->mismatches, hle->mismatch);
+	hle->calls = 0;
+	hle->native = 0;
+	hle->time = 0;
+	hle->bios = 0;
+	hle->cycles = 0;
+	hle->mismatches = 0;
+	hle->mismatch[0] = 0;
+    }
+}
+
 /****************************************************************************
 * neogeo_patch_rom
+*
+* Once the BIOS is loaded
 ****************************************************************************/
 void neogeo_patch_rom(void)
 {
+    unsigned short *entry;
     int i = 0;
 
     while (rompatch[i].offset != 0xFFFF) {
@@ -113,4 +970,20 @@ void neogeo_patch_rom(void)
 	    rompatch[i].patch;
 	i++;
     }
+
+	/*** BIOS HLE, only over JMP abs.l entries, the target as the 68K reads it ***/
+    for (i = 0; i < BIOS_HLE_CALLS; i++) {
+	entry = (unsigned short *) (neogeo_rom_memory + bioshle[i].offset);
+	if (bioshle[i].offset && entry[0] == 0x4EF9) {
+	    bioshle[i].operand[0] = entry[1];
+	    bioshle[i].operand[1] = entry[2];
+	    bioshle[i].target =
+		m68k_read_memory_32(0xC00000 + bioshle[i].offset + 2) & 0xFFFFFF;
+	}
+    }
+
+    bios_hle_scan();
+    hlepatched = 1;
+    for (i = 0; i < BIOS_HLE_CALLS; i++)
+	bios_hle_patch(i);
 }
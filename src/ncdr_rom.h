@@ -7,6 +7,18 @@
 #ifndef __NCDRROM__
 #define __NCDRROM__
 
+/*** BIOS HLE modes, see ncdr_rom.c ***/
+#define HLE_OFF		0
+#define HLE_ON		1
+#define HLE_CHECK	2
+
+#define BIOS_HLE_CALLS	6
+
 void neogeo_patch_rom(void);
+int neogeo_bios_hle(unsigned int trap);
+int neogeo_bios_hle_set(int i, int mode);
+int neogeo_bios_hle_get(int i);
+const char *neogeo_bios_hle_name(int i);
+void neogeo_bios_hle_stats(FILE *fp);
 
 #endif
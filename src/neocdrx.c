@@ -111,6 +111,16 @@ static void neogeo_read_gamename(void);
 static void neogeo_cdda_check(void);
 static void neogeo_run(void);
 static void neogeo_run_bios(void);
+#if M68K_FAST_RAM_STATS
+static void neogeo_fast_ram_stats(void);
+#endif
+#if M68K_PROFILE
+static void neogeo_profile(void);
+#endif
+static void neogeo_hle_stats(void);
+#if Z80_IDLE_STATS
+static void neogeo_idle_stats(void);
+#endif
 
 /*** 68K core ***/
 int mame_debug = 0;
@@ -344,6 +354,10 @@ int main(void)
 	//  Initialise Mame memory map etc
 	initialise_memmap();
 
+	//  PRG RAM and BIOS, read and written directly by recompiled code
+	m68k_drc_map(0, 0x200000, neogeo_prg_memory, 1);
+	m68k_drc_map(0xc00000, 0x80000, neogeo_rom_memory, 0);
+
 	//  Go to main menu
 	// Select Device
 	// Select title
@@ -457,6 +471,7 @@ static void neogeo_run(void)
 	StartGX();
 	InitGCAudio();
 	FrameTicker = 0;
+	capture_start();
 
 	/*** (re)start emulation ***/
 	for (;;) {
@@ -509,12 +524,17 @@ static void neogeo_run(void)
 		if (FrameTicker > 5)
 		FrameTicker = 1;
 
+		/*** Unthrottled capture doesn't wait for the vbl ***/
+		if (capture_unthrottled())
+		FrameTicker = 1;
+
 		while (FrameTicker == 0) //wait until vbl
 		usleep(50);
 
 		FrameTicker--;
 
-		/*** Update video ***/
+		/*** Update video, unless frame skip drops this frame ***/
+		if (!video_skip_frame(FrameTicker))
 		video_draw_screen1();
 
 		/*** Update input ***/
@@ -780,10 +800,27 @@ void neogeo_exit_cdplayer(void)
 ****************************************************************************/
 void neogeo_new_game(void)
 {
+	/*** The menus use the GX, let the render thread finish first ***/
+	video_render_sync();
+	capture_stop();
+
 	/*** Prevent scratching noises in menu ***/
 	AUDIO_StopDMA();
+
+#if M68K_FAST_RAM_STATS
+	neogeo_fast_ram_stats();
+#endif
+#if M68K_PROFILE
+	neogeo_profile();
+#endif
+	neogeo_hle_stats();
+#if Z80_IDLE_STATS
+	neogeo_idle_stats();
+#endif
+
 	if (!load_mainmenu() /* !load_options() */)
 	{
+	capture_start();
 	AUDIO_StartDMA();
 	return;
 	}
@@ -792,6 +829,7 @@ void neogeo_new_game(void)
 
 	/*** Clear memory, except the BIOS ROM ***/
 	memset(neogeo_prg_memory, 0, PRG_MEM);
+	m68k_cache_flush();
 	memset(neogeo_spr_memory, 0, SPR_MEM);
 	memset(neogeo_fix_memory, 0, FIX_MEM);
 	memset(neogeo_pcm_memory, 0, PCM_MEM);
@@ -808,6 +846,8 @@ void neogeo_new_game(void)
 	/*** Set memory system defaults ***/
 	memreset();
 	video_clear();
+	video_fix_flush();
+	video_scb_flush();
 	mz80_reset();
 	YM2610_sh_reset();
 
@@ -816,9 +856,124 @@ void neogeo_new_game(void)
 	cdda_init();
 
 	restart = 1;
+	capture_start();
 	AUDIO_StartDMA();
 }
 
+/****************************************************************************
+* neogeo_stats_open
+*
+* Opens a stats file in the NeoCDRX folder. Like the load stats, only goes
+* to SD / ODE.
+****************************************************************************/
+static FILE *neogeo_stats_open(const char *name)
+{
+	char path[64];
+	FILE *fp;
+
+	if (SaveDevice != 1)
+		return NULL;
+
+	sprintf(path, "/NeoCDRX/%s", name);
+	fp = fopen(path, "w");
+	if (!fp)
+	{
+		sprintf(path, "sd:/NeoCDRX/%s", name);
+		fp = fopen(path, "w");
+	}
+	return fp;
+}
+
+#if M68K_FAST_RAM_STATS
+/****************************************************************************
+* neogeo_fast_ram_stats
+*
+* 68K fast RAM hit/miss counts since the menu was last opened, for builds
+* with M68K_FAST_RAM_STATS.
+****************************************************************************/
+static void neogeo_fast_ram_stats(void)
+{
+	FILE *fp = neogeo_stats_open("fastram.csv");
+
+	if (!fp)
+		return;
+
+	m68k_fast_ram_stats(fp);
+	fclose(fp);
+}
+#endif
+
+#if M68K_PROFILE
+/****************************************************************************
+* neogeo_profile
+*
+* 68K profile since the menu was last opened, for builds with M68K_PROFILE.
+* profile.folded has the opcode counts, the PC histogram and the memory
+* handler counts, for flamegraph.pl or speedscope. Each top frame (op, pc,
+* read, write, calls) counts something different, so view them one at a time.
+* profile.csv has the counts by opcode handler, for m68kmake's PROFILE.
+****************************************************************************/
+static void neogeo_profile(void)
+{
+	FILE *fp;
+
+	fp = neogeo_stats_open("profile.folded");
+	if (fp)
+	{
+		m68k_profile_write(fp);
+		neogeo_memory_profile(fp);
+		fclose(fp);
+	}
+
+	fp = neogeo_stats_open("profile.csv");
+	if (fp)
+	{
+		m68k_profile_handlers(fp);
+		fclose(fp);
+	}
+
+	m68k_profile_reset();
+	neogeo_memory_profile_reset();
+}
+#endif
+
+/****************************************************************************
+* neogeo_hle_stats
+*
+* BIOS HLE calls since the menu was last opened (see ncdr_rom.c), when any
+* of them is on or being checked
+****************************************************************************/
+static void neogeo_hle_stats(void)
+{
+	FILE *fp;
+	int i;
+
+	for (i = 0; i < BIOS_HLE_CALLS && neogeo_bios_hle_get(i) == HLE_OFF; i++);
+	if (i == BIOS_HLE_CALLS || !(fp = neogeo_stats_open("hle.csv")))
+		return;
+
+	neogeo_bios_hle_stats(fp);
+	fclose(fp);
+}
+
+#if Z80_IDLE_STATS
+/****************************************************************************
+* neogeo_idle_stats
+*
+* Z80 idle share per frame since the menu was last opened (see cpuintf.c)
+****************************************************************************/
+static void neogeo_idle_stats(void)
+{
+	FILE *fp = neogeo_stats_open("z80idle.csv");
+
+	if (!fp)
+		return;
+
+	neogeo_z80_idle_stats(fp);
+	fclose(fp);
+}
+#endif
+
 /****************************************************************************
 * neogeo_run_bios
 ****************************************************************************/
@@ -859,6 +1014,7 @@ static void neogeo_run_bios(void)
 void neogeo_ipl_end(void)
 {
 	memcpy(neogeo_prg_memory, neogeo_game_vectors, 0x100);
+	m68k_cache_invalidate(0, 0x100);
 
 	m68k_write_memory_8(0x10FD83, neogeo_region);
 	m68k_write_memory_16(0xff011c, ~(neogeo_region << 8));
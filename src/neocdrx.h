@@ -37,10 +37,14 @@ typedef unsigned int Uint32;
 #include "memory.h"
 #include "cpuintf.h"
 #include "cdrom.h"
+#include "cdcache.h"
+#include "loadprof.h"
 #include "cdaudio.h"
 #include "patches.h"
 #include "video.h"
 #include "gxvideo.h"
+#include "scale2x.h"
+#include "capture.h"
 #include "pd4990a.h"
 #include "input.h"
 #include "timer.h"
@@ -92,6 +96,13 @@ extern unsigned char VideoMode;         /* 0=Auto,1=480p,2=480i */
 extern unsigned char SkipBios;          /* 0=False, 1=True */
 extern unsigned char CropOverscan;      /* 0=False, 1=True */
 extern unsigned char FilterMode;        /* 0=Nearest (pixel-perfect), 1=Bilinear */
+extern unsigned char LoadStats;         /* 0=Off, 1=CSV, 2=CSV+Overlay */
+extern unsigned char CpuCore;           /* 0=Linked block cache, 1=Plain interpreter, 2=Recompiler */
+extern unsigned char RenderThread;      /* 0=Off, 1=On */
+extern unsigned char FrameSkip;         /* 0=Off, 1=Auto, 2=Fixed */
+extern unsigned char SkipCount;         /* 1-5, most in a row for Auto */
+extern unsigned char Scaler;            /* 0=Off, 1=Scale2x, 2=xBR-lite */
+extern unsigned char Capture;           /* 0=Off, 1=Live, 2=Fast */
 extern int dirsel_back_to_main;         /* set by DirSelector to signal return-to-main */
 extern int use_SD;
 extern int use_USB;
@@ -123,6 +123,7 @@ mixer_update_audio (void)
   /*** Update from sound core ***/
   streamupdate (3200);
   MP3MixAudio (mp3buffer, (u8 *) play_buffer, 3200);
+  capture_audio (mp3buffer, 3200);
 
   /*** Update the mixbuffer ***/
   for (i = 0; i < 800; i++)
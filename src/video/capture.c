@@ -0,0 +1,654 @@
+/****************************************************************************
+*   NeoCDRX
+*   NeoGeo CD Emulator
+*   NeoCD Redux - Copyright (C) 2007 softdev
+****************************************************************************/
+
+/****************************************************************************
+* Capture
+*
+* Every emulated frame and its 1/60s of sound go into an uncompressed AVI,
+* 24 bit RGB at 60fps with 16 bit stereo PCM at 48kHz, in /NeoCDRX on the
+* save device. As with the prefs, the folder is never created.
+*
+* The emulation only copies the frame, before the overlays are drawn, and
+* the sound into two small rings; a low priority thread converts and writes
+* them. In Live mode a full ring drops the frame, and the writer puts an
+* empty chunk (the previous frame again) or silence in its place, as it
+* does for frames the frame skip didn't draw, so the streams stay in step.
+* Fast mode instead runs the emulation unthrottled and waits for the writer,
+* for headless runs that want every frame, and shows the encode rate.
+*
+* Files are split before AVI 1.0 limits, and the totals of each capture are
+* appended to /NeoCDRX/capture.csv.
+****************************************************************************/
+#include <gccore.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include <unistd.h>
+#include <ogc/lwp_watchdog.h>
+#include "neocdrx.h"
+
+#define CAPTURE_FRAMES  8	/*** video ring, 140K each ***/
+#define CAPTURE_CHUNKS  32	/*** sound ring ***/
+#define CAPTURE_CHUNK   3200	/*** 800 stereo samples, one frame ***/
+#define CAPTURE_INDEX   16384	/*** idx1 entries per file ***/
+#define CAPTURE_SPLIT   (1000 << 20)
+#define CAPTURE_PRIO    40
+#define CAPTURE_STACK   0x8000
+
+#define CAPTURE_PIXELS  (NEOSCR_WIDTH * NEOSCR_HEIGHT)
+#define CAPTURE_BYTES   (CAPTURE_PIXELS * 3)
+#define CAPTURE_HEADER  326	/*** RIFF, hdrl and the movi LIST ***/
+
+#define CAPTURE_PATH_A  "/NeoCDRX/cap%04d_%02d.avi"
+#define CAPTURE_PATH_B  "sd:/NeoCDRX/cap%04d_%02d.avi"
+#define CAPTURE_LOG_A   "/NeoCDRX/capture.csv"
+#define CAPTURE_LOG_B   "sd:/NeoCDRX/capture.csv"
+
+typedef struct
+{
+  unsigned short pixels[CAPTURE_PIXELS];
+  int repeats;			/*** frames not captured just before ***/
+} CAPFRAME;
+
+typedef struct
+{
+  char data[CAPTURE_CHUNK];
+  int silent;			/*** chunks not captured just before ***/
+} CAPCHUNK;
+
+int capture_active = 0;
+
+static int mode;
+static CAPFRAME *frames = NULL;
+static CAPCHUNK *chunks = NULL;
+static volatile int frame_head, frame_tail;
+static volatile int chunk_head, chunk_tail;
+static int frame_lost, chunk_lost;
+
+/*** Writer ***/
+static unsigned char *rgb = NULL;
+static unsigned char *idx = NULL;
+static unsigned char pcm[CAPTURE_CHUNK];
+static int idx_count;
+static FILE *fp = NULL;
+static int session, part;
+static unsigned int movi_bytes;
+static unsigned int file_frames, file_chunks;
+
+/*** Totals for the log ***/
+static unsigned int total_frames, total_repeats, total_dropped;
+static unsigned int total_video, total_sound;
+static unsigned long long total_bytes;
+static u64 start_time;
+
+/*** Encode rate for the overlay ***/
+static u64 second_start;
+static int second_frames;
+static char status[24];
+
+static int started = 0;
+static lwp_t capture_lwp;
+static sem_t capture_ready;
+
+/****************************************************************************
+* Little endian fields, whatever the CPU
+****************************************************************************/
+static unsigned char *
+capture_put32 (unsigned char *p, unsigned int v)
+{
+  p[0] = v;
+  p[1] = v >> 8;
+  p[2] = v >> 16;
+  p[3] = v >> 24;
+  return p + 4;
+}
+
+static unsigned char *
+capture_put16 (unsigned char *p, unsigned int v)
+{
+  p[0] = v;
+  p[1] = v >> 8;
+  return p + 2;
+}
+
+static unsigned char *
+capture_putid (unsigned char *p, const char *id)
+{
+  memcpy (p, id, 4);
+  return p + 4;
+}
+
+/****************************************************************************
+* capture_header
+*
+* RIFF header, the two stream headers and the start of the movi LIST, for
+* the current file and what has been written to it so far.
+****************************************************************************/
+static void
+capture_header (unsigned char *h)
+{
+  unsigned char *p = h;
+
+  p = capture_putid (p, "RIFF");
+  p = capture_put32 (p, CAPTURE_HEADER + movi_bytes + idx_count * 16);
+  p = capture_putid (p, "AVI ");
+
+  p = capture_putid (p, "LIST");
+  p = capture_put32 (p, 294);
+  p = capture_putid (p, "hdrl");
+
+  p = capture_putid (p, "avih");
+  p = capture_put32 (p, 56);
+  p = capture_put32 (p, 16667);	/* us per frame */
+  p = capture_put32 (p, (CAPTURE_BYTES + CAPTURE_CHUNK) * 60);
+  p = capture_put32 (p, 0);
+  p = capture_put32 (p, 0x110);	/* AVIF_HASINDEX | AVIF_ISINTERLEAVED */
+  p = capture_put32 (p, file_frames);
+  p = capture_put32 (p, 0);
+  p = capture_put32 (p, 2);
+  p = capture_put32 (p, CAPTURE_BYTES + 8);
+  p = capture_put32 (p, NEOSCR_WIDTH);
+  p = capture_put32 (p, NEOSCR_HEIGHT);
+  memset (p, 0, 16);
+  p += 16;
+
+  /*** Video, bottom up 24 bit DIB ***/
+  p = capture_putid (p, "LIST");
+  p = capture_put32 (p, 116);
+  p = capture_putid (p, "strl");
+  p = capture_putid (p, "strh");
+  p = capture_put32 (p, 56);
+  p = capture_putid (p, "vids");
+  p = capture_putid (p, "DIB ");
+  p = capture_put32 (p, 0);
+  p = capture_put32 (p, 0);
+  p = capture_put32 (p, 0);
+  p = capture_put32 (p, 1);	/* scale */
+  p = capture_put32 (p, 60);	/* rate */
+  p = capture_put32 (p, 0);
+  p = capture_put32 (p, file_frames);
+  p = capture_put32 (p, CAPTURE_BYTES);
+  p = capture_put32 (p, 0xffffffff);
+  p = capture_put32 (p, 0);
+  p = capture_put16 (p, 0);
+  p = capture_put16 (p, 0);
+  p = capture_put16 (p, NEOSCR_WIDTH);
+  p = capture_put16 (p, NEOSCR_HEIGHT);
+  p = capture_putid (p, "strf");
+  p = capture_put32 (p, 40);
+  p = capture_put32 (p, 40);
+  p = capture_put32 (p, NEOSCR_WIDTH);
+  p = capture_put32 (p, NEOSCR_HEIGHT);
+  p = capture_put16 (p, 1);
+  p = capture_put16 (p, 24);
+  p = capture_put32 (p, 0);	/* BI_RGB */
+  p = capture_put32 (p, CAPTURE_BYTES);
+  memset (p, 0, 16);
+  p += 16;
+
+  /*** Sound, 16 bit stereo PCM ***/
+  p = capture_putid (p, "LIST");
+  p = capture_put32 (p, 94);
+  p = capture_putid (p, "strl");
+  p = capture_putid (p, "strh");
+  p = capture_put32 (p, 56);
+  p = capture_putid (p, "auds");
+  p = capture_put32 (p, 0);
+  p = capture_put32 (p, 0);
+  p = capture_put32 (p, 0);
+  p = capture_put32 (p, 0);
+  p = capture_put32 (p, 4);	/* scale, one stereo sample */
+  p = capture_put32 (p, SAMPLE_RATE * 4);
+  p = capture_put32 (p, 0);
+  p = capture_put32 (p, file_chunks * (CAPTURE_CHUNK / 4));
+  p = capture_put32 (p, CAPTURE_CHUNK);
+  p = capture_put32 (p, 0xffffffff);
+  p = capture_put32 (p, 4);
+  memset (p, 0, 8);
+  p += 8;
+  p = capture_putid (p, "strf");
+  p = capture_put32 (p, 18);
+  p = capture_put16 (p, 1);	/* WAVE_FORMAT_PCM */
+  p = capture_put16 (p, 2);
+  p = capture_put32 (p, SAMPLE_RATE);
+  p = capture_put32 (p, SAMPLE_RATE * 4);
+  p = capture_put16 (p, 4);
+  p = capture_put16 (p, 16);
+  p = capture_put16 (p, 0);
+
+  p = capture_putid (p, "LIST");
+  p = capture_put32 (p, movi_bytes + 4);
+  capture_putid (p, "movi");
+}
+
+/****************************************************************************
+* capture_open / capture_close
+*
+* One part of a capture. The header is written again with the totals, and
+* the index added, when the part is closed.
+****************************************************************************/
+static FILE *
+capture_fopen (int n, const char *how)
+{
+  char path[64];
+  FILE *f;
+
+  sprintf (path, CAPTURE_PATH_A, n, part);
+  f = fopen (path, how);
+  if (!f)
+    {
+      sprintf (path, CAPTURE_PATH_B, n, part);
+      f = fopen (path, how);
+    }
+  return f;
+}
+
+static int
+capture_open (void)
+{
+  unsigned char h[CAPTURE_HEADER];
+
+  fp = capture_fopen (session, "wb");
+  if (!fp)
+    return 0;
+
+  movi_bytes = 0;
+  file_frames = file_chunks = 0;
+  idx_count = 0;
+
+  capture_header (h);
+  fwrite (h, 1, CAPTURE_HEADER, fp);
+  return 1;
+}
+
+static void
+capture_close (void)
+{
+  unsigned char h[CAPTURE_HEADER];
+
+  if (!fp)
+    return;
+
+  capture_putid (h, "idx1");
+  capture_put32 (h + 4, idx_count * 16);
+  fwrite (h, 1, 8, fp);
+  fwrite (idx, 16, idx_count, fp);
+
+  capture_header (h);
+  fseek (fp, 0, SEEK_SET);
+  fwrite (h, 1, CAPTURE_HEADER, fp);
+  fclose (fp);
+  fp = NULL;
+}
+
+/****************************************************************************
+* capture_chunk
+*
+* Adds a chunk to the movi LIST and the index, going on to the next part
+* first when this one is full.
+****************************************************************************/
+static void
+capture_chunk (const char *id, const void *data, int bytes)
+{
+  unsigned char head[8], *e;
+
+  if (fp && (idx_count == CAPTURE_INDEX
+	     || movi_bytes + 8 + bytes > CAPTURE_SPLIT))
+    {
+      capture_close ();
+      part++;
+      capture_open ();
+    }
+
+  if (!fp)
+    return;
+
+  e = idx + idx_count++ * 16;
+  capture_putid (e, id);
+  capture_put32 (e + 4, 0x10);	/* AVIIF_KEYFRAME */
+  capture_put32 (e + 8, movi_bytes + 4);
+  capture_put32 (e + 12, bytes);
+
+  capture_putid (head, id);
+  capture_put32 (head + 4, bytes);
+  fwrite (head, 1, 8, fp);
+  if (bytes)
+    fwrite (data, 1, bytes, fp);
+
+  movi_bytes += 8 + bytes;
+  total_bytes += 8 + bytes;
+}
+
+/*** An empty video chunk shows the previous frame again ***/
+static void
+capture_repeat (void)
+{
+  capture_chunk ("00db", NULL, 0);
+  file_frames++;
+  total_video++;
+  total_repeats++;
+}
+
+static void
+capture_silence (void)
+{
+  memset (pcm, 0, CAPTURE_CHUNK);
+  capture_chunk ("01wb", pcm, CAPTURE_CHUNK);
+  file_chunks++;
+  total_sound++;
+}
+
+/****************************************************************************
+* capture_write_frame
+*
+* RGB565 to bottom up BGR24
+****************************************************************************/
+static void
+capture_write_frame (const CAPFRAME * f)
+{
+  const unsigned short *src;
+  unsigned char *dst = rgb;
+  int i, x, y, c;
+
+  for (i = 0; i < f->repeats; i++)
+    capture_repeat ();
+
+  for (y = NEOSCR_HEIGHT - 1; y >= 0; y--)
+    {
+      src = f->pixels + y * NEOSCR_WIDTH;
+      for (x = 0; x < NEOSCR_WIDTH; x++)
+	{
+	  c = *src++;
+	  *dst++ = ((c & 0x1f) << 3) | ((c >> 2) & 7);
+	  *dst++ = ((c >> 3) & 0xfc) | ((c >> 9) & 3);
+	  *dst++ = ((c >> 8) & 0xf8) | (c >> 13);
+	}
+    }
+
+  capture_chunk ("00db", rgb, CAPTURE_BYTES);
+  file_frames++;
+  total_video++;
+  total_frames++;
+}
+
+/*** Native 16 bit samples to little endian ***/
+static void
+capture_write_chunk (const CAPCHUNK * c)
+{
+  const s16 *s = (const s16 *) c->data;
+  int i;
+
+  for (i = 0; i < c->silent; i++)
+    capture_silence ();
+
+  for (i = 0; i < CAPTURE_CHUNK / 2; i++)
+    {
+      pcm[i * 2] = s[i];
+      pcm[i * 2 + 1] = s[i] >> 8;
+    }
+
+  capture_chunk ("01wb", pcm, CAPTURE_CHUNK);
+  file_chunks++;
+  total_sound++;
+}
+
+/****************************************************************************
+* capture_thread
+*
+* Takes one entry per post, a frame then its sound, so the streams stay
+* interleaved. The ring tail only moves once the entry is written.
+****************************************************************************/
+static void *
+capture_thread (void *arg)
+{
+  u64 now;
+
+  for (;;)
+    {
+      LWP_SemWait (capture_ready);
+
+      if (frame_tail != frame_head
+	  && (chunk_tail == chunk_head || total_video <= total_sound))
+	{
+	  capture_write_frame (&frames[frame_tail]);
+
+	  second_frames++;
+	  now = gettime ();
+	  if (diff_usec (second_start, now) >= 1000000)
+	    {
+	      sprintf (status, "CAP %d FPS", second_frames);
+	      second_frames = 0;
+	      second_start = now;
+	    }
+
+	  frame_tail = (frame_tail + 1) % CAPTURE_FRAMES;
+	}
+      else
+	{
+	  capture_write_chunk (&chunks[chunk_tail]);
+	  chunk_tail = (chunk_tail + 1) % CAPTURE_CHUNKS;
+	}
+    }
+
+  return NULL;
+}
+
+/****************************************************************************
+* capture_frame
+*
+* Called with each frame drawn, and the number of frames the frame skip
+* didn't draw just before it.
+****************************************************************************/
+void
+capture_frame (const unsigned short *buffer, int repeats)
+{
+  int next;
+
+  if (!capture_active)
+    return;
+
+  next = (frame_head + 1) % CAPTURE_FRAMES;
+  if (next == frame_tail)
+    {
+      if (mode == CAPTURE_FAST)
+	{
+	  while (next == frame_tail)
+	    usleep (100);
+	}
+      else
+	{
+	  frame_lost += repeats + 1;
+	  total_dropped++;
+	  return;
+	}
+    }
+
+  frames[frame_head].repeats = frame_lost + repeats;
+  frame_lost = 0;
+  memcpy (frames[frame_head].pixels, buffer, CAPTURE_PIXELS * 2);
+  frame_head = next;
+  LWP_SemPost (capture_ready);
+}
+
+/****************************************************************************
+* capture_audio
+*
+* Called with each frame of sound from the mixer.
+****************************************************************************/
+void
+capture_audio (const char *buffer, int bytes)
+{
+  int next;
+
+  if (!capture_active)
+    return;
+
+  next = (chunk_head + 1) % CAPTURE_CHUNKS;
+  if (next == chunk_tail)
+    {
+      if (mode == CAPTURE_FAST)
+	{
+	  while (next == chunk_tail)
+	    usleep (100);
+	}
+      else
+	{
+	  chunk_lost++;
+	  return;
+	}
+    }
+
+  if (bytes > CAPTURE_CHUNK)
+    bytes = CAPTURE_CHUNK;
+
+  chunks[chunk_head].silent = chunk_lost;
+  chunk_lost = 0;
+  memcpy (chunks[chunk_head].data, buffer, bytes);
+  memset (chunks[chunk_head].data + bytes, 0, CAPTURE_CHUNK - bytes);
+  chunk_head = next;
+  LWP_SemPost (capture_ready);
+}
+
+/****************************************************************************
+* capture_log
+****************************************************************************/
+static void
+capture_log (unsigned int ms)
+{
+  FILE *log = fopen (CAPTURE_LOG_A, "a");
+
+  if (!log)
+    log = fopen (CAPTURE_LOG_B, "a");
+  if (!log)
+    return;
+
+  if (ftell (log) == 0)
+    fprintf (log, "capture,parts,mode,frames,repeats,dropped,sound,bytes,"
+	     "seconds,encode_fps\n");
+
+  fprintf (log, "%d,%d,%s,%u,%u,%u,%u,%llu,%u.%03u,%u\n",
+	   session, part + 1, mode == CAPTURE_FAST ? "Fast" : "Live",
+	   total_frames, total_repeats, total_dropped, total_sound,
+	   total_bytes, ms / 1000, ms % 1000,
+	   ms ? (unsigned int) ((u64) total_frames * 1000 / ms) : 0);
+  fclose (log);
+}
+
+static void
+capture_free (void)
+{
+  free (frames);
+  free (chunks);
+  free (rgb);
+  free (idx);
+  frames = NULL;
+  chunks = NULL;
+  rgb = NULL;
+  idx = NULL;
+}
+
+/****************************************************************************
+* capture_start
+*
+* Starts a new capture when Capture is on, to the first free capNNNN.
+****************************************************************************/
+void
+capture_start (void)
+{
+  FILE *f;
+
+  if (capture_active || Capture == CAPTURE_OFF || SaveDevice != 1)
+    return;
+
+  frames = memalign (32, sizeof (CAPFRAME) * CAPTURE_FRAMES);
+  chunks = memalign (32, sizeof (CAPCHUNK) * CAPTURE_CHUNKS);
+  rgb = memalign (32, CAPTURE_BYTES);
+  idx = memalign (32, CAPTURE_INDEX * 16);
+  if (!frames || !chunks || !rgb || !idx)
+    {
+      capture_free ();
+      return;
+    }
+
+  part = 0;
+  for (session = 0; session < 10000; session++)
+    {
+      if ((f = capture_fopen (session, "rb")) == NULL)
+	break;
+      fclose (f);
+    }
+
+  if (session == 10000 || !capture_open ())
+    {
+      capture_free ();
+      return;
+    }
+
+  if (!started)
+    {
+      LWP_SemInit (&capture_ready, 0, CAPTURE_FRAMES + CAPTURE_CHUNKS);
+      LWP_CreateThread (&capture_lwp, capture_thread, NULL, NULL,
+			CAPTURE_STACK, CAPTURE_PRIO);
+      started = 1;
+    }
+
+  frame_head = frame_tail = 0;
+  chunk_head = chunk_tail = 0;
+  frame_lost = chunk_lost = 0;
+  total_frames = total_repeats = total_dropped = 0;
+  total_video = total_sound = 0;
+  total_bytes = 0;
+  second_frames = 0;
+  status[0] = 0;
+  mode = Capture;
+  start_time = second_start = gettime ();
+  capture_active = 1;
+}
+
+/****************************************************************************
+* capture_stop
+*
+* Waits for the writer to empty the rings, fills in what was lost at the
+* end and closes the file. The render thread must be idle.
+****************************************************************************/
+void
+capture_stop (void)
+{
+  unsigned int ms;
+
+  if (!capture_active)
+    return;
+
+  capture_active = 0;
+  while (frame_tail != frame_head || chunk_tail != chunk_head)
+    usleep (1000);
+
+  ms = ticks_to_millisecs (diff_ticks (start_time, gettime ()));
+
+  for (; frame_lost; frame_lost--)
+    capture_repeat ();
+  for (; chunk_lost; chunk_lost--)
+    capture_silence ();
+
+  capture_close ();
+  capture_log (ms);
+  capture_free ();
+}
+
+/*** Fast mode doesn't wait for the retrace ***/
+int
+capture_unthrottled (void)
+{
+  return capture_active && mode == CAPTURE_FAST;
+}
+
+/*** Overlay text, once the first second is in ***/
+const char *
+capture_status (void)
+{
+  return capture_active && status[0] ? status : NULL;
+}
@@ -0,0 +1,28 @@
+/****************************************************************************
+*   NeoCDRX
+*   NeoGeo CD Emulator
+*   NeoCD Redux - Copyright (C) 2007 softdev
+****************************************************************************/
+
+/****************************************************************************
+* Capture
+*
+* Frames and sound written to an uncompressed AVI on the save device.
+****************************************************************************/
+#ifndef __CAPTURE__
+#define __CAPTURE__
+
+#define CAPTURE_OFF   0
+#define CAPTURE_LIVE  1		/*** drops frames the writer can't keep up with ***/
+#define CAPTURE_FAST  2		/*** unthrottled, waits for the writer instead ***/
+
+extern int capture_active;
+
+void capture_start (void);
+void capture_stop (void);
+void capture_frame (const unsigned short *buffer, int repeats);
+void capture_audio (const char *buffer, int bytes);
+int capture_unthrottled (void);
+const char *capture_status (void);
+
+#endif
@@ -74,28 +74,154 @@ draw_fix (u16 code, u16 colour, u16 sx, u16 sy, u16 * palette,
 }
 
 
-/* Draw entire Character Foreground */
+/****************************************************************************
+* FIX layer cache
+*
+* Each of the 40x28 cells is kept drawn in RGB565, with a mask of the
+* screen pixels it leaves alone, and is only redrawn when its map word, its
+* palette or the FIX tiles change. The map words are marked in
+* video_fix_dirty from neogeo_vidram16_data_w, the palettes in
+* video_fix_paldirty by video_update_palette; anything else (tile loads,
+* bank switches, resets) calls video_fix_flush. A frame then only merges
+* the non empty cells into the screen, two pixels per word. The bits a frame
+* is drawn with come through its VIDEO_FRAME, as a render job takes them
+* from the live ones at vblank. video_update_fix brings the cache up to
+* date once a frame, then video_draw_fix merges it one band at a time.
+****************************************************************************/
+unsigned int video_fix_dirty[40];
+unsigned int video_fix_paldirty;
+
+static u16 fix_key[40][28];
+static u32 fix_pixels[40][28][32];
+static u32 fix_keep[40][28][32];
+
+/*** Non empty cells, as x << 5 | y ***/
+static u16 fix_cells[40 * 28];
+static int fix_count;
+static u8 fix_used[40][28];
+
+/* Redraw everything next frame */
 void
-video_draw_fix (void)
+video_fix_flush (void)
 {
-  u16 x, y;
-  u16 code, colour;
-  u16 *fixarea = (u16 *)(video_vidram + 0xE004);
+  memset (video_fix_dirty, 0xff, sizeof (video_fix_dirty));
+}
+
+/* Draw one cell into the cache */
+static void
+fix_cache_cell (int x, int y, u16 key, u16 * palette)
+{
+  u8 r, i, opaque;
+  u16 *dest = (u16 *) fix_pixels[x][y];
+  u16 *keep = (u16 *) fix_keep[x][y];
+  u16 *paldata = &palette[(key & 0xf000) >> 8];
+  u32 mydword, col;
+  u32 *fix;
+
+  fix_key[x][y] = key;
+  fix_used[x][y] = video_fix_usage[key & 0xfff];
+  if (!fix_used[x][y])
+    return;
+
+  opaque = fix_used[x][y] & 1;
+  fix = (u32 *) & (neogeo_fix_memory[(key & 0xfff) << 5]);
 
-  for (y = 0; y < 28; y++)
+  for (r = 0; r < 8; r++)
     {
-      for (x = 0; x < 40; x++)
+      mydword = *fix++;
+      for (i = 0; i < 8; i++)
 	{
-	  code = fixarea[x << 5];
+	  col = (mydword >> (i << 2)) & 0x0f;
+	  if (col || opaque)
+	    {
+	      dest[i] = paldata[col];
+	      keep[i] = 0;
+	    }
+	  else
+	    {
+	      dest[i] = 0;
+	      keep[i] = 0xffff;
+	    }
+	}
+      dest += 8;
+      keep += 8;
+    }
+}
+
+/* Redraw the changed cells */
+void
+video_update_fix (VIDEO_FRAME * frame)
+{
+  int x, y, changed = 0;
+  u32 dirty;
+  u16 *fixarea = (u16 *) (frame->vidram + 0xE000);
+  u32 *fix_dirty = frame->fix_dirty;
+  u32 paldirty = *frame->fix_paldirty;
 
-	  colour = (code & 0xf000) >> 8;
-	  code &= 0xfff;
+  /*** Cells using a changed palette ***/
+  if (paldirty)
+    {
+      for (x = 0; x < 40; x++)
+	for (y = 0; y < 28; y++)
+	  if (paldirty & (1 << (fix_key[x][y] >> 12)))
+	    fix_dirty[x] |= 1 << (y + 2);
+      *frame->fix_paldirty = 0;
+    }
 
-	  if (video_fix_usage[code])
-	    draw_fix (code, colour, (x << 3), (y << 3), video_paletteram_pc,
-		      neogeo_fix_memory, video_fix_usage[code] & 1);
+  /*** Redraw the dirty cells, map rows 2-29 are visible ***/
+  for (x = 0; x < 40; x++)
+    {
+      dirty = (fix_dirty[x] >> 2) & 0x0fffffff;
+      fix_dirty[x] = 0;
+      for (y = 0; dirty; y++, dirty >>= 1)
+	if (dirty & 1)
+	  {
+	    fix_cache_cell (x, y, fixarea[(x << 5) + y + 2], frame->palette);
+	    changed = 1;
+	  }
+    }
+
+  if (changed)
+    {
+      fix_count = 0;
+      for (x = 0; x < 40; x++)
+	for (y = 0; y < 28; y++)
+	  if (fix_used[x][y])
+	    fix_cells[fix_count++] = (x << 5) | y;
+    }
+}
+
+/* Draw the Character Foreground of lines y0 to y1 - 1 */
+void
+video_draw_fix (int y0, int y1)
+{
+  int x, y, r, r0, r1, i;
+  u32 *src, *keep, *dest;
+
+  /*** Merge into the screen over the sprites ***/
+  for (i = 0; i < fix_count; i++)
+    {
+      x = fix_cells[i] >> 5;
+      y = fix_cells[i] & 31;
+      r0 = y0 - (y << 3);
+      r1 = y1 - (y << 3);
+      if (r0 >= 8 || r1 <= 0)
+	continue;
+      if (r0 < 0)
+	r0 = 0;
+      if (r1 > 8)
+	r1 = 8;
+      src = fix_pixels[x][y] + (r0 << 2);
+      keep = fix_keep[x][y] + (r0 << 2);
+
+      for (r = r0; r < r1; r++, src += 4, keep += 4)
+	{
+	  dest = (u32 *) (video_line_ptr[(y << 3) + r] + (x << 3));
+	  dest[0] = (dest[0] & keep[0]) | src[0];
+	  dest[1] = (dest[1] & keep[1]) | src[1];
+	  dest[2] = (dest[2] & keep[2]) | src[2];
+	  dest[3] = (dest[3] & keep[3]) | src[3];
 	}
-      fixarea++;
     }
 }
 
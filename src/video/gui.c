@@ -8,9 +8,11 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stddef.h>
 #include <math.h>
 #include <zlib.h>
 #include "neocdrx.h"
+#include "ncdr_rom.h"
 #include "iso9660.h"
 #include <ogc/dvd.h>
 #include "backdrop.h"
@@ -92,12 +94,29 @@ unsigned char VideoMode = 0;              // 0=Auto,1=480p,2=480i
 unsigned char SkipBios = 0;               // 0=False, 1=True
 unsigned char CropOverscan = 1;           // 0=False, 1=True
 unsigned char FilterMode = 1;             // 0=Nearest, 1=Bilinear
+unsigned char LoadStats = 0;              // 0=Off, 1=CSV, 2=CSV+Overlay
+unsigned char CpuCore = 0;                // 0=Linked block cache, 1=Plain interpreter, 2=Recompiler
+unsigned char RenderThread = 0;           // 0=Off, 1=On
+unsigned char FrameSkip = 0;              // 0=Off, 1=Auto, 2=Fixed
+unsigned char SkipCount = 2;              // 1-5
+unsigned char Scaler = 0;                 // 0=Off, 1=Scale2x, 2=xBR-lite
+unsigned char Capture = 0;                // 0=Off, 1=Live, 2=Fast
+unsigned char ReadAhead = 0;              // 0=64KB, 1=128KB, 2=Off, 3=16KB, 4=32KB
+unsigned char BiosHle[BIOS_HLE_CALLS];    // HLE_OFF, HLE_ON, HLE_CHECK per BIOS call
+
+/* Read-ahead window for each ReadAhead value */
+static const int read_ahead_sizes[] = { 65536, 131072, 0, 16384, 32768 };
+static const char *read_ahead_labels[] = { "64KB", "128KB", "Off", "16KB", "32KB" };
+#define READ_AHEAD_COUNT  5
 
 /* Prefs file path — tried bare (GC/ODE) then sd: prefix (Wii) */
 #define PREFS_PATH_A  "/NeoCDRX/NeoCDRXprefs.bin"
 #define PREFS_PATH_B  "sd:/NeoCDRX/NeoCDRXprefs.bin"
 
-typedef struct { unsigned char SaveDevice; unsigned char DefaultLoadDevice; unsigned char neogeo_region; unsigned char MenuTrigger; unsigned char VideoMode; unsigned char SkipBios; unsigned char CropOverscan; unsigned char FilterMode; } NeoPrefs;
+typedef struct { unsigned char SaveDevice; unsigned char DefaultLoadDevice; unsigned char neogeo_region; unsigned char MenuTrigger; unsigned char VideoMode; unsigned char SkipBios; unsigned char CropOverscan; unsigned char FilterMode; unsigned char LoadStats; unsigned char CpuCore; unsigned char RenderThread; unsigned char FrameSkip; unsigned char SkipCount; unsigned char Scaler; unsigned char Capture; unsigned char ReadAhead; unsigned char BiosHle[BIOS_HLE_CALLS]; } NeoPrefs;
+
+/* Prefs files from older builds stop here; later fields keep their defaults */
+#define PREFS_MIN_SIZE  offsetof(NeoPrefs, LoadStats)
 
 void save_prefs(void)
 {
@@ -110,6 +129,15 @@ void save_prefs(void)
   p.SkipBios = SkipBios;
   p.CropOverscan = CropOverscan;
   p.FilterMode = FilterMode;
+  p.LoadStats = LoadStats;
+  p.CpuCore = CpuCore;
+  p.RenderThread = RenderThread;
+  p.FrameSkip = FrameSkip;
+  p.SkipCount = SkipCount;
+  p.Scaler = Scaler;
+  p.Capture = Capture;
+  p.ReadAhead = ReadAhead;
+  memcpy(p.BiosHle, BiosHle, sizeof(BiosHle));
 
   /* Try subdirectory paths first, then fall back to root of the filesystem.
    * Do NOT call mkdir() — the devkitPPC newlib stub crashes on GC when the
@@ -125,10 +153,12 @@ void save_prefs(void)
 void load_prefs(void)
 {
   NeoPrefs p;
+  int i;
   FILE *fp = fopen(PREFS_PATH_A, "rb");
   if (!fp) fp = fopen(PREFS_PATH_B, "rb");
   if (!fp) return;
-  if (fread(&p, 1, sizeof(p), fp) == sizeof(p)) {
+  memset(&p, 0, sizeof(p));
+  if (fread(&p, 1, sizeof(p), fp) >= PREFS_MIN_SIZE) {
     SaveDevice = p.SaveDevice < 2 ? p.SaveDevice : 1;
     DefaultLoadDevice = p.DefaultLoadDevice < 6 ? p.DefaultLoadDevice : 0;
     neogeo_region = p.neogeo_region < 3 ? p.neogeo_region : 0;
@@ -137,8 +167,21 @@ void load_prefs(void)
     SkipBios = p.SkipBios < 2 ? p.SkipBios : 0;
     CropOverscan = p.CropOverscan < 2 ? p.CropOverscan : 1;
     FilterMode = p.FilterMode < 2 ? p.FilterMode : 1;
+    LoadStats = p.LoadStats < 3 ? p.LoadStats : 0;
+    CpuCore = p.CpuCore < 3 ? p.CpuCore : 0;
+    RenderThread = p.RenderThread < 2 ? p.RenderThread : 0;
+    FrameSkip = p.FrameSkip < 3 ? p.FrameSkip : 0;
+    SkipCount = (p.SkipCount >= 1 && p.SkipCount <= 5) ? p.SkipCount : 2;
+    Scaler = p.Scaler < SCALER_COUNT ? p.Scaler : SCALER_OFF;
+    Capture = p.Capture <= CAPTURE_FAST ? p.Capture : CAPTURE_OFF;
+    ReadAhead = p.ReadAhead < READ_AHEAD_COUNT ? p.ReadAhead : 0;
+    for (i = 0; i < BIOS_HLE_CALLS; i++)
+      BiosHle[i] = neogeo_bios_hle_set(i, p.BiosHle[i] <= HLE_CHECK ? p.BiosHle[i] : HLE_OFF);
   }
   fclose(fp);
+  m68k_cache_enable(CpuCore == 0);
+  m68k_drc_enable(CpuCore == 2);
+  GEN_SetReadAhead(read_ahead_sizes[ReadAhead]);
 }
 
 int use_SD  = 0;
@@ -979,6 +1022,16 @@ static const char *load_device_label(unsigned char v)
   }
 }
 
+/* Label for LoadStats value */
+static const char *load_stats_label(unsigned char v)
+{
+  switch (v) {
+    case 1: return "CSV";
+    case 2: return "CSV+OSD";
+    default: return "Off";
+  }
+}
+
 /****************************************************************************
 * Audio menu
 ****************************************************************************/
@@ -1030,6 +1083,98 @@ int audiomenu()
   return 0;
 }
 
+/* Label for CpuCore value */
+static const char *cpu_core_label(unsigned char v)
+{
+  static const char *labels[] = { "Linked", "Off", "Recomp" };
+
+  return labels[v];
+}
+
+/****************************************************************************
+* BIOS HLE menu
+****************************************************************************/
+int bioshlemenu() {
+  int prevmenu = menu;
+  int quit = 0;
+  int ret;
+  int i;
+  char items[BIOS_HLE_CALLS][22];
+  static const char *labels[] = { "Off", "On", "Check" };
+
+  menu = 0;
+
+  while (quit == 0)
+    {
+      for (i = 0; i < BIOS_HLE_CALLS; i++)
+        snprintf(items[i], 22, "%-11s %9s", neogeo_bios_hle_name(i), labels[BiosHle[i]]);
+
+      ret = DoMenu (&items[0], BIOS_HLE_CALLS, 0);
+      if (ret >= 0)   // Off, On, Check - loops have no Check
+        BiosHle[ret] = neogeo_bios_hle_set(ret, (BiosHle[ret] + 1) % 3);
+      else
+        quit = 1;
+    }
+  menu = prevmenu;
+  return 0;
+}
+
+/****************************************************************************
+* Advanced menu
+****************************************************************************/
+int advancedmenu() {
+  int prevmenu = menu;
+  int quit = 0;
+  int ret;
+  int count = 5;
+  char items[5][22];
+  static const char *capture_labels[] = { "Off", "Live", "Fast" };
+
+  menu = 0;
+
+  while (quit == 0)
+    {
+      snprintf(items[0], 22, "Load Stats:  %8s", load_stats_label(LoadStats));
+      snprintf(items[1], 22, "68K Blocks:  %8s", cpu_core_label(CpuCore));
+      snprintf(items[2], 22, "Capture:     %8s", capture_labels[Capture]);
+      snprintf(items[3], 22, "Read Ahead:  %8s", read_ahead_labels[ReadAhead]);
+      snprintf(items[4], 22, "BIOS HLE            >");
+
+      ret = DoMenu (&items[0], count, 0);
+      switch (ret)
+      {
+        case 0:   // Load Stats
+          LoadStats++;
+          if (LoadStats > 2) LoadStats = 0;
+          break;
+        case 1:   // 68K block cache, then the recompiler
+          CpuCore++;
+          if (CpuCore > 2) CpuCore = 0;
+          m68k_cache_enable(CpuCore == 0);
+          m68k_drc_enable(CpuCore == 2);
+          break;
+        case 2:   // AVI capture, starts when the game resumes
+          Capture++;
+          if (Capture > CAPTURE_FAST) Capture = CAPTURE_OFF;
+          break;
+        case 3:   // Read-ahead window, for files opened from now on
+          ReadAhead++;
+          if (ReadAhead >= READ_AHEAD_COUNT) ReadAhead = 0;
+          GEN_SetReadAhead(read_ahead_sizes[ReadAhead]);
+          break;
+        case 4:   // Per BIOS call
+          bioshlemenu();
+          break;
+        case -1:
+          quit = 1;
+          break;
+      }
+    }
+  save_prefs();
+  menu = prevmenu;
+  return 0;
+}
+
 /****************************************************************************
 * Graphics menu
 ****************************************************************************/
@@ -1037,8 +1182,10 @@ int graphicsmenu() {
   int prevmenu = menu;
   int quit = 0;
   int ret;
-  int count = 3;
-  char items[3][22];
+  int count = 7;
+  char items[7][22];
+  static const char *skip_labels[] = { "Off", "Auto", "Fixed" };
+  static const char *scaler_labels[] = { "Off", "Scale2x", "xBR-lite" };
 
   /* Track VideoMode on entry so we can detect changes on exit */
   unsigned char entry_video_mode = VideoMode;
@@ -1050,6 +1197,10 @@ int graphicsmenu() {
       snprintf(items[1], 22, "Crop Overscan:%7s", CropOverscan ? "True" : "False");
       snprintf(items[0], 22, "Filter Mode:%9s", FilterMode ? "Bilinear" : "Nearest");
       snprintf(items[2], 22, "Video Mode:   %7s", vmode_label(VideoMode));
+      snprintf(items[3], 22, "Render Thread:%7s", RenderThread ? "On" : "Off");
+      snprintf(items[4], 22, "Frame Skip:%10s", skip_labels[FrameSkip]);
+      snprintf(items[5], 22, "Skip Count:%10d", SkipCount);
+      snprintf(items[6], 22, "Scaler:%14s", scaler_labels[Scaler]);
 
       ret = DoMenu (&items[0], count, 0);
       switch (ret)
@@ -1064,6 +1215,21 @@ int graphicsmenu() {
           VideoMode++;
           if (VideoMode > 2) VideoMode = 0;
           break;
+        case 3:   // Render thread
+          RenderThread = !RenderThread;
+          break;
+        case 4:   // Frame skip
+          FrameSkip++;
+          if (FrameSkip > 2) FrameSkip = 0;
+          break;
+        case 5:   // Most frames skipped in a row, or skipped per frame drawn
+          SkipCount++;
+          if (SkipCount > 5) SkipCount = 1;
+          break;
+        case 6:   // Pixel scaler, used when the picture is shown at 2x
+          Scaler++;
+          if (Scaler >= SCALER_COUNT) Scaler = SCALER_OFF;
+          break;
         case -1:
           quit = 1;
           break;
@@ -1094,8 +1260,8 @@ int optionmenu() {
   int quit = 0;
   int ret;
   int num_save_devices = 2;
-  int count = 7;
-  char items[7][22];
+  int count = 8;
+  char items[8][22];
 
   menu = 0;
 
@@ -1110,8 +1276,9 @@ int optionmenu() {
     snprintf(items[2], 22, "Load Device: %8s", load_device_label(DefaultLoadDevice));
     snprintf(items[3], 22, "Menu Toggle: %8s", menu_trigger_label(MenuTrigger));
     snprintf(items[4], 22, "Skip BIOS:   %8s", SkipBios ? "True" : "False");
-    snprintf(items[5], 22, "FX/Music Equalizer  >");
-    snprintf(items[6], 22, "Graphics Settings   >");
+    snprintf(items[5], 22, "Advanced Settings   >");
+    snprintf(items[6], 22, "FX/Music Equalizer  >");
+    snprintf(items[7], 22, "Graphics Settings   >");
 
     ret = DoMenu (&items[0], count, 0);
     switch (ret)
@@ -1150,11 +1317,15 @@ int optionmenu() {
         SkipBios = !SkipBios;
         break;
 
-      case 5:   // FX / Music Equalizer
+      case 5:   // Load Stats, 68K blocks
+        advancedmenu();
+        break;
+
+      case 6:   // FX / Music Equalizer
         audiomenu();
         break;
 
-      case 6:
+      case 7:
         graphicsmenu();
         break;
 
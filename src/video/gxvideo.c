@@ -22,10 +22,16 @@
 *
 * The projection is orthographic with 1 GX unit = 1 EFB pixel, so quad
 * coordinates are in screen-pixel space and there is no approximation.
+*
+* When the picture is shown at 2x, a pixel scaler (Scaler) can run between
+* the rasterizer and the texture upload, four source lines at a time into
+* a strip that is tiled into a texture twice the size. The EFB is only 640
+* pixels wide, so the picture is never shown at 3x and every scaler is 2x.
 ****************************************************************************/
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <malloc.h>
 #include <gccore.h>
 #include "neocdrx.h"
 
@@ -37,10 +43,30 @@ extern GXRModeObj *vmode;
 /*** 3D GX ***/
 #define DEFAULT_FIFO_SIZE ( 256 * 1024 )
 #define TEXSIZE ( (NEOSCR_WIDTH * NEOSCR_HEIGHT) * 2 )
+#define SCALE_MAX 2
+#define SCALED_TEXSIZE ( TEXSIZE * SCALE_MAX * SCALE_MAX )
 
 static u8 gp_fifo[DEFAULT_FIFO_SIZE] ATTRIBUTE_ALIGN (32);
 static u8 texturemem[TEXSIZE] ATTRIBUTE_ALIGN (32);
 
+/*** Scaled texture, allocated the first time a scaler is used ***/
+static u8 *scaledmem = NULL;
+static u8 *texture = texturemem;
+
+/*** Four source lines of scaler output ***/
+static u16 scalestrip[NEOSCR_WIDTH * SCALE_MAX * 4 * SCALE_MAX]
+  ATTRIBUTE_ALIGN (32);
+
+static const struct
+{
+  PIXSCALER scale;
+  int factor;
+} scalers[SCALER_COUNT] = {
+  { NULL, 1 },
+  { Scale2X, 2 },
+  { ScaleXBR2X, 2 },
+};
+
 GXTexObj texobj;
 int vwidth, vheight, oldvwidth, oldvheight;
 static int oldFilterMode = -1;   /* -1 forces first-frame init */
@@ -67,7 +93,7 @@ draw_init (void)
 
   GX_InvalidateTexAll ();
 
-  GX_InitTexObj (&texobj, texturemem, vwidth, vheight, GX_TF_RGB565,
+  GX_InitTexObj (&texobj, texture, vwidth, vheight, GX_TF_RGB565,
          GX_CLAMP, GX_CLAMP, GX_FALSE);
 
   /* Bilinear filtering smooths scaled output; nearest-neighbour preserves
@@ -76,6 +102,20 @@ draw_init (void)
   GX_InitTexObjFilterMode (&texobj, filter, filter);
 }
 
+/****************************************************************************
+ * display_scale
+ * Largest integer multiple of the source that fits the current EFB.
+ ****************************************************************************/
+static int
+display_scale (void)
+{
+  int scale_x = vmode->fbWidth / NEOSCR_WIDTH;      /* 640/320 = 2 */
+  int scale_y = vmode->efbHeight / NEOSCR_HEIGHT;   /* 480/224 = 2  or  240/224 = 1 */
+  int scale   = (scale_x < scale_y) ? scale_x : scale_y;
+
+  return scale < 1 ? 1 : scale;
+}
+
 /****************************************************************************
  * draw_square
  * Orthographic projection: 1 GX unit = 1 EFB pixel.
@@ -92,10 +132,7 @@ draw_square (void)
   int efb_h = vmode->efbHeight;     /* 480 for 480p, 240 for 480i */
 
   /* Integer scale: largest multiple of source dimensions that fits */
-  int scale_x = efb_w / NEOSCR_WIDTH;   /* 640/320 = 2 */
-  int scale_y = efb_h / NEOSCR_HEIGHT;  /* 480/224 = 2  or  240/224 = 1 */
-  int scale   = (scale_x < scale_y) ? scale_x : scale_y;
-  if (scale < 1) scale = 1;
+  int scale   = display_scale ();
 
   /* Source pixel region (UV-level crop) */
   int src_x0 = CropOverscan ? (8 * scale) : 0;
@@ -162,21 +199,74 @@ StartGX (void)
   vheight = 100;
 }
 
+/****************************************************************************
+ * texture_tile
+ * Copies lines y to y + lines - 1 of a linear RGB565 picture into the 4x4
+ * texel blocks of the texture. pitch is in pixels; y and lines are
+ * multiples of 4.
+ ****************************************************************************/
+static void
+texture_tile (const u16 *src, int pitch, int y, int lines)
+{
+  int h, w;
+  long long int *dst  = (long long int *) (texture + y * vwidth * 2);
+  const long long int *src1, *src2, *src3, *src4;
+
+  for (h = 0; h < lines; h += 4, src += pitch * 4)
+    {
+      src1 = (const long long int *) src;
+      src2 = (const long long int *) (src + pitch);
+      src3 = (const long long int *) (src + pitch * 2);
+      src4 = (const long long int *) (src + pitch * 3);
+
+      for (w = 0; w < vwidth >> 2; w++)
+        {
+          *dst++ = *src1++;
+          *dst++ = *src2++;
+          *dst++ = *src3++;
+          *dst++ = *src4++;
+        }
+    }
+}
+
+/****************************************************************************
+ * scaler_factor
+ * Factor of the scaler in use. Scaling is only worth it when the picture
+ * is shown at 2x or more, and is skipped if there is no memory for it.
+ ****************************************************************************/
+static int
+scaler_factor (int mode)
+{
+  if (mode == SCALER_OFF || mode >= SCALER_COUNT || display_scale () < 2)
+    return 1;
+
+  if (scaledmem == NULL)
+    {
+      scaledmem = memalign (32, SCALED_TEXSIZE);
+      if (scaledmem == NULL)
+        {
+          Scaler = SCALER_OFF;
+          return 1;
+        }
+      memset (scaledmem, 0, SCALED_TEXSIZE);
+    }
+
+  return scalers[mode].factor;
+}
+
 /****************************************************************************
  * Update Video
  ****************************************************************************/
 void
 update_video (int width, int height, char *vbuffer)
 {
-  int h, w;
-  long long int *dst  = (long long int *) texturemem;
-  long long int *src1 = (long long int *) vbuffer;
-  long long int *src2 = (long long int *) (vbuffer + 640);
-  long long int *src3 = (long long int *) (vbuffer + 1280);
-  long long int *src4 = (long long int *) (vbuffer + 1920);
+  int mode = Scaler;
+  int factor = scaler_factor (mode);
+  int y;
 
-  vwidth  = 320;
-  vheight = 224;
+  vwidth  = width * factor;
+  vheight = height * factor;
+  texture = factor > 1 ? scaledmem : texturemem;
 
   whichfb ^= 1;
 
@@ -195,22 +285,19 @@ update_video (int width, int height, char *vbuffer)
   GX_SetTevOp (GX_TEVSTAGE0, GX_DECAL);
   GX_SetTevOrder (GX_TEVSTAGE0, GX_TEXCOORD0, GX_TEXMAP0, GX_COLOR0A0);
 
-  for (h = 0; h < vheight; h += 4)
+  if (factor == 1)
+    texture_tile ((u16 *) vbuffer, width, 0, height);
+  else
     {
-      for (w = 0; w < 80; w++)
+      for (y = 0; y < height; y += 4)
         {
-          *dst++ = *src1++;
-          *dst++ = *src2++;
-          *dst++ = *src3++;
-          *dst++ = *src4++;
+          scalers[mode].scale (scalestrip, vwidth, (u16 *) vbuffer, width,
+                               width, height, y, y + 4);
+          texture_tile (scalestrip, vwidth, y * factor, factor * 4);
         }
-      src1 += 240;
-      src2 += 240;
-      src3 += 240;
-      src4 += 240;
     }
 
-  DCFlushRange (texturemem, TEXSIZE);
+  DCFlushRange (texture, vwidth * vheight * 2);
 
   GX_SetNumChans (1);
   GX_LoadTexObj (&texobj, GX_TEXMAP0);
@@ -227,5 +314,6 @@ update_video (int width, int height, char *vbuffer)
   VIDEO_SetNextFramebuffer (xfb[whichfb]);
   VIDEO_Flush ();
 
-  VIDEO_WaitVSync ();
+  if (!capture_unthrottled ())
+    VIDEO_WaitVSync ();
 }
@@ -5,61 +5,197 @@
 *
 * Check http://scale2x.sourceforge.net for algorithm info and complete
 * Scale2X package
+*
+* Each scaler takes source rows y0 to y1 - 1 of a width x height image, so
+* the caller can scale a few rows at a time into a buffer that stays in
+* the cache. The rows above and below are found once per row, and the
+* neighbours slide along the row in registers, with the first and last
+* pixel repeating themselves instead of clamping every load.
 *****************************************************************************/
 #include <gccore.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include "scale2x.h"
+
+/****************************************************************************
+* Neighbours
+*
+*   A B C
+*   D E F
+*   G H I
+****************************************************************************/
+#define ROW_ABOVE(e) (y > 0 ? (e) - srcpitch : (e))
+#define ROW_BELOW(e) (y < height - 1 ? (e) + srcpitch : (e))
 
 /****************************************************************************
-* Init_Scale2X
+* Scale2X
 *
-* Build a colour LUT for RGB565
+* Same result as the reference rules, as E0 = D == B && B != F && D != H
+* reduces to D == B once B != H and D != F are known.
 ****************************************************************************/
-void Init_Scale2X(void)
+static inline void
+scale2x_pixel (u16 * d0, u16 * d1, u16 B, u16 D, u16 E, u16 F, u16 H)
 {
+  if (B != H && D != F)
+    {
+      d0[0] = D == B ? D : E;
+      d0[1] = B == F ? F : E;
+      d1[0] = D == H ? D : E;
+      d1[1] = H == F ? F : E;
+    }
+  else
+    d0[0] = d0[1] = d1[0] = d1[1] = E;
+}
+
+static void
+scale2x_row (u16 * d0, u16 * d1, const u16 * b, const u16 * e,
+	     const u16 * h, int width)
+{
+  u16 D, E, F;
+  int x;
+
+  D = E = e[0];
+  for (x = 0; x < width - 1; x++, d0 += 2, d1 += 2)
+    {
+      F = e[x + 1];
+      scale2x_pixel (d0, d1, b[x], D, E, F, h[x]);
+      D = E;
+      E = F;
+    }
+
+  scale2x_pixel (d0, d1, b[x], D, E, E, h[x]);
+}
+
+void
+Scale2X (u16 * dst, int dstpitch, const u16 * src, int srcpitch,
+	 int width, int height, int y0, int y1)
+{
+  const u16 *e;
+  int y;
+
+  for (y = y0; y < y1; y++, dst += dstpitch * 2)
+    {
+      e = src + y * srcpitch;
+      scale2x_row (dst, dst + dstpitch, ROW_ABOVE (e), e, ROW_BELOW (e),
+		   width);
+    }
 }
 
 /****************************************************************************
-* Scale2X
+* ScaleXBR2X
+*
+* xBR level 1 cut down to the 3x3 neighbourhood. A corner of E is cut by
+* an edge when the colours along the edge are closer than those across it,
+*
+*   E3: d(E,C) + d(E,G) + 4 d(F,H)  <  d(D,H) + d(B,F) + 4 d(E,I)
+*
+* and is then blended halfway towards the closer of its two neighbours.
+* Pixels that match all four of B, D, F and H are copied straight away,
+* as no corner can change.
+****************************************************************************/
+static inline int
+xbr_dist (u16 a, u16 b)
+{
+  int r = (a >> 11) - (b >> 11);
+  int g = ((a >> 5) & 63) - ((b >> 5) & 63);
+  int l = (a & 31) - (b & 31);
+
+  if (a == b)
+    return 0;
+  return (abs (r) << 1) + abs (g) + (abs (l) << 1);
+}
+
+static inline u16
+xbr_blend (u16 a, u16 b)
+{
+  return (a & b) + (((a ^ b) & 0xF7DE) >> 1);
+}
+
+static inline u16
+xbr_corner (u16 E, u16 P, u16 Q, int edge, int across)
+{
+  if (edge >= across)
+    return E;
+
+  return xbr_blend (E, xbr_dist (E, P) <= xbr_dist (E, Q) ? P : Q);
+}
+
+/****************************************************************************
+* Each diagonal distance is shared by two pixels of the row, so only the
+* four diagonals right of E are measured per pixel and the four left of it
+* are the ones measured for the pixel before:
 *
-* This is the actual algorithm implemented for the GC
+*   d(A,E) d(B,D)  left, above    d(B,F) d(C,E)  right, above
+*   d(D,H) d(E,G)  left, below    d(E,I) d(F,H)  right, below
 ****************************************************************************/
-void Scale2X(char *srcpix, int srcpitch, char *dstpix, int dstpitch,
-	     int width, int height)
+static void
+xbr_row (u16 * d0, u16 * d1, const u16 * b, const u16 * e, const u16 * h,
+	 int width)
 {
-    u16 E0, E1, E2, E3, B, D, E, F, H;
-    int looph, loopw;
-    int t;
-
-    for (looph = 0; looph < height; ++looph) {
-	for (loopw = 0; loopw < width; ++loopw) {
-		
-	    t = looph * srcpitch;	
-	    B = *(u16 *) (srcpix + (MAX(0, looph - 1) * srcpitch) +
-			  (loopw << 1));
-	    D = *(u16 *) (srcpix + t +
-			  (MAX(0, loopw - 1)<<1));
-	    E = *(u16 *) (srcpix + t + (loopw << 1));
-	    F = *(u16 *) (srcpix + t +
-			  (2 * MIN(width - 1, loopw + 1)));
-	    H = *(u16 *) (srcpix + (MIN(height - 1, looph + 1) * srcpitch) +
-			  (loopw << 1));
-
-	    E0 = D == B && B != F && D != H ? D : E;
-	    E1 = B == F && B != D && F != H ? F : E;
-	    E2 = D == H && D != B && H != F ? D : E;
-	    E3 = H == F && D != H && B != F ? F : E;
-
-	    t = looph * dstpitch * 2;
-	    *(u16 *) (dstpix + t + loopw * 2 * 2) = E0;
-	    *(u16 *) (dstpix + t + (loopw * 2 + 1) * 2) =
-		E1;
-	    *(u16 *) (dstpix + (looph * 2 + 1) * dstpitch + loopw * 2 * 2) =
-		E2;
-	    *(u16 *) (dstpix + (looph * 2 + 1) * dstpitch +
-		      (loopw * 2 + 1) * 2) = E3;
+  u16 B, C, D, E, F, H, I;
+  int ae, bd, dh, eg, bf, ce, ei, fh;
+  int x;
+
+  B = b[0];
+  D = E = e[0];
+  H = h[0];
+  ae = bd = xbr_dist (B, E);
+  dh = eg = xbr_dist (E, H);
+  for (x = 0; x < width; x++, d0 += 2, d1 += 2)
+    {
+      if (x < width - 1)
+	{
+	  C = b[x + 1];
+	  F = e[x + 1];
+	  I = h[x + 1];
+	}
+      else
+	{
+	  C = B;
+	  F = E;
+	  I = H;
+	}
+
+      ce = xbr_dist (C, E);
+      ei = xbr_dist (E, I);
+
+      if (E == B && E == D && E == F && E == H)
+	{
+	  bf = fh = 0;
+	  d0[0] = d0[1] = d1[0] = d1[1] = E;
+	}
+      else
+	{
+	  bf = xbr_dist (B, F);
+	  fh = xbr_dist (F, H);
+	  d0[0] = xbr_corner (E, B, D, ce + eg + 4 * bd, bf + dh + 4 * ae);
+	  d0[1] = xbr_corner (E, B, F, ae + ei + 4 * bf, bd + fh + 4 * ce);
+	  d1[0] = xbr_corner (E, D, H, ae + ei + 4 * dh, fh + bd + 4 * eg);
+	  d1[1] = xbr_corner (E, F, H, ce + eg + 4 * fh, dh + bf + 4 * ei);
 	}
+
+      ae = bf;
+      bd = ce;
+      dh = ei;
+      eg = fh;
+      B = C;
+      D = E;
+      E = F;
+      H = I;
     }
+}
 
+void
+ScaleXBR2X (u16 * dst, int dstpitch, const u16 * src, int srcpitch,
+	    int width, int height, int y0, int y1)
+{
+  const u16 *e;
+  int y;
+
+  for (y = y0; y < y1; y++, dst += dstpitch * 2)
+    {
+      e = src + y * srcpitch;
+      xbr_row (dst, dst + dstpitch, ROW_ABOVE (e), e, ROW_BELOW (e), width);
+    }
 }
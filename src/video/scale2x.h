@@ -0,0 +1,29 @@
+/****************************************************************************
+*   NeoCDRX
+*   NeoGeo CD Emulator
+*   NeoCD Redux - Copyright (C) 2007 softdev
+****************************************************************************/
+
+/****************************************************************************
+* NeoCD-Redux
+*
+* Pixel scalers
+****************************************************************************/
+#ifndef __SCALE2X__
+#define __SCALE2X__
+
+#define SCALER_OFF     0
+#define SCALER_2X      1
+#define SCALER_XBR     2
+#define SCALER_COUNT   3
+
+typedef void (*PIXSCALER) (u16 * dst, int dstpitch, const u16 * src,
+			   int srcpitch, int width, int height, int y0,
+			   int y1);
+
+void Scale2X (u16 * dst, int dstpitch, const u16 * src, int srcpitch,
+	      int width, int height, int y0, int y1);
+void ScaleXBR2X (u16 * dst, int dstpitch, const u16 * src, int srcpitch,
+		 int width, int height, int y0, int y1);
+
+#endif
@@ -14,21 +14,14 @@
 #define VIDEO_NORMAL	1
 #define VIDEO_SCANLINES	2
 
-#define LINE_BEGIN mydword = (*((unsigned int *)fspr))
-#define LINE_MID	mydword = (*((unsigned int *)fspr+1))
-#define PIXEL_LAST	col = (mydword&0x0F); if (col) *bm = paldata[col]
-#define PIXEL_R		col = (mydword&0x0F); if (col) *bm = paldata[col]; bm--
-#define PIXEL_F		col = (mydword&0x0F); if (col) *bm = paldata[col]; bm++
-#define PIXEL_LAST_OPAQUE col = (mydword&0x0F); *bm = paldata[col]
-#define PIXEL_R_OPAQUE col = (mydword&0x0F); *bm = paldata[col]; bm--
-#define PIXEL_F_OPAQUE col = (mydword&0x0F); *bm = paldata[col]; bm++
-#define SHIFT7		mydword >>= 28
-#define SHIFT6		mydword >>= 24
-#define SHIFT5		mydword >>= 20
-#define SHIFT4		mydword >>= 16
-#define SHIFT3		mydword >>= 12
-#define SHIFT2		mydword >>= 8
-#define SHIFT1		mydword >>= 4
+/*** Horizontal bands a frame is drawn in, and threads drawing them besides
+     the caller. Host builds can raise both; the GC and Wii have one core. ***/
+#ifndef VIDEO_BANDS
+#define VIDEO_BANDS		1
+#endif
+#ifndef VIDEO_BAND_THREADS
+#define VIDEO_BAND_THREADS	0
+#endif
 
 //-- Global Variables --------------------------------------------------------
 char video_vidram[0x20000];
@@ -39,8 +32,8 @@ unsigned short *video_paletteram_pc;
 unsigned short video_palette_bank0_pc[4096];
 unsigned short video_palette_bank1_pc[4096];
 unsigned short video_color_lut[32768];
-u32 video_color_long[0x10000];
-u32 video_scan_long[0x10000];
+unsigned int video_palette_dirty[2][128];
+unsigned int *video_paldirty;
 
 int video_modulo;
 int video_pointer;
@@ -50,11 +43,13 @@ int video_mode = 0;
 unsigned short *video_line_ptr[224];
 unsigned char video_fix_usage[4096];
 unsigned char video_spr_usage[0x10000];
-static char videobuffer[(NEOSCR_WIDTH * (NEOSCR_HEIGHT + 16)) * 2];
+unsigned int video_scb_head[12];
+unsigned int video_scb_live[12];
+static char videobuffer[(NEOSCR_WIDTH * (NEOSCR_HEIGHT + 16)) * 2]
+  ATTRIBUTE_ALIGN (32);
 static char *video_buffer = videobuffer;
 u8 *SrcPtr;
 u8 *DestPtr;
-unsigned char video_shrinky[17];
 unsigned char full_y_skip[16] = { 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1 };
 
 unsigned int neogeo_frame_counter = 0;
@@ -67,7 +62,51 @@ double gamma_correction = 1.0;
 int fullscreen_flag = 0;
 int display_mode = 1;
 int snap_no;
-int frameskip = 0;
+int frameskip = 0;		/* frames skipped since the last one drawn */
+static int skip_count;		/* frames skipped this second */
+static int skip_frames;		/* frames run this second */
+static int skip_shown;		/* frames skipped last second */
+static int skip_before;		/* frames skipped before the one drawn */
+
+/*** Y shrink of one tile, by zoom and by the line phase it starts at ***/
+typedef struct
+{
+  unsigned char shrinky[17];	/* lines to step down after each line drawn */
+  unsigned char yskip;		/* lines drawn */
+  unsigned short dday;		/* phase for the next tile */
+} SHRINK;
+
+static SHRINK video_shrink[256][17];
+
+/*** Tiles drawn in a strip, by zoom and by the tile count in its SCB3 ***/
+static unsigned char video_strip_tiles[256][64];
+
+/*** Palette of the frame being drawn ***/
+static unsigned short *render_palette;
+
+/*** A sprite tile to draw, found by the pass over the SCB tables ***/
+typedef struct
+{
+  const unsigned char *l_y_skip;
+  unsigned short code;
+  unsigned char color;
+  unsigned char blit;		/* opaque << 5 | flip x << 4 | zoom x */
+  unsigned char flipy;
+  unsigned char zy;
+  short sx;
+  short sy;
+} SPRTILE;
+
+#define SPR_TILES	(0x180 * 32)
+
+static SPRTILE spr_tiles[SPR_TILES];
+static int spr_count;
+
+/*** Tiles reaching each band, in drawing order ***/
+static unsigned short band_tiles[VIDEO_BANDS][SPR_TILES];
+static int band_count[VIDEO_BANDS];
+static int band_top[VIDEO_BANDS + 1];
+static unsigned char band_of_line[224];
 
 //-- Function Prototypes -----------------------------------------------------
 int video_init (void);
@@ -76,18 +115,20 @@ void video_draw_line (int);
 int video_set_mode (int);
 void video_mode_toggle (void);
 void video_fullscreen_toggle (void);
-void incframeskip (void);
 void video_precalc_lut (void);
+void video_update_palette (void);
+static void video_precalc_shrink (void);
 void video_flip_pages (void);
-void video_draw_spr (unsigned int code, unsigned int color, int flipx,
-		     int flipy, int sx, int sy, int zx, int zy);
+static void video_precalc_bands (void);
+static void video_spr_add (int code, int attr, int sx, int sy, int zx,
+			   int zy, const unsigned char *l_y_skip);
+static void video_render_bands (VIDEO_FRAME * frame);
+static int video_scb_next (const unsigned int *bits, int strip);
 void video_draw_screen1 (void);
 void video_draw_screen2 (void);
 void snapshot_init (void);
 void video_save_snapshot (void);
 void video_setup (void);
-void video_draw_spr_opaque (unsigned int code, unsigned int color, int flipx,
-			    int flipy, int sx, int sy, int zx, int zy);
 
 static inline u32
 VFLIP32 (unsigned int b)
@@ -113,17 +154,23 @@ video_init (void)
   unsigned short *ptr;
 
   video_precalc_lut ();
+  video_precalc_shrink ();
+  video_precalc_bands ();
 
   memset (video_palette_bank0_ng, 0, 8192);
   memset (video_palette_bank1_ng, 0, 8192);
   memset (video_palette_bank0_pc, 0, 8192);
   memset (video_palette_bank1_pc, 0, 8192);
+  memset (video_palette_dirty, 0, sizeof (video_palette_dirty));
   memset (video_spr_usage, 0, 0x10000);
   memset (video_vidram, 0, 0x20000);
   memset (video_buffer, 0, (NEOSCR_WIDTH * NEOSCR_HEIGHT) * 2);
+  video_fix_flush ();
+  video_scb_flush ();
 
   video_paletteram_ng = video_palette_bank0_ng;
   video_paletteram_pc = video_palette_bank0_pc;
+  video_paldirty = video_palette_dirty[0];
   video_modulo = 0;
   video_pointer = 0;
 
@@ -152,59 +199,190 @@ video_set_mode (int mode)
 }
 
 //----------------------------------------------------------------------------
+// A colour is three 5 bit channels, so the LUT is put together from three
+// 32 entry ramps. Without gamma they are plain integer scales, the same
+// values pow gave. The LUT is only rebuilt when gamma_correction changes,
+// and then every palette entry is converted again.
 void
 video_precalc_lut (void)
 {
-  int ndx, rr, rg, rb;
+  static double lut_gamma = 0;
+  unsigned short ramp_r[32], ramp_g[32], ramp_b[32];
+  int ndx, i;
 
-  for (rr = 0; rr < 32; rr++)
+  if (gamma_correction == lut_gamma)
+    return;
+  lut_gamma = gamma_correction;
+
+  for (i = 0; i < 32; i++)
     {
-      for (rg = 0; rg < 32; rg++)
+      if (gamma_correction == 1.0)
 	{
-	  for (rb = 0; rb < 32; rb++)
-	    {
-	      ndx =
-		((rr & 1) << 14) | ((rg & 1) << 13) | ((rb & 1) << 12) |
-		((rr & 30) << 7) | ((rg & 30) << 3) | ((rb & 30) >> 1);
-	      video_color_lut[ndx] =
-		((int) (31 * pow ((double) rb / 31, 1 / gamma_correction)) <<
-		 0) | ((int) (63 *
-			      pow ((double) rg / 31,
-				   1 / gamma_correction)) << 5) | ((int) (31 *
-									  pow
-									  ((double) rr / 31, 1 / gamma_correction)) << 11);
-	    }
+	  ramp_r[i] = i << 11;
+	  ramp_g[i] = ((63 * i) / 31) << 5;
+	  ramp_b[i] = i;
+	}
+      else
+	{
+	  ramp_b[i] = (int) (31 * pow ((double) i / 31, 1 / gamma_correction));
+	  ramp_g[i] =
+	    (int) (63 * pow ((double) i / 31, 1 / gamma_correction)) << 5;
+	  ramp_r[i] = ramp_b[i] << 11;
 	}
     }
 
-  for (ndx = 0; ndx < 0x10000; ndx++)
+  /*** Neo Geo colour: R0 G0 B0 in bits 14-12, R4-1 G4-1 B4-1 in 11-0 ***/
+  for (ndx = 0; ndx < 32768; ndx++)
+    video_color_lut[ndx] =
+      ramp_r[((ndx >> 7) & 30) | ((ndx >> 14) & 1)] |
+      ramp_g[((ndx >> 3) & 30) | ((ndx >> 13) & 1)] |
+      ramp_b[((ndx << 1) & 30) | ((ndx >> 12) & 1)];
+
+  memset (video_palette_dirty, 0xff, sizeof (video_palette_dirty));
+}
+
+/****************************************************************************
+* video_update_palette
+*
+* Palette writes only store the Neo Geo colour and mark the entry in the
+* dirty bitmap of its bank (VIDEO_PALETTE_W). Before a frame is drawn, the
+* marked entries of both banks are converted to RGB565 here, once however
+* often they were written, and the FIX palettes among them of the bank on
+* screen are passed on to the FIX cache.
+****************************************************************************/
+void
+video_update_palette (void)
+{
+  unsigned short *ng, *pc;
+  unsigned int dirty;
+  int bank, i, n;
+
+  for (bank = 0; bank < 2; bank++)
     {
-      video_color_long[ndx] = ndx | (ndx << 16);
-      video_scan_long[ndx] = (video_color_long[ndx] >> 1) & 0x7bef7bef;
+      ng = bank ? video_palette_bank1_ng : video_palette_bank0_ng;
+      pc = bank ? video_palette_bank1_pc : video_palette_bank0_pc;
+
+      for (i = 0; i < 128; i++)
+	{
+	  dirty = video_palette_dirty[bank][i];
+	  if (!dirty)
+	    continue;
+	  video_palette_dirty[bank][i] = 0;
+
+	  if (i < 8 && pc == video_paletteram_pc)
+	    video_fix_paldirty |= ((dirty & 0xffff) ? 1 << (i << 1) : 0) |
+	      ((dirty >> 16) ? 2 << (i << 1) : 0);
+
+	  for (n = i << 5; dirty; n++, dirty >>= 1)
+	    if (dirty & 1)
+	      pc[n] = video_color_lut[ng[n] & 0x7fff];
+	}
     }
+}
+
+/* Mark count entries of the current bank from offset, wrapping at 4096 */
+void
+video_palette_mark (unsigned int offset, unsigned int count)
+{
+  offset &= 0xfff;
+  if (count > 4096)
+    count = 4096;
 
+  while (count)
+    {
+      if (!(offset & 31) && count >= 32)
+	{
+	  video_paldirty[offset >> 5] = 0xffffffff;
+	  offset += 32;
+	  count -= 32;
+	}
+      else
+	{
+	  VIDEO_PALETTE_W (offset);
+	  offset++;
+	  count--;
+	}
+      offset &= 0xfff;
+    }
 }
 
 //----------------------------------------------------------------------------
-void
-video_draw_screen1 ()
+// The y shrink of a tile depends on the zoom and on dday, the line phase
+// left by the tile above. dday starts each strip at 0 and is a multiple of
+// 16 after each tile, so a table of 17 phases per zoom covers every tile.
+static void
+video_precalc_shrink (void)
+{
+  int rzy, phase, i, my, tiles;
+  int dday, yskip;
+  SHRINK *shrink;
+
+  for (rzy = 0; rzy < 256; rzy++)
+    {
+      for (phase = 0; phase <= 16; phase++)
+	{
+	  shrink = &video_shrink[rzy][phase];
+	  dday = phase << 4;
+	  yskip = 0;
+	  shrink->shrinky[0] = 0;
+	  for (i = 0; i < 16; i++)
+	    {
+	      shrink->shrinky[i + 1] = 0;
+	      dday -= rzy + 1;
+	      if (dday <= 0)
+		{
+		  dday += 256;
+		  yskip++;
+		  shrink->shrinky[yskip]++;
+		}
+	      else
+		shrink->shrinky[yskip]++;
+	    }
+	  shrink->yskip = yskip;
+	  shrink->dday = dday;
+	}
+
+      for (my = 0; my < 64; my++)
+	{
+	  if (my == 0x21)
+	    tiles = 0x20;
+	  else if (rzy != 0xff && my != 0)
+	    tiles = ((my * 16 * 256) / (rzy + 1) + 15) / 16;
+	  else
+	    tiles = my;
+
+	  video_strip_tiles[rzy][my] = tiles > 0x20 ? 0x20 : tiles;
+	}
+    }
+}
+
+//----------------------------------------------------------------------------
+static void
+video_render (VIDEO_FRAME * frame)
 {
   //static unsigned int fc;
   int sx = 0, sy = 0, oy = 0, my = 0, zx = 1, rzy = 1;
-  int offs, i, count, y;
+  int offs, count, y, strip, chain_end = 0;
   int tileno, tileatr, t1, t2, t3;
+  SHRINK *shrink;
+  const unsigned char *shrinky = full_y_skip;
   char fullmode = 0;
   int ddax = 0, dday = 0, rzx = 15, yskip = 0;
 //  int pass1 = 0;
 //  int t;
 
-  if (!video_enable)
+  render_palette = frame->palette;
+
+  if (!frame->enable)
     {
-      video_clear ();
+      memset (video_buffer, 0, (NEOSCR_WIDTH * (NEOSCR_HEIGHT + 16)) * 2);
       return;
     }
 
-  if (!spr_disable)
+  spr_count = 0;
+  memset (band_count, 0, sizeof (band_count));
+
+  if (!frame->spr_disable)
     {
 
 //      if ( patch_ssrpg )
@@ -227,18 +405,22 @@ video_draw_screen1 ()
 //      else
 //        pass1 = 0;
 
-      //fill background colour
-      int f;
-      unsigned short *vxfb = (unsigned short *) video_buffer;
-      for (f = 0; f < (320 * 224); f++)
-	vxfb[f] = video_paletteram_pc[4095];
-
 //      for (count = pass1; count < 0x300; count += 2)
       for (count = 0; count < 0x300; count += 2)
 	{
-	  t3 = *((unsigned short *) (&video_vidram[0x10000 + count]));
-	  t1 = *((unsigned short *) (&video_vidram[0x10400 + count]));
-	  t2 = *((unsigned short *) (&video_vidram[0x10800 + count]));
+	  /*** At the end of a chain, go on to the next one with tiles ***/
+	  if (count == chain_end)
+	    {
+	      strip = video_scb_next (frame->scb_live, count >> 1);
+	      if (strip >= 0x180)
+		break;
+	      count = strip << 1;
+	      chain_end = video_scb_next (frame->scb_head, strip + 1) << 1;
+	    }
+
+	  t3 = *((unsigned short *) (&frame->vidram[0x10000 + count]));
+	  t1 = *((unsigned short *) (&frame->vidram[0x10400 + count]));
+	  t2 = *((unsigned short *) (&frame->vidram[0x10800 + count]));
 
 		// If this bit is set this new column is placed next to last one
 		if (t1 & 0x40) {
@@ -283,13 +465,7 @@ video_draw_screen1 ()
 		}
 		oy = sy;
 
-		 if(my==0x21) my=0x20;
-
-		 else if(rzy!=0xff && my!=0)
-		 //my = ((my<<4<<8)/(rzy+1)+15)>>4; //my = ((my*16*256)/(rzy+1)+15)/16;
-		 my = ((my * 16 * 256) / (rzy + 1) + 15) / 16;
-
-		 if(my>0x20) my=0x20;
+		 my = video_strip_tiles[rzy][my];
 		  ddax = 0;		// setup x zoom
 		  if (ddax == 0) { }
 	    }
@@ -312,15 +488,15 @@ video_draw_screen1 ()
 	  // my holds the number of tiles in each vertical multisprite block
 	  for (y = 0; y < my; y++)
 	    {
-	      tileno = *((unsigned short *) (&video_vidram[offs]));
+	      tileno = *((unsigned short *) (&frame->vidram[offs]));
 	      offs += 2;
-	      tileatr = *((unsigned short *) (&video_vidram[offs]));
+	      tileatr = *((unsigned short *) (&frame->vidram[offs]));
 	      offs += 2;
 
 	      if (tileatr & 0x8)
-		tileno = (tileno & ~7) | (neogeo_frame_counter & 7);
+		tileno = (tileno & ~7) | (frame->frame_counter & 7);
 	      else if (tileatr & 0x4)
-		tileno = (tileno & ~3) | (neogeo_frame_counter & 3);
+		tileno = (tileno & ~3) | (frame->frame_counter & 3);
 
 //                      tileno &= 0x7FFF;
 	      if (tileno > 0x7FFF)	/*** Fatal Fury 3 uses tiles up to 34000 ***/
@@ -328,21 +504,10 @@ video_draw_screen1 ()
 
 	      if (rzy != 255)
 		{
-		  yskip = 0;
-		  video_shrinky[0] = 0;
-		  for (i = 0; i < 16; i++)
-		    {
-		      video_shrinky[i + 1] = 0;
-		      dday -= rzy + 1;
-		      if (dday <= 0)
-			{
-			  dday += 256;
-			  yskip++;
-			  video_shrinky[yskip]++;
-			}
-		      else
-			video_shrinky[yskip]++;
-		    }
+		  shrink = &video_shrink[rzy][dday >> 4];
+		  shrinky = shrink->shrinky;
+		  yskip = shrink->yskip;
+		  dday = shrink->dday;
 		}
 
 	    if (fullmode == 2 || (fullmode == 1 && rzy == 0xff)) 
@@ -367,38 +532,226 @@ video_draw_screen1 ()
 
 
 	      if ((tileatr >> 8) && (sy < 224) && video_spr_usage[tileno])
-		{
-		  if (video_spr_usage[tileno] & 1)
-		    video_draw_spr_opaque (tileno,
-					   tileatr >> 8,
-					   tileatr & 0x01, tileatr & 0x02,
-					   sx, sy, rzx, yskip);
-		  else
-		    video_draw_spr (tileno,
-				    tileatr >> 8,
-				    tileatr & 0x01, tileatr & 0x02,
-				    sx, sy, rzx, yskip);
-		}
+		video_spr_add (tileno, tileatr, sx, sy, rzx, yskip,
+			       yskip == 16 ? full_y_skip : shrinky);
 
 	      sy += yskip;
 	    }			// for y
 	}			// for count
     }
 
-  if (!fix_disable)
-    video_draw_fix ();
+  if (!frame->fix_disable)
+    video_update_fix (frame);
 
-    /*** Do clipping ***/
-  for (count = 0; count < 224; count++)
+  video_render_bands (frame);
+
+  /*** Captured without the overlays ***/
+  capture_frame ((unsigned short *) video_buffer, frame->repeats);
+
+  if (frame->skipped)
     {
-      for (sx = 0; sx < 8; sx++)
-	video_line_ptr[count][sx] = video_line_ptr[count][sx + 311] = 0;
+      char text[12];
+      sprintf (text, "SKIP %d", frame->skipped);
+      fixputs (31, 26, text);
     }
 
+  if (capture_status ())
+    fixputs (2, 26, capture_status ());
+
+  if (frame->loadprof)
+    loadprof_draw ((unsigned short *) video_buffer);
+
   update_video (320, 224, video_buffer);
 
 }
 
+/****************************************************************************
+* Render thread
+*
+* With RenderThread on, video_draw_screen1 only copies what the frame is
+* drawn from into a render job at vblank, and video_render_thread draws and
+* uploads it while the next frame is emulated, a frame later than the
+* serial path would show it. The two jobs are used in turn, so the
+* emulation fills one while the thread draws the other, and waits only
+* when both are still queued. The wait on the GX and the retrace in
+* update_video is then spent emulating instead.
+*
+* Anything else that draws or uses the GX from the emulation thread (load
+* screens, the menus) calls video_render_sync first, and so does anything
+* that changes SPR or FIX memory, which the jobs don't copy.
+****************************************************************************/
+#define RENDER_JOBS	2
+#define RENDER_PRIO	80
+#define RENDER_STACK	0x10000
+
+typedef struct
+{
+  VIDEO_FRAME frame;
+  char vidram[0x10C00];		/* up to the end of SCB4 */
+  unsigned short palette[4096];
+  unsigned int fix_dirty[40];
+  unsigned int fix_paldirty;
+  unsigned int scb_head[12];
+  unsigned int scb_live[12];
+} RENDER_JOB;
+
+static RENDER_JOB render_job[RENDER_JOBS] ATTRIBUTE_ALIGN (32);
+static int render_head;
+static int render_started = 0;
+static int render_queued = 0;	/* Jobs queued, by the emulation thread */
+static volatile int render_done = 0;	/* and drawn, by the render thread */
+static lwp_t render_lwp;
+static sem_t render_free;
+static sem_t render_ready;
+
+static void *
+video_render_thread (void *arg)
+{
+  int tail = 0;
+
+  for (;;)
+    {
+      LWP_SemWait (render_ready);
+      video_render (&render_job[tail].frame);
+      tail = (tail + 1) % RENDER_JOBS;
+      render_done++;
+      LWP_SemPost (render_free);
+    }
+
+  return NULL;
+}
+
+/*** Copy the parts of VRAM the frame is drawn from ***/
+static void
+video_render_copy (char *dest)
+{
+  memcpy (dest, video_vidram, 0xC000);	/* SCB1, sprites 0-383 */
+  memcpy (dest + 0xE000, video_vidram + 0xE000, 0xA00);	/* FIX map */
+  memcpy (dest + 0x10000, video_vidram + 0x10000, 0xC00);	/* SCB2-4 */
+}
+
+static void
+video_render_queue (void)
+{
+  RENDER_JOB *job;
+
+  if (!render_started)
+    {
+      LWP_SemInit (&render_free, RENDER_JOBS, RENDER_JOBS);
+      LWP_SemInit (&render_ready, 0, RENDER_JOBS);
+      LWP_CreateThread (&render_lwp, video_render_thread, NULL, NULL,
+			RENDER_STACK, RENDER_PRIO);
+      render_started = 1;
+    }
+
+  LWP_SemWait (render_free);
+  job = &render_job[render_head];
+  render_head = (render_head + 1) % RENDER_JOBS;
+
+  job->frame.vidram = job->vidram;
+  job->frame.palette = job->palette;
+  job->frame.frame_counter = neogeo_frame_counter;
+  job->frame.fix_dirty = job->fix_dirty;
+  job->frame.fix_paldirty = &job->fix_paldirty;
+  job->frame.enable = video_enable;
+  job->frame.spr_disable = spr_disable;
+  job->frame.fix_disable = fix_disable;
+  job->frame.loadprof = loadprof_frames != 0;
+  job->frame.skipped = FrameSkip ? skip_shown : 0;
+  job->frame.repeats = skip_before;
+  job->frame.scb_head = job->scb_head;
+  job->frame.scb_live = job->scb_live;
+  memcpy (job->scb_head, video_scb_head, sizeof (job->scb_head));
+  memcpy (job->scb_live, video_scb_live, sizeof (job->scb_live));
+
+  if (video_enable)
+    {
+      video_render_copy (job->vidram);
+      memcpy (job->palette, video_paletteram_pc, sizeof (job->palette));
+    }
+
+  /*** The job takes over the FIX cache bits when it draws the FIX ***/
+  memset (job->fix_dirty, 0, sizeof (job->fix_dirty));
+  job->fix_paldirty = 0;
+  if (video_enable && !fix_disable)
+    {
+      memcpy (job->fix_dirty, video_fix_dirty, sizeof (job->fix_dirty));
+      memset (video_fix_dirty, 0, sizeof (video_fix_dirty));
+      job->fix_paldirty = video_fix_paldirty;
+      video_fix_paldirty = 0;
+    }
+
+  render_queued++;
+  LWP_SemPost (render_ready);
+}
+
+/* Wait for the render thread to finish the queued jobs, if any */
+void
+video_render_sync (void)
+{
+  int i;
+
+  if (!render_started || render_done == render_queued)
+    return;
+
+  for (i = 0; i < RENDER_JOBS; i++)
+    LWP_SemWait (render_free);
+  for (i = 0; i < RENDER_JOBS; i++)
+    LWP_SemPost (render_free);
+}
+
+/*** A frame drawn straight from the live VRAM and palettes ***/
+static void
+video_live_frame (VIDEO_FRAME * frame)
+{
+  frame->vidram = video_vidram;
+  frame->palette = video_paletteram_pc;
+  frame->frame_counter = neogeo_frame_counter;
+  frame->fix_dirty = video_fix_dirty;
+  frame->fix_paldirty = &video_fix_paldirty;
+  frame->enable = video_enable;
+  frame->spr_disable = spr_disable;
+  frame->fix_disable = fix_disable;
+  frame->loadprof = loadprof_frames != 0;
+  frame->skipped = FrameSkip ? skip_shown : 0;
+  frame->repeats = skip_before;
+  frame->scb_head = video_scb_head;
+  frame->scb_live = video_scb_live;
+}
+
+//----------------------------------------------------------------------------
+void
+video_draw_screen1 ()
+{
+  VIDEO_FRAME frame;
+
+  video_update_palette ();
+
+  if (RenderThread)
+    video_render_queue ();
+  else
+    {
+      video_live_frame (&frame);
+      video_render (&frame);
+    }
+
+  if (loadprof_frames && video_enable)
+    loadprof_frames--;
+}
+
+/****************************************************************************
+* Sprite blitters
+*
+* One blitter per x zoom, x flip and opacity, all generated from the zoom
+* table below and dispatched through spr_blitter. A tile row is two words
+* of eight 4bpp pixels, numbered 0-15 in the order the hardware draws them.
+* SPR_ZOOM_n calls P(x, pixel) for each of the n + 1 columns drawn at that
+* zoom; with x flip, column x draws pixel 15 - pixel instead.
+*
+* The transparent blitters test each word of a row first and skip its
+* eight pixels when they are all transparent, which is most of the edge
+* of a sprite.
+****************************************************************************/
 //       Without  flip              With Flip
 // 01: X0000000 00000000        00000000 0000000X
 // 02: X0000000 X0000000        0000000X 0000000X
@@ -417,1793 +770,431 @@ video_draw_screen1 ()
 // 15: XXXXXXXX XXXXXXX0        0XXXXXXX XXXXXXXX
 // 16: XXXXXXXX XXXXXXXX        XXXXXXXX XXXXXXXX
 
-void
-video_draw_spr (unsigned int code, unsigned int color, int flipx,
-		int flipy, int sx, int sy, int zx, int zy)
+#define SPR_ZOOM_0(P)	P(0,0)
+#define SPR_ZOOM_1(P)	P(0,0) P(1,8)
+#define SPR_ZOOM_2(P)	P(0,0) P(1,5) P(2,10)
+#define SPR_ZOOM_3(P)	P(0,0) P(1,4) P(2,8) P(3,12)
+#define SPR_ZOOM_4(P)	P(0,0) P(1,3) P(2,6) P(3,9) P(4,12)
+#define SPR_ZOOM_5(P)	P(0,0) P(1,2) P(2,5) P(3,8) P(4,10) P(5,13)
+#define SPR_ZOOM_6(P)	P(0,0) P(1,2) P(2,4) P(3,6) P(4,9) P(5,11) P(6,13)
+#define SPR_ZOOM_7(P)	P(0,0) P(1,2) P(2,4) P(3,6) P(4,8) P(5,10) P(6,12) P(7,14)
+#define SPR_ZOOM_8(P)	P(0,0) P(1,1) P(2,3) P(3,5) P(4,7) P(5,8) P(6,10) P(7,12) P(8,14)
+#define SPR_ZOOM_9(P)	P(0,0) P(1,1) P(2,3) P(3,4) P(4,6) P(5,8) P(6,9) P(7,11) P(8,12) P(9,14)
+#define SPR_ZOOM_10(P)	P(0,0) P(1,1) P(2,2) P(3,4) P(4,5) P(5,7) P(6,8) P(7,10) P(8,11) P(9,13) P(10,14)
+#define SPR_ZOOM_11(P)	P(0,0) P(1,1) P(2,2) P(3,4) P(4,5) P(5,6) P(6,8) P(7,9) P(8,10) P(9,12) P(10,13) P(11,14)
+#define SPR_ZOOM_12(P)	P(0,0) P(1,1) P(2,2) P(3,3) P(4,4) P(5,6) P(6,7) P(7,8) P(8,9) P(9,11) P(10,12) P(11,13) P(12,14)
+#define SPR_ZOOM_13(P)	P(0,0) P(1,1) P(2,2) P(3,3) P(4,4) P(5,5) P(6,6) P(7,8) P(8,9) P(9,10) P(10,11) P(11,12) P(12,13) P(13,14)
+#define SPR_ZOOM_14(P)	P(0,0) P(1,1) P(2,2) P(3,3) P(4,4) P(5,5) P(6,6) P(7,7) P(8,8) P(9,9) P(10,10) P(11,11) P(12,12) P(13,13) P(14,14)
+#define SPR_ZOOM_15(P)	P(0,0) P(1,1) P(2,2) P(3,3) P(4,4) P(5,5) P(6,6) P(7,7) P(8,8) P(9,9) P(10,10) P(11,11) P(12,12) P(13,13) P(14,14) P(15,15)
+
+/*** Pixel of the row drawn in column x, flipped or not ***/
+#define SPR_SRC(n)	(flip ? 15 - (n) : (n))
+#define SPR_NIBBLE(n)	(((SPR_SRC (n) < 8 ? w0 : w1) >> ((SPR_SRC (n) & 7) * 4)) & 0x0F)
+
+#define SPR_PIXEL(x, n)	{ int col = SPR_NIBBLE (n); if (col) bm[x] = paldata[col]; }
+#define SPR_PIXEL_OPAQUE(x, n)	bm[x] = paldata[SPR_NIBBLE (n)];
+
+/*** Pixels from one word only ***/
+#define SPR_PIXEL_W0(x, n)	if (SPR_SRC (n) < 8) SPR_PIXEL (x, n)
+#define SPR_PIXEL_W1(x, n)	if (SPR_SRC (n) >= 8) SPR_PIXEL (x, n)
+
+typedef void (*SPRBLITTER) (unsigned char *fspr, int dy,
+			    const unsigned short *paldata, int sx, int sy,
+			    int ey, const unsigned char *l_y_skip,
+			    unsigned short *const *lines);
+
+#define SPR_BLITTER(name, zoom, flipx, transparent)			\
+static void								\
+name (unsigned char *fspr, int dy, const unsigned short *paldata,	\
+      int sx, int sy, int ey, const unsigned char *l_y_skip,		\
+      unsigned short *const *lines)					\
+{									\
+  const int flip = flipx;						\
+  unsigned short *bm;							\
+  unsigned int w0, w1;							\
+  int y, l = 0;								\
+									\
+  for (y = sy; y <= ey; y++, l++)					\
+    {									\
+      fspr += l_y_skip[l] * dy;						\
+      w0 = *((unsigned int *) fspr);					\
+      w1 = *((unsigned int *) fspr + 1);				\
+      bm = lines[y] + sx;						\
+      if (!transparent)							\
+	{								\
+	  zoom (SPR_PIXEL_OPAQUE)					\
+	  continue;							\
+	}								\
+      if (w0)								\
+	{								\
+	  zoom (SPR_PIXEL_W0)						\
+	}								\
+      if (w1)								\
+	{								\
+	  zoom (SPR_PIXEL_W1)						\
+	}								\
+    }									\
+}
+
+#define SPR_BLITTERS(z)							\
+SPR_BLITTER (spr_##z, SPR_ZOOM_##z, 0, 1)				\
+SPR_BLITTER (spr_##z##_flip, SPR_ZOOM_##z, 1, 1)			\
+SPR_BLITTER (spr_##z##_opaque, SPR_ZOOM_##z, 0, 0)			\
+SPR_BLITTER (spr_##z##_opaque_flip, SPR_ZOOM_##z, 1, 0)
+
+SPR_BLITTERS (0) SPR_BLITTERS (1) SPR_BLITTERS (2) SPR_BLITTERS (3)
+SPR_BLITTERS (4) SPR_BLITTERS (5) SPR_BLITTERS (6) SPR_BLITTERS (7)
+SPR_BLITTERS (8) SPR_BLITTERS (9) SPR_BLITTERS (10) SPR_BLITTERS (11)
+SPR_BLITTERS (12) SPR_BLITTERS (13) SPR_BLITTERS (14) SPR_BLITTERS (15)
+
+#define SPR_ZOOMS(s)							\
+  { spr_0##s, spr_1##s, spr_2##s, spr_3##s, spr_4##s, spr_5##s,	\
+    spr_6##s, spr_7##s, spr_8##s, spr_9##s, spr_10##s, spr_11##s,	\
+    spr_12##s, spr_13##s, spr_14##s, spr_15##s }
+
+/*** [opaque][flipx][zoom x] ***/
+static const SPRBLITTER spr_blitter[2][2][16] = {
+  {SPR_ZOOMS (), SPR_ZOOMS (_flip)},
+  {SPR_ZOOMS (_opaque), SPR_ZOOMS (_opaque_flip)}
+};
+
+/****************************************************************************
+* Bands
+*
+* The pass over the SCB tables only lists the tiles to draw, in drawing
+* order, with the bands each one reaches. A band then draws the background
+* colour, its tiles clipped to its lines, the FIX layer and the borders,
+* and writes to no other line, so the bands of a frame can be drawn in any
+* order or all at once and give the same frame. With VIDEO_BAND_THREADS,
+* helper threads take bands from a shared counter along with the caller.
+****************************************************************************/
+static VIDEO_FRAME *band_frame;
+
+/*** Bands are whole rows of FIX cells ***/
+static void
+video_precalc_bands (void)
 {
-  int oy, ey, y, dy;
-  unsigned short *bm;
-  int col;
-  int l;
-  unsigned int mydword;
-  unsigned char *fspr = 0;
-  unsigned char *l_y_skip;
-  const unsigned short *paldata;
+  int band, y;
 
+  for (band = 0; band <= VIDEO_BANDS; band++)
+    band_top[band] = (28 * band / VIDEO_BANDS) << 3;
 
-  // Check for total transparency, no need to draw
-  //if (video_spr_usage[code] == 0)
-  //      return;
+  for (band = 0; band < VIDEO_BANDS; band++)
+    for (y = band_top[band]; y < band_top[band + 1]; y++)
+      band_of_line[y] = band;
+}
 
-  if (sx <= -8)
+/*** List a tile for the bands its lines fall in ***/
+static void
+video_spr_add (int code, int attr, int sx, int sy, int zx, int zy,
+	       const unsigned char *l_y_skip)
+{
+  SPRTILE *tile;
+  int top = sy < 0 ? 0 : sy;
+  int bottom = sy + zy > 224 ? 224 : sy + zy;
+  int band;
+
+  if (sx <= -8 || top >= bottom)
     return;
 
-  if (zy == 16)
-    l_y_skip = full_y_skip;
-  else
-    l_y_skip = video_shrinky;
+  tile = &spr_tiles[spr_count];
+  tile->l_y_skip = l_y_skip;
+  tile->code = code;
+  tile->color = attr >> 8;
+  tile->blit = ((video_spr_usage[code] & 1) << 5) | ((attr & 0x01) << 4) | zx;
+  tile->flipy = (attr & 0x02) != 0;
+  tile->zy = zy;
+  tile->sx = sx;
+  tile->sy = sy;
 
-  fspr = neogeo_spr_memory;
+  for (band = band_of_line[top]; band <= band_of_line[bottom - 1]; band++)
+    band_tiles[band][band_count[band]++] = spr_count;
 
-  // Mish/AJP - Most clipping is done in main loop
-  oy = sy;
-  ey = sy + zy - 1;		// Clip for size of zoomed object
+  spr_count++;
+}
 
-  if (sy < 0)
-    sy = 0;
-  if (ey >= 224)
-    ey = 223;
+/****************************************************************************
+* Strip index
+*
+* A chain starts at a strip without the sticky bit and with a y zoom; until
+* the next such strip, everything drawn hangs off the position, height and
+* zoom it sets. A chain whose first strip has a height of 0 draws nothing,
+* so video_scb_head marks the strips starting a chain and video_scb_live
+* those of them with tiles, a bit per strip. They follow the SCB2 and SCB3
+* writes (VIDEO_SCB_W), and video_render only walks the live chains.
+****************************************************************************/
+void
+video_scb_update (int strip)
+{
+  unsigned short *v = (unsigned short *) video_vidram;
+  unsigned short t1 = v[0x8200 + strip];
+  unsigned int bit = 1 << (strip & 31);
+  int w = strip >> 5;
+
+  video_scb_head[w] &= ~bit;
+  video_scb_live[w] &= ~bit;
 
-  if (flipy)			// Y flip
+  if (!(t1 & 0x40) && (v[0x8000 + strip] & 0xff))
     {
-      dy = -8;
-      fspr += (code + 1) * 128 - 8 - (sy - oy) * 8;
+      video_scb_head[w] |= bit;
+      if (t1 & 0x3f)
+	video_scb_live[w] |= bit;
     }
-  else				// normal
+}
+
+/* Rebuild the index after VRAM was changed as a whole */
+void
+video_scb_flush (void)
+{
+  int strip;
+
+  for (strip = 0; strip < 0x180; strip++)
+    video_scb_update (strip);
+}
+
+/*** First strip from strip on marked in bits, or 0x180 ***/
+static int
+video_scb_next (const unsigned int *bits, int strip)
+{
+  unsigned int word;
+  int w = strip >> 5;
+
+  if (strip >= 0x180)
+    return 0x180;
+
+  word = bits[w] & ~((1u << (strip & 31)) - 1);
+  while (!word)
     {
-      dy = 8;
-      fspr += code * 128 + (sy - oy) * 8;
+      if (++w == 12)
+	return 0x180;
+      word = bits[w];
     }
 
-  paldata = (unsigned short *) &video_paletteram_pc[color * 16];
+  return (w << 5) + __builtin_ctz (word);
+}
+
+/****************************************************************************
+* video_skip_frame
+*
+* Called once per emulated frame with the number of retraces the main loop
+* is behind by, returns 1 when the frame should not be drawn. Auto skips
+* while the loop is behind, up to SkipCount frames in a row; Fixed always
+* draws one frame in SkipCount + 1, to measure the emulation alone. The
+* CPUs, sound and input still run on every frame.
+****************************************************************************/
+int
+video_skip_frame (int behind)
+{
+  int skip = 0;
+
+  if (FrameSkip == FRAMESKIP_AUTO)
+    skip = behind > 0 && frameskip < SkipCount;
+  else if (FrameSkip == FRAMESKIP_FIXED)
+    skip = frameskip < SkipCount;
 
-  if (flipx)			// X flip
+  if (skip)
     {
-      l = 0;
-      switch (zx)
-	{
-	case 0:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx;
-	      LINE_MID;
-	      SHIFT7;
-	      PIXEL_LAST;
-	      l++;
-	    }
-	  break;
-	case 1:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx + 1;
-	      LINE_BEGIN;
-	      SHIFT7;
-	      PIXEL_R;
-	      LINE_MID;
-	      SHIFT7;
-	      PIXEL_LAST;
-	      l++;
-	    }
-	  break;
-	case 2:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx + 2;
-	      LINE_BEGIN;
-	      SHIFT5;
-	      PIXEL_R;
-	      LINE_MID;
-	      SHIFT2;
-	      PIXEL_R;
-	      SHIFT5;
-	      PIXEL_LAST;
-	      l++;
-	    }
-	  break;
-	case 3:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx + 3;
-	      LINE_BEGIN;
-	      SHIFT3;
-	      PIXEL_R;
-	      SHIFT4;
-	      PIXEL_R;
-	      LINE_MID;
-	      SHIFT3;
-	      PIXEL_R;
-	      SHIFT4;
-	      PIXEL_LAST;
-	      l++;
-	    }
-	  break;
-	case 4:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx + 4;
-	      LINE_BEGIN;
-	      SHIFT3;
-	      PIXEL_R;
-	      SHIFT3;
-	      PIXEL_R;
-	      LINE_MID;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT3;
-	      PIXEL_R;
-	      SHIFT3;
-	      PIXEL_LAST;
-	      l++;
-	    }
-	  break;
-	case 5:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx + 5;
-	      LINE_BEGIN;
-	      SHIFT2;
-	      PIXEL_R;
-	      SHIFT3;
-	      PIXEL_R;
-	      SHIFT2;
-	      PIXEL_R;
-	      LINE_MID;
-	      SHIFT2;
-	      PIXEL_R;
-	      SHIFT3;
-	      PIXEL_R;
-	      SHIFT2;
-	      PIXEL_LAST;
-	      l++;
-	    }
-	  break;
-	case 6:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx + 6;
-	      LINE_BEGIN;
-	      SHIFT2;
-	      PIXEL_R;
-	      SHIFT2;
-	      PIXEL_R;
-	      SHIFT2;
-	      PIXEL_R;
-	      LINE_MID;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT2;
-	      PIXEL_R;
-	      SHIFT2;
-	      PIXEL_R;
-	      SHIFT2;
-	      PIXEL_LAST;
-	      l++;
-	    }
-	  break;
-	case 7:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx + 7;
-	      LINE_BEGIN;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT2;
-	      PIXEL_R;
-	      SHIFT2;
-	      PIXEL_R;
-	      SHIFT2;
-	      PIXEL_R;
-	      LINE_MID;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT2;
-	      PIXEL_R;
-	      SHIFT2;
-	      PIXEL_R;
-	      SHIFT2;
-	      PIXEL_LAST;
-	      l++;
-	    }
-	  break;
-	case 8:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx + 8;
-	      LINE_BEGIN;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT2;
-	      PIXEL_R;
-	      SHIFT2;
-	      PIXEL_R;
-	      SHIFT2;
-	      PIXEL_R;
-	      LINE_MID;
-	      PIXEL_R;
-	      SHIFT2;
-	      PIXEL_R;
-	      SHIFT2;
-	      PIXEL_R;
-	      SHIFT2;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_LAST;
-	      l++;
-	    }
-	  break;
-	case 9:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx + 9;
-	      LINE_BEGIN;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT2;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT2;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_R;
-	      LINE_MID;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT2;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT2;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_LAST;
-	      l++;
-	    }
-	  break;
-	case 10:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx + 10;
-	      LINE_BEGIN;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT2;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT2;
-	      PIXEL_R;
-	      LINE_MID;
-	      PIXEL_R;
-	      SHIFT2;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT2;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_LAST;
-	      l++;
-	    }
-	  break;
-	case 11:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx + 11;
-	      LINE_BEGIN;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT2;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_R;
-	      LINE_MID;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT2;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_LAST;
-	      l++;
-	    }
-	  break;
-	case 12:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx + 12;
-	      LINE_BEGIN;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT2;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_R;
-	      LINE_MID;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT2;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_LAST;
-	      l++;
-	    }
-	  break;
-	case 13:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx + 13;
-	      LINE_BEGIN;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_R;
-	      LINE_MID;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_LAST;
-	      l++;
-	    }
-	  break;
-	case 14:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx + 14;
-	      LINE_BEGIN;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_R;
-	      LINE_MID;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_LAST;
-	      l++;
-	    }
-	  break;
-	case 15:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx + 15;
-	      LINE_BEGIN;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_R;
-	      LINE_MID;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_R;
-	      SHIFT1;
-	      PIXEL_LAST;
-	      l++;
-	    }
-	  break;
-	}
+      frameskip++;
+      skip_count++;
     }
-  else				// normal
+  else
     {
-      l = 0;
-      switch (zx)
-	{
-	case 0:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx;
-	      LINE_BEGIN;
-	      PIXEL_LAST;
-	      l++;
-	    }
-	  break;
-	case 1:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx;
-	      LINE_BEGIN;
-	      PIXEL_F;
-	      LINE_MID;
-	      PIXEL_LAST;
-	      l++;
-	    }
-	  break;
-	case 2:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx;
-	      LINE_BEGIN;
-	      PIXEL_F;
-	      SHIFT5;
-	      PIXEL_F;
-	      LINE_MID;
-	      SHIFT2;
-	      PIXEL_LAST;
-	      l++;
-	    }
-	  break;
-	case 3:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx;
-	      LINE_BEGIN;
-	      PIXEL_F;
-	      SHIFT4;
-	      PIXEL_F;
-	      LINE_MID;
-	      PIXEL_F;
-	      SHIFT4;
-	      PIXEL_LAST;
-	      l++;
-	    }
-	  break;
-	case 4:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx;
-	      LINE_BEGIN;
-	      PIXEL_F;
-	      SHIFT3;
-	      PIXEL_F;
-	      SHIFT3;
-	      PIXEL_F;
-	      LINE_MID;
-	      SHIFT1;
-	      PIXEL_F;
-	      SHIFT3;
-	      PIXEL_LAST;
-	      l++;
-	    }
-	  break;
-	case 5:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx;
-	      LINE_BEGIN;
-	      PIXEL_F;
-	      SHIFT2;
-	      PIXEL_F;
-	      SHIFT3;
-	      PIXEL_F;
-	      LINE_MID;
-	      PIXEL_F;
-	      SHIFT2;
-	      PIXEL_F;
-	      SHIFT3;
-	      PIXEL_LAST;
-	      l++;
-	    }
-	  break;
-	case 6:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx;
-	      LINE_BEGIN;
-	      PIXEL_F;
-	      SHIFT2;
-	      PIXEL_F;
-	      SHIFT2;
-	      PIXEL_F;
-	      SHIFT2;
-	      PIXEL_F;
-	      LINE_MID;
-	      SHIFT1;
-	      PIXEL_F;
-	      SHIFT2;
-	      PIXEL_F;
-	      SHIFT2;
-	      PIXEL_LAST;
-	      l++;
-	    }
-	  break;
-	case 7:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx;
-	      LINE_BEGIN;
-	      PIXEL_F;
-	      SHIFT2;
-	      PIXEL_F;
-	      SHIFT2;
-	      PIXEL_F;
-	      SHIFT2;
-	      PIXEL_F;
-	      LINE_MID;
-	      PIXEL_F;
-	      SHIFT2;
-	      PIXEL_F;
-	      SHIFT2;
-	      PIXEL_F;
-	      SHIFT2;
-	      PIXEL_LAST;
-	      l++;
-	    }
-	  break;
-	case 8:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx;
-	      LINE_BEGIN;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_F;
-	      SHIFT2;
-	      PIXEL_F;
-	      SHIFT2;
-	      PIXEL_F;
-	      SHIFT2;
-	      PIXEL_F;
-	      LINE_MID;
-	      PIXEL_F;
-	      SHIFT2;
-	      PIXEL_F;
-	      SHIFT2;
-	      PIXEL_F;
-	      SHIFT2;
-	      PIXEL_LAST;
-	      l++;
-	    }
-	  break;
-	case 9:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx;
-	      LINE_BEGIN;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_F;
-	      SHIFT2;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_F;
-	      SHIFT2;
-	      PIXEL_F;
-	      LINE_MID;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_F;
-	      SHIFT2;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_F;
-	      SHIFT2;
-	      PIXEL_LAST;
-	      l++;
-	    }
-	  break;
-	case 10:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx;
-	      LINE_BEGIN;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_F;
-	      SHIFT2;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_F;
-	      SHIFT2;
-	      PIXEL_F;
-	      LINE_MID;
-	      PIXEL_F;
-	      SHIFT2;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_F;
-	      SHIFT2;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_LAST;
-	      l++;
-	    }
-	  break;
-	case 11:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx;
-	      LINE_BEGIN;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_F;
-	      SHIFT2;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_F;
-	      LINE_MID;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_F;
-	      SHIFT2;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_LAST;
-	      l++;
-	    }
-	  break;
-	case 12:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx;
-	      LINE_BEGIN;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_F;
-	      SHIFT2;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_F;
-	      LINE_MID;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_F;
-	      SHIFT2;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_LAST;
-	      l++;
-	    }
-	  break;
-	case 13:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx;
-	      LINE_BEGIN;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_F;
-	      LINE_MID;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_LAST;
-	      l++;
-	    }
-	  break;
-	case 14:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx;
-	      LINE_BEGIN;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_F;
-	      LINE_MID;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_LAST;
-	      l++;
-	    }
-	  break;
-	case 15:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx;
-	      LINE_BEGIN;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_F;
-	      LINE_MID;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_F;
-	      SHIFT1;
-	      PIXEL_LAST;
-	      l++;
-	    }
-	  break;
-	}
+      skip_before = frameskip;
+      frameskip = 0;
     }
-}
 
+  /*** Count for the indicator ***/
+  if (++skip_frames == 60)
+    {
+      skip_shown = skip_count;
+      skip_count = 0;
+      skip_frames = 0;
+    }
 
-void
-video_draw_spr_opaque (unsigned int code, unsigned int color, int flipx,
-		       int flipy, int sx, int sy, int zx, int zy)
+  return skip;
+}
+
+/****************************************************************************
+* video_blit_spr_edge
+*
+* Draws a tile over the left or right edge through a scratch row, so that
+* the pixels past the edge don't wrap onto the line above or below, which
+* may be in another band.
+****************************************************************************/
+static void
+video_blit_spr_edge (SPRBLITTER blit, unsigned char *fspr, int dy,
+		     const unsigned short *paldata, int sx, int sy, int ey,
+		     const unsigned char *l_y_skip)
 {
-  int oy, ey, y, dy;
-  unsigned short *bm;
-  int col;
-  int l;
-  unsigned int mydword;
-  unsigned char *fspr = 0;
-  unsigned char *l_y_skip;
-  const unsigned short *paldata;
+  unsigned short row[16][16];
+  unsigned short *rows[16];
+  int x0 = sx < 0 ? 0 : sx;
+  int x1 = sx + 16 > 320 ? 320 : sx + 16;
+  int y, n = ey - sy + 1;
 
+  for (y = 0; y < 16; y++)
+    rows[y] = row[y];
+  for (y = 0; y < n; y++)
+    memcpy (&row[y][x0 - sx], video_line_ptr[sy + y] + x0, (x1 - x0) * 2);
 
-  // Check for total transparency, no need to draw
-  //if (video_spr_usage[code] == 0)
-  //      return;
+  blit (fspr, dy, paldata, 0, 0, n - 1, l_y_skip, rows);
 
-  if (sx <= -8)
-    return;
+  for (y = 0; y < n; y++)
+    memcpy (video_line_ptr[sy + y] + x0, &row[y][x0 - sx], (x1 - x0) * 2);
+}
 
-  if (zy == 16)
-    l_y_skip = full_y_skip;
-  else
-    l_y_skip = video_shrinky;
+/****************************************************************************
+* video_blit_spr
+*
+* Clips the tile to the screen and to lines y0 to y1 - 1, and finds its
+* first row for the blitter
+****************************************************************************/
+static void
+video_blit_spr (const SPRTILE * tile, int y0, int y1)
+{
+  int sx = tile->sx, sy = tile->sy, oy, ey, dy;
+  unsigned char *fspr;
+  const unsigned char *l_y_skip = tile->l_y_skip;
+  const unsigned short *paldata = &render_palette[tile->color * 16];
+  SPRBLITTER blit = spr_blitter[tile->blit >> 5][(tile->blit >> 4) & 1]
+    [tile->blit & 15];
 
   fspr = neogeo_spr_memory;
 
   // Mish/AJP - Most clipping is done in main loop
   oy = sy;
-  ey = sy + zy - 1;		// Clip for size of zoomed object
+  ey = sy + tile->zy - 1;	// Clip for size of zoomed object
 
   if (sy < 0)
     sy = 0;
   if (ey >= 224)
     ey = 223;
 
-  if (flipy)			// Y flip
+  if (tile->flipy)		// Y flip
     {
       dy = -8;
-      fspr += (code + 1) * 128 - 8 - (sy - oy) * 8;
+      fspr += (tile->code + 1) * 128 - 8 - (sy - oy) * 8;
     }
   else				// normal
     {
       dy = 8;
-      fspr += code * 128 + (sy - oy) * 8;
+      fspr += tile->code * 128 + (sy - oy) * 8;
     }
 
-  paldata = (unsigned short *) &video_paletteram_pc[color * 16];
+  /*** Step to the top of the band as the lines above it would ***/
+  for (; sy < y0; sy++)
+    fspr += *l_y_skip++ * dy;
+  if (ey >= y1)
+    ey = y1 - 1;
+
+  if (sx < 0 || sx > 320 - 16)
+    video_blit_spr_edge (blit, fspr, dy, paldata, sx, sy, ey, l_y_skip);
+  else
+    blit (fspr, dy, paldata, sx, sy, ey, l_y_skip, video_line_ptr);
+}
+
+/*** Draw one band of the frame in band_frame ***/
+static void
+video_render_band (int band)
+{
+  int y0 = band_top[band], y1 = band_top[band + 1];
+  int i, x, y;
+  unsigned short *line;
 
-  if (flipx)			// X flip
+  if (!band_frame->spr_disable)
     {
-      l = 0;
-      switch (zx)
+      //fill background colour
+      for (y = y0; y < y1; y++)
 	{
-	case 0:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx;
-	      LINE_MID;
-	      SHIFT7;
-	      PIXEL_LAST_OPAQUE;
-	      l++;
-	    }
-	  break;
-	case 1:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx + 1;
-	      LINE_BEGIN;
-	      SHIFT7;
-	      PIXEL_R_OPAQUE;
-	      LINE_MID;
-	      SHIFT7;
-	      PIXEL_LAST_OPAQUE;
-	      l++;
-	    }
-	  break;
-	case 2:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx + 2;
-	      LINE_BEGIN;
-	      SHIFT5;
-	      PIXEL_R_OPAQUE;
-	      LINE_MID;
-	      SHIFT2;
-	      PIXEL_R_OPAQUE;
-	      SHIFT5;
-	      PIXEL_LAST_OPAQUE;
-	      l++;
-	    }
-	  break;
-	case 3:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx + 3;
-	      LINE_BEGIN;
-	      SHIFT3;
-	      PIXEL_R_OPAQUE;
-	      SHIFT4;
-	      PIXEL_R_OPAQUE;
-	      LINE_MID;
-	      SHIFT3;
-	      PIXEL_R_OPAQUE;
-	      SHIFT4;
-	      PIXEL_LAST_OPAQUE;
-	      l++;
-	    }
-	  break;
-	case 4:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx + 4;
-	      LINE_BEGIN;
-	      SHIFT3;
-	      PIXEL_R_OPAQUE;
-	      SHIFT3;
-	      PIXEL_R_OPAQUE;
-	      LINE_MID;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT3;
-	      PIXEL_R_OPAQUE;
-	      SHIFT3;
-	      PIXEL_LAST_OPAQUE;
-	      l++;
-	    }
-	  break;
-	case 5:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx + 5;
-	      LINE_BEGIN;
-	      SHIFT2;
-	      PIXEL_R_OPAQUE;
-	      SHIFT3;
-	      PIXEL_R_OPAQUE;
-	      SHIFT2;
-	      PIXEL_R_OPAQUE;
-	      LINE_MID;
-	      SHIFT2;
-	      PIXEL_R_OPAQUE;
-	      SHIFT3;
-	      PIXEL_R_OPAQUE;
-	      SHIFT2;
-	      PIXEL_LAST_OPAQUE;
-	      l++;
-	    }
-	  break;
-	case 6:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx + 6;
-	      LINE_BEGIN;
-	      SHIFT2;
-	      PIXEL_R_OPAQUE;
-	      SHIFT2;
-	      PIXEL_R_OPAQUE;
-	      SHIFT2;
-	      PIXEL_R_OPAQUE;
-	      LINE_MID;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT2;
-	      PIXEL_R_OPAQUE;
-	      SHIFT2;
-	      PIXEL_R_OPAQUE;
-	      SHIFT2;
-	      PIXEL_LAST_OPAQUE;
-	      l++;
-	    }
-	  break;
-	case 7:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx + 7;
-	      LINE_BEGIN;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT2;
-	      PIXEL_R_OPAQUE;
-	      SHIFT2;
-	      PIXEL_R_OPAQUE;
-	      SHIFT2;
-	      PIXEL_R_OPAQUE;
-	      LINE_MID;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT2;
-	      PIXEL_R_OPAQUE;
-	      SHIFT2;
-	      PIXEL_R_OPAQUE;
-	      SHIFT2;
-	      PIXEL_LAST_OPAQUE;
-	      l++;
-	    }
-	  break;
-	case 8:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx + 8;
-	      LINE_BEGIN;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT2;
-	      PIXEL_R_OPAQUE;
-	      SHIFT2;
-	      PIXEL_R_OPAQUE;
-	      SHIFT2;
-	      PIXEL_R_OPAQUE;
-	      LINE_MID;
-	      PIXEL_R_OPAQUE;
-	      SHIFT2;
-	      PIXEL_R_OPAQUE;
-	      SHIFT2;
-	      PIXEL_R_OPAQUE;
-	      SHIFT2;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_LAST_OPAQUE;
-	      l++;
-	    }
-	  break;
-	case 9:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx + 9;
-	      LINE_BEGIN;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT2;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT2;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      LINE_MID;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT2;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT2;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_LAST_OPAQUE;
-	      l++;
-	    }
-	  break;
-	case 10:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx + 10;
-	      LINE_BEGIN;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT2;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT2;
-	      PIXEL_R_OPAQUE;
-	      LINE_MID;
-	      PIXEL_R_OPAQUE;
-	      SHIFT2;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT2;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_LAST_OPAQUE;
-	      l++;
-	    }
-	  break;
-	case 11:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx + 11;
-	      LINE_BEGIN;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT2;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      LINE_MID;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT2;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_LAST_OPAQUE;
-	      l++;
-	    }
-	  break;
-	case 12:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx + 12;
-	      LINE_BEGIN;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT2;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      LINE_MID;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT2;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_LAST_OPAQUE;
-	      l++;
-	    }
-	  break;
-	case 13:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx + 13;
-	      LINE_BEGIN;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      LINE_MID;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_LAST_OPAQUE;
-	      l++;
-	    }
-	  break;
-	case 14:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx + 14;
-	      LINE_BEGIN;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      LINE_MID;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_LAST_OPAQUE;
-	      l++;
-	    }
-	  break;
-	case 15:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx + 15;
-	      LINE_BEGIN;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      LINE_MID;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_R_OPAQUE;
-	      SHIFT1;
-	      PIXEL_LAST_OPAQUE;
-	      l++;
-	    }
-	  break;
+	  line = video_line_ptr[y];
+	  for (x = 0; x < 320; x++)
+	    line[x] = render_palette[4095];
 	}
+
+      for (i = 0; i < band_count[band]; i++)
+	video_blit_spr (&spr_tiles[band_tiles[band][i]], y0, y1);
     }
-  else				// normal
+
+  if (!band_frame->fix_disable)
+    video_draw_fix (y0, y1);
+
+    /*** Do clipping ***/
+  for (y = y0; y < y1; y++)
     {
-      l = 0;
-      switch (zx)
-	{
-	case 0:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx;
-	      LINE_BEGIN;
-	      PIXEL_LAST_OPAQUE;
-	      l++;
-	    }
-	  break;
-	case 1:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx;
-	      LINE_BEGIN;
-	      PIXEL_F_OPAQUE;
-	      LINE_MID;
-	      PIXEL_LAST_OPAQUE;
-	      l++;
-	    }
-	  break;
-	case 2:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx;
-	      LINE_BEGIN;
-	      PIXEL_F_OPAQUE;
-	      SHIFT5;
-	      PIXEL_F_OPAQUE;
-	      LINE_MID;
-	      SHIFT2;
-	      PIXEL_LAST_OPAQUE;
-	      l++;
-	    }
-	  break;
-	case 3:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx;
-	      LINE_BEGIN;
-	      PIXEL_F_OPAQUE;
-	      SHIFT4;
-	      PIXEL_F_OPAQUE;
-	      LINE_MID;
-	      PIXEL_F_OPAQUE;
-	      SHIFT4;
-	      PIXEL_LAST_OPAQUE;
-	      l++;
-	    }
-	  break;
-	case 4:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx;
-	      LINE_BEGIN;
-	      PIXEL_F_OPAQUE;
-	      SHIFT3;
-	      PIXEL_F_OPAQUE;
-	      SHIFT3;
-	      PIXEL_F_OPAQUE;
-	      LINE_MID;
-	      SHIFT1;
-	      PIXEL_F_OPAQUE;
-	      SHIFT3;
-	      PIXEL_LAST_OPAQUE;
-	      l++;
-	    }
-	  break;
-	case 5:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx;
-	      LINE_BEGIN;
-	      PIXEL_F_OPAQUE;
-	      SHIFT2;
-	      PIXEL_F_OPAQUE;
-	      SHIFT3;
-	      PIXEL_F_OPAQUE;
-	      LINE_MID;
-	      PIXEL_F_OPAQUE;
-	      SHIFT2;
-	      PIXEL_F_OPAQUE;
-	      SHIFT3;
-	      PIXEL_LAST_OPAQUE;
-	      l++;
-	    }
-	  break;
-	case 6:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx;
-	      LINE_BEGIN;
-	      PIXEL_F_OPAQUE;
-	      SHIFT2;
-	      PIXEL_F_OPAQUE;
-	      SHIFT2;
-	      PIXEL_F_OPAQUE;
-	      SHIFT2;
-	      PIXEL_F_OPAQUE;
-	      LINE_MID;
-	      SHIFT1;
-	      PIXEL_F_OPAQUE;
-	      SHIFT2;
-	      PIXEL_F_OPAQUE;
-	      SHIFT2;
-	      PIXEL_LAST_OPAQUE;
-	      l++;
-	    }
-	  break;
-	case 7:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx;
-	      LINE_BEGIN;
-	      PIXEL_F_OPAQUE;
-	      SHIFT2;
-	      PIXEL_F_OPAQUE;
-	      SHIFT2;
-	      PIXEL_F_OPAQUE;
-	      SHIFT2;
-	      PIXEL_F_OPAQUE;
-	      LINE_MID;
-	      PIXEL_F_OPAQUE;
-	      SHIFT2;
-	      PIXEL_F_OPAQUE;
-	      SHIFT2;
-	      PIXEL_F_OPAQUE;
-	      SHIFT2;
-	      PIXEL_LAST_OPAQUE;
-	      l++;
-	    }
-	  break;
-	case 8:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx;
-	      LINE_BEGIN;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_F_OPAQUE;
-	      SHIFT2;
-	      PIXEL_F_OPAQUE;
-	      SHIFT2;
-	      PIXEL_F_OPAQUE;
-	      SHIFT2;
-	      PIXEL_F_OPAQUE;
-	      LINE_MID;
-	      PIXEL_F_OPAQUE;
-	      SHIFT2;
-	      PIXEL_F_OPAQUE;
-	      SHIFT2;
-	      PIXEL_F_OPAQUE;
-	      SHIFT2;
-	      PIXEL_LAST_OPAQUE;
-	      l++;
-	    }
-	  break;
-	case 9:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx;
-	      LINE_BEGIN;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_F_OPAQUE;
-	      SHIFT2;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_F_OPAQUE;
-	      SHIFT2;
-	      PIXEL_F_OPAQUE;
-	      LINE_MID;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_F_OPAQUE;
-	      SHIFT2;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_F_OPAQUE;
-	      SHIFT2;
-	      PIXEL_LAST_OPAQUE;
-	      l++;
-	    }
-	  break;
-	case 10:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx;
-	      LINE_BEGIN;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_F_OPAQUE;
-	      SHIFT2;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_F_OPAQUE;
-	      SHIFT2;
-	      PIXEL_F_OPAQUE;
-	      LINE_MID;
-	      PIXEL_F_OPAQUE;
-	      SHIFT2;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_F_OPAQUE;
-	      SHIFT2;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_LAST_OPAQUE;
-	      l++;
-	    }
-	  break;
-	case 11:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx;
-	      LINE_BEGIN;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_F_OPAQUE;
-	      SHIFT2;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_F_OPAQUE;
-	      LINE_MID;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_F_OPAQUE;
-	      SHIFT2;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_LAST_OPAQUE;
-	      l++;
-	    }
-	  break;
-	case 12:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx;
-	      LINE_BEGIN;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_F_OPAQUE;
-	      SHIFT2;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_F_OPAQUE;
-	      LINE_MID;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_F_OPAQUE;
-	      SHIFT2;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_LAST_OPAQUE;
-	      l++;
-	    }
-	  break;
-	case 13:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx;
-	      LINE_BEGIN;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_F_OPAQUE;
-	      LINE_MID;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_LAST_OPAQUE;
-	      l++;
-	    }
-	  break;
-	case 14:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx;
-	      LINE_BEGIN;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_F_OPAQUE;
-	      LINE_MID;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_LAST_OPAQUE;
-	      l++;
-	    }
-	  break;
-	case 15:
-	  for (y = sy; y <= ey; y++)
-	    {
-	      fspr += l_y_skip[l] * dy;
-	      bm = (video_line_ptr[y]) + sx;
-	      LINE_BEGIN;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_F_OPAQUE;
-	      LINE_MID;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_F_OPAQUE;
-	      SHIFT1;
-	      PIXEL_LAST_OPAQUE;
-	      l++;
-	    }
-	  break;
-	}
+      for (x = 0; x < 8; x++)
+	video_line_ptr[y][x] = video_line_ptr[y][x + 311] = 0;
+    }
+}
+
+#if VIDEO_BAND_THREADS
+static lwp_t band_lwp[VIDEO_BAND_THREADS];
+static sem_t band_start;
+static sem_t band_done;
+static mutex_t band_mutex;
+static int band_next;
+static int band_started = 0;
+
+/*** Draw bands until none are left ***/
+static void
+video_render_bands_take (void)
+{
+  int band;
+
+  for (;;)
+    {
+      LWP_MutexLock (band_mutex);
+      band = band_next++;
+      LWP_MutexUnlock (band_mutex);
+
+      if (band >= VIDEO_BANDS)
+	return;
+      video_render_band (band);
+    }
+}
+
+static void *
+video_band_thread (void *arg)
+{
+  for (;;)
+    {
+      LWP_SemWait (band_start);
+      video_render_bands_take ();
+      LWP_SemPost (band_done);
+    }
+
+  return NULL;
+}
+#endif
+
+static void
+video_render_bands (VIDEO_FRAME * frame)
+{
+  int i;
+
+  band_frame = frame;
+
+#if VIDEO_BAND_THREADS
+  if (!band_started)
+    {
+      LWP_SemInit (&band_start, 0, VIDEO_BAND_THREADS);
+      LWP_SemInit (&band_done, 0, VIDEO_BAND_THREADS);
+      LWP_MutexInit (&band_mutex, false);
+      for (i = 0; i < VIDEO_BAND_THREADS; i++)
+	LWP_CreateThread (&band_lwp[i], video_band_thread, NULL, NULL,
+			  RENDER_STACK, RENDER_PRIO);
+      band_started = 1;
     }
+
+  band_next = 0;
+  for (i = 0; i < VIDEO_BAND_THREADS; i++)
+    LWP_SemPost (band_start);
+  video_render_bands_take ();
+  for (i = 0; i < VIDEO_BAND_THREADS; i++)
+    LWP_SemWait (band_done);
+#else
+  for (i = 0; i < VIDEO_BANDS; i++)
+    video_render_band (i);
+#endif
 }
 
 /****************************************************************************
@@ -2212,15 +1203,36 @@ video_draw_spr_opaque (unsigned int code, unsigned int color, int flipx,
 void
 video_clear (void)
 {
+  video_render_sync ();
   memset (video_buffer, 0, (NEOSCR_WIDTH * (NEOSCR_HEIGHT + 16)) * 2);
 }
 
+/****************************************************************************
+* video_draw_load_fix
+*
+* The load screens draw only the FIX layer, from the live VRAM, between
+* frames.
+****************************************************************************/
+void
+video_draw_load_fix (void)
+{
+  VIDEO_FRAME frame;
+
+  video_render_sync ();
+  video_update_palette ();
+  video_live_frame (&frame);
+  video_update_fix (&frame);
+  video_draw_fix (0, NEOSCR_HEIGHT);
+}
+
 /****************************************************************************
 * blitter
 ****************************************************************************/
 void
 blitter (void)
 {
+  video_render_sync ();
+  loadprof_draw ((unsigned short *) video_buffer);
   update_video (320, 224, video_buffer);
 }
 
@@ -2230,5 +1242,6 @@ blitter (void)
 void
 savescreen (char *buffer)
 {
+  video_render_sync ();
   memcpy (buffer, video_buffer, (640 * 224));
 }
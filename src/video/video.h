@@ -13,6 +13,11 @@
 #define NEOSCR_WIDTH 320
 #define NEOSCR_HEIGHT 224
 
+/*** FrameSkip ***/
+#define FRAMESKIP_OFF	0
+#define FRAMESKIP_AUTO	1
+#define FRAMESKIP_FIXED	2
+
 /*-- Global Variables ------------------------------------------------------*/
 extern char video_vidram[0x20000];
 extern unsigned short *video_paletteram_ng;
@@ -30,8 +35,12 @@ extern unsigned short video_palette_bank1[4096];
 extern unsigned short *video_line_ptr[224];
 extern unsigned char video_fix_usage[4096];
 extern unsigned char video_spr_usage[0x10000];
+extern unsigned int video_scb_head[12];
+extern unsigned int video_scb_live[12];
 extern unsigned int video_hide_fps;
 extern unsigned short video_color_lut[32768];
+extern unsigned int video_palette_dirty[2][128];
+extern unsigned int *video_paldirty;
 extern int spr_disable;
 extern int fix_disable;
 extern int video_mode;
@@ -41,23 +50,75 @@ extern int frameskip;
 extern unsigned int neogeo_frame_counter;
 extern unsigned int neogeo_frame_counter_speed;
 
+/*** What a frame is drawn from: the live state, or a copy made at vblank ***/
+typedef struct
+{
+  char *vidram;
+  unsigned short *palette;
+  unsigned int frame_counter;
+  unsigned int *fix_dirty;
+  unsigned int *fix_paldirty;
+  int enable;
+  int spr_disable;
+  int fix_disable;
+  int loadprof;
+  int skipped;			/* frames skipped in the last second */
+  int repeats;			/* frames skipped just before this one */
+  unsigned int *scb_head;
+  unsigned int *scb_live;
+} VIDEO_FRAME;
+
 /*-- video.c functions ----------------------------------------------------*/
 int video_init (void);
 void video_shutdown (void);
 int video_set_mode (int);
 void video_draw_screen1 (void);
 void video_save_snapshot (void);
-void video_draw_spr (unsigned int code, unsigned int color, int flipx,
-		     int flipy, int sx, int sy, int zx, int zy);
 void video_setup (void);
 void video_fullscreen_toggle (void);
 void video_mode_toggle (void);
 void video_clear (void);
+void video_draw_load_fix (void);
+void video_render_sync (void);
+int video_skip_frame (int behind);
+void video_scb_update (int strip);
+void video_scb_flush (void);
+void video_precalc_lut (void);
+void video_update_palette (void);
+void video_palette_mark (unsigned int offset, unsigned int count);
 void blitter (void);
 void savescreen (char *buffer);
 
 /*-- draw_fix.c functions -------------------------------------------------*/
-void video_draw_fix (void);
+void video_update_fix (VIDEO_FRAME * frame);
+void video_draw_fix (int y0, int y1);
+void video_fix_flush (void);
 void fixputs (u16 x, u16 y, const char *string);
 
+/*** FIX cache dirty bits: a word per map column, a bit per row ***/
+extern unsigned int video_fix_dirty[40];
+extern unsigned int video_fix_paldirty;
+
+/*** Mark the FIX cache after a write to VRAM word p ***/
+#define VIDEO_FIX_MAP_W(p) \
+  do \
+    { \
+      if ((unsigned int) ((p) - 0x7000) < 0x500) \
+	video_fix_dirty[((p) - 0x7000) >> 5] |= 1 << ((p) & 31); \
+    } \
+  while (0)
+
+/*** Keep the strip index after a write to VRAM word p ***/
+#define VIDEO_SCB_W(p) \
+  do \
+    { \
+      if ((unsigned int) ((p) - 0x8000) < 0x400 && ((p) & 0x1ff) < 0x180) \
+	video_scb_update ((p) & 0x1ff); \
+    } \
+  while (0)
+
+/*** Mark entry n of the current palette bank after a write ***/
+#define VIDEO_PALETTE_W(n) \
+  video_paldirty[(n) >> 5] |= 1 << ((n) & 31)
+
 #endif /* VIDEO_H */
@@ -94,7 +94,7 @@
 * NeoGeo CD - Modifications
 *
 * Z80 Read/Write Memory performed using subcpu_memspace.
-* Z80 Port Read/Write coded to z80intrf
+* Z80 Port Read/Write through the port tables in z80intrf
 * Added EXIT_ON_EOI for better interrupt / cycle control
 *
 * At the bottom of this module are mz80 wrappers for the original MZ80 i/f.
@@ -105,10 +105,10 @@
 /*** Z80 Memory Space for NeoCD ***/
 #define change_pc(pc)
 extern UINT8 subcpu_memspace[0x10000];
-extern UINT16 PortRead( UINT16 Port );
-extern void PortWrite( UINT16 Port, UINT8 data );
-static UINT8 cpu_readop( UINT32 address );
-static UINT8 cpu_readop_arg( UINT32 address );
+extern UINT8 (*const z80_port_read[256])( void );
+extern void (*const z80_port_write[256])( UINT8 data );
+#define cpu_readop(address)     subcpu_memspace[address]
+#define cpu_readop_arg(address) subcpu_memspace[address]
 static INT32 z80_irq_callback( INT32 irq );
 //extern int z80done;
 int EXIT_ON_EOI = 0;
@@ -142,6 +142,14 @@ extern CPU CPU_Z80;
 /* check for delay loops counting down BC */
 #define TIME_LOOP_HACKS		0
 
+/* skip the rest of the timeslice in sound driver wait loops */
+#ifndef IDLE_LOOP_SKIP
+#define IDLE_LOOP_SKIP		1
+#endif
+
+/* longest backward JR that closes a wait loop */
+#define IDLE_LOOP_SIZE		16
+
 #ifdef X86_ASM
 #undef	BIG_FLAGS_ARRAY
 #define BIG_FLAGS_ARRAY		0
@@ -243,6 +251,23 @@ static Z80_Regs Z80;
 static UINT32 EA;
 static int after_EI = 0;
 
+/* cycles burned or skipped while idle, cleared by the scheduler each frame */
+int z80_idle_cycles = 0;
+
+#if IDLE_LOOP_SKIP
+/* memory and port writes, so a wait loop can be seen not to have any */
+static UINT32 idle_writes;
+
+/* state at the last backward JR, to compare with the next time round */
+static struct
+{
+	UINT32	pc;
+	int		icount;
+	UINT32	writes;
+	Z80_Regs regs;
+}	idle;
+#endif
+
 static UINT8 SZ[256];		/* zero and sign flags */
 static UINT8 SZ_BIT[256];	/* zero, sign and parity/overflow (=zero) flags for BIT opcode */
 static UINT8 SZP[256];		/* zero, sign and parity flags */
@@ -489,9 +514,55 @@ INLINE void BURNODD(int cycles, int opcodes, int cyclesum)
 	{
 		R += (cycles / cyclesum) * opcodes;
 		z80_ICount -= (cycles / cyclesum) * cyclesum;
+		z80_idle_cycles += (cycles / cyclesum) * cyclesum;
 	}
 }
 
+#if IDLE_LOOP_SKIP
+/****************************************************************************/
+/* Sound driver wait loops. Nothing the Z80 can see changes during a        */
+/* timeslice: the command latch, the YM2610 timers and the interrupt lines  */
+/* are only updated by the scheduler between calls to z80_execute. So a     */
+/* loop that comes back to the same backward JR with the same registers and */
+/* without writing memory or ports goes round the same way until the slice  */
+/* ends. Skip its whole iterations and leave the last, partial one to run,  */
+/* so the slice ends in exactly the state it would have without the skip.   */
+/****************************************************************************/
+static void idle_loop(void)
+{
+	Z80_Regs *r = &idle.regs;
+
+	if( PCD == idle.pc && idle_writes == idle.writes &&
+		Z80.sp.d == r->sp.d && Z80.af.d == r->af.d && Z80.bc.d == r->bc.d &&
+		Z80.de.d == r->de.d && Z80.hl.d == r->hl.d && Z80.ix.d == r->ix.d &&
+		Z80.iy.d == r->iy.d && Z80.af2.d == r->af2.d && Z80.bc2.d == r->bc2.d &&
+		Z80.de2.d == r->de2.d && Z80.hl2.d == r->hl2.d &&
+		IFF1 == r->iff1 && IFF2 == r->iff2 && IM == r->im && I == r->i )
+	{
+		int period = idle.icount - z80_ICount;
+
+		if( period > 0 && z80_ICount > period )
+		{
+			int n = (z80_ICount - 1) / period;
+			R += n * (UINT8)(R - r->r);
+			z80_ICount -= n * period;
+			z80_idle_cycles += n * period;
+		}
+	}
+
+	idle.pc = PCD;
+	idle.icount = z80_ICount;
+	idle.writes = idle_writes;
+	idle.regs = Z80;
+}
+
+#define IDLE_LOOP(arg)											\
+	if( (arg) < 0 && (arg) >= -IDLE_LOOP_SIZE && !after_EI )	\
+		idle_loop()
+#else
+#define IDLE_LOOP(arg) ((void)0)
+#endif
+
 /***************************************************************
  * define an opcode function
  ***************************************************************/
@@ -615,14 +686,18 @@ INLINE void BURNODD(int cycles, int opcodes, int cyclesum)
  * Input a byte from given I/O port
  ***************************************************************/
 //#define IN(port)   ((UINT8)io_read_byte_8(port))
-#define IN(port)     ((UINT16)PortRead(port))
+#define IN(port)     ((UINT16)z80_port_read[(port) & 0xff]())
 
 
 /***************************************************************
  * Output a byte to given I/O port
  ***************************************************************/
 //#define OUT(port,value) io_write_byte_8(port,value)
-#define OUT(port,value) PortWrite( port, value )
+#if IDLE_LOOP_SKIP
+#define OUT(port,value) ( idle_writes++, z80_port_write[(port) & 0xff]( value ) )
+#else
+#define OUT(port,value) z80_port_write[(port) & 0xff]( value )
+#endif
 
 /***************************************************************
  * Read a byte from given memory location
@@ -643,7 +718,11 @@ INLINE void RM16( UINT32 addr, PAIR *r )
  * Write a byte to given memory location
  ***************************************************************/
 //#define WM(addr,value) program_write_byte_8(addr,value)
+#if IDLE_LOOP_SKIP
+#define WM(addr, value) ( idle_writes++, subcpu_memspace[addr]=(value) )
+#else
 #define WM(addr, value) subcpu_memspace[addr]=(value)
+#endif
 
 /***************************************************************
  * Write a word to given memory location
@@ -782,6 +861,7 @@ INLINE UINT32 ARG16(void)
 	else														\
 	{															\
 		UINT8 op = cpu_readop(PCD);								\
+		IDLE_LOOP(arg);											\
 		if( PCD == oldpc-1 )									\
 		{														\
 			/* NOP - JR $-1 or EI - JR $-1 */					\
@@ -813,6 +893,8 @@ INLINE UINT32 ARG16(void)
 		PC += arg;				/* so don't do PC += ARG() */	\
 		CC(ex,opcode);											\
 		change_pc(PCD);											\
+		if( opcode != 0x10 )	/* DJNZ never comes round the same */	\
+			IDLE_LOOP(arg);										\
 	}															\
 	else PC++;													\
 
@@ -3938,6 +4020,9 @@ static int z80_execute(int cycles)
 {
 	z80_ICount = cycles - Z80.extra_cycles;
 	Z80.extra_cycles = 0;
+#if IDLE_LOOP_SKIP
+	idle.pc = ~0;	/* the scheduler may have changed anything since */
+#endif
 
 	do
 	{
@@ -3964,6 +4049,7 @@ static void z80_burn(int cycles)
 		int n = (cycles + 3) / 4;
 		R += n;
 		z80_ICount -= 4 * n;
+		z80_idle_cycles += 4 * n;
 	}
 }
 
@@ -4482,16 +4568,6 @@ void z80_get_info(UINT32 state, union cpuinfo *info)
  * 
  * Basic wrappers for original MZ80 interface.
  ***********************************************************************************/
-static UINT8 cpu_readop( UINT32 address )
-{
-	return subcpu_memspace[address];
-}
-
-static UINT8 cpu_readop_arg( UINT32 address )
-{
-	return subcpu_memspace[address];
-}
-
 /****************************************************************************
 * irq_callback
 *
@@ -108,5 +108,6 @@ void mz80int( INT32 irq );
 void mz80ClearPendingInterrupt( INT32 irq );
 void mz80_reset( void );
 extern int cpu_enabled;
+extern int z80_idle_cycles;
 
 #endif
@@ -36,77 +36,102 @@ int nmi_over = 0;
 * very important task too.
 ***/
 
-void
-PortWrite (UINT16 PortNo, UINT8 data)
+//-- Port Handlers ----------------------------------------------------------
+/***
+* The Z80 core dispatches IN and OUT through z80_port_read/z80_port_write,
+* indexed by the low byte of the port. The YM2610 ports call fm.c directly.
+***/
+
+static UINT8
+port_nop_r (void)
 {
+  //printf("Unimplemented Z80 Read Port\n");
+  return 0;
+}
 
-  switch (PortNo & 0xff)
-    {
+static void
+port_nop_w (UINT8 data)
+{
+  //printf("Unimplemented Z80 Write Port data: %x\n",data);
+}
 
-    case 0x4:
-      YM2610_control_port_0_A_w (0, data);
-      break;
+static UINT8
+port_sound_code_r (void)
+{
+  pending_command = 0;
+  return sound_code;
+}
 
-    case 0x5:
-      YM2610_data_port_0_A_w (0, data);
-      break;
+static UINT8
+port_ym2610_status_a_r (void)
+{
+  return YM2610Read (0);
+}
 
-    case 0x6:
-      YM2610_control_port_0_B_w (0, data);
-      break;
+static UINT8
+port_ym2610_data_r (void)
+{
+  return YM2610Read (1);
+}
 
-    case 0x7:
-      YM2610_data_port_0_B_w (0, data);
-      break;
+static UINT8
+port_ym2610_status_b_r (void)
+{
+  return YM2610Read (2);
+}
 
-    case 0x8:
-      /* NMI enable / acknowledge? (the data written doesn't matter) */
-      break;
+static void
+port_ym2610_control_a_w (UINT8 data)
+{
+  YM2610Write (0, data);
+}
 
-    case 0xc:
-      result_code = data;
-      break;
+static void
+port_ym2610_data_a_w (UINT8 data)
+{
+  YM2610Write (1, data);
+}
 
-    case 0x18:
-      /* NMI disable? (the data written doesn't matter) */
-      break;
+static void
+port_ym2610_control_b_w (UINT8 data)
+{
+  YM2610Write (2, data);
+}
 
-    case 0x80:
-      cdda_stop ();
-      break;
+static void
+port_ym2610_data_b_w (UINT8 data)
+{
+  YM2610Write (3, data);
+}
 
-    default:
-      //printf("Unimplemented Z80 Write Port: %x data: %x\n",PortNo&0xff,data);
-      break;
-    }
+static void
+port_result_code_w (UINT8 data)
+{
+  result_code = data;
 }
 
-//---------------------------------------------------------------------------
-UINT8
-PortRead (UINT16 PortNo)
+static void
+port_cdda_stop_w (UINT8 data)
 {
-  switch (PortNo & 0xff)
-    {
-    case 0x0:
-      pending_command = 0;
-      return sound_code;
-      break;
-
-    case 0x4:
-      return YM2610_status_port_0_A_r (0);
-      break;
-
-    case 0x5:
-      return YM2610_read_port_0_r (0);
-      break;
-
-    case 0x6:
-      return YM2610_status_port_0_B_r (0);
-      break;
-
-    default:
-      //printf("Unimplemented Z80 Read Port: %d\n",PortNo&0xff);
-      break;
-    };
-  return 0;
+  cdda_stop ();
 }
+
+UINT8 (*const z80_port_read[256]) (void) = {
+  [0x00 ... 0xff] = port_nop_r,
+  [0x00] = port_sound_code_r,
+  [0x04] = port_ym2610_status_a_r,
+  [0x05] = port_ym2610_data_r,
+  [0x06] = port_ym2610_status_b_r,
+};
+
+void (*const z80_port_write[256]) (UINT8 data) = {
+  [0x00 ... 0xff] = port_nop_w,
+  [0x04] = port_ym2610_control_a_w,
+  [0x05] = port_ym2610_data_a_w,
+  [0x06] = port_ym2610_control_b_w,
+  [0x07] = port_ym2610_data_b_w,
+  /* 0x08: NMI enable / acknowledge? (the data written doesn't matter) */
+  [0x0c] = port_result_code_w,
+  /* 0x18: NMI disable? (the data written doesn't matter) */
+  [0x80] = port_cdda_stop_w,
+};
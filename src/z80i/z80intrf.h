@@ -25,5 +25,7 @@ extern int sound_code;
 extern int pending_command;
 extern int result_code;
 extern int z80_cycles;
+extern UINT8 (*const z80_port_read[256]) (void);
+extern void (*const z80_port_write[256]) (UINT8 data);
 
 #endif /* Z80INTRF_H */
@@ -0,0 +1,144 @@
+/****************************************************************************
+*   NeoCDRX
+*   NeoGeo CD Emulator
+*   NeoCD Redux - Copyright (C) 2007 softdev
+****************************************************************************/
+
+/****************************************************************************
+* Band renderer check
+*
+* Draws random frames, with random sprite strips, zooms, chains, FIX cells,
+* palette writes and tile animation, all written through the 68000 memory
+* map, and hashes every frame as it reaches update_video. Built with bands
+* and helper threads and with the serial path, the two hashes must match.
+*
+* The time spent in video_draw_screen1 goes to stderr, so builds with 0 to
+* N helper threads can be compared (make -C tests bench).
+*
+* Usage: bands [frames] [seed]
+****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ogc/lwp_watchdog.h>
+#include "neocdrx.h"
+
+#define SPR_SIZE  0x400000
+#define FIX_SIZE  0x20000
+
+static unsigned long long hash = 1469598103934665603ULL;
+static unsigned int seed;
+
+static unsigned int
+rnd (unsigned int n)
+{
+  seed = seed * 1103515245 + 12345;
+  return ((seed >> 8) & 0xffffff) % n;
+}
+
+/*** Every frame drawn, in the order the screen shows them ***/
+void
+update_video (int width, int height, char *vbuffer)
+{
+  unsigned short *p = (unsigned short *) vbuffer;
+  int i;
+
+  for (i = 0; i < width * height; i++)
+    hash = (hash ^ p[i]) * 1099511628211ULL;
+}
+
+static void
+fill (unsigned char *p, int len)
+{
+  int i;
+
+  for (i = 0; i < len; i++)
+    p[i] = rnd (5) ? rnd (256) : 0;
+}
+
+static void
+vram_w (int address, int data)
+{
+  m68k_write_memory_16 (0x3c0000, address);
+  m68k_write_memory_16 (0x3c0002, data);
+}
+
+/****************************************************************************
+* One frame of changes
+*
+* Most strips get a zoom, position and size, some are chained to the one
+* before, and some are left empty. A sparse frame clears most of them, as
+* a game between scenes would.
+****************************************************************************/
+static void
+emulate (void)
+{
+  int i, k, sparse = rnd (4) == 0;
+
+  m68k_write_memory_16 (0x3c0004, 1);
+  for (i = 0; i < 3000; i++)
+    vram_w (rnd (0x6000), rnd (0x10000));
+
+  for (i = 0; i < 40; i++)
+    vram_w (0x7000 + rnd (0x500), (rnd (16) << 12) | rnd (0x1000));
+
+  for (i = 0; i < 0x180; i++)
+    {
+      k = rnd (100);
+      if (sparse && i > 40)
+	{
+	  if (k < 3)
+	    vram_w (0x8200 + i, 0);
+	  continue;
+	}
+
+      vram_w (0x8000 + i, (rnd (16) << 8) |
+	      (k < 5 ? 0 : k < 20 ? 0xff : 0x40 + rnd (0xc0)));
+      vram_w (0x8200 + i, (rnd (3) ? 0x40 : 0) |
+	      ((rnd (300) + 0x1f0 - 280) << 7) |
+	      (k % 7 == 0 ? 0 : rnd (3) == 0 ? 0x21 : rnd (33)));
+      vram_w (0x8400 + i, rnd (400) << 7);
+    }
+
+  for (i = 0; i < 30; i++)
+    m68k_write_memory_16 (0x400000 + 2 * rnd (4096), rnd (0x10000));
+
+  neogeo_frame_counter++;
+}
+
+int
+main (int argc, char *argv[])
+{
+  int frames = argc > 1 ? atoi (argv[1]) : 300;
+  unsigned char *src;
+  unsigned long long start, total = 0;
+  int f;
+
+  seed = argc > 2 ? atoi (argv[2]) : 1;
+
+  neogeo_spr_memory = malloc (SPR_SIZE);
+  neogeo_fix_memory = malloc (FIX_SIZE);
+  initialise_memmap ();
+  video_init ();
+
+  src = malloc (SPR_SIZE);
+  fill (src, SPR_SIZE);
+  neogeo_copy_spr (neogeo_spr_memory, 0, src, SPR_SIZE);
+  fill (src, FIX_SIZE);
+  neogeo_copy_fix (neogeo_fix_memory, 0, src, FIX_SIZE);
+  free (src);
+
+  for (f = 0; f < frames; f++)
+    {
+      emulate ();
+
+      start = gettime ();
+      video_draw_screen1 ();
+      total += gettime () - start;
+    }
+
+  printf ("hash %016llx\n", hash);
+  fprintf (stderr, "%s: %d frames, %.3f ms a frame\n", argv[0], frames,
+	   total / 1e6 / frames);
+  return 0;
+}
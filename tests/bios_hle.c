@@ -0,0 +1,845 @@
+/****************************************************************************
+*   NeoCDRX
+*   NeoGeo CD Emulator
+*   NeoCD Redux - Copyright (C) 2007 softdev
+****************************************************************************/
+
+/****************************************************************************
+* BIOS HLE against the BIOS code
+*
+* A stand-in BIOS with 68K versions of FIX_CLEAR, LSP_1ST, MESS_OUT and
+* SYSTEM_IO behind the jump table, written to the same description as the
+* native ones in ncdr_rom.c, and fill and copy loops of every form the
+* native code takes. Each call is made from the same random state three
+* times: with the call off, on and checked. RAM less the stack, VRAM, the
+* VRAM port and the palette must come out the same each time, and for the
+* loops the registers, flags and 68K cycles too. The checked runs must not
+* report a mismatch. Timeslices are random, so loops get cut short.
+*
+* MESS_OUT gets an unknown command now and then, and must hand the call to
+* the BIOS code. It learns where the message buffer starts from the first
+* call the BIOS code runs.
+*
+* Usage: bios_hle [calls] [seed]
+****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "neocdrx.h"
+#include "ncdr_rom.h"
+
+#define IDLE       0x1000	/*** FABE, BRA.S * - 2 ***/
+#define STACK_TOP  0x10000
+#define LISTS      0x20000
+#define DATA       0x30000
+#define BUFFERS    0x40000
+#define MESS_BUFFER 0x10F800
+
+#define SYSTEM_IO  0x1000	/*** In the stand-in BIOS ***/
+#define FIX_CLEAR  0x1400
+#define LSP_1ST    0x1800
+#define MESS_OUT   0x2000
+#define LOOPS      0x3000
+
+#define LOOP_CALLS 6
+
+typedef struct
+{
+  unsigned char ram[0x200000];
+  unsigned char vram[0x20000];
+  unsigned short pal[0x1000];
+  int pointer, modulo;
+  unsigned int regs[15];
+  unsigned int sr;
+  unsigned int cycles;
+} STATE;
+
+static STATE start, lle, hle;
+static unsigned int seed;
+static unsigned int pc;
+static unsigned int lp;
+static unsigned char p1, p2, startsel;
+static unsigned int total, stop_cycles;
+static int stopped;
+
+static unsigned int
+rnd (unsigned int n)
+{
+  seed = seed * 1103515245 + 12345;
+  return ((seed >> 8) & 0xffffff) % n;
+}
+
+/****************************************************************************
+* Hooks: the controllers, the end of a call, and the cycle count
+****************************************************************************/
+unsigned char
+read_player1 (void)
+{
+  return p1;
+}
+
+unsigned char
+read_player2 (void)
+{
+  return p2;
+}
+
+unsigned char
+read_pl12_startsel (void)
+{
+  return startsel;
+}
+
+void
+neogeo_exit (void)
+{
+  stop_cycles = total + m68k_cycles_run ();
+  stopped = 1;
+  m68k_end_timeslice ();
+}
+
+double
+neogeo_m68k_cycles (void)
+{
+  return total + m68k_cycles_run ();
+}
+
+/****************************************************************************
+* The stand-in BIOS
+****************************************************************************/
+static void
+emit (unsigned int word)
+{
+  *(unsigned short *) (neogeo_rom_memory + pc) = word;
+  pc += 2;
+}
+
+/*** Longs are read whole, as the host's memory map does ***/
+static void
+emit32 (unsigned int value)
+{
+  *(unsigned int *) (neogeo_rom_memory + pc) = value;
+  pc += 4;
+}
+
+/*** Branches: the opcode goes in, the displacement is set by land ***/
+static unsigned int
+branch8 (unsigned int op)
+{
+  emit (op);
+  return pc - 2;
+}
+
+static void
+land8 (unsigned int at)
+{
+  *(unsigned short *) (neogeo_rom_memory + at) |= (pc - at - 2) & 0xff;
+}
+
+static unsigned int
+branch16 (unsigned int op)
+{
+  emit (op);
+  emit (0);
+  return pc - 2;
+}
+
+static void
+land16 (unsigned int at)
+{
+  *(unsigned short *) (neogeo_rom_memory + at) = pc - at;
+}
+
+static void
+back16 (unsigned int op, unsigned int to)
+{
+  emit (op);
+  emit (to - pc);
+}
+
+static void
+jump_entry (unsigned int entry, unsigned int to)
+{
+  pc = entry;
+  emit (0x4EF9);		/* JMP to */
+  emit32 (0xC00000 + to);
+}
+
+static void
+make_system_io (void)
+{
+  unsigned int reset[2], norep, bsr[2];
+
+  pc = SYSTEM_IO;
+  emit (0x41F9);		/* LEA $10FD94,A0 */
+  emit32 (0x10FD94);
+  emit (0x1039);		/* MOVE.B $300000,D0 */
+  emit32 (0x300000);
+  emit (0x4600);		/* NOT.B D0 */
+  bsr[0] = branch16 (0x6100);	/* BSR player */
+  emit (0x41E8);		/* LEA 6(A0),A0 */
+  emit (0x0006);
+  emit (0x1039);		/* MOVE.B $340000,D0 */
+  emit32 (0x340000);
+  emit (0x4600);		/* NOT.B D0 */
+  bsr[1] = branch16 (0x6100);	/* BSR player */
+  emit (0x1039);		/* MOVE.B $380000,D0 */
+  emit32 (0x380000);
+  emit (0x4600);		/* NOT.B D0 */
+  emit (0x0200);		/* ANDI.B #$0F,D0 */
+  emit (0x000F);
+  emit (0x1239);		/* MOVE.B $10FDAC,D1 */
+  emit32 (0x10FDAC);
+  emit (0x13C0);		/* MOVE.B D0,$10FDAC */
+  emit32 (0x10FDAC);
+  emit (0x4601);		/* NOT.B D1 */
+  emit (0xC200);		/* AND.B D0,D1 */
+  emit (0x13C1);		/* MOVE.B D1,$10FDAD */
+  emit32 (0x10FDAD);
+  emit (0x4E75);		/* RTS */
+
+  /*** A0 the player's bytes, D0 the inputs ***/
+  land16 (bsr[0]);
+  land16 (bsr[1]);
+  emit (0x1228);		/* MOVE.B 2(A0),D1      previous */
+  emit (0x0002);
+  emit (0x1141);		/* MOVE.B D1,1(A0) */
+  emit (0x0001);
+  emit (0x1140);		/* MOVE.B D0,2(A0)      current */
+  emit (0x0002);
+  emit (0x1401);		/* MOVE.B D1,D2 */
+  emit (0x4602);		/* NOT.B D2 */
+  emit (0xC400);		/* AND.B D0,D2 */
+  emit (0x1142);		/* MOVE.B D2,3(A0)      change */
+  emit (0x0003);
+  emit (0xB200);		/* CMP.B D0,D1 */
+  reset[0] = branch8 (0x6600);	/* BNE.S reset */
+  emit (0x4A00);		/* TST.B D0 */
+  reset[1] = branch8 (0x6700);	/* BEQ.S reset */
+  emit (0x5228);		/* ADDQ.B #1,5(A0)      timer */
+  emit (0x0005);
+  emit (0x0C28);		/* CMPI.B #16,5(A0) */
+  emit (0x0010);
+  emit (0x0005);
+  norep = branch8 (0x6500);	/* BCS.S norep */
+  emit (0x117C);		/* MOVE.B #8,5(A0) */
+  emit (0x0008);
+  emit (0x0005);
+  emit (0x1140);		/* MOVE.B D0,4(A0)      repeat */
+  emit (0x0004);
+  emit (0x4E75);
+  land8 (norep);
+  emit (0x4228);		/* CLR.B 4(A0) */
+  emit (0x0004);
+  emit (0x4E75);
+  land8 (reset[0]);
+  land8 (reset[1]);
+  emit (0x4228);		/* CLR.B 5(A0) */
+  emit (0x0005);
+  emit (0x1142);		/* MOVE.B D2,4(A0) */
+  emit (0x0004);
+  emit (0x4E75);
+}
+
+static void
+make_fix_clear (void)
+{
+  unsigned int loop, ff, wr;
+
+  pc = FIX_CLEAR;
+  emit (0x41F9);		/* LEA $3C0000,A0 */
+  emit32 (0x3C0000);
+  emit (0x317C);		/* MOVE.W #1,4(A0) */
+  emit (0x0001);
+  emit (0x0004);
+  emit (0x30BC);		/* MOVE.W #$7000,(A0) */
+  emit (0x7000);
+  emit (0x323C);		/* MOVE.W #$4FF,D1 */
+  emit (0x04FF);
+  emit (0x7400);		/* MOVEQ #0,D2 */
+  loop = pc;
+  emit (0x303C);		/* MOVE.W #$20,D0 */
+  emit (0x0020);
+  emit (0x0C42);		/* CMPI.W #$20,D2 */
+  emit (0x0020);
+  ff = branch8 (0x6500);	/* BCS.S ff */
+  emit (0x0C42);		/* CMPI.W #$4E0,D2 */
+  emit (0x04E0);
+  wr = branch8 (0x6500);	/* BCS.S wr */
+  land8 (ff);
+  emit (0x303C);		/* MOVE.W #$FF,D0 */
+  emit (0x00FF);
+  land8 (wr);
+  emit (0x3140);		/* MOVE.W D0,2(A0) */
+  emit (0x0002);
+  emit (0x5242);		/* ADDQ.W #1,D2 */
+  back16 (0x51C9, loop);	/* DBRA D1,loop */
+  emit (0x4E75);
+}
+
+static void
+make_lsp_1st (void)
+{
+  unsigned int loop;
+
+  pc = LSP_1ST;
+  emit (0x41F9);		/* LEA $3C0000,A0 */
+  emit32 (0x3C0000);
+  emit (0x317C);		/* MOVE.W #1,4(A0) */
+  emit (0x0001);
+  emit (0x0004);
+  emit (0x30BC);		/* MOVE.W #$8000,(A0) */
+  emit (0x8000);
+  emit (0x323C);		/* MOVE.W #$1FF,D1 */
+  emit (0x01FF);
+  emit (0x303C);		/* MOVE.W #$FFF,D0 */
+  emit (0x0FFF);
+  loop = pc;
+  emit (0x3140);		/* MOVE.W D0,2(A0) */
+  emit (0x0002);
+  back16 (0x51C9, loop);	/* DBRA D1,loop */
+  emit (0x30BC);		/* MOVE.W #$8200,(A0) */
+  emit (0x8200);
+  emit (0x323C);		/* MOVE.W #$1FF,D1 */
+  emit (0x01FF);
+  emit (0x7000);		/* MOVEQ #0,D0 */
+  loop = pc;
+  emit (0x3140);		/* MOVE.W D0,2(A0) */
+  emit (0x0002);
+  back16 (0x51C9, loop);	/* DBRA D1,loop */
+  emit (0x4E75);
+}
+
+/****************************************************************************
+* MESS_OUT: A2 walks the buffer, A0 a list, A1 the data, A3 the VRAM port,
+* D3 the upper byte, D4 the end code and D5 the VRAM address. Anything but
+* the known commands ends a list.
+****************************************************************************/
+static void
+make_mess_out (void)
+{
+  static const unsigned int cmds[] = { 1, 2, 3, 4, 5, 6, 7, 0x0A };
+  unsigned int done, lists, end, list, str, sdone, bsr, at[8], i;
+  unsigned int strs[3];
+
+  pc = MESS_OUT;
+  emit (0x4A39);		/* TST.B $10FDC2 */
+  emit32 (0x10FDC2);
+  done = branch8 (0x6600);	/* BNE.S done */
+  emit (0x47F9);		/* LEA $3C0000,A3 */
+  emit32 (0x3C0000);
+  emit (0x45F9);		/* LEA MESS_BUFFER,A2 */
+  emit32 (MESS_BUFFER);
+  lists = pc;
+  emit (0xB5F9);		/* CMPA.L $10FDBE,A2 */
+  emit32 (0x10FDBE);
+  end = branch8 (0x6400);	/* BCC.S end */
+  emit (0x205A);		/* MOVEA.L (A2)+,A0 */
+  bsr = branch16 (0x6100);	/* BSR list */
+  emit (0x6000 | ((lists - pc - 2) & 0xff));	/* BRA.S lists */
+  land8 (end);
+  emit (0x23FC);		/* MOVE.L #MESS_BUFFER,$10FDBE */
+  emit32 (MESS_BUFFER);
+  emit32 (0x10FDBE);
+  land8 (done);
+  emit (0x4E75);
+
+  list = pc;
+  land16 (bsr);
+  emit (0x3018);		/* MOVE.W (A0)+,D0 */
+  for (i = 0; i < 8; i++)
+    {
+      emit (0x0C40);		/* CMPI.W #cmd,D0 */
+      emit (cmds[i]);
+      at[i] = branch16 (0x6700);	/* BEQ cmd */
+    }
+  emit (0x4E75);
+
+  land16 (at[0]);		/*** 01 ***/
+  emit (0x3018);		/* MOVE.W (A0)+,D0 */
+  emit (0x1800);		/* MOVE.B D0,D4 */
+  emit (0x3600);		/* MOVE.W D0,D3 */
+  emit (0x4203);		/* CLR.B D3 */
+  back16 (0x6000, list);	/* BRA list */
+
+  land16 (at[1]);		/*** 02 ***/
+  emit (0x3758);		/* MOVE.W (A0)+,4(A3) */
+  emit (0x0004);
+  back16 (0x6000, list);
+
+  land16 (at[2]);		/*** 03 ***/
+  emit (0x3A18);		/* MOVE.W (A0)+,D5 */
+  emit (0x3685);		/* MOVE.W D5,(A3) */
+  back16 (0x6000, list);
+
+  land16 (at[3]);		/*** 04 ***/
+  emit (0x2258);		/* MOVEA.L (A0)+,A1 */
+  strs[0] = branch16 (0x6100);	/* BSR str */
+  back16 (0x6000, list);
+
+  land16 (at[4]);		/*** 05 ***/
+  emit (0xDA58);		/* ADD.W (A0)+,D5 */
+  emit (0x3685);		/* MOVE.W D5,(A3) */
+  back16 (0x6000, list);
+
+  land16 (at[5]);		/*** 06 ***/
+  strs[1] = branch16 (0x6100);	/* BSR str */
+  back16 (0x6000, list);
+
+  land16 (at[6]);		/*** 07 ***/
+  emit (0x2248);		/* MOVEA.L A0,A1 */
+  strs[2] = branch16 (0x6100);	/* BSR str */
+  emit (0x2009);		/* MOVE.L A1,D0 */
+  emit (0x5280);		/* ADDQ.L #1,D0 */
+  emit (0x0240);		/* ANDI.W #$FFFE,D0 */
+  emit (0xFFFE);
+  emit (0x2040);		/* MOVEA.L D0,A0 */
+  back16 (0x6000, list);
+
+  land16 (at[7]);		/*** 0A ***/
+  emit (0x2018);		/* MOVE.L (A0)+,D0 */
+  emit (0x2F08);		/* MOVE.L A0,-(SP) */
+  emit (0x2040);		/* MOVEA.L D0,A0 */
+  back16 (0x6100, list);	/* BSR list */
+  emit (0x205F);		/* MOVEA.L (SP)+,A0 */
+  back16 (0x6000, list);
+
+  /*** Bytes at A1 to the end code ***/
+  str = pc;
+  for (i = 0; i < 3; i++)
+    land16 (strs[i]);
+  emit (0x7000);		/* MOVEQ #0,D0 */
+  emit (0x1019);		/* MOVE.B (A1)+,D0 */
+  emit (0xB004);		/* CMP.B D4,D0 */
+  sdone = branch8 (0x6700);	/* BEQ.S sdone */
+  emit (0x8043);		/* OR.W D3,D0 */
+  emit (0x3740);		/* MOVE.W D0,2(A3) */
+  emit (0x0002);
+  emit (0x6000 | ((str - pc - 2) & 0xff));	/* BRA.S str */
+  land8 (sdone);
+  emit (0x4E75);
+}
+
+/*** MOVE or CLR, DBRA, RTS ***/
+static const unsigned short loops[LOOP_CALLS][2] = {
+  {0x26C2, 0x51CD},		/* MOVE.L D2,(A3)+      DBRA D5 */
+  {0x32C6, 0x51C8},		/* MOVE.W D6,(A1)+      DBRA D0 */
+  {0x429C, 0x51C9},		/* CLR.L (A4)+          DBRA D1 */
+  {0x4258, 0x51CF},		/* CLR.W (A0)+          DBRA D7 */
+  {0x2ADA, 0x51CB},		/* MOVE.L (A2)+,(A5)+   DBRA D3 */
+  {0x30DE, 0x51CC}		/* MOVE.W (A6)+,(A0)+   DBRA D4 */
+};
+
+static void
+make_bios (void)
+{
+  int i;
+
+  memset (neogeo_rom_memory, 0xff, 0x80000);
+  jump_entry (0x44A, SYSTEM_IO);
+  jump_entry (0x4C2, FIX_CLEAR);
+  jump_entry (0x4C8, LSP_1ST);
+  jump_entry (0x4CE, MESS_OUT);
+  make_system_io ();
+  make_fix_clear ();
+  make_lsp_1st ();
+  make_mess_out ();
+
+  for (i = 0; i < LOOP_CALLS; i++)
+    {
+      pc = LOOPS + i * 0x10;
+      emit (loops[i][0]);
+      emit (loops[i][1]);
+      emit (0xFFFC);
+      emit (0x4E75);
+    }
+
+  neogeo_patch_rom ();
+}
+
+/****************************************************************************
+* Message lists, written the width they are read
+****************************************************************************/
+static void
+lw (unsigned int v)
+{
+  m68k_write_memory_16 (lp, v);
+  lp += 2;
+}
+
+static void
+ll (unsigned int v)
+{
+  m68k_write_memory_32 (lp, v);
+  lp += 4;
+}
+
+/*** n bytes of text and the end code ***/
+static unsigned int
+text (unsigned int a, int n, int end)
+{
+  int c;
+
+  while (n--)
+    {
+      do
+	c = rnd (256);
+      while (c == end);
+      m68k_write_memory_8 (a++, c);
+    }
+  m68k_write_memory_8 (a++, end);
+  return a;
+}
+
+static unsigned int data, subs;
+
+static void
+make_list (int depth, int *end, int unknown)
+{
+  unsigned int sub, a;
+  int i, n = 2 + rnd (6);
+
+  if (!depth)
+    {
+      *end = rnd (2) ? 0xFF : 0x00;
+      lw (0x01);
+      lw ((rnd (16) << 12) | *end);
+      lw (0x03);
+      lw (0x7000 + rnd (0x500));
+    }
+
+  for (i = 0; i < n; i++)
+    switch (rnd (unknown ? 9 : 8))
+      {
+      case 0:
+	lw (0x02);
+	lw (rnd (2) ? 1 : 32);
+	break;
+      case 1:
+	lw (0x05);
+	lw (rnd (0x40));
+	break;
+      case 2:			/*** Two strings, for a resume ***/
+	lw (0x04);
+	ll (data);
+	data = text (text (data, rnd (20), *end), rnd (20), *end);
+	if (rnd (2))
+	  lw (0x06);
+	break;
+      case 3:
+	lw (0x07);
+	a = text (lp, rnd (20), *end);
+	lp = (a + 1) & ~1;
+	break;
+      case 4:
+	if (depth < 2)
+	  {
+	    sub = subs;
+	    subs += 0x100;
+	    lw (0x0A);
+	    ll (sub);
+	    a = lp;
+	    lp = sub;
+	    make_list (depth + 1, end, unknown);
+	    lw (0x0B);
+	    lp = a;
+	  }
+	break;
+      case 5:
+	*end = rnd (2) ? 0xFF : 0x7F;
+	lw (0x01);
+	lw ((rnd (16) << 12) | *end);
+	break;
+      case 6:
+	lw (0x03);
+	lw (0x7000 + rnd (0x500));
+	break;
+      case 7:
+	break;
+      case 8:
+	lw (0x08);
+	break;
+      }
+
+  if (!depth)
+    lw (0x00);
+}
+
+static void
+make_messages (void)
+{
+  int i, n = rnd (5), end = 0, unknown = !rnd (10);
+
+  lp = LISTS;
+  subs = LISTS + 0x8000;
+  data = DATA;
+  for (i = 0; i < n; i++)
+    {
+      m68k_write_memory_32 (MESS_BUFFER + i * 4, lp);
+      make_list (0, &end, unknown);
+      lp = (lp + 0x400) & ~0x3ff;
+    }
+  m68k_write_memory_32 (0x10FDBE, MESS_BUFFER + n * 4);
+  m68k_write_memory_8 (0x10FDC2, !rnd (8));
+}
+
+/****************************************************************************
+* Runs
+****************************************************************************/
+static void
+save (STATE * s)
+{
+  int i;
+
+  memcpy (s->ram, neogeo_prg_memory, 0x200000);
+  memcpy (s->vram, video_vidram, 0x20000);
+  memcpy (s->pal, video_paletteram_ng, 0x2000);
+  s->pointer = video_pointer;
+  s->modulo = video_modulo;
+  for (i = 0; i < 15; i++)
+    s->regs[i] = m68k_get_reg (NULL, M68K_REG_D0 + i);
+  s->sr = m68k_get_reg (NULL, M68K_REG_SR);
+}
+
+static void
+restore (const STATE * s)
+{
+  int i;
+
+  memcpy (neogeo_prg_memory, s->ram, 0x200000);
+  memcpy (video_vidram, s->vram, 0x20000);
+  memcpy (video_paletteram_ng, s->pal, 0x2000);
+  video_pointer = s->pointer;
+  video_modulo = s->modulo;
+  m68k_cache_flush ();
+  for (i = 0; i < 15; i++)
+    m68k_set_reg (M68K_REG_D0 + i, s->regs[i]);
+  m68k_set_reg (M68K_REG_SR, s->sr);
+}
+
+/*** 0 if the call never returns ***/
+static int
+run (unsigned int to)
+{
+  m68k_set_reg (M68K_REG_SP, STACK_TOP - 4);
+  m68k_write_memory_32 (STACK_TOP - 4, IDLE);
+  m68k_set_reg (M68K_REG_PC, 0xC00000 + to);
+
+  stopped = 0;
+  total = 0;
+  while (!stopped && total < 100000000)
+    total += m68k_execute (1 + rnd (20000));
+  return stopped;
+}
+
+/*** Runs a call in a mode, from start ***/
+static int
+call (int i, int mode, unsigned int to, STATE * s)
+{
+  int ok;
+
+  restore (&start);
+  neogeo_bios_hle_set (i, mode);
+  ok = run (to);
+  neogeo_bios_hle_set (i, HLE_OFF);
+  save (s);
+  s->cycles = stop_cycles;
+
+  if (!ok)
+    printf ("%s: mode %d call at %x did not return, pc %x\n",
+	    neogeo_bios_hle_name (i), mode, to,
+	    m68k_get_reg (NULL, M68K_REG_PC));
+  return ok;
+}
+
+static int
+differ (const char *name, const char *what, const unsigned char *a,
+	const unsigned char *b, int from, int to)
+{
+  int i;
+
+  if (!memcmp (a + from, b + from, to - from))
+    return 0;
+  for (i = from; a[i] == b[i]; i++)
+    ;
+  printf ("%s: %s differs at %x\n", name, what, i);
+  return 1;
+}
+
+static int
+compare (const char *name, const char *mode, int loop)
+{
+  if (differ (name, "ram", lle.ram, hle.ram, 0, STACK_TOP - 0x400)
+      || differ (name, "ram", lle.ram, hle.ram, STACK_TOP, 0x200000)
+      || differ (name, "vram", lle.vram, hle.vram, 0, 0x20000)
+      || differ (name, "palette", (unsigned char *) lle.pal,
+		 (unsigned char *) hle.pal, 0, 0x2000))
+    ;
+  else if (lle.pointer != hle.pointer || lle.modulo != hle.modulo)
+    printf ("%s: VRAM port %x/%x, not %x/%x\n", name, hle.pointer,
+	    hle.modulo, lle.pointer, lle.modulo);
+  else if (loop && differ (name, "registers", (unsigned char *) lle.regs,
+			   (unsigned char *) hle.regs, 0, sizeof (lle.regs)))
+    ;
+  else if (loop && (lle.sr & 0x1f) != (hle.sr & 0x1f))
+    printf ("%s: flags %02x, not %02x\n", name, hle.sr & 0x1f,
+	    lle.sr & 0x1f);
+  else if (loop && lle.cycles != hle.cycles)
+    printf ("%s: %u cycles, not %u\n", name, hle.cycles, lle.cycles);
+  else
+    return 1;
+
+  printf ("%s: %s run differs from the BIOS code\n", name, mode);
+  return 0;
+}
+
+/*** Random start for call i ***/
+static unsigned int
+setup (int i)
+{
+  unsigned int a, v;
+  int r, k;
+
+  for (a = 0; a < 0x10000; a += 2)
+    ((unsigned short *) video_vidram)[a >> 1] = rnd (0x10000);
+  video_pointer = rnd (0x10000);
+  video_modulo = rnd (0x10000);
+
+  for (r = 0; r < 15; r++)
+    m68k_set_reg (M68K_REG_D0 + r, (rnd (0x10000) << 16) | rnd (0x10000));
+  m68k_set_reg (M68K_REG_SR, 0x2700 | rnd (0x20));
+
+  switch (i)
+    {
+    case 0:
+      return 0x4C2;
+    case 1:
+      return 0x4C8;
+    case 2:
+      make_messages ();
+      return 0x4CE;
+    case 3:
+      for (a = 0x10FD94; a < 0x10FDAE; a++)
+	m68k_write_memory_8 (a, rnd (256));
+      p1 = rnd (256);
+      p2 = rnd (256);
+      startsel = rnd (16);
+      /*** Held inputs, some near the repeat ***/
+      if (rnd (2))
+	m68k_write_memory_8 (0x10FD96, ~p1 & 0xff);
+      if (rnd (2))
+	m68k_write_memory_8 (0x10FD99, 12 + rnd (6));
+      return 0x44A;
+    }
+
+  /*** Loops: sources in RAM, destinations in RAM or the palette. Longs
+       are aligned, as the memory map writes one across its 64KB banks in
+       two words, which on this host is not the order it reads it in. ***/
+  for (a = BUFFERS; a < BUFFERS + 0x10000; a += 2)
+    m68k_write_memory_16 (a, rnd (0x10000));
+  v = rnd (4) ? 1 + rnd (0x200) : rnd (0x10000);
+  for (r = 0; r < 8; r++)
+    m68k_set_reg (M68K_REG_D0 + r,
+		  (rnd (0x10000) << 16) | (rnd (4) ? v : rnd (0x10000)));
+  for (r = 0; r < 7; r++)
+    m68k_set_reg (M68K_REG_A0 + r, rnd (4) ? BUFFERS + rnd (0x4000) * 4 :
+		  0x400000 + rnd (0x800) * 4);
+  /*** The first four loops fill, the others copy ***/
+  k = i == 4 ? rnd (4) : 4 + rnd (2);
+  m68k_set_reg (M68K_REG_D0 + (loops[k][1] & 7), v);
+  return LOOPS + k * 0x10;
+}
+
+/*** Columns of the stats for call i ***/
+static void
+stats (FILE * fp, int i, unsigned int *native, double *usec,
+       unsigned int *mismatches)
+{
+  char line[256], name[32];
+  unsigned int calls, bios;
+  double cycles;
+
+  rewind (fp);
+  while (fgets (line, sizeof (line), fp))
+    if (sscanf (line, "%31[^,],%*[^,],%u,%u,%lf,%u,%lf,%u", name, &calls,
+		native, usec, &bios, &cycles, mismatches) == 7
+	&& !strcmp (name, neogeo_bios_hle_name (i)))
+      return;
+
+  *native = 0;
+}
+
+int
+main (int argc, char *argv[])
+{
+  int calls = argc > 1 ? atoi (argv[1]) : 100;
+  double cycles[BIOS_HLE_CALLS], usec;
+  unsigned int native, mismatches, to;
+  FILE *fp;
+  int i, n, modes;
+
+  seed = argc > 2 ? atoi (argv[2]) : 1;
+
+  neogeo_prg_memory = calloc (1, 0x200000);
+  neogeo_rom_memory = calloc (1, 0x80000);
+  initialise_memmap ();
+  video_init ();
+  make_bios ();
+
+  m68k_write_memory_16 (IDLE, 0xFABE);	/* neogeo_exit */
+  m68k_write_memory_16 (IDLE + 2, 0x60FC);	/* BRA.S IDLE */
+  m68k_set_cpu_type (M68K_CPU_TYPE_68000);
+  m68k_pulse_reset ();
+
+  /*** The block cache reads longs in the BIOS as two words, and the memory
+       map whole, which only agree on a big-endian host ***/
+  m68k_cache_enable (0);
+
+  for (i = 0; i < BIOS_HLE_CALLS; i++)
+    {
+      cycles[i] = 0;
+      modes = i < 4 ? 3 : 2;
+      for (n = 0; n < calls; n++)
+	{
+	  to = setup (i);
+	  save (&start);
+
+	  if (!call (i, HLE_OFF, to, &lle) || !call (i, HLE_ON, to, &hle)
+	      || !compare (neogeo_bios_hle_name (i), "native", i >= 4))
+	    return 1;
+	  cycles[i] += lle.cycles;
+	  if (modes == 3 && (!call (i, HLE_CHECK, to, &hle)
+			     || !compare (neogeo_bios_hle_name (i), "checked",
+					  0)))
+	    return 1;
+	}
+    }
+
+  /*** Every call counted, less the ones that were off ***/
+  for (i = 0; i < BIOS_HLE_CALLS; i++)
+    neogeo_bios_hle_set (i, HLE_ON);
+  fp = tmpfile ();
+  neogeo_bios_hle_stats (fp);
+
+  for (i = 0; i < BIOS_HLE_CALLS; i++)
+    {
+      stats (fp, i, &native, &usec, &mismatches);
+      if (!native)
+	{
+	  printf ("%s: never ran natively\n", neogeo_bios_hle_name (i));
+	  return 1;
+	}
+      if (mismatches)
+	{
+	  printf ("%s: %u checked calls mismatched\n",
+		  neogeo_bios_hle_name (i), mismatches);
+	  return 1;
+	}
+      printf ("  %-9s %8.0f 68K cycles a call, %7.2f us native\n",
+	      neogeo_bios_hle_name (i), cycles[i] / calls, usec);
+    }
+
+  fclose (fp);
+  printf ("%s: %d calls each, off, on and checked, ok\n", argv[0], calls);
+  return 0;
+}
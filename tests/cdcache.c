@@ -0,0 +1,357 @@
+/****************************************************************************
+*   NeoCDRX
+*   NeoGeo CD Emulator
+*   NeoCD Redux - Copyright (C) 2007 softdev
+****************************************************************************/
+
+/****************************************************************************
+* Decoded SPR cache check
+*
+* Loads SPR files from the host disk through fileio.c the way cdrom.c does:
+* a cache hit is tried first, and a miss reads, decodes and stores. Checks
+* that a second load hits and restores the decoded data and usage bytes,
+* that a changed or resized source misses, and that rewriting an entry does
+* not evict others while the cache stays under its cap (build/cache, set to
+* 4MB here).
+*
+* Then times cold and warm loads of a 2MB file, and the full source read
+* and CRC the warm check used to do. The files come from the host's file
+* cache, so these are CPU figures - a slow device only adds to the bytes a
+* cold load reads.
+*
+* Usage: cdcache [runs] [seed]
+****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+#include <zlib.h>
+#include <ogc/lwp_watchdog.h>
+#include "neocdrx.h"
+
+#define CACHE_DIR   "build/cache/"
+#define BUFFER_SIZE 131072
+#define MAXFILES    4
+
+unsigned short SaveDevice = 1;
+
+static unsigned char buffer[BUFFER_SIZE];
+static FILE *files[MAXFILES + 1];
+static unsigned int dev_bytes;
+static unsigned int seed;
+
+static unsigned int
+rnd (unsigned int n)
+{
+  seed = seed * 1103515245 + 12345;
+  return ((seed >> 8) & 0xffffff) % n;
+}
+
+/****************************************************************************
+* Device handler on stdio, counting the bytes read
+****************************************************************************/
+static u32
+host_fopen (const char *filename, const char *mode)
+{
+  int i;
+
+  for (i = 1; i <= MAXFILES; i++)
+    if (!files[i])
+      {
+	files[i] = fopen (filename, mode);
+	return files[i] ? i : 0;
+      }
+
+  return 0;
+}
+
+static u32
+host_fread (char *buf, int block, int length, u32 fp)
+{
+  u32 n = fread (buf, block, length, files[fp]);
+
+  dev_bytes += n * block;
+  return n;
+}
+
+static int
+host_fclose (u32 fp)
+{
+  int ret = fclose (files[fp]);
+
+  files[fp] = NULL;
+  return ret;
+}
+
+static int
+host_fseek (u32 fp, int where, int whence)
+{
+  return fseek (files[fp], where, whence);
+}
+
+static int
+host_ftell (u32 fp)
+{
+  return ftell (files[fp]);
+}
+
+static GENHANDLER host_handler = {
+  host_fopen, host_fread, NULL, host_fclose, host_fseek, host_ftell
+};
+
+/****************************************************************************
+* Files
+****************************************************************************/
+static void
+make_file (const char *name, int len)
+{
+  FILE *fp = fopen (name, "wb");
+  int i;
+
+  for (i = 0; i < len; i++)
+    fputc (rnd (256), fp);
+  fclose (fp);
+}
+
+/*** Flip a byte, and set a new length if len ***/
+static void
+poke_file (const char *name, int pos, int len)
+{
+  FILE *fp = fopen (name, "r+b");
+  int c;
+
+  fseek (fp, pos, SEEK_SET);
+  c = fgetc (fp);
+  fseek (fp, pos, SEEK_SET);
+  fputc (c ^ 0x5a, fp);
+  fclose (fp);
+
+  if (len && truncate (name, len))
+    perror (name);
+}
+
+/*** Remove every entry, or age them, the bigger the older ***/
+static void
+walk_cache (int age)
+{
+  char path[300];
+  struct dirent *ent;
+  struct utimbuf ut;
+  struct stat st;
+  DIR *d = opendir (CACHE_DIR);
+
+  while ((ent = readdir (d)) != NULL)
+    if (ent->d_name[0] != '.')
+      {
+	sprintf (path, CACHE_DIR "%s", ent->d_name);
+	if (!age)
+	  remove (path);
+	else if (stat (path, &st) == 0)
+	  {
+	    ut.actime = ut.modtime = 1000000000 - st.st_size;
+	    utime (path, &ut);
+	  }
+      }
+  closedir (d);
+}
+
+/****************************************************************************
+* cdrom_load_spr_file, less the loading screen. Returns 1 on a cache hit.
+****************************************************************************/
+static int
+load_spr (const char *path, unsigned int offset)
+{
+  GENFILE fp = GEN_fopen (path, "rb");
+  unsigned int start = offset;
+  int flen, readed, total = 0;
+
+  GEN_fseek (fp, 0, SEEK_END);
+  flen = GEN_ftell (fp);
+  GEN_fseek (fp, 0, SEEK_SET);
+
+  if (cdcache_load (path, fp, CDCACHE_SPR, offset, flen))
+    {
+      GEN_fclose (fp);
+      return 1;
+    }
+
+  do
+    {
+      readed = GEN_fread ((char *) neogeo_spr_memory + offset, 1,
+			  BUFFER_SIZE, fp);
+      if (readed > 0)
+	{
+	  neogeo_decode_spr (neogeo_spr_memory, offset, readed);
+	  offset += readed;
+	  total += readed;
+	}
+    }
+  while (readed == BUFFER_SIZE);
+
+  cdcache_store (path, fp, CDCACHE_SPR, start, total);
+  GEN_fclose (fp);
+  return 0;
+}
+
+/*** Store again over an entry, with the decoded data in place ***/
+static void
+store_spr (const char *path, unsigned int offset, int len)
+{
+  GENFILE fp = GEN_fopen (path, "rb");
+
+  cdcache_store (path, fp, CDCACHE_SPR, offset, len);
+  GEN_fclose (fp);
+}
+
+/*** What the warm check used to read ***/
+static unsigned int
+crc_spr (const char *path)
+{
+  GENFILE fp = GEN_fopen (path, "rb");
+  unsigned int crc = 0;
+  int readed;
+
+  do
+    {
+      readed = GEN_fread ((char *) buffer, 1, BUFFER_SIZE, fp);
+      if (readed > 0)
+	crc = crc32 (crc, buffer, readed);
+    }
+  while (readed == BUFFER_SIZE);
+
+  GEN_fclose (fp);
+  return crc;
+}
+
+/****************************************************************************
+* Load twice, the second one from the cache, and compare
+****************************************************************************/
+static int
+check_hit (const char *name, unsigned int offset, int len)
+{
+  static unsigned char spr[0x200000], usage[0x4000];
+  int tiles = (len + 127) >> 7;
+
+  if (load_spr (name, offset))
+    {
+      printf ("%s: first load hit\n", name);
+      return 0;
+    }
+
+  memcpy (spr, neogeo_spr_memory + offset, tiles << 7);
+  memcpy (usage, video_spr_usage + (offset >> 7), tiles);
+  memset (neogeo_spr_memory + offset, 0, tiles << 7);
+  memset (video_spr_usage + (offset >> 7), 0, tiles);
+
+  if (!load_spr (name, offset))
+    {
+      printf ("%s: second load missed\n", name);
+      return 0;
+    }
+
+  if (memcmp (spr, neogeo_spr_memory + offset, tiles << 7)
+      || memcmp (usage, video_spr_usage + (offset >> 7), tiles))
+    {
+      printf ("%s: cached data differs\n", name);
+      return 0;
+    }
+
+  return 1;
+}
+
+static int
+check_miss (const char *what, const char *name, unsigned int offset)
+{
+  if (load_spr (name, offset))
+    {
+      printf ("%s: hit after %s\n", name, what);
+      return 0;
+    }
+
+  return 1;
+}
+
+static double
+msec (u64 ns, int runs)
+{
+  return ns / 1e6 / runs;
+}
+
+int
+main (int argc, char *argv[])
+{
+  int runs = argc > 1 ? atoi (argv[1]) : 10;
+  u64 t, cold = 0, warm = 0, full = 0;
+  unsigned int warm_bytes = 0;
+  int i, ok;
+
+  seed = argc > 2 ? atoi (argv[2]) : 1;
+
+  neogeo_spr_memory = calloc (1, 0x400000);
+  GEN_SetHandler (&host_handler);
+
+  mkdir (CACHE_DIR, 0755);
+  walk_cache (0);
+
+  make_file ("build/a.spr", 0x200000);
+  make_file ("build/b.spr", 0x100000);
+  make_file ("build/c.spr", 10000);
+
+  ok = check_hit ("build/a.spr", 0, 0x200000)
+    && check_hit ("build/b.spr", 0x200000, 0x100000)
+    && check_hit ("build/c.spr", 0x380000, 10000);
+
+  /*** 3MB of 4MB used, a the oldest - rewriting b must keep it ***/
+  if (ok)
+    {
+      walk_cache (1);
+      store_spr ("build/b.spr", 0x200000, 0x100000);
+      if (!load_spr ("build/a.spr", 0))
+	{
+	  printf ("build/a.spr: evicted by rewriting build/b.spr\n");
+	  ok = 0;
+	}
+    }
+
+  /*** The last byte is in a sample, and so is the new length ***/
+  if (ok)
+    {
+      poke_file ("build/b.spr", 0x100000 - 1, 0);
+      ok = check_miss ("a change", "build/b.spr", 0x200000);
+    }
+
+  if (ok)
+    {
+      poke_file ("build/c.spr", 0, 10001);
+      ok = check_miss ("a resize", "build/c.spr", 0x380000);
+    }
+
+  if (!ok)
+    return 1;
+
+  for (i = 0; i < runs; i++)
+    {
+      walk_cache (0);
+      t = gettime ();
+      load_spr ("build/a.spr", 0);
+      cold += gettime () - t;
+
+      dev_bytes = 0;
+      t = gettime ();
+      load_spr ("build/a.spr", 0);
+      warm += gettime () - t;
+      warm_bytes += dev_bytes;
+
+      t = gettime ();
+      crc_spr ("build/a.spr");
+      full += gettime () - t;
+    }
+
+  printf ("%s: 2MB SPR cold %.2f ms, warm %.2f ms reading %uKB of the source"
+	  " (reading it all %.2f ms more), ok\n", argv[0], msec (cold, runs),
+	  msec (warm, runs), warm_bytes / runs >> 10, msec (full, runs));
+  return 0;
+}
@@ -0,0 +1,356 @@
+/****************************************************************************
+*   NeoCDRX
+*   NeoGeo CD Emulator
+*   NeoCD Redux - Copyright (C) 2007 softdev
+****************************************************************************/
+
+/****************************************************************************
+* 68K dispatch table layout
+*
+* Builds the compact dispatch tables (M68K_COMPACT_DISPATCH) and checks that
+* every opcode gets the same handler and base cycles as from the flat jump
+* and cycle tables. Then runs an opcode trace through a model of the GC data
+* cache - 32KB, 8 way, 32 byte lines, LRU - and counts the misses the
+* dispatch lookups take per instruction, for each layout. Between two
+* instructions the emulator touches other memory, modelled as random reads
+* over 2MB: light is 2 of them, heavy 8.
+*
+* Table addresses are laid out as on the GC, with 4 byte pointers. Only the
+* tables are modelled, not the handler code.
+*
+* The trace is drawn from the "op;" counts in a profile.folded written by
+* an M68K_PROFILE build, or else from a synthetic profile: handlers in a
+* random order with Zipf weights, each spread evenly over its opcodes.
+* The handler counts can be written out as a CSV, in the format m68kmake
+* takes as PROFILE to put the busiest handlers first ("make dispatch").
+*
+* Usage: dispatch [instructions] [seed] [profile.folded|-] [handlers.csv]
+****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../src/m68000/m68kcpu.c"
+
+#define CACHE_SETS  128		/*** 32KB / (8 ways * 32 bytes) ***/
+#define CACHE_WAYS  8
+#define CACHE_LINE  5
+#define OTHER_SIZE  0x200000
+
+/*** Where the tables sit in the model ***/
+#define FLAT_JUMP   0x80100000
+#define FLAT_CYCLES 0x80140000
+#define PAGE_TABLE  0x80200000
+#define INDEX_TABLE 0x80201000
+#define HANDLERS    0x80230000
+#define OTHER       0x80400000
+
+/*** Nothing here runs 68K code ***/
+int img_display;
+
+void cdrom_load_files (void) { }
+void neogeo_cdda_control (void) { }
+void neogeo_upload (void) { }
+void neogeo_exit_cdplayer (void) { }
+void neogeo_start_upload (void) { }
+void neogeo_end_upload (void) { }
+void neogeo_progress_show (void) { }
+void neogeo_trace (void) { }
+void neogeo_ipl (void) { }
+void neogeo_ipl_end (void) { }
+void neogeo_exit (void) { }
+int neogeo_bios_hle (unsigned int trap) { return -1; }
+
+unsigned int m68k_read_memory_8 (unsigned int address) { return 0; }
+unsigned int m68k_read_memory_16 (unsigned int address) { return 0; }
+unsigned int m68k_read_memory_32 (unsigned int address) { return 0; }
+void m68k_write_memory_8 (unsigned int address, unsigned int value) { }
+void m68k_write_memory_16 (unsigned int address, unsigned int value) { }
+void m68k_write_memory_32 (unsigned int address, unsigned int value) { }
+
+typedef struct
+{
+  unsigned int tag[CACHE_SETS][CACHE_WAYS];	/*** Most recent first ***/
+} CACHE;
+
+static double weight[0x10000];
+static double cumul[0x10000];
+static unsigned int seed;
+
+static unsigned int
+rnd (unsigned int n)
+{
+  seed = seed * 1103515245 + 12345;
+  return ((seed >> 8) & 0xffffff) % n;
+}
+
+/****************************************************************************
+* Cache model
+****************************************************************************/
+/*** Returns 1 on a miss ***/
+static int
+cache_read (CACHE * c, unsigned int address)
+{
+  unsigned int line = (address >> CACHE_LINE) | 0x80000000;
+  unsigned int *way = c->tag[line & (CACHE_SETS - 1)];
+  int i, miss;
+
+  for (i = 0; i < CACHE_WAYS - 1 && way[i] != line; i++)
+    ;
+  miss = way[i] != line;
+
+  memmove (way + 1, way, i * sizeof (unsigned int));
+  way[0] = line;
+  return miss;
+}
+
+/*** The lookups of m68ki_execute_ir(), either way ***/
+static int
+dispatch_flat (CACHE * c, unsigned int ir)
+{
+  return cache_read (c, FLAT_JUMP + ir * 4)
+    + cache_read (c, FLAT_CYCLES + ir);
+}
+
+static int
+dispatch_compact (CACHE * c, unsigned int ir)
+{
+  unsigned int page = m68ki_dispatch_page[ir >> DISPATCH_PAGE_SHIFT];
+  unsigned int slot = page + (ir & (DISPATCH_PAGE_SIZE - 1));
+
+  return cache_read (c, PAGE_TABLE + (ir >> DISPATCH_PAGE_SHIFT) * 2)
+    + cache_read (c, INDEX_TABLE + slot * 2)
+    + cache_read (c, HANDLERS + m68ki_dispatch_index[slot] * 8);
+}
+
+/****************************************************************************
+* Opcode weights
+****************************************************************************/
+static int
+legal (unsigned int ir)
+{
+  return m68ki_instruction_jump_table[ir] != m68k_op_illegal
+    && m68ki_instruction_jump_table[ir] != m68k_op_1010
+    && m68ki_instruction_jump_table[ir] != m68k_op_1111;
+}
+
+static void
+synthetic_weights (void)
+{
+  static void (*order[4096]) (void);
+  static unsigned int spread[0x10000];
+  void (*h) (void);
+  unsigned int n = 0, i, j, k;
+
+  for (i = 0; i < 0x10000; i++)
+    {
+      if (!legal (i))
+	continue;
+      h = m68ki_instruction_jump_table[i];
+      for (j = 0; j < n && order[j] != h; j++)
+	;
+      if (j == n)
+	order[n++] = h;
+      spread[j]++;
+    }
+
+  /*** Random rank for each handler ***/
+  for (i = n - 1; i > 0; i--)
+    {
+      j = rnd (i + 1);
+      h = order[i];
+      order[i] = order[j];
+      order[j] = h;
+      k = spread[i];
+      spread[i] = spread[j];
+      spread[j] = k;
+    }
+
+  for (i = 0; i < 0x10000; i++)
+    if (legal (i))
+      {
+	for (j = 0; order[j] != m68ki_instruction_jump_table[i]; j++)
+	  ;
+	weight[i] = 1e9 / (j + 1) / spread[j];
+      }
+}
+
+static int
+read_weights (const char *name)
+{
+  FILE *fp = fopen (name, "r");
+  char line[256];
+  unsigned int ir, count;
+  int n = 0;
+
+  if (!fp)
+    {
+      perror (name);
+      return 0;
+    }
+
+  while (fgets (line, sizeof (line), fp))
+    if (!strncmp (line, "op;", 3)
+	&& sscanf (strchr (line + 3, ';') + 1, "%x %u", &ir, &count) == 2)
+      {
+	weight[ir & 0xffff] += count;
+	n++;
+      }
+
+  fclose (fp);
+  return n;
+}
+
+/*** Counts by handler, busiest first, as m68k_profile_handlers() does ***/
+static void
+write_handlers (const char *name)
+{
+  const m68ki_handler_name_struct *t;
+  double *sum;
+  FILE *fp = fopen (name, "w");
+  unsigned int n, i, j, best;
+
+  if (!fp)
+    {
+      perror (name);
+      return;
+    }
+
+  for (n = 0; m68ki_handler_name_table[n].opcode_handler; n++)
+    ;
+  sum = calloc (n, sizeof (double));
+
+  for (i = 0; i < 0x10000; i++)
+    for (t = m68ki_handler_name_table; weight[i] > 0 && t->opcode_handler;
+	 t++)
+      if (t->opcode_handler == m68ki_instruction_jump_table[i])
+	{
+	  sum[t - m68ki_handler_name_table] += weight[i];
+	  break;
+	}
+
+  fprintf (fp, "handler,count\n");
+  for (i = 0; i < n; i++)
+    {
+      for (best = 0, j = 1; j < n; j++)
+	if (sum[j] > sum[best])
+	  best = j;
+      if (sum[best] <= 0)
+	break;
+      fprintf (fp, "%s,%.0f\n", m68ki_handler_name_table[best].name,
+	       sum[best]);
+      sum[best] = 0;
+    }
+
+  free (sum);
+  fclose (fp);
+}
+
+static unsigned int
+draw (void)
+{
+  double r = (double) rnd (1 << 24) / (1 << 24) * cumul[0xffff];
+  unsigned int lo = 0, hi = 0xffff, mid;
+
+  while (lo < hi)
+    {
+      mid = (lo + hi) / 2;
+      if (cumul[mid] > r)
+	hi = mid;
+      else
+	lo = mid + 1;
+    }
+
+  return lo;
+}
+
+/****************************************************************************
+* Misses an instruction, flat and compact, with traffic other reads between
+****************************************************************************/
+static void
+simulate (int instructions, int traffic, double *flat, double *compact)
+{
+  static CACHE cf, cc;
+  unsigned int ir, other, mf = 0, mc = 0;
+  int i, j;
+
+  memset (&cf, 0, sizeof (cf));
+  memset (&cc, 0, sizeof (cc));
+
+  /*** Warm up on the first tenth ***/
+  for (i = -instructions / 10; i < instructions; i++)
+    {
+      if (i == 0)
+	mf = mc = 0;
+
+      ir = draw ();
+      mf += dispatch_flat (&cf, ir);
+      mc += dispatch_compact (&cc, ir);
+
+      for (j = 0; j < traffic; j++)
+	{
+	  other = OTHER + rnd (OTHER_SIZE);
+	  cache_read (&cf, other);
+	  cache_read (&cc, other);
+	}
+    }
+
+  *flat = (double) mf / instructions;
+  *compact = (double) mc / instructions;
+}
+
+int
+main (int argc, char *argv[])
+{
+  int instructions = argc > 1 ? atoi (argv[1]) : 2000000;
+  double light_flat, light_compact, heavy_flat, heavy_compact;
+  const m68ki_dispatch_entry *entry;
+  unsigned int i, pages = 0, hot = 0, bytes;
+
+  seed = argc > 2 ? atoi (argv[2]) : 1;
+
+  m68k_set_cpu_type (M68K_CPU_TYPE_68000);
+  m68k_pulse_reset ();
+  m68ki_build_dispatch ();
+
+  for (i = 0; i < 0x10000; i++)
+    {
+      entry = m68ki_dispatch (i);
+      if (entry->handler != m68ki_instruction_jump_table[i]
+	  || entry->cycles != CYC_INSTRUCTION[i])
+	{
+	  printf ("%s: opcode %04x dispatches differently\n", argv[0], i);
+	  return 1;
+	}
+      if (m68ki_dispatch_page[i >> DISPATCH_PAGE_SHIFT] >= pages)
+	pages = m68ki_dispatch_page[i >> DISPATCH_PAGE_SHIFT] + DISPATCH_PAGE_SIZE;
+    }
+
+  if (argc > 3 && strcmp (argv[3], "-"))
+    {
+      if (!read_weights (argv[3]))
+	return 1;
+    }
+  else
+    synthetic_weights ();
+
+  if (argc > 4)
+    write_handlers (argv[4]);
+
+  for (i = 0; i < 0x10000; i++)
+    cumul[i] = (i ? cumul[i - 1] : 0) + weight[i];
+
+  simulate (instructions, 2, &light_flat, &light_compact);
+  simulate (instructions, 8, &heavy_flat, &heavy_compact);
+
+  while (m68ki_hot_handler_table[hot])
+    hot++;
+
+  bytes = DISPATCH_PAGES * 2 + pages * 2 + m68ki_dispatch_num_handlers * 8;
+  printf ("%s: %u handlers, %u pages, %uKB against %uKB flat, %u hot, "
+	  "ok\n", argv[0], m68ki_dispatch_num_handlers,
+	  pages >> DISPATCH_PAGE_SHIFT, bytes >> 10, (0x10000 * 5) >> 10, hot);
+  printf ("  dispatch misses an instruction, flat / compact:"
+	  " light %.2f / %.2f, heavy %.2f / %.2f\n", light_flat,
+	  light_compact, heavy_flat, heavy_compact);
+  return 0;
+}
@@ -0,0 +1,185 @@
+/****************************************************************************
+*   NeoCDRX
+*   NeoGeo CD Emulator
+*   NeoCD Redux - Copyright (C) 2007 softdev
+****************************************************************************/
+
+/****************************************************************************
+* FIX cache check
+*
+* Makes random FIX map writes through the VRAM pointer and modulo, palette
+* writes, palette bank switches and FIX tile loads, as the 68000 side and
+* the CD loader would, and draws each frame with the cache over a random
+* background. Every frame is compared with a reference that draws all 40x28
+* cells straight from the map, the tiles and the Neo Geo colours.
+*
+* Usage: fix_cache [frames] [seed]
+****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "neocdrx.h"
+
+#define FIX_SIZE  0x20000
+
+static unsigned short screen[224][320];
+static unsigned char src[FIX_SIZE];
+
+static unsigned int seed;
+
+static unsigned int
+rnd (unsigned int n)
+{
+  seed = seed * 1103515245 + 12345;
+  return ((seed >> 8) & 0xffffff) % n;
+}
+
+/****************************************************************************
+* Random tiles, some empty and some solid
+****************************************************************************/
+static void
+fill_tiles (unsigned char *p, int len)
+{
+  int i, kind = 0;
+
+  for (i = 0; i < len; i++)
+    {
+      if ((i & 31) == 0)
+	kind = rnd (4);
+
+      switch (kind)
+	{
+	case 0:
+	  p[i] = 0;
+	  break;
+	case 1:
+	  p[i] = 0x11 * (1 + rnd (15));
+	  break;
+	case 2:
+	  p[i] = rnd (256);
+	  break;
+	default:
+	  p[i] = rnd (2) ? 0 : rnd (256);
+	  break;
+	}
+    }
+}
+
+/****************************************************************************
+* Reference
+*
+* Map word 0x7000 + x * 32 + y + 2 is cell x, y. Its top four bits pick one
+* of the first 16 palettes, the rest the tile. A tile row is a word of
+* eight pixels, pixel k in bits 4k to 4k + 3, drawn where the pixel is not
+* 0 unless the whole tile is opaque.
+****************************************************************************/
+static void
+ref_draw_fix (void)
+{
+  unsigned short *map = (unsigned short *) (video_vidram + 0xE000);
+  unsigned int *row;
+  int x, y, r, k, key, tile, col;
+
+  for (x = 0; x < 40; x++)
+    for (y = 0; y < 28; y++)
+      {
+	key = map[x * 32 + y + 2];
+	tile = key & 0xfff;
+	if (!video_fix_usage[tile])
+	  continue;
+
+	row = (unsigned int *) (neogeo_fix_memory + tile * 32);
+	for (r = 0; r < 8; r++)
+	  for (k = 0; k < 8; k++)
+	    {
+	      col = (row[r] >> (k * 4)) & 15;
+	      if (col || video_fix_usage[tile] == 1)
+		screen[y * 8 + r][x * 8 + k] =
+		  video_color_lut[video_paletteram_ng[(key >> 12) * 16 + col]
+				  & 0x7fff];
+	    }
+      }
+}
+
+/****************************************************************************
+* One frame of changes
+****************************************************************************/
+static void
+emulate (int frame)
+{
+  int i, n, offset, length;
+
+  /*** Map writes, in columns or rows, with a few elsewhere in VRAM ***/
+  n = rnd (frame % 50 == 0 ? 2000 : 40);
+  for (i = 0; i < n; i++)
+    {
+      if (rnd (8) == 0)
+	{
+	  m68k_write_memory_16 (0x3c0000, rnd (0x8000));
+	  m68k_write_memory_16 (0x3c0004, rnd (2) ? 1 : 32);
+	}
+      if (rnd (10) == 0)
+	m68k_write_memory_16 (0x3c0000, 0x7000 + rnd (0x500));
+      m68k_write_memory_16 (0x3c0002, (rnd (16) << 12) | rnd (0x1000));
+    }
+
+  /*** Palette writes, mostly to the FIX palettes ***/
+  n = rnd (16);
+  for (i = 0; i < n; i++)
+    m68k_write_memory_16 (0x400000 + 2 * rnd (rnd (2) ? 256 : 4096),
+			  rnd (0x10000));
+
+  if (rnd (60) == 0)
+    m68k_write_memory_16 (rnd (2) ? 0x3a000e : 0x3a001e, 0);
+
+  /*** New tiles now and then ***/
+  if (rnd (100) == 0)
+    {
+      offset = rnd ((FIX_SIZE - 0x2000) >> 5) << 5;
+      length = 1 + rnd (0x2000);
+      fill_tiles (src, length);
+      neogeo_copy_fix (neogeo_fix_memory, offset, src, length);
+    }
+}
+
+int
+main (int argc, char *argv[])
+{
+  int frames = argc > 1 ? atoi (argv[1]) : 3000;
+  int f, x, y;
+  unsigned short bg;
+
+  seed = argc > 2 ? atoi (argv[2]) : 1;
+
+  neogeo_fix_memory = malloc (FIX_SIZE);
+  initialise_memmap ();
+  video_init ();
+
+  fill_tiles (src, FIX_SIZE);
+  neogeo_copy_fix (neogeo_fix_memory, 0, src, FIX_SIZE);
+
+  for (f = 0; f < frames; f++)
+    {
+      emulate (f);
+
+      bg = rnd (0x10000);
+      for (y = 0; y < 224; y++)
+	for (x = 0; x < 320; x++)
+	  screen[y][x] = video_line_ptr[y][x] = bg + x * y;
+
+      video_draw_load_fix ();
+      ref_draw_fix ();
+
+      for (y = 0; y < 224; y++)
+	if (memcmp (video_line_ptr[y], screen[y], 640))
+	  {
+	    for (x = 0; video_line_ptr[y][x] == screen[y][x]; x++);
+	    printf ("frame %d: pixel %d,%d is %04x, not %04x\n", f, x, y,
+		    video_line_ptr[y][x], screen[y][x]);
+	    return 1;
+	  }
+    }
+
+  printf ("%s: %d frames, ok\n", argv[0], frames);
+  return 0;
+}
@@ -0,0 +1,217 @@
+/****************************************************************************
+*   NeoCDRX
+*   NeoGeo CD Emulator
+*   NeoCD Redux - Copyright (C) 2007 softdev
+****************************************************************************/
+
+/****************************************************************************
+* Host stand-ins
+*
+* The parts of the emulator a host test does not build, as weak symbols so
+* any of them can come from the real source instead. Memory regions are
+* left NULL for the test to allocate.
+****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "neocdrx.h"
+
+#define WEAK __attribute__ ((weak))
+
+/*** Memory ***/
+WEAK unsigned char *neogeo_rom_memory;
+WEAK unsigned char *neogeo_prg_memory;
+WEAK unsigned char *neogeo_fix_memory;
+WEAK unsigned char *neogeo_ipl_memory;
+WEAK unsigned char *neogeo_spr_memory;
+WEAK unsigned char *neogeo_pcm_memory;
+WEAK unsigned char neogeo_memorycard[8192];
+WEAK char neogeo_game_vectors[0x100];
+WEAK UINT8 subcpu_memspace[65536];
+WEAK unsigned int cdrom_bytes_moved;
+
+/*** Prefs ***/
+WEAK unsigned char RenderThread;
+WEAK unsigned char FrameSkip;
+WEAK unsigned char SkipCount = 2;
+
+/*** CPUs ***/
+WEAK CPU CPU_Z80;
+WEAK int cpu_enabled = 1;
+WEAK int scanline;
+WEAK unsigned char m68k_cache_pages[1 << (24 - M68K_CACHE_PAGE_SHIFT)];
+
+WEAK void
+m68k_cache_invalidate (unsigned int address, unsigned int length)
+{
+}
+
+WEAK void
+m68k_set_irq (unsigned int int_level)
+{
+}
+
+WEAK void
+mz80int (INT32 irq)
+{
+}
+
+WEAK void
+mz80nmi (void)
+{
+}
+
+WEAK void
+mz80ClearPendingInterrupt (INT32 irq)
+{
+}
+
+WEAK void
+mz80_reset (void)
+{
+}
+
+/*** NeoCD traps in the 68K core ***/
+WEAK int img_display;
+
+WEAK void
+cdrom_load_files (void)
+{
+}
+
+WEAK void
+neogeo_cdda_control (void)
+{
+}
+
+WEAK void
+neogeo_upload (void)
+{
+}
+
+WEAK void
+neogeo_exit_cdplayer (void)
+{
+}
+
+WEAK void
+neogeo_start_upload (void)
+{
+}
+
+WEAK void
+neogeo_end_upload (void)
+{
+}
+
+WEAK void
+neogeo_progress_show (void)
+{
+}
+
+WEAK void
+neogeo_trace (void)
+{
+}
+
+WEAK void
+neogeo_ipl (void)
+{
+}
+
+WEAK void
+neogeo_ipl_end (void)
+{
+}
+
+WEAK void
+neogeo_exit (void)
+{
+}
+
+WEAK int
+neogeo_bios_hle (unsigned int trap)
+{
+  return -1;
+}
+
+/*** Sound latch ***/
+WEAK int pending_command;
+WEAK int result_code;
+WEAK int sound_code;
+
+/*** Calendar ***/
+WEAK struct pd4990a_s pd4990a;
+
+WEAK void
+pd4990a_addretrace (void)
+{
+}
+
+WEAK READ8_HANDLER (pd4990a_testbit_r)
+{
+  return 0;
+}
+
+WEAK READ8_HANDLER (pd4990a_databit_r)
+{
+  return 0;
+}
+
+WEAK WRITE16_HANDLER (pd4990a_control_16_w)
+{
+}
+
+/*** CD audio ***/
+WEAK void
+cdda_stop (void)
+{
+}
+
+/*** Input ***/
+WEAK unsigned char
+read_player1 (void)
+{
+  return 0xff;
+}
+
+WEAK unsigned char
+read_player2 (void)
+{
+  return 0xff;
+}
+
+WEAK unsigned char
+read_pl12_startsel (void)
+{
+  return 0x0f;
+}
+
+/*** Output ***/
+WEAK int loadprof_frames;
+
+WEAK void
+loadprof_draw (unsigned short *buffer)
+{
+}
+
+WEAK void
+capture_frame (const unsigned short *buffer, int repeats)
+{
+}
+
+WEAK void
+capture_audio (const char *buffer, int bytes)
+{
+}
+
+WEAK const char *
+capture_status (void)
+{
+  return NULL;
+}
+
+WEAK void
+update_video (int width, int height, char *vbuffer)
+{
+}
@@ -0,0 +1,99 @@
+/****************************************************************************
+* Host stand-in for libogc
+*
+* Just enough of gccore.h for the emulator core to build with the host
+* compiler. LWP threads, semaphores and mutexes map onto POSIX ones.
+****************************************************************************/
+#ifndef __HOST_GCCORE__
+#define __HOST_GCCORE__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <semaphore.h>
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int8_t s8;
+typedef int16_t s16;
+typedef int32_t s32;
+typedef int64_t s64;
+typedef volatile u8 vu8;
+typedef volatile u16 vu16;
+typedef volatile u32 vu32;
+typedef float f32;
+
+#define ATTRIBUTE_ALIGN(v) __attribute__ ((aligned (v)))
+
+typedef struct
+{
+  u32 viTVMode;
+  u16 fbWidth;
+  u16 efbHeight;
+  u16 xfbHeight;
+  u16 viXOrigin;
+  u16 viYOrigin;
+  u16 viWidth;
+  u16 viHeight;
+} GXRModeObj;
+
+/*** LWP on POSIX threads ***/
+typedef pthread_t lwp_t;
+typedef pthread_mutex_t *mutex_t;
+typedef sem_t host_sem_t;
+typedef host_sem_t *lwp_sem_t;
+#define sem_t lwp_sem_t
+
+static inline s32
+LWP_CreateThread (lwp_t * thread, void *(*entry) (void *), void *arg,
+		  void *stackbase, u32 stack_size, u8 prio)
+{
+  return pthread_create (thread, NULL, entry, arg);
+}
+
+static inline s32
+LWP_SemInit (lwp_sem_t * sem, u32 start, u32 max)
+{
+  *sem = malloc (sizeof (host_sem_t));
+  return sem_init (*sem, 0, start);
+}
+
+static inline s32
+LWP_SemWait (lwp_sem_t sem)
+{
+  return sem_wait (sem);
+}
+
+static inline s32
+LWP_SemPost (lwp_sem_t sem)
+{
+  return sem_post (sem);
+}
+
+static inline s32
+LWP_MutexInit (mutex_t * mutex, bool recursive)
+{
+  *mutex = malloc (sizeof (pthread_mutex_t));
+  return pthread_mutex_init (*mutex, NULL);
+}
+
+static inline s32
+LWP_MutexLock (mutex_t mutex)
+{
+  return pthread_mutex_lock (mutex);
+}
+
+static inline s32
+LWP_MutexUnlock (mutex_t mutex)
+{
+  return pthread_mutex_unlock (mutex);
+}
+
+/*** Cache control has nothing to do on the host ***/
+#define DCFlushRange(p, len)
+#define DCInvalidateRange(p, len)
+
+#endif
@@ -0,0 +1,23 @@
+/****************************************************************************
+* Host stand-in for libogc
+****************************************************************************/
+#ifndef __HOST_DISC_IO__
+#define __HOST_DISC_IO__
+
+#include <gccore.h>
+
+typedef u32 sec_t;
+
+typedef struct
+{
+  u32 ioType;
+  u32 features;
+  bool (*startup) (void);
+  bool (*isInserted) (void);
+  bool (*readSectors) (sec_t sector, sec_t numSectors, void *buffer);
+  bool (*writeSectors) (sec_t sector, sec_t numSectors, const void *buffer);
+  bool (*clearStatus) (void);
+  bool (*shutdown) (void);
+} DISC_INTERFACE;
+
+#endif
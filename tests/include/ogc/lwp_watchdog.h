@@ -0,0 +1,33 @@
+/****************************************************************************
+* Host stand-in for libogc
+*
+* Time base in nanoseconds from the monotonic clock.
+****************************************************************************/
+#ifndef __HOST_LWP_WATCHDOG__
+#define __HOST_LWP_WATCHDOG__
+
+#include <time.h>
+#include <gccore.h>
+
+static inline u64
+gettime (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (u64) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static inline u32
+diff_usec (u64 start, u64 end)
+{
+  return (u32) ((end - start) / 1000);
+}
+
+static inline u32
+diff_msec (u64 start, u64 end)
+{
+  return (u32) ((end - start) / 1000000);
+}
+
+#endif
@@ -0,0 +1,436 @@
+/****************************************************************************
+*   NeoCDRX
+*   NeoGeo CD Emulator
+*   NeoCD Redux - Copyright (C) 2007 softdev
+****************************************************************************/
+
+/****************************************************************************
+* 68K block cache cross-check
+*
+* Runs random loops of straight-line code, with short forward branches,
+* through the block cache and through the plain interpreter, and compares the
+* registers, SR, cycles and data RAM they finish with. Each program is run
+* in timeslices of random length, so blocks are linked, broken and resumed
+* at every point. Every program ends in TST.L D0 and BRA.S *, so the flags
+* a cached block leaves out are settled by the time they are compared.
+*
+* Built with M68K_DEAD_FLAGS on, this checks the _nf handlers against the
+* full ones the interpreter runs; m68k_cache_flags is the same check with
+* it off.
+*
+* Absolute long operands also read the last bytes of PRG RAM and just past
+* it. The results are hashed, so m68k_ram, built with M68K_FAST_RAM on, can
+* be compared with m68k_ram_ref, which reads through the handlers. The RAM
+* is followed by guard bytes the handlers never return.
+*
+* Usage: m68k_cache [programs] [seed]
+****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "m68k.h"
+
+#define RAM_SIZE    0x200000
+#define RAM_GUARD   16
+#define PROG_BASE   0x1000
+#define DATA_BASE   0x4000
+#define DATA_SIZE   0x4000
+#define STACK_TOP   0x10000
+#define COUNTER     0x3ffe
+#define PROG_OPS    48
+#define LOOPS       8
+#define RUN_CYCLES  60000
+
+unsigned char *neogeo_prg_memory;
+int img_display;
+
+/*** Nothing here reaches the NeoCD traps ***/
+void cdrom_load_files (void) { }
+void neogeo_cdda_control (void) { }
+void neogeo_upload (void) { }
+void neogeo_exit_cdplayer (void) { }
+void neogeo_start_upload (void) { }
+void neogeo_end_upload (void) { }
+void neogeo_progress_show (void) { }
+void neogeo_trace (void) { }
+void neogeo_ipl (void) { }
+void neogeo_ipl_end (void) { }
+void neogeo_exit (void) { }
+int neogeo_bios_hle (unsigned int trap) { return -1; }
+
+/****************************************************************************
+* Memory, in 68000 byte order
+****************************************************************************/
+#define RAM(a) neogeo_prg_memory[(a) & (RAM_SIZE - 1)]
+
+unsigned int
+m68k_read_memory_8 (unsigned int address)
+{
+  return RAM (address);
+}
+
+unsigned int
+m68k_read_memory_16 (unsigned int address)
+{
+  return (RAM (address) << 8) | RAM (address + 1);
+}
+
+unsigned int
+m68k_read_memory_32 (unsigned int address)
+{
+  return (m68k_read_memory_16 (address) << 16) |
+    m68k_read_memory_16 (address + 2);
+}
+
+void
+m68k_write_memory_8 (unsigned int address, unsigned int value)
+{
+  RAM (address) = value;
+  m68k_cache_write (address, 1);
+}
+
+void
+m68k_write_memory_16 (unsigned int address, unsigned int value)
+{
+  RAM (address) = value >> 8;
+  RAM (address + 1) = value;
+  m68k_cache_write (address, 2);
+}
+
+void
+m68k_write_memory_32 (unsigned int address, unsigned int value)
+{
+  m68k_write_memory_16 (address, value >> 16);
+  m68k_write_memory_16 (address + 2, value);
+}
+
+/****************************************************************************
+* Program generator
+****************************************************************************/
+static unsigned int seed;
+static unsigned int pc;
+
+static unsigned int
+rnd (unsigned int n)
+{
+  seed = seed * 1103515245 + 12345;
+  return ((seed >> 8) & 0xffffff) % n;
+}
+
+static void
+emit (unsigned int word)
+{
+  RAM (pc) = word >> 8;
+  RAM (pc + 1) = word;
+  pc += 2;
+}
+
+/*** Immediate data of a size 0=byte, 1=word, 2=long ***/
+static void
+emit_imm (int size)
+{
+  if (size == 2)
+    emit (rnd (0x10000));
+  emit (size == 0 ? rnd (0x100) : rnd (0x10000));
+}
+
+/*** A source operand: Dn, (An), (An)+, -(An), d16(An), abs.w, abs.l or #imm ***/
+static int ea_ext_size;		/* 0 none, 1 a word, 2 a long, 3 + size immediate */
+static unsigned int ea_ext;
+
+static int
+src_ea (int size)
+{
+  int an = rnd (4);
+
+  ea_ext_size = 0;
+  switch (rnd (9))
+    {
+    case 1:
+      return 0x10 | an;
+    case 2:
+      return 0x18 | an;
+    case 3:
+      return 0x20 | an;
+    case 4:
+      ea_ext_size = 1;
+      ea_ext = rnd (0x200) & ~1;
+      return 0x28 | an;
+    case 5:
+      ea_ext_size = 1;
+      ea_ext = DATA_BASE + (rnd (DATA_SIZE) & ~3);
+      return 0x38;
+    case 6:
+      ea_ext_size = 3 + size;
+      return 0x3c;
+    case 7:
+      ea_ext_size = 2;
+      if (rnd (2))
+	ea_ext = DATA_BASE + (rnd (DATA_SIZE) & ~3);
+      else
+	ea_ext = RAM_SIZE - 8 + rnd (12);
+      return 0x39;
+    default:
+      return rnd (8);
+    }
+}
+
+static void
+src_ea_ext (void)
+{
+  if (ea_ext_size == 1)
+    emit (ea_ext);
+  else if (ea_ext_size == 2)
+    {
+      emit (ea_ext >> 16);
+      emit (ea_ext);
+    }
+  else if (ea_ext_size >= 3)
+    emit_imm (ea_ext_size - 3);
+}
+
+static const unsigned int alu_ops[5] = { 0xD000, 0x9000, 0xC000, 0x8000, 0xB000 };	/* ADD SUB AND OR CMP */
+static const unsigned int imm_ops[6] = { 0x0000, 0x0200, 0x0400, 0x0600, 0x0A00, 0x0C00 };	/* ORI ANDI SUBI ADDI EORI CMPI */
+static const unsigned int unary_ops[5] = { 0x4000, 0x4200, 0x4400, 0x4600, 0x4A00 };	/* NEGX CLR NEG NOT TST */
+static const unsigned int misc_ops[4] = { 0x4880, 0x48C0, 0x4840, 0x4800 };	/* EXT.W EXT.L SWAP NBCD */
+static const unsigned int move_ops[3] = { 0x1000, 0x3000, 0x2000 };	/* MOVE.B .W .L */
+
+/*** One instruction; single word ones only when one is asked for ***/
+static void
+emit_op (int single)
+{
+  int x = rnd (8), y = rnd (8), size = rnd (3), ea;
+
+  switch (rnd (single ? 12 : 20))
+    {
+    case 0:			/* MOVEQ */
+      emit (0x7000 | x << 9 | rnd (0x100));
+      break;
+    case 1:			/* ADD, SUB, AND, OR, CMP Dy,Dx */
+      emit (alu_ops[rnd (5)] | x << 9 | size << 6 | y);
+      break;
+    case 2:			/* ADDX, SUBX, EOR Dx,Dy */
+      emit ((rnd (3) == 0 ? 0xB100 : rnd (2) ? 0xD100 : 0x9100) | x << 9 |
+	    size << 6 | y);
+      break;
+    case 3:			/* NEGX, CLR, NEG, NOT, TST Dy */
+      emit (unary_ops[rnd (5)] | size << 6 | y);
+      break;
+    case 4:			/* EXT.W, EXT.L, SWAP, NBCD Dy */
+      emit (misc_ops[rnd (4)] | y);
+      break;
+    case 5:			/* Shifts and rotates */
+      emit (0xE000 | x << 9 | rnd (2) << 8 | size << 6 | rnd (2) << 5 |
+	    rnd (4) << 3 | y);
+      break;
+    case 6:			/* ADDQ, SUBQ */
+      emit (0x5000 | x << 9 | rnd (2) << 8 | size << 6 | y);
+      break;
+    case 7:			/* Scc */
+      emit (0x50C0 | rnd (16) << 8 | y);
+      break;
+    case 8:			/* ABCD, SBCD */
+      emit ((rnd (2) ? 0xC100 : 0x8100) | x << 9 | y);
+      break;
+    case 9:			/* BTST, BCHG, BCLR, BSET Dx,Dy */
+      emit (0x0100 | x << 9 | rnd (4) << 6 | y);
+      break;
+    case 10:			/* CMPM (Ay)+,(Ax)+ */
+      emit (0xB108 | rnd (4) << 9 | size << 6 | rnd (4));
+      break;
+    case 11:			/* MOVE Dy,Dx */
+      emit (move_ops[size] | x << 9 | y);
+      break;
+    case 12:			/* ADD, SUB, AND, OR, CMP <ea>,Dx */
+      ea = src_ea (size);
+      emit (alu_ops[rnd (5)] | x << 9 | size << 6 | ea);
+      src_ea_ext ();
+      break;
+    case 13:			/* MULU, MULS <ea>,Dx */
+      ea = src_ea (1);
+      emit ((rnd (2) ? 0xC0C0 : 0xC1C0) | x << 9 | ea);
+      src_ea_ext ();
+      break;
+    case 14:			/* ORI, ANDI, SUBI, ADDI, EORI, CMPI #imm,Dy */
+      emit (imm_ops[rnd (6)] | size << 6 | y);
+      emit_imm (size);
+      break;
+    case 15:			/* MOVE Dy,(Ax) / (Ax)+ / -(Ax) */
+      emit (move_ops[size] | rnd (4) << 9 | (2 + rnd (3)) << 6 | y);
+      break;
+    case 16:			/* MOVE <ea>,Dx */
+      ea = src_ea (size);
+      emit (move_ops[size] | x << 9 | ea);
+      src_ea_ext ();
+      break;
+    case 17:			/* MOVE #imm,CCR */
+      emit (0x44FC);
+      emit (rnd (0x20));
+      break;
+    case 18:			/* ADDA, SUBA, CMPA Dy,A4-A6 */
+      emit ((rnd (3) == 0 ? 0xB0C0 : rnd (2) ? 0xD0C0 : 0x90C0) |
+	    (4 + rnd (3)) << 9 | rnd (2) << 8 | y);
+      break;
+    default:			/* Bcc.S or BSR.S over the next instruction */
+      emit (0x6002 | rnd (16) << 8);
+      emit_op (1);
+      break;
+    }
+}
+
+static void
+make_program (void)
+{
+  unsigned int body;
+  int i;
+
+  memset (neogeo_prg_memory, 0, STACK_TOP);
+  for (i = DATA_BASE; i < DATA_BASE + DATA_SIZE; i++)
+    RAM (i) = rnd (0x100);
+  for (i = RAM_SIZE - 8; i < RAM_SIZE + RAM_GUARD; i++)
+    neogeo_prg_memory[i] = rnd (0x100);
+
+  /*** Reset vectors ***/
+  m68k_write_memory_32 (0, STACK_TOP);
+  m68k_write_memory_32 (4, PROG_BASE);
+
+  /*** A0-A3 point into the data, the rest get random values ***/
+  pc = PROG_BASE;
+  for (i = 0; i < 4; i++)
+    {
+      emit (0x207C | i << 9);	/* MOVEA.L #imm,Ai */
+      emit (0);
+      emit (DATA_BASE + 0x800 + i * 0x1000);
+    }
+  for (i = 4; i < 7; i++)
+    {
+      emit (0x207C | i << 9);
+      emit_imm (2);
+    }
+  for (i = 0; i < 8; i++)
+    {
+      emit (0x203C | i << 9);	/* MOVE.L #imm,Di */
+      emit_imm (2);
+    }
+
+  emit (0x44FC);		/* MOVE #imm,CCR */
+  emit (rnd (0x20));
+
+  /*** The body runs LOOPS times, from the cache after the first ***/
+  m68k_write_memory_16 (COUNTER, LOOPS);
+  body = pc;
+  for (i = 0; i < PROG_OPS; i++)
+    emit_op (0);
+  emit (0x5378);		/* SUBQ.W #1,COUNTER */
+  emit (COUNTER);
+  emit (0x6600);		/* BNE.W body */
+  emit (body - pc);
+
+  emit (0x4A80);		/* TST.L D0 */
+  emit (0x60FE);		/* BRA.S * */
+}
+
+/****************************************************************************
+* Run and compare
+****************************************************************************/
+static unsigned long long hash = 1469598103934665603ULL;
+
+static void
+hash_bytes (const void *p, int len)
+{
+  const unsigned char *b = p;
+  int i;
+
+  for (i = 0; i < len; i++)
+    hash = (hash ^ b[i]) * 1099511628211ULL;
+}
+
+typedef struct
+{
+  unsigned int reg[18];
+  int cycles;
+  unsigned char data[DATA_SIZE];
+} RESULT;
+
+static void
+run (RESULT * r, int cached, unsigned int slice_seed)
+{
+  unsigned int save = seed;
+  int left = RUN_CYCLES, slice, i;
+
+  m68k_cache_enable (cached);
+  m68k_pulse_reset ();
+
+  seed = slice_seed;
+  r->cycles = 0;
+  while (left > 0)
+    {
+      slice = rnd (2) ? 1 + rnd (64) : 1 + rnd (4000);
+      if (slice > left)
+	slice = left;
+      r->cycles += m68k_execute (slice);
+      left -= slice;
+    }
+  seed = save;
+
+  for (i = 0; i < 16; i++)
+    r->reg[i] = m68k_get_reg (NULL, M68K_REG_D0 + i);
+  r->reg[16] = m68k_get_reg (NULL, M68K_REG_SR);
+  r->reg[17] = m68k_get_reg (NULL, M68K_REG_PC);
+  memcpy (r->data, &RAM (DATA_BASE), DATA_SIZE);
+}
+
+int
+main (int argc, char *argv[])
+{
+  static const char *names[18] = { "D0", "D1", "D2", "D3", "D4", "D5", "D6",
+    "D7", "A0", "A1", "A2", "A3", "A4", "A5", "A6", "A7", "SR", "PC"
+  };
+  static RESULT interp, cached;
+  static unsigned char ram[STACK_TOP];
+  int programs = argc > 1 ? atoi (argv[1]) : 2000;
+  int p, i, failed = 0;
+
+  seed = argc > 2 ? strtoul (argv[2], NULL, 0) : 1;
+
+  neogeo_prg_memory = calloc (1, RAM_SIZE + RAM_GUARD);
+  m68k_set_cpu_type (M68K_CPU_TYPE_68000);
+
+  for (p = 0; p < programs && failed < 10; p++)
+    {
+      unsigned int slice_seed = rnd (0x10000);
+
+      make_program ();
+      memcpy (ram, neogeo_prg_memory, STACK_TOP);
+      run (&interp, 0, slice_seed);
+
+      memcpy (neogeo_prg_memory, ram, STACK_TOP);
+      run (&cached, 1, slice_seed);
+
+      for (i = 0; i < 18; i++)
+	if (interp.reg[i] != cached.reg[i])
+	  {
+	    printf ("program %d: %s %08x interpreter, %08x cached\n", p,
+		    names[i], interp.reg[i], cached.reg[i]);
+	    failed++;
+	  }
+      if (interp.cycles != cached.cycles)
+	{
+	  printf ("program %d: %d cycles interpreter, %d cached\n", p,
+		  interp.cycles, cached.cycles);
+	  failed++;
+	}
+      if (memcmp (interp.data, cached.data, DATA_SIZE))
+	{
+	  printf ("program %d: data RAM differs\n", p);
+	  failed++;
+	}
+
+      hash_bytes (&cached, sizeof (cached));
+    }
+
+  printf ("hash %016llx\n", hash);
+  fprintf (stderr, "%s: %d programs, %s\n", argv[0], p,
+	   failed ? "FAILED" : "ok");
+  return failed != 0;
+}
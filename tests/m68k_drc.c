@@ -0,0 +1,1264 @@
+/****************************************************************************
+*   NeoCDRX
+*   NeoGeo CD Emulator
+*   NeoCD Redux - Copyright (C) 2007 softdev
+****************************************************************************/
+
+/****************************************************************************
+* 68K recompiler cross-check
+*
+* Runs the PowerPC code the recompiler (M68K_DRC) writes on a small emulator
+* of the PowerPC instructions it uses, and checks it against the plain
+* interpreter, in two ways:
+*
+*  - Block by block: each block is run once through the recompiler and once
+*    through the interpreter from the same state, and the registers, SR, PC,
+*    cycles, RAM and writes past RAM must come out the same.
+*  - Whole programs in timeslices of random length, with blocks linked into
+*    each other, compared once both have reached the BRA.S * at the end.
+*
+* The programs are random loops of the instructions the recompiler
+* translates, in every addressing mode, with Bcc, DBcc, BSR, JSR and RTS,
+* compares right before the branches that use them, instructions it leaves
+* to the interpreter, and MOVE.Ws that patch a MOVEQ further down the
+* same block. Reads past RAM return a pattern, writes past it are hashed.
+*
+* The emulated PowerPC sees PRG RAM big-endian, as on the GC, and the
+* core's own structures, the code and its stack in host byte order. Helper
+* calls clobber every volatile register. The entry code must give back r1
+* and r14-r31 as it found them.
+*
+* Usage: m68k_drc [programs] [seed]
+****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "m68kcpu.h"
+
+#define RAM_SIZE    0x200000
+#define RAM_GUARD   16
+#define PROG_BASE   0x1000
+#define DATA_BASE   0x4000
+#define DATA_SIZE   0x4000
+#define STACK_TOP   0x10000
+#define RAM_KEPT    (STACK_TOP + 8)	/*** And the last 8 bytes ***/
+#define COUNTER     0x3ffe
+#define IO_BASE     0x300000
+#define PROG_OPS    48
+#define LOOPS       8
+#define BLOCK_CYCLES 20000
+#define RUN_CYCLES  400000
+
+unsigned char *neogeo_prg_memory;
+int img_display;
+
+/*** Nothing here reaches the NeoCD traps ***/
+void cdrom_load_files (void) { }
+void neogeo_cdda_control (void) { }
+void neogeo_upload (void) { }
+void neogeo_exit_cdplayer (void) { }
+void neogeo_start_upload (void) { }
+void neogeo_end_upload (void) { }
+void neogeo_progress_show (void) { }
+void neogeo_trace (void) { }
+void neogeo_ipl (void) { }
+void neogeo_ipl_end (void) { }
+void neogeo_exit (void) { }
+int neogeo_bios_hle (unsigned int trap) { return -1; }
+
+/****************************************************************************
+* Memory, in 68000 byte order, and a pattern past it
+****************************************************************************/
+#define RAM(a) neogeo_prg_memory[(a) & (RAM_SIZE - 1)]
+
+static unsigned int io_hash;
+static int stray_writes;	/*** To RAM the test doesn't keep ***/
+
+static unsigned int
+read_byte (unsigned int address)
+{
+  address &= 0xffffff;
+  if (address < RAM_SIZE)
+    return neogeo_prg_memory[address];
+  return (address * 0x9e3779b1) >> 24;
+}
+
+static void
+write_byte (unsigned int address, unsigned int value)
+{
+  address &= 0xffffff;
+  if (address < RAM_SIZE)
+    {
+      if (address >= STACK_TOP && address < RAM_SIZE - 8)
+	stray_writes++;
+      neogeo_prg_memory[address] = value;
+      m68k_cache_write (address, 1);
+    }
+  else
+    io_hash = (io_hash ^ address ^ (value & 0xff) << 24) * 16777619;
+}
+
+unsigned int
+m68k_read_memory_8 (unsigned int address)
+{
+  return read_byte (address);
+}
+
+unsigned int
+m68k_read_memory_16 (unsigned int address)
+{
+  return (read_byte (address) << 8) | read_byte (address + 1);
+}
+
+unsigned int
+m68k_read_memory_32 (unsigned int address)
+{
+  return (m68k_read_memory_16 (address) << 16) |
+    m68k_read_memory_16 (address + 2);
+}
+
+void
+m68k_write_memory_8 (unsigned int address, unsigned int value)
+{
+  write_byte (address, value);
+}
+
+void
+m68k_write_memory_16 (unsigned int address, unsigned int value)
+{
+  write_byte (address, value >> 8);
+  write_byte (address + 1, value);
+}
+
+void
+m68k_write_memory_32 (unsigned int address, unsigned int value)
+{
+  m68k_write_memory_16 (address, value >> 16);
+  m68k_write_memory_16 (address + 2, value);
+}
+
+/****************************************************************************
+* PowerPC emulator
+*
+* Only what the recompiler writes: integer instructions, CR0, XER[CA], LR
+* and CTR. The memory it may touch is mapped in windows of the exact size,
+* so that an access past them fails, and m68k_drc_host() gives the address
+* of a pointer in them.
+****************************************************************************/
+#define WINDOWS     8
+#define MAGIC_LR    0xfffffff0	/*** Return address of m68k_drc_run() ***/
+#define MAX_STEPS   50000000
+
+typedef struct
+{
+  unsigned char *host;
+  unsigned int base;
+  unsigned int size;
+  int big;			/*** Big-endian, else host order ***/
+} WINDOW;
+
+static WINDOW windows[WINDOWS];
+static int num_windows;
+static unsigned int gpr[32], lr, ctr, ca;
+static int cr_lt, cr_gt, cr_eq;
+static unsigned long long ppc_steps;
+static unsigned int ppc_stack[0x4000];
+
+static void
+fail (const char *what, unsigned int pc, unsigned int word)
+{
+  fprintf (stderr, "m68k_drc: %s at %08x (%08x)\n", what, pc, word);
+  exit (1);
+}
+
+static void
+map_window (const void *host, unsigned int size, int big)
+{
+  WINDOW *w = &windows[num_windows];
+
+  w->host = (unsigned char *) host;
+  w->base = 0x10000000 + num_windows * 0x1000000;
+  w->size = size;
+  w->big = big;
+  num_windows++;
+}
+
+unsigned int
+m68k_drc_host (const void *host)
+{
+  const unsigned char *p = host;
+  int i;
+
+  for (i = 0; i < num_windows; i++)
+    if (p >= windows[i].host && p < windows[i].host + windows[i].size)
+      return windows[i].base + (p - windows[i].host);
+  fail ("pointer to unmapped memory", 0, 0);
+  return 0;
+}
+
+static unsigned char *
+ppc_addr (unsigned int address, int size, int *big)
+{
+  int i;
+
+  for (i = 0; i < num_windows; i++)
+    if (address >= windows[i].base &&
+	address - windows[i].base + size <= windows[i].size)
+      {
+	*big = windows[i].big;
+	return windows[i].host + (address - windows[i].base);
+      }
+  fail ("access to unmapped memory", address, size);
+  return NULL;
+}
+
+static unsigned int
+ppc_load (unsigned int address, int size)
+{
+  int big, i;
+  unsigned char *p = ppc_addr (address, size, &big);
+  unsigned int value = 0;
+  unsigned short half;
+
+  if (big)
+    {
+      for (i = 0; i < size; i++)
+	value = (value << 8) | p[i];
+      return value;
+    }
+  if (size == 1)
+    return *p;
+  if (size == 2)
+    {
+      memcpy (&half, p, 2);
+      return half;
+    }
+  memcpy (&value, p, 4);
+  return value;
+}
+
+static void
+ppc_store (unsigned int address, int size, unsigned int value)
+{
+  int big, i;
+  unsigned char *p = ppc_addr (address, size, &big);
+  unsigned short half = value;
+
+  if (big)
+    {
+      for (i = size - 1; i >= 0; i--, value >>= 8)
+	p[i] = value;
+      return;
+    }
+  if (size == 1)
+    *p = value;
+  else if (size == 2)
+    memcpy (p, &half, 2);
+  else
+    memcpy (p, &value, 4);
+}
+
+static void
+set_cr0 (int lt, int gt)
+{
+  cr_lt = lt;
+  cr_gt = gt;
+  cr_eq = !lt && !gt;
+}
+
+static void
+record (unsigned int value)
+{
+  set_cr0 ((int) value < 0, (int) value > 0);
+}
+
+static unsigned int
+rotl (unsigned int value, int n)
+{
+  n &= 31;
+  return n ? (value << n) | (value >> (32 - n)) : value;
+}
+
+static unsigned int
+mask (int mb, int me)
+{
+  unsigned int from = 0xffffffff >> mb;
+  unsigned int to = 0xffffffff << (31 - me);
+
+  return mb <= me ? from & to : from | to;
+}
+
+/*** rD = rA + rB + carry in, setting CA ***/
+static unsigned int
+add_carry (unsigned int a, unsigned int b, unsigned int in)
+{
+  unsigned long long sum = (unsigned long long) a + b + in;
+
+  ca = sum >> 32;
+  return sum;
+}
+
+static int
+branch_taken (unsigned int bo, unsigned int bi)
+{
+  int bit = bi == 0 ? cr_lt : bi == 1 ? cr_gt : bi == 2 ? cr_eq : 0;
+
+  if (bo & 0x10)
+    return 1;
+  return (bo & 8) ? bit : !bit;
+}
+
+/*** Run from pc until it returns to MAGIC_LR ***/
+static void
+ppc_run (unsigned int pc)
+{
+  unsigned int (*helper) (unsigned int, unsigned int, unsigned int);
+  unsigned int w, op, d, a, b, ea, next, i;
+  int simm;
+
+  while (pc != MAGIC_LR)
+    {
+      if (++ppc_steps % MAX_STEPS == 0)
+	fail ("runaway code", pc, 0);
+
+      if (pc >= DRC_HELPER_BASE && pc < DRC_HELPER_BASE + DRC_HELPERS * 4)
+	{
+	  helper = m68ki_drc_helpers[(pc - DRC_HELPER_BASE) / 4];
+	  gpr[3] = helper (gpr[3], gpr[4], gpr[5]);
+	  gpr[0] = gpr[4] = gpr[5] = gpr[6] = gpr[7] = 0xdeadbeef;
+	  gpr[8] = gpr[9] = gpr[10] = gpr[11] = gpr[12] = 0xdeadbeef;
+	  ctr = 0xdeadbeef;
+	  ca = 1;
+	  set_cr0 (1, 1);
+	  pc = lr;
+	  continue;
+	}
+
+      w = ppc_load (pc, 4);
+      op = w >> 26;
+      d = (w >> 21) & 31;
+      a = (w >> 16) & 31;
+      b = (w >> 11) & 31;
+      simm = (short) w;
+      next = pc + 4;
+
+      switch (op)
+	{
+	case 10:		/*** cmplwi ***/
+	  set_cr0 (gpr[a] < (w & 0xffff), gpr[a] > (w & 0xffff));
+	  break;
+	case 11:		/*** cmpwi ***/
+	  set_cr0 ((int) gpr[a] < simm, (int) gpr[a] > simm);
+	  break;
+	case 13:		/*** addic. ***/
+	  gpr[d] = add_carry (gpr[a], simm, 0);
+	  record (gpr[d]);
+	  break;
+	case 14:		/*** addi ***/
+	  gpr[d] = (a ? gpr[a] : 0) + simm;
+	  break;
+	case 15:		/*** addis ***/
+	  gpr[d] = (a ? gpr[a] : 0) + (w << 16);
+	  break;
+	case 16:		/*** bc ***/
+	  if (w & 2)
+	    fail ("absolute branch", pc, w);
+	  if (w & 1)
+	    lr = next;
+	  if (branch_taken (d, a))
+	    next = pc + (short) (w & 0xfffc);
+	  break;
+	case 18:		/*** b, bl ***/
+	  if (w & 2)
+	    fail ("absolute branch", pc, w);
+	  if (w & 1)
+	    lr = next;
+	  next = pc + ((int) (w << 6) >> 6 & ~3);
+	  break;
+	case 19:
+	  if (((w >> 1) & 0x3ff) == 16 && d == 20)	/*** blr ***/
+	    next = lr;
+	  else if (((w >> 1) & 0x3ff) == 528 && d == 20)	/*** bctr(l) ***/
+	    next = ctr;
+	  else
+	    fail ("unknown instruction", pc, w);
+	  if (w & 1)
+	    lr = pc + 4;
+	  break;
+	case 20:		/*** rlwimi ***/
+	  i = mask ((w >> 6) & 31, (w >> 1) & 31);
+	  gpr[a] = (rotl (gpr[d], b) & i) | (gpr[a] & ~i);
+	  if (w & 1)
+	    record (gpr[a]);
+	  break;
+	case 21:		/*** rlwinm ***/
+	  gpr[a] = rotl (gpr[d], b) & mask ((w >> 6) & 31, (w >> 1) & 31);
+	  if (w & 1)
+	    record (gpr[a]);
+	  break;
+	case 24:
+	  gpr[a] = gpr[d] | (w & 0xffff);
+	  break;
+	case 25:
+	  gpr[a] = gpr[d] | (w << 16);
+	  break;
+	case 26:
+	  gpr[a] = gpr[d] ^ (w & 0xffff);
+	  break;
+	case 27:
+	  gpr[a] = gpr[d] ^ (w << 16);
+	  break;
+	case 28:		/*** andi. ***/
+	  gpr[a] = gpr[d] & (w & 0xffff);
+	  record (gpr[a]);
+	  break;
+	case 32:
+	  gpr[d] = ppc_load ((a ? gpr[a] : 0) + simm, 4);
+	  break;
+	case 34:
+	  gpr[d] = ppc_load ((a ? gpr[a] : 0) + simm, 1);
+	  break;
+	case 36:
+	  ppc_store ((a ? gpr[a] : 0) + simm, 4, gpr[d]);
+	  break;
+	case 37:		/*** stwu ***/
+	  ppc_store (gpr[a] + simm, 4, gpr[d]);
+	  gpr[a] += simm;
+	  break;
+	case 40:
+	  gpr[d] = ppc_load ((a ? gpr[a] : 0) + simm, 2);
+	  break;
+	case 46:		/*** lmw ***/
+	  for (ea = gpr[a] + simm, i = d; i < 32; i++, ea += 4)
+	    gpr[i] = ppc_load (ea, 4);
+	  break;
+	case 47:		/*** stmw ***/
+	  for (ea = gpr[a] + simm, i = d; i < 32; i++, ea += 4)
+	    ppc_store (ea, 4, gpr[i]);
+	  break;
+	case 31:
+	  ea = (a ? gpr[a] : 0) + gpr[b];
+	  switch ((w >> 1) & 0x3ff)
+	    {
+	    case 0:		/*** cmpw ***/
+	      set_cr0 ((int) gpr[a] < (int) gpr[b], (int) gpr[a] > (int) gpr[b]);
+	      break;
+	    case 32:		/*** cmplw ***/
+	      set_cr0 (gpr[a] < gpr[b], gpr[a] > gpr[b]);
+	      break;
+	    case 8:		/*** subfc ***/
+	      gpr[d] = add_carry (~gpr[a], gpr[b], 1);
+	      break;
+	    case 10:		/*** addc ***/
+	      gpr[d] = add_carry (gpr[a], gpr[b], 0);
+	      break;
+	    case 136:		/*** subfe ***/
+	      gpr[d] = add_carry (~gpr[a], gpr[b], ca);
+	      break;
+	    case 202:		/*** addze ***/
+	      gpr[d] = add_carry (gpr[a], 0, ca);
+	      break;
+	    case 40:
+	      gpr[d] = gpr[b] - gpr[a];
+	      break;
+	    case 104:
+	      gpr[d] = -gpr[a];
+	      break;
+	    case 235:
+	      gpr[d] = gpr[a] * gpr[b];
+	      break;
+	    case 266:
+	      gpr[d] = gpr[a] + gpr[b];
+	      break;
+	    case 23:
+	      gpr[d] = ppc_load (ea, 4);
+	      break;
+	    case 279:
+	      gpr[d] = ppc_load (ea, 2);
+	      break;
+	    case 87:
+	      gpr[d] = ppc_load (ea, 1);
+	      break;
+	    case 151:
+	      ppc_store (ea, 4, gpr[d]);
+	      break;
+	    case 407:
+	      ppc_store (ea, 2, gpr[d]);
+	      break;
+	    case 215:
+	      ppc_store (ea, 1, gpr[d]);
+	      break;
+	    case 24:		/*** slw ***/
+	      gpr[a] = gpr[b] & 32 ? 0 : gpr[d] << (gpr[b] & 31);
+	      break;
+	    case 26:		/*** cntlzw ***/
+	      for (i = 0; i < 32 && !(gpr[d] & (0x80000000 >> i)); i++);
+	      gpr[a] = i;
+	      break;
+	    case 28:
+	      gpr[a] = gpr[d] & gpr[b];
+	      break;
+	    case 60:
+	      gpr[a] = gpr[d] & ~gpr[b];
+	      break;
+	    case 124:
+	      gpr[a] = ~(gpr[d] | gpr[b]);
+	      break;
+	    case 316:
+	      gpr[a] = gpr[d] ^ gpr[b];
+	      break;
+	    case 444:
+	      gpr[a] = gpr[d] | gpr[b];
+	      break;
+	    case 824:		/*** srawi ***/
+	      ca = (int) gpr[d] < 0 && (gpr[d] & ((1u << b) - 1));
+	      gpr[a] = (int) gpr[d] >> b;
+	      break;
+	    case 922:
+	      gpr[a] = (short) gpr[d];
+	      break;
+	    case 954:
+	      gpr[a] = (signed char) gpr[d];
+	      break;
+	    case 339:		/*** mflr ***/
+	      if (a != 8 || b)
+		fail ("unknown SPR", pc, w);
+	      gpr[d] = lr;
+	      break;
+	    case 467:		/*** mtlr, mtctr ***/
+	      if ((a != 8 && a != 9) || b)
+		fail ("unknown SPR", pc, w);
+	      if (a == 8)
+		lr = gpr[d];
+	      else
+		ctr = gpr[d];
+	      break;
+	    default:
+	      fail ("unknown instruction", pc, w);
+	    }
+	  /*** Record forms: only or. is written ***/
+	  if ((w & 1) && ((w >> 1) & 0x3ff) == 444)
+	    record (gpr[a]);
+	  else if (w & 1)
+	    fail ("unknown record form", pc, w);
+	  break;
+	default:
+	  fail ("unknown instruction", pc, w);
+	}
+      pc = next;
+    }
+}
+
+/*** Call the entry code as the C code would, and check it kept the ABI ***/
+void
+m68k_drc_run (unsigned int entry, unsigned int code)
+{
+  unsigned int saved[32];
+  int i;
+
+  for (i = 0; i < 32; i++)
+    gpr[i] = 0x5a5a0000 + i * 0x1111;
+  gpr[1] = m68k_drc_host (ppc_stack) + sizeof (ppc_stack) - 16;
+  gpr[3] = code;
+  lr = MAGIC_LR;
+  memcpy (saved, gpr, sizeof (saved));
+
+  ppc_run (entry);
+
+  if (gpr[1] != saved[1])
+    fail ("stack pointer not restored", 0, gpr[1]);
+  for (i = 14; i < 32; i++)
+    if (gpr[i] != saved[i])
+      fail ("non-volatile register not restored", i, gpr[i]);
+}
+
+/****************************************************************************
+* Program generator
+****************************************************************************/
+static unsigned int seed;
+static unsigned int pc;
+static unsigned int end_pc;
+static int data_regs = 8;	/*** D7 is left alone in a DBcc loop ***/
+
+static unsigned int
+rnd (unsigned int n)
+{
+  seed = seed * 1103515245 + 12345;
+  return ((seed >> 8) & 0xffffff) % n;
+}
+
+static void
+emit (unsigned int word)
+{
+  RAM (pc) = word >> 8;
+  RAM (pc + 1) = word;
+  pc += 2;
+}
+
+static void
+patch (unsigned int at, unsigned int word)
+{
+  RAM (at) = word >> 8;
+  RAM (at + 1) = word;
+}
+
+/*** Immediate data of a size 0=byte, 1=word, 2=long ***/
+static void
+emit_imm (int size)
+{
+  if (size == 2)
+    emit (rnd (0x10000));
+  emit (size == 0 ? rnd (0x100) : rnd (0x10000));
+}
+
+/*** Extension words of the last operand, emitted after the opcode ***/
+static unsigned int ext[2];
+static int ext_words;
+
+static void
+emit_ext (const unsigned int *words, int count)
+{
+  int i;
+
+  for (i = 0; i < count; i++)
+    emit (words[i]);
+}
+
+/*** A brief extension word: Xn.W or .L with an 8 bit displacement ***/
+static unsigned int
+index_word (void)
+{
+  return rnd (16) << 12 | rnd (2) << 11 | rnd (0x100);
+}
+
+/*** A source operand in any mode, #imm included unless it is written ***/
+static int
+src_ea (int size, int writable)
+{
+  int an = rnd (4);
+
+  ext_words = 0;
+  switch (rnd (writable ? 9 : 14))
+    {
+    case 0:
+      return 0x10 | an;
+    case 1:
+      return 0x18 | an;
+    case 2:
+      return 0x20 | an;
+    case 3:
+      ext[ext_words++] = rnd (0x200) & ~1;
+      return 0x28 | an;
+    case 4:
+      ext[ext_words++] = DATA_BASE + (rnd (DATA_SIZE) & ~3);
+      return 0x38;
+    case 5:			/*** abs.l in the data, at the end of RAM or past it ***/
+      ext[ext_words] = rnd (3) ? DATA_BASE + (rnd (DATA_SIZE) & ~3) :
+	rnd (2) ? RAM_SIZE - 8 + rnd (12) : IO_BASE + rnd (0x100);
+      ext[ext_words + 1] = ext[ext_words];
+      ext[ext_words] >>= 16;
+      ext_words += 2;
+      return 0x39;
+    case 6:
+    case 7:
+    case 8:
+      return rnd (data_regs);
+    case 9:			/*** d8(An,Xn), anywhere ***/
+      ext[ext_words++] = index_word ();
+      return 0x30 | an;
+    case 10:			/*** d16(PC) ***/
+      ext[ext_words++] = rnd (0x100) - 0x80;
+      return 0x3a;
+    case 11:			/*** d8(PC,Xn) ***/
+      ext[ext_words++] = index_word ();
+      return 0x3b;
+    case 12:
+      if (size)
+	return 0x08 | rnd (8);
+      return rnd (data_regs);
+    default:
+      if (size == 2)
+	ext[ext_words++] = rnd (0x10000);
+      ext[ext_words++] = size ? rnd (0x10000) : rnd (0x100);
+      return 0x3c;
+    }
+}
+
+/*** A memory operand that is written: only A0-A3 and the data, or past RAM ***/
+static int
+dst_ea (void)
+{
+  int ea = src_ea (2, 1);
+
+  while (ea < 0x10)
+    ea = src_ea (2, 1);
+  return ea;
+}
+
+static const unsigned int alu_ops[5] = { 0xD000, 0x9000, 0xC000, 0x8000, 0xB000 };	/* ADD SUB AND OR CMP */
+static const unsigned int alu_mem_ops[5] = { 0xD100, 0x9100, 0xC100, 0x8100, 0xB100 };	/* ADD SUB AND OR EOR */
+static const unsigned int imm_ops[6] = { 0x0000, 0x0200, 0x0400, 0x0600, 0x0A00, 0x0C00 };	/* ORI ANDI SUBI ADDI EORI CMPI */
+static const unsigned int unary_ops[5] = { 0x4000, 0x4200, 0x4400, 0x4600, 0x4A00 };	/* NEGX CLR NEG NOT TST */
+static const unsigned int misc_ops[4] = { 0x4880, 0x48C0, 0x4840, 0x4800 };	/* EXT.W EXT.L SWAP NBCD */
+static const unsigned int move_ops[3] = { 0x1000, 0x3000, 0x2000 };	/* MOVE.B .W .L */
+
+/*** Calls, patched to the subroutines once they are placed ***/
+#define SUBS  3
+#define CALLS 64
+
+static struct
+{
+  unsigned int at;		/*** Word to patch ***/
+  unsigned int base;		/*** 0: absolute, else relative to it ***/
+  int sub;
+} calls[CALLS];
+static int num_calls;
+
+static void
+call (int sub, unsigned int base)
+{
+  if (num_calls < CALLS)
+    {
+      calls[num_calls].at = pc;
+      calls[num_calls].base = base;
+      calls[num_calls].sub = sub;
+      num_calls++;
+    }
+  emit (0);
+}
+
+static void emit_op (int single);
+
+/*** Flags set right before the instruction that uses them ***/
+static void
+emit_compare (void)
+{
+  int x = rnd (data_regs), size = rnd (3), ea;
+
+  switch (rnd (4))
+    {
+    case 0:			/*** CMP <ea>,Dx ***/
+      ea = src_ea (size, 0);
+      emit (0xB000 | x << 9 | size << 6 | ea);
+      emit_ext (ext, ext_words);
+      break;
+    case 1:			/*** CMPA <ea>,A4-A6 ***/
+      size = 1 + rnd (2);
+      ea = src_ea (size, 0);
+      emit (0xB0C0 | (4 + rnd (3)) << 9 | (size == 2) << 8 | ea);
+      emit_ext (ext, ext_words);
+      break;
+    case 2:			/*** TST <ea> ***/
+      ea = src_ea (size, 1);
+      emit (0x4A00 | size << 6 | ea);
+      emit_ext (ext, ext_words);
+      break;
+    default:
+      emit_op (1);
+    }
+}
+
+/*** One instruction; single word ones without branches when asked ***/
+static void
+emit_op (int single)
+{
+  int x = rnd (data_regs), y = rnd (data_regs), size = rnd (3), ea, dst;
+  unsigned int words[2], count, at, loop;
+
+  switch (rnd (single ? 12 : 40))
+    {
+    case 0:			/*** MOVEQ ***/
+      emit (0x7000 | x << 9 | rnd (0x100));
+      break;
+    case 1:			/*** ADD, SUB, AND, OR, CMP Dy,Dx ***/
+      emit (alu_ops[rnd (5)] | x << 9 | size << 6 | y);
+      break;
+    case 2:			/*** ADDX, SUBX, EOR Dx,Dy ***/
+      emit ((rnd (3) == 0 ? 0xB100 : rnd (2) ? 0xD100 : 0x9100) | x << 9 |
+	    size << 6 | y);
+      break;
+    case 3:			/*** NEGX, CLR, NEG, NOT, TST Dy ***/
+      emit (unary_ops[rnd (5)] | size << 6 | y);
+      break;
+    case 4:			/*** EXT.W, EXT.L, SWAP, NBCD Dy ***/
+      emit (misc_ops[rnd (4)] | y);
+      break;
+    case 5:			/*** Shifts and rotates, by count or register ***/
+      emit (0xE000 | x << 9 | rnd (2) << 8 | size << 6 | rnd (2) << 5 |
+	    rnd (4) << 3 | y);
+      break;
+    case 6:			/*** ADDQ, SUBQ Dy, An ***/
+      emit (0x5000 | x << 9 | rnd (2) << 8 | (rnd (4) ? size << 6 | y :
+					      0x88 | (4 + rnd (3))));
+      break;
+    case 7:			/*** Scc Dy ***/
+      emit (0x50C0 | rnd (16) << 8 | y);
+      break;
+    case 8:			/*** ABCD, SBCD, EXG ***/
+      emit ((rnd (3) ? rnd (2) ? 0xC100 : 0x8100 : 0xC140) | x << 9 | y);
+      break;
+    case 9:			/*** BTST, BCHG, BCLR, BSET Dx,Dy ***/
+      emit (0x0100 | x << 9 | rnd (4) << 6 | y);
+      break;
+    case 10:			/*** CMPM (Ay)+,(Ax)+ ***/
+      emit (0xB108 | rnd (4) << 9 | size << 6 | rnd (4));
+      break;
+    case 11:			/*** MOVE Dy,Dx ***/
+      emit (move_ops[size] | x << 9 | y);
+      break;
+    case 12:			/*** ADD, SUB, AND, OR, CMP <ea>,Dx ***/
+      ea = src_ea (size, 0);
+      emit (alu_ops[rnd (5)] | x << 9 | size << 6 | ea);
+      emit_ext (ext, ext_words);
+      break;
+    case 13:			/*** MULU, MULS <ea>,Dx ***/
+      ea = src_ea (1, 0);
+      emit ((rnd (2) ? 0xC0C0 : 0xC1C0) | x << 9 | ea);
+      emit_ext (ext, ext_words);
+      break;
+    case 14:			/*** ORI, ANDI, SUBI, ADDI, EORI, CMPI #imm,<ea> ***/
+      ea = rnd (2) ? y : dst_ea ();
+      emit (imm_ops[rnd (6)] | size << 6 | ea);
+      emit_imm (size);
+      emit_ext (ext, ea < 0x10 ? 0 : ext_words);
+      break;
+    case 15:
+    case 16:			/*** MOVE <ea>,<ea> ***/
+      ea = src_ea (size, 0);
+      count = ext_words;
+      memcpy (words, ext, sizeof (words));
+      dst = rnd (3) ? dst_ea () : x;
+      emit (move_ops[size] | (dst & 7) << 9 | (dst >> 3) << 6 | ea);
+      emit_ext (words, count);
+      emit_ext (ext, dst < 0x10 ? 0 : ext_words);
+      break;
+    case 17:			/*** MOVE.L An,(An)+ / -(An) ***/
+      x = rnd (4);
+      emit (0x2008 | x << 9 | (3 + rnd (2)) << 6 | x);
+      break;
+    case 18:			/*** ADD, SUB, AND, OR, EOR Dx,<ea> ***/
+      ea = dst_ea ();
+      emit (alu_mem_ops[rnd (5)] | x << 9 | size << 6 | ea);
+      emit_ext (ext, ext_words);
+      break;
+    case 19:			/*** NEGX, CLR, NEG, NOT, TST <ea> ***/
+      ea = dst_ea ();
+      emit (unary_ops[rnd (5)] | size << 6 | ea);
+      emit_ext (ext, ext_words);
+      break;
+    case 20:			/*** ADDQ, SUBQ <ea> ***/
+      ea = dst_ea ();
+      emit (0x5000 | x << 9 | rnd (2) << 8 | size << 6 | ea);
+      emit_ext (ext, ext_words);
+      break;
+    case 21:			/*** Scc <ea> ***/
+      ea = dst_ea ();
+      emit (0x50C0 | rnd (16) << 8 | ea);
+      emit_ext (ext, ext_words);
+      break;
+    case 22:			/*** BTST, BCHG, BCLR, BSET #n / Dx,<ea> ***/
+      ea = dst_ea ();
+      if (rnd (2))
+	{
+	  emit (0x0800 | rnd (4) << 6 | ea);
+	  emit (rnd (0x100));
+	}
+      else
+	emit (0x0100 | x << 9 | rnd (4) << 6 | ea);
+      emit_ext (ext, ext_words);
+      break;
+    case 23:			/*** Memory shifts ***/
+      ea = dst_ea ();
+      emit (0xE0C0 | rnd (4) << 9 | rnd (2) << 8 | ea);
+      emit_ext (ext, ext_words);
+      break;
+    case 24:			/*** LEA, MOVEA <ea>,A4-A6 ***/
+      size = 1 + rnd (2);
+      ea = src_ea (size, 0);
+      if ((ea & 0x38) == 0x18 || (ea & 0x38) == 0x20 || ea < 0x10 || ea == 0x3c)
+	emit ((size == 2 ? 0x2040 : 0x3040) | (4 + rnd (3)) << 9 | ea);
+      else
+	emit (0x41C0 | (4 + rnd (3)) << 9 | ea);
+      emit_ext (ext, ext_words);
+      break;
+    case 25:			/*** ADDA, SUBA <ea>,A4-A6 ***/
+      size = 1 + rnd (2);
+      ea = src_ea (size, 0);
+      emit ((rnd (2) ? 0xD0C0 : 0x90C0) | (4 + rnd (3)) << 9 |
+	    (size == 2) << 8 | ea);
+      emit_ext (ext, ext_words);
+      break;
+    case 26:			/*** PEA <ea>, ADDQ.L #4,A7 ***/
+      ea = src_ea (2, 1);
+      if (ea < 0x10 || (ea & 0x38) == 0x18 || (ea & 0x38) == 0x20)
+	ea = 0x10 | (ea & 3);
+      emit (0x4840 | ea);
+      emit_ext (ext, ext_words);
+      emit_op (1);
+      emit (0x588F);
+      break;
+    case 27:			/*** MOVEM.L to -(A7) and back ***/
+      x = rnd (0x100) << 8 | rnd (8) << 1;	/*** D0-D7, A4-A6 ***/
+      emit (0x48E7);
+      emit (x);
+      emit_op (1);
+      emit (0x4CDF);
+      for (y = 0, count = 0; count < 16; count++)	/*** Reversed for (A7)+ ***/
+	y |= (x >> count & 1) << (15 - count);
+      emit (y);
+      break;
+    case 28:			/*** DIVU, DIVS #imm,Dx ***/
+      emit ((rnd (2) ? 0x80FC : 0x81FC) | x << 9);
+      emit (1 + rnd (0xffff));
+      break;
+    case 29:			/*** MOVE #imm,CCR ***/
+      emit (0x44FC);
+      emit (rnd (0x20));
+      break;
+    case 30:			/*** Bcc.W over the next instruction ***/
+      emit_compare ();
+      emit (0x6000 | rnd (16) << 8);
+      emit (4);
+      emit_op (1);
+      break;
+    case 31:			/*** Scc after a compare ***/
+      emit_compare ();
+      ea = rnd (2) ? y : dst_ea ();
+      emit (0x50C0 | rnd (16) << 8 | ea);
+      emit_ext (ext, ea < 0x10 ? 0 : ext_words);
+      break;
+    case 32:			/*** DBcc loop on D7 ***/
+      if (data_regs == 7)
+	break;
+      emit (0x7E00 | rnd (4));	/*** MOVEQ #n,D7 ***/
+      data_regs = 7;
+      loop = pc;
+      emit_compare ();
+      data_regs = 8;
+      emit (0x51CF | rnd (16) << 8);
+      emit (loop - pc);
+      break;
+    case 33:			/*** BSR.W, JSR abs.w, d16(PC), (A4) ***/
+      switch (rnd (4))
+	{
+	case 0:
+	  emit (0x6100);
+	  call (rnd (SUBS), pc);
+	  break;
+	case 1:
+	  emit (0x4EB8);
+	  call (rnd (SUBS), 0);
+	  break;
+	case 2:
+	  emit (0x4EBA);
+	  call (rnd (SUBS), pc);
+	  break;
+	default:
+	  emit (0x49F8);	/*** LEA abs.w,A4 ***/
+	  call (rnd (SUBS), 0);
+	  emit (0x4E94);
+	}
+      break;
+    case 34:			/*** JMP d16(PC) to the next instruction ***/
+      emit (0x4EFA);
+      emit (2);
+      break;
+    case 35:			/*** Patch a MOVEQ further down ***/
+      emit (0x31FC);		/*** MOVE.W #imm,abs.w ***/
+      emit (0x7000 | x << 9 | rnd (0x100));
+      at = pc;
+      emit (0);
+      for (count = rnd (3); count; count--)
+	emit_op (1);
+      patch (at, pc);
+      emit (0x7000 | x << 9 | rnd (0x100));
+      if (rnd (2))
+	emit (0xC140 | rnd (8) << 9 | rnd (8));	/*** EXG, left to the interpreter ***/
+      break;
+    case 36:			/*** MOVE SR,Dy ***/
+      emit (0x40C0 | y);
+      break;
+    default:			/*** Bcc.S or BSR.S over the next instruction ***/
+      if (rnd (2))
+	emit_compare ();
+      emit (0x6002 | rnd (16) << 8);
+      emit_op (1);
+      break;
+    }
+}
+
+static void
+make_program (void)
+{
+  unsigned int body, subs[SUBS];
+  int i, count;
+
+  memset (neogeo_prg_memory, 0, STACK_TOP);
+  for (i = DATA_BASE; i < DATA_BASE + DATA_SIZE; i++)
+    RAM (i) = rnd (0x100);
+  for (i = RAM_SIZE - 8; i < RAM_SIZE + RAM_GUARD; i++)
+    neogeo_prg_memory[i] = rnd (0x100);
+
+  /*** Reset vectors ***/
+  m68k_write_memory_32 (0, STACK_TOP);
+  m68k_write_memory_32 (4, PROG_BASE);
+
+  /*** A0-A3 point into the data, the rest get random values ***/
+  pc = PROG_BASE;
+  for (i = 0; i < 4; i++)
+    {
+      emit (0x207C | i << 9);	/*** MOVEA.L #imm,Ai ***/
+      emit (0);
+      emit (DATA_BASE + 0x800 + i * 0x1000);
+    }
+  for (i = 4; i < 7; i++)
+    {
+      emit (0x207C | i << 9);
+      emit_imm (2);
+    }
+  for (i = 0; i < 8; i++)
+    {
+      emit (0x203C | i << 9);	/*** MOVE.L #imm,Di ***/
+      emit_imm (2);
+    }
+
+  emit (0x44FC);		/*** MOVE #imm,CCR ***/
+  emit (rnd (0x20));
+
+  m68k_write_memory_16 (COUNTER, LOOPS);
+  num_calls = 0;
+  body = pc;
+  for (i = 0; i < PROG_OPS; i++)
+    emit_op (0);
+  emit (0x5378);		/*** SUBQ.W #1,COUNTER ***/
+  emit (COUNTER);
+  emit (0x6600);		/*** BNE.W body ***/
+  emit (body - pc);
+
+  emit (0x4A80);		/*** TST.L D0 ***/
+  end_pc = pc;
+  emit (0x60FE);		/*** BRA.S * ***/
+
+  /*** Subroutines of a few instructions ***/
+  for (i = 0; i < SUBS; i++)
+    {
+      subs[i] = pc;
+      for (count = 1 + rnd (4); count; count--)
+	emit_op (1);
+      emit (0x4E75);		/*** RTS ***/
+    }
+  for (i = 0; i < num_calls; i++)
+    patch (calls[i].at, subs[calls[i].sub] - calls[i].base);
+}
+
+/****************************************************************************
+* Run and compare
+****************************************************************************/
+typedef struct
+{
+  unsigned int reg[18];
+  int cycles;
+  unsigned int io;
+  unsigned char ram[RAM_KEPT];
+} RESULT;
+
+static const char *names[18] = { "D0", "D1", "D2", "D3", "D4", "D5", "D6",
+  "D7", "A0", "A1", "A2", "A3", "A4", "A5", "A6", "A7", "SR", "PC"
+};
+
+/*** The RAM a program can write ***/
+static void
+save_ram (unsigned char *ram)
+{
+  memcpy (ram, neogeo_prg_memory, STACK_TOP);
+  memcpy (ram + STACK_TOP, neogeo_prg_memory + RAM_SIZE - 8, 8);
+}
+
+static void
+load_ram (const unsigned char *ram)
+{
+  memcpy (neogeo_prg_memory, ram, STACK_TOP);
+  memcpy (neogeo_prg_memory + RAM_SIZE - 8, ram + STACK_TOP, 8);
+}
+
+static void
+get_result (RESULT * r)
+{
+  int i;
+
+  for (i = 0; i < 16; i++)
+    r->reg[i] = m68k_get_reg (NULL, M68K_REG_D0 + i);
+  r->reg[16] = m68k_get_reg (NULL, M68K_REG_SR);
+  r->reg[17] = m68k_get_reg (NULL, M68K_REG_PC);
+  r->io = io_hash;
+  save_ram (r->ram);
+}
+
+static int
+compare (const RESULT * interp, const RESULT * drc, const char *where,
+	 int cycles)
+{
+  int failed = 0, i;
+
+  for (i = 0; i < 18; i++)
+    if (interp->reg[i] != drc->reg[i])
+      {
+	printf ("%s: %s %08x interpreter, %08x recompiled\n", where, names[i],
+		interp->reg[i], drc->reg[i]);
+	failed++;
+      }
+  if (cycles && interp->cycles != drc->cycles)
+    {
+      printf ("%s: %d cycles interpreter, %d recompiled\n", where,
+	      interp->cycles, drc->cycles);
+      failed++;
+    }
+  if (interp->io != drc->io)
+    {
+      printf ("%s: writes past RAM differ\n", where);
+      failed++;
+    }
+  for (i = 0; i < RAM_KEPT; i++)
+    if (interp->ram[i] != drc->ram[i])
+      {
+	printf ("%s: RAM at %06x %02x interpreter, %02x recompiled\n", where,
+		i < STACK_TOP ? i : RAM_SIZE - RAM_KEPT + i, interp->ram[i],
+		drc->ram[i]);
+	failed++;
+	break;
+      }
+  return failed;
+}
+
+/*** Every block run once each way, from the same state ***/
+static int
+check_blocks (int p, int *blocks)
+{
+  static m68ki_cpu_core context;
+  static unsigned char ram[RAM_KEPT];
+  static RESULT interp, drc;
+  unsigned int io, block_pc;
+  char where[64];
+  int used = 0, i;
+
+  m68k_drc_enable (0);
+  m68k_pulse_reset ();
+  io_hash = 0;
+
+  while (used < BLOCK_CYCLES && m68k_get_reg (NULL, M68K_REG_PC) != end_pc)
+    {
+      block_pc = m68k_get_reg (NULL, M68K_REG_PC);
+      m68k_get_context (&context);
+      save_ram (ram);
+      io = io_hash;
+
+      m68k_drc_enable (1);
+      drc.cycles = m68k_execute (1);
+      m68k_drc_enable (0);
+      get_result (&drc);
+
+      m68k_set_context (&context);
+      load_ram (ram);
+      io_hash = io;
+      for (interp.cycles = 0; interp.cycles < drc.cycles;)
+	interp.cycles += m68k_execute (1);
+      get_result (&interp);
+
+      sprintf (where, "program %d, block at %06x", p, block_pc);
+      /*** The BRA.S * at the end uses up the slice, whatever is left ***/
+      if (compare (&interp, &drc, where, drc.reg[17] != end_pc))
+	{
+	  for (printf ("%s:", where), i = 0; i < 16; i++)
+	    printf (" %04x", m68k_read_memory_16 (block_pc + i * 2));
+	  printf ("\n");
+	  return 1;
+	}
+      used += drc.cycles;
+      (*blocks)++;
+    }
+  return 0;
+}
+
+/*** The whole program in timeslices, with blocks linked ***/
+static int
+run (RESULT * r, int recompiled, unsigned int slice_seed)
+{
+  unsigned int save = seed;
+  int left = RUN_CYCLES, slice;
+
+  m68k_drc_enable (recompiled);
+  m68k_pulse_reset ();
+  io_hash = 0;
+
+  seed = slice_seed;
+  while (left > 0 && m68k_get_reg (NULL, M68K_REG_PC) != end_pc)
+    {
+      slice = rnd (2) ? 1 + rnd (64) : 1 + rnd (4000);
+      left -= m68k_execute (slice);
+    }
+  seed = save;
+
+  get_result (r);
+  return left > 0;
+}
+
+int
+main (int argc, char *argv[])
+{
+  static RESULT interp, drc;
+  static unsigned char ram[RAM_KEPT];
+  int programs = argc > 1 ? atoi (argv[1]) : 400;
+  int p, failed = 0, blocks = 0, finished = 0;
+  char where[32];
+
+  seed = argc > 2 ? strtoul (argv[2], NULL, 0) : 1;
+
+  neogeo_prg_memory = calloc (1, RAM_SIZE + RAM_GUARD);
+  map_window (neogeo_prg_memory, RAM_SIZE + RAM_GUARD, 1);
+  map_window (m68ki_drc_code, DRC_CODE_SIZE, 0);
+  map_window (&m68ki_drc, sizeof (m68ki_drc), 0);
+  map_window (&m68ki_cpu, sizeof (m68ki_cpu), 0);
+  map_window (m68k_cache_pages, (0x1000000 >> M68K_CACHE_PAGE_SHIFT) + 1, 0);
+  map_window (ppc_stack, sizeof (ppc_stack), 0);
+  m68k_drc_map (0, 0x10000, neogeo_prg_memory, 1);
+  m68k_drc_map (RAM_SIZE - 0x10000, 0x10000,
+		neogeo_prg_memory + RAM_SIZE - 0x10000, 1);
+  m68k_set_cpu_type (M68K_CPU_TYPE_68000);
+  m68k_cache_enable (0);
+
+  for (p = 0; p < programs && failed < 10; p++)
+    {
+      unsigned int slice_seed = rnd (0x10000);
+
+      make_program ();
+      save_ram (ram);
+      stray_writes = 0;
+      failed += check_blocks (p, &blocks);
+      if (stray_writes)
+	{
+	  printf ("program %d: writes to RAM that isn't compared\n", p);
+	  failed++;
+	}
+
+      load_ram (ram);
+      if (!run (&interp, 0, slice_seed))
+	continue;
+      load_ram (ram);
+      if (!run (&drc, 1, slice_seed))
+	{
+	  printf ("program %d: recompiled run didn't finish\n", p);
+	  failed++;
+	  continue;
+	}
+      sprintf (where, "program %d", p);
+      failed += compare (&interp, &drc, where, 0) != 0;
+      finished++;
+    }
+
+  printf ("%d blocks, %d programs run through, %llu PowerPC instructions\n",
+	  blocks, finished, ppc_steps);
+  fprintf (stderr, "%s: %d programs, %s\n", argv[0], p,
+	   failed ? "FAILED" : "ok");
+  m68k_drc_enable (0);
+  return failed != 0;
+}
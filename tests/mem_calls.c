@@ -0,0 +1,216 @@
+/****************************************************************************
+*   NeoCDRX
+*   NeoGeo CD Emulator
+*   NeoCD Redux - Copyright (C) 2007 softdev
+****************************************************************************/
+
+/****************************************************************************
+* Memory handler calls a frame
+*
+* Runs the 68K core over the real memory map with a frame of the I/O a game
+* does at vblank: kick the watchdog, acknowledge the interrupt, read the
+* controllers and the raster line, copy 256 colours with MOVE.L, send
+* 1024 SCB1 words through the VRAM port, 288 SCB2-4 address and data pairs
+* with MOVE.L, and a row of FIX text. The data changes every frame.
+*
+* The VRAM, palette and register hash goes to stdout, the handler calls a
+* frame (from the M68K_PROFILE counts) to stderr. mem_calls_ref is built
+* without the 8 and 32 bit handlers, as before they were added; the hashes
+* must match.
+*
+* Usage: mem_calls [frames] [seed]
+****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "neocdrx.h"
+
+#define CODE      0x1000
+#define BUFFER    0x4000
+#define PAL_LONGS 128
+#define SCB1_WORDS 1024
+#define SCB_LONGS 288
+#define FIX_WORDS 40
+#define STACK_TOP 0x10000
+
+static unsigned long long hash = 1469598103934665603ULL;
+static unsigned int seed;
+static unsigned int pc;
+
+static unsigned int
+rnd (unsigned int n)
+{
+  seed = seed * 1103515245 + 12345;
+  return ((seed >> 8) & 0xffffff) % n;
+}
+
+static void
+hash_bytes (const void *p, int len)
+{
+  const unsigned char *b = p;
+  int i;
+
+  for (i = 0; i < len; i++)
+    hash = (hash ^ b[i]) * 1099511628211ULL;
+}
+
+static void
+emit (unsigned int word)
+{
+  m68k_write_memory_16 (pc, word);
+  pc += 2;
+}
+
+/****************************************************************************
+* The frame
+*
+* Only word immediates, as RAM is kept in host order here: A0 walks the
+* buffers, A1 is the palette, A2/A3 the VRAM address and data ports, and
+* A4-A6 the controllers, set by the caller.
+****************************************************************************/
+static unsigned int
+make_code (void)
+{
+  unsigned int loop;
+
+  pc = CODE;
+  emit (0x1940);		/* MOVE.B D0,1(A4)      watchdog */
+  emit (0x0001);
+  emit (0x357C);		/* MOVE.W #4,12(A2)     IRQ ack */
+  emit (0x0004);
+  emit (0x000C);
+  emit (0x1214);		/* MOVE.B (A4),D1       P1 */
+  emit (0x1415);		/* MOVE.B (A5),D2       P2 */
+  emit (0x1616);		/* MOVE.B (A6),D3       start/select */
+  emit (0x3A2A);		/* MOVE.W 6(A2),D5      raster line */
+  emit (0x0006);
+
+  emit (0x3E3C);		/* MOVE.W #n-1,D7 */
+  emit (PAL_LONGS - 1);
+  loop = pc;
+  emit (0x22D8);		/* MOVE.L (A0)+,(A1)+ */
+  emit (0x51CF);		/* DBRA D7,loop */
+  emit (loop - pc);
+
+  emit (0x357C);		/* MOVE.W #1,4(A2)      modulo */
+  emit (0x0001);
+  emit (0x0004);
+  emit (0x4252);		/* CLR.W (A2)           SCB1 */
+  emit (0x3E3C);
+  emit (SCB1_WORDS - 1);
+  loop = pc;
+  emit (0x3698);		/* MOVE.W (A0)+,(A3) */
+  emit (0x51CF);
+  emit (loop - pc);
+
+  emit (0x3E3C);
+  emit (SCB_LONGS - 1);
+  loop = pc;
+  emit (0x2498);		/* MOVE.L (A0)+,(A2)    address and data */
+  emit (0x51CF);
+  emit (loop - pc);
+
+  emit (0x357C);		/* MOVE.W #32,4(A2)     modulo */
+  emit (0x0020);
+  emit (0x0004);
+  emit (0x34BC);		/* MOVE.W #$7022,(A2)   FIX row */
+  emit (0x7022);
+  emit (0x3E3C);
+  emit (FIX_WORDS - 1);
+  loop = pc;
+  emit (0x3698);		/* MOVE.W (A0)+,(A3) */
+  emit (0x51CF);
+  emit (loop - pc);
+
+  emit (0x60FE);		/* BRA.S * */
+  return pc - 2;
+}
+
+/*** New data for a frame, written the width the frame reads it ***/
+static void
+make_data (void)
+{
+  unsigned int a = BUFFER;
+  int i;
+
+  for (i = 0; i < PAL_LONGS; i++, a += 4)
+    m68k_write_memory_32 (a, (rnd (0x10000) << 16) | rnd (0x10000));
+  for (i = 0; i < SCB1_WORDS; i++, a += 2)
+    m68k_write_memory_16 (a, rnd (0x10000));
+  for (i = 0; i < SCB_LONGS; i++, a += 4)
+    m68k_write_memory_32 (a, ((0x8000 + (i / 96) * 0x200 + i % 96) << 16) |
+			  rnd (0x10000));
+  for (i = 0; i < FIX_WORDS; i++, a += 2)
+    m68k_write_memory_16 (a, rnd (0x10000));
+}
+
+/*** Handler calls in the memory profile ***/
+static unsigned int
+count_calls (void)
+{
+  FILE *fp = tmpfile ();
+  char line[256];
+  unsigned int total = 0, n;
+
+  neogeo_memory_profile (fp);
+  rewind (fp);
+  while (fgets (line, sizeof (line), fp))
+    if (!strncmp (line, "calls;", 6) && sscanf (strrchr (line, ' '), "%u", &n))
+      total += n;
+  fclose (fp);
+
+  return total;
+}
+
+int
+main (int argc, char *argv[])
+{
+  int frames = argc > 1 ? atoi (argv[1]) : 600;
+  unsigned int idle, reg, calls = 0;
+  int f, i;
+
+  seed = argc > 2 ? atoi (argv[2]) : 1;
+
+  neogeo_prg_memory = calloc (1, 0x200000);
+  neogeo_rom_memory = calloc (1, 0x80000);
+  initialise_memmap ();
+  video_init ();
+
+  m68k_write_memory_32 (0, STACK_TOP);
+  m68k_write_memory_32 (4, CODE);
+  idle = make_code ();
+  m68k_set_cpu_type (M68K_CPU_TYPE_68000);
+  m68k_pulse_reset ();
+
+  for (f = 0; f < frames; f++)
+    {
+      make_data ();
+
+      m68k_set_reg (M68K_REG_A0, BUFFER);
+      m68k_set_reg (M68K_REG_A1, 0x400000 + rnd (8) * 0x200);
+      m68k_set_reg (M68K_REG_A2, 0x3c0000);
+      m68k_set_reg (M68K_REG_A3, 0x3c0002);
+      m68k_set_reg (M68K_REG_A4, 0x300000);
+      m68k_set_reg (M68K_REG_A5, 0x340000);
+      m68k_set_reg (M68K_REG_A6, 0x380000);
+      m68k_set_reg (M68K_REG_PC, CODE);
+
+      neogeo_memory_profile_reset ();
+      while (m68k_get_reg (NULL, M68K_REG_PC) != idle)
+	m68k_execute (10000);
+      calls += count_calls ();
+
+      for (i = 0; i < 8; i++)
+	{
+	  reg = m68k_get_reg (NULL, M68K_REG_D0 + i);
+	  hash_bytes (&reg, sizeof (reg));
+	}
+    }
+
+  hash_bytes (video_vidram, 0x20000);
+  hash_bytes (video_paletteram_ng, 0x2000);
+  printf ("hash %016llx\n", hash);
+  fprintf (stderr, "%s: %d frames, %u handler calls a frame\n", argv[0],
+	   frames, calls / frames);
+  return 0;
+}
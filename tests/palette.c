@@ -0,0 +1,243 @@
+/****************************************************************************
+*   NeoCDRX
+*   NeoGeo CD Emulator
+*   NeoCD Redux - Copyright (C) 2007 softdev
+****************************************************************************/
+
+/****************************************************************************
+* Palette check
+*
+* First the colour LUT is compared with one built a colour at a time with
+* pow, as it was before the ramps, at several gammas.
+*
+* Then random byte, word and long palette writes, CD fills and copies,
+* bank switches and gamma changes go through the 68000 memory map, while
+* the test keeps its own copy of both banks. After each frame's
+* video_update_palette, both banks must hold exactly those colours, and
+* their RGB565 copies what converting every colour at once would give.
+*
+* Usage: palette [frames] [seed]
+****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "neocdrx.h"
+
+#define PAL_TYPE  0x06
+#define COPY_SRC  0x100000
+
+static const double gammas[] = { 1.0, 2.2, 0.5, 1.4, 3.0 };
+
+static unsigned short ng[2][4096];
+static unsigned short ref_lut[32768];
+static int bank;
+
+static unsigned int seed;
+
+static unsigned int
+rnd (unsigned int n)
+{
+  seed = seed * 1103515245 + 12345;
+  return ((seed >> 8) & 0xffffff) % n;
+}
+
+/****************************************************************************
+* Reference LUT, one entry at a time
+****************************************************************************/
+static void
+ref_precalc_lut (double gamma)
+{
+  int ndx, rr, rg, rb;
+
+  for (rr = 0; rr < 32; rr++)
+    for (rg = 0; rg < 32; rg++)
+      for (rb = 0; rb < 32; rb++)
+	{
+	  ndx = ((rr & 1) << 14) | ((rg & 1) << 13) | ((rb & 1) << 12) |
+	    ((rr & 30) << 7) | ((rg & 30) << 3) | ((rb & 30) >> 1);
+	  ref_lut[ndx] = (int) (31 * pow ((double) rb / 31, 1 / gamma)) |
+	    (int) (63 * pow ((double) rg / 31, 1 / gamma)) << 5 |
+	    (int) (31 * pow ((double) rr / 31, 1 / gamma)) << 11;
+	}
+}
+
+static int
+check_lut (double gamma)
+{
+  int i;
+
+  gamma_correction = gamma;
+  video_precalc_lut ();
+  ref_precalc_lut (gamma);
+
+  for (i = 0; i < 32768; i++)
+    if (video_color_lut[i] != ref_lut[i])
+      {
+	printf ("gamma %.1f: colour %04x is %04x, not %04x\n", gamma, i,
+		video_color_lut[i], ref_lut[i]);
+	return 0;
+      }
+
+  return 1;
+}
+
+/****************************************************************************
+* CD uploads, through the hardware registers
+****************************************************************************/
+static void
+upload_regs (int reg, unsigned int value)
+{
+  m68k_write_memory_16 (0xff0000 + reg, value >> 16);
+  m68k_write_memory_16 (0xff0002 + reg, value & 0xffff);
+}
+
+static void
+upload_fill (int offset, int count, unsigned short colour)
+{
+  int i;
+
+  upload_regs (0x64, 0x400000 + offset * 2);
+  m68k_write_memory_16 (0xff006c, colour);
+  upload_regs (0x70, count);
+  m68k_write_memory_16 (0xff0060, 0x40);
+
+  for (i = 0; i < count; i++)
+    ng[bank][(offset + i) & 0xfff] = colour;
+}
+
+/*** The length counts words, but twice as many are copied ***/
+static void
+upload_copy (int offset, int length)
+{
+  unsigned short colour;
+  int i;
+
+  for (i = 0; i < length * 2; i++)
+    {
+      colour = rnd (0x10000);
+      m68k_write_memory_16 (COPY_SRC + i * 2, colour);
+      ng[bank][(offset + i) & 0xfff] = colour;
+    }
+
+  m68k_write_memory_8 (0x108000 + 0x7eda, PAL_TYPE);
+  upload_regs (0x64, COPY_SRC);
+  upload_regs (0x68, 0x400000 + offset * 2);
+  upload_regs (0x70, length);
+  m68k_write_memory_16 (0xff0060, 0x40);
+}
+
+/****************************************************************************
+* One frame of changes
+****************************************************************************/
+static void
+emulate (void)
+{
+  unsigned int address, value;
+  int i, n, offset, shift;
+
+  n = rnd (4) ? rnd (40) : rnd (2000);
+  for (i = 0; i < n; i++)
+    {
+      address = 0x400000 + (rnd (0x200000) << 1);
+      offset = (address >> 1) & 0xfff;
+      value = rnd (0x10000);
+
+      switch (rnd (8))
+	{
+	case 0:
+	  shift = rnd (2) << 3;
+	  m68k_write_memory_8 (address | !shift, value & 0xff);
+	  ng[bank][offset] =
+	    (ng[bank][offset] & ~(0xff << shift)) | ((value & 0xff) << shift);
+	  break;
+	case 1:
+	  value = (value << 16) | rnd (0x10000);
+	  m68k_write_memory_32 (address, value);
+	  ng[bank][offset] = value >> 16;
+	  ng[bank][(offset + 1) & 0xfff] = value & 0xffff;
+	  break;
+	default:
+	  m68k_write_memory_16 (address, value);
+	  ng[bank][offset] = value;
+	  break;
+	}
+    }
+
+  if (rnd (20) == 0)
+    upload_fill (rnd (4096), 1 + rnd (rnd (8) ? 64 : 5000), rnd (0x10000));
+  if (rnd (20) == 0)
+    upload_copy (rnd (4096), 1 + rnd (rnd (8) ? 32 : 2500));
+
+  if (rnd (30) == 0)
+    {
+      bank = rnd (2);
+      m68k_write_memory_16 (bank ? 0x3a001e : 0x3a000e, 0);
+    }
+
+  if (rnd (200) == 0)
+    {
+      gamma_correction = gammas[rnd (sizeof (gammas) / sizeof (double))];
+      video_precalc_lut ();
+    }
+}
+
+static int
+check_banks (int frame)
+{
+  unsigned short *bank_ng[2] = { video_palette_bank0_ng,
+    video_palette_bank1_ng
+  };
+  unsigned short *bank_pc[2] = { video_palette_bank0_pc,
+    video_palette_bank1_pc
+  };
+  int b, i;
+
+  for (b = 0; b < 2; b++)
+    for (i = 0; i < 4096; i++)
+      {
+	if (bank_ng[b][i] != ng[b][i])
+	  {
+	    printf ("frame %d: bank %d colour %03x is %04x, not %04x\n",
+		    frame, b, i, bank_ng[b][i], ng[b][i]);
+	    return 0;
+	  }
+	if (bank_pc[b][i] != video_color_lut[ng[b][i] & 0x7fff])
+	  {
+	    printf ("frame %d: bank %d RGB565 %03x is %04x, not %04x\n",
+		    frame, b, i, bank_pc[b][i],
+		    video_color_lut[ng[b][i] & 0x7fff]);
+	    return 0;
+	  }
+      }
+
+  return 1;
+}
+
+int
+main (int argc, char *argv[])
+{
+  int frames = argc > 1 ? atoi (argv[1]) : 2000;
+  int f, i;
+
+  seed = argc > 2 ? atoi (argv[2]) : 1;
+
+  for (i = 0; i < sizeof (gammas) / sizeof (double); i++)
+    if (!check_lut (gammas[i]))
+      return 1;
+
+  neogeo_prg_memory = calloc (1, 0x200000);
+  initialise_memmap ();
+  video_init ();
+
+  for (f = 0; f < frames; f++)
+    {
+      emulate ();
+      video_update_palette ();
+      if (!check_banks (f))
+	return 1;
+    }
+
+  printf ("%s: %d gammas, %d frames, ok\n", argv[0], i, frames);
+  return 0;
+}
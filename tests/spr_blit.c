@@ -0,0 +1,205 @@
+/****************************************************************************
+*   NeoCDRX
+*   NeoGeo CD Emulator
+*   NeoCD Redux - Copyright (C) 2007 softdev
+****************************************************************************/
+
+/****************************************************************************
+* Sprite blitter check
+*
+* Draws random rows of decoded sprite data with every generated blitter, at
+* every x zoom, with and without x flip, y flip and opacity, over random row
+* skips and positions, the screen edges included. Each tile is compared
+* with a reference that draws one pixel at a time, taking the source pixel
+* of column x at zoom z as x * 16 / (z + 1), the hardware's even spread.
+*
+* Both are then timed over the same tiles, as a benchmark of the blitters.
+*
+* Usage: spr_blit [tiles] [seed]
+****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ogc/lwp_watchdog.h>
+#include "../src/video/video.c"
+
+#define SPR_BYTES  0x10000
+#define BENCH      20
+
+static unsigned short screen[2][224][320];
+static unsigned short *ref_line[224];
+static unsigned short pal[16];
+static unsigned char *spr;
+
+static unsigned int seed;
+
+static unsigned int
+rnd (unsigned int n)
+{
+  seed = seed * 1103515245 + 12345;
+  return ((seed >> 8) & 0xffffff) % n;
+}
+
+/****************************************************************************
+* Random rows, each word empty, solid, random, or random with holes
+****************************************************************************/
+static unsigned int
+rnd_word (void)
+{
+  unsigned int w = 0;
+  int k;
+
+  switch (rnd (4))
+    {
+    case 0:
+      return 0;
+    case 1:
+      return 0x11111111 * (1 + rnd (15));
+    case 2:
+      return (rnd (0x10000) << 16) | rnd (0x10000);
+    default:
+      for (k = 0; k < 32; k += 4)
+	if (rnd (3) == 0)
+	  w |= (1 + rnd (15)) << k;
+      return w;
+    }
+}
+
+/****************************************************************************
+* Reference
+****************************************************************************/
+typedef struct
+{
+  int zoom, flip, opaque, dy, sx, sy, ey;
+  unsigned int start;
+  unsigned char skip[16];
+} TILE;
+
+static void
+ref_blit (const TILE * t, unsigned short *const *lines)
+{
+  const unsigned int *row;
+  unsigned int p = t->start;
+  int x, y, l, pix, col;
+
+  for (y = t->sy, l = 0; y <= t->ey; y++, l++)
+    {
+      p += t->skip[l] * t->dy;
+      row = (const unsigned int *) (spr + p);
+
+      for (x = 0; x <= t->zoom; x++)
+	{
+	  if (t->sx + x < 0 || t->sx + x >= 320)
+	    continue;
+
+	  pix = x * 16 / (t->zoom + 1);
+	  if (t->flip)
+	    pix = 15 - pix;
+
+	  col = (row[pix >> 3] >> ((pix & 7) * 4)) & 15;
+	  if (col || t->opaque)
+	    lines[y][t->sx + x] = pal[col];
+	}
+    }
+}
+
+static void
+new_blit (const TILE * t)
+{
+  SPRBLITTER blit = spr_blitter[t->opaque][t->flip][t->zoom];
+
+  if (t->sx < 0 || t->sx > 320 - 16)
+    video_blit_spr_edge (blit, spr + t->start, t->dy, pal, t->sx, t->sy,
+			 t->ey, t->skip);
+  else
+    blit (spr + t->start, t->dy, pal, t->sx, t->sy, t->ey, t->skip,
+	  video_line_ptr);
+}
+
+static void
+rnd_tile (TILE * t)
+{
+  int i;
+
+  t->zoom = rnd (16);
+  t->flip = rnd (2);
+  t->opaque = rnd (4) == 0;
+  t->dy = rnd (2) ? 8 : -8;
+  if (rnd (8))
+    t->sx = rnd (320 - 15);
+  else
+    t->sx = rnd (2) ? -15 + rnd (15) : 305 + rnd (15);
+  t->sy = rnd (224);
+  t->ey = t->sy + rnd (16);
+  if (t->ey > 223)
+    t->ey = 223;
+  t->start = (SPR_BYTES / 2) & ~7;
+
+  for (i = 0; i < 16; i++)
+    t->skip[i] = rnd (4) ? 1 : rnd (3);
+}
+
+int
+main (int argc, char *argv[])
+{
+  int tiles = argc > 1 ? atoi (argv[1]) : 20000;
+  TILE *t;
+  unsigned long long start;
+  double blit_ns, ref_ns;
+  int i, n, rows = 0;
+
+  seed = argc > 2 ? atoi (argv[2]) : 1;
+
+  spr = malloc (SPR_BYTES);
+  for (i = 0; i < SPR_BYTES; i += 4)
+    *(unsigned int *) (spr + i) = rnd_word ();
+  for (i = 0; i < 16; i++)
+    pal[i] = 0x8000 | rnd (0x8000);
+  for (i = 0; i < 224; i++)
+    {
+      video_line_ptr[i] = screen[0][i];
+      ref_line[i] = screen[1][i];
+    }
+
+  t = malloc (tiles * sizeof (TILE));
+  for (n = 0; n < tiles; n++)
+    {
+      rnd_tile (&t[n]);
+      rows += t[n].ey - t[n].sy + 1;
+
+      /*** A fresh area of the screen, the same on both ***/
+      for (i = 0; i < 16 && t[n].sy + i < 224; i++)
+	{
+	  screen[0][t[n].sy + i][rnd (320)] = rnd (0x10000);
+	  memcpy (screen[1][t[n].sy + i], screen[0][t[n].sy + i], 640);
+	}
+
+      new_blit (&t[n]);
+      ref_blit (&t[n], ref_line);
+
+      if (memcmp (screen[0], screen[1], sizeof (screen[0])))
+	{
+	  printf ("tile %d: zoom %d%s%s%s at %d,%d-%d differs\n", n,
+		  t[n].zoom, t[n].flip ? " flip x" : "",
+		  t[n].dy < 0 ? " flip y" : "", t[n].opaque ? " opaque" : "",
+		  t[n].sx, t[n].sy, t[n].ey);
+	  return 1;
+	}
+    }
+
+  start = gettime ();
+  for (i = 0; i < BENCH; i++)
+    for (n = 0; n < tiles; n++)
+      new_blit (&t[n]);
+  blit_ns = diff_usec (start, gettime ()) * 1000.0 / BENCH / rows;
+
+  start = gettime ();
+  for (i = 0; i < BENCH; i++)
+    for (n = 0; n < tiles; n++)
+      ref_blit (&t[n], video_line_ptr);
+  ref_ns = diff_usec (start, gettime ()) * 1000.0 / BENCH / rows;
+
+  printf ("%s: %d tiles, ok, %.1f ns a row (%.1f one pixel at a time)\n",
+	  argv[0], tiles, blit_ns, ref_ns);
+  return 0;
+}
@@ -0,0 +1,198 @@
+/****************************************************************************
+*   NeoCDRX
+*   NeoGeo CD Emulator
+*   NeoCD Redux - Copyright (C) 2007 softdev
+****************************************************************************/
+
+/****************************************************************************
+* Sprite decoder check
+*
+* Decodes random tiles with neogeo_decode_spr, in place, and with
+* neogeo_copy_spr, from a separate buffer, at random tile offsets and byte
+* lengths. Both are compared with a reference that builds each pixel one
+* bitplane bit at a time, along with the usage byte of every tile.
+*
+* Usage: spr_decode [rounds] [seed]
+****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "neocdrx.h"
+
+#define SPR_SIZE  0x100000
+#define TILES     (SPR_SIZE >> 7)
+#define MAX_LEN   0x4000
+
+static unsigned char *mem, *ref;
+static unsigned char refusage[TILES];
+static unsigned char src[MAX_LEN];
+
+static unsigned int seed;
+
+static unsigned int
+rnd (unsigned int n)
+{
+  seed = seed * 1103515245 + 12345;
+  return ((seed >> 8) & 0xffffff) % n;
+}
+
+/****************************************************************************
+* Random tiles, with some empty and some solid ones, and a mix of zero
+* bytes so that part opaque rows turn up as well.
+****************************************************************************/
+static void
+fill_tiles (unsigned char *p, int len)
+{
+  int i, kind = 0;
+
+  for (i = 0; i < len; i++)
+    {
+      if ((i & 127) == 0)
+	kind = rnd (4);
+
+      switch (kind)
+	{
+	case 0:
+	  p[i] = 0;
+	  break;
+	case 1:
+	  p[i] = 0xff;
+	  break;
+	case 2:
+	  p[i] = rnd (256);
+	  break;
+	default:
+	  p[i] = rnd (3) ? 0 : rnd (256);
+	  break;
+	}
+    }
+}
+
+/****************************************************************************
+* Reference
+*
+* A row is eight pixels from four plane bytes, the first two tile halves
+* swapped. Plane bytes 1, 0, 3 and 2 give bits 0 to 3 of a pixel, and bit k
+* of each plane belongs to pixel k, which sits in bits 4k to 4k + 3.
+****************************************************************************/
+static unsigned int
+ref_row (const unsigned char *s)
+{
+  unsigned int row = 0, pix;
+  int k;
+
+  for (k = 0; k < 8; k++)
+    {
+      pix = ((s[1] >> k) & 1) | (((s[0] >> k) & 1) << 1) |
+	(((s[3] >> k) & 1) << 2) | (((s[2] >> k) & 1) << 3);
+      row |= pix << (k << 2);
+    }
+
+  return row;
+}
+
+static void
+ref_decode (unsigned int offset, unsigned int length)
+{
+  unsigned char tile[128];
+  unsigned int *dst, t, j, k;
+  int opaque;
+
+  for (t = 0; t < (length + 127) >> 7; t++)
+    {
+      dst = (unsigned int *) (ref + offset + (t << 7));
+      memcpy (tile, dst, 128);
+      opaque = 0;
+
+      for (j = 0; j < 16; j++)
+	{
+	  dst[j * 2] = ref_row (tile + 64 + j * 4);
+	  dst[j * 2 + 1] = ref_row (tile + j * 4);
+	}
+
+      for (j = 0; j < 32; j++)
+	for (k = 0; k < 32; k += 4)
+	  opaque += ((dst[j] >> k) & 15) != 0;
+
+      refusage[(offset >> 7) + t] = opaque ? (opaque == 256 ? 1 : 2) : 0;
+    }
+}
+
+/****************************************************************************
+* check
+****************************************************************************/
+static int
+check (int round, const char *how, unsigned int offset, unsigned int length)
+{
+  unsigned int i;
+
+  for (i = 0; i < SPR_SIZE; i++)
+    {
+      if (mem[i] != ref[i])
+	{
+	  printf ("round %d: %s %06x+%x, byte %06x is %02x, not %02x\n",
+		  round, how, offset, length, i, mem[i], ref[i]);
+	  return 0;
+	}
+    }
+
+  for (i = 0; i < TILES; i++)
+    {
+      if (video_spr_usage[i] != refusage[i])
+	{
+	  printf ("round %d: %s %06x+%x, tile %05x usage %d, not %d\n",
+		  round, how, offset, length, i, video_spr_usage[i],
+		  refusage[i]);
+	  return 0;
+	}
+    }
+
+  return 1;
+}
+
+int
+main (int argc, char *argv[])
+{
+  int rounds = argc > 1 ? atoi (argv[1]) : 2000;
+  unsigned int offset, length;
+  int r;
+
+  seed = argc > 2 ? atoi (argv[2]) : 1;
+
+  mem = malloc (SPR_SIZE + MAX_LEN);
+  ref = malloc (SPR_SIZE + MAX_LEN);
+  initialise_memmap ();
+
+  fill_tiles (mem, SPR_SIZE);
+  memcpy (ref, mem, SPR_SIZE);
+  memset (video_spr_usage, 0, TILES);
+  memset (refusage, 0, TILES);
+
+  for (r = 0; r < rounds; r++)
+    {
+      offset = rnd (TILES - (MAX_LEN >> 7)) << 7;
+      length = 1 + rnd (MAX_LEN);
+
+      if (rnd (2))
+	{
+	  fill_tiles (mem + offset, length);
+	  memcpy (ref + offset, mem + offset, length);
+	  neogeo_decode_spr (mem, offset, length);
+	  ref_decode (offset, length);
+	  if (!check (r, "decode", offset, length))
+	    return 1;
+	}
+      else
+	{
+	  fill_tiles (src, length);
+	  neogeo_copy_spr (mem, offset, src, length);
+	  memcpy (ref + offset, src, length);
+	  ref_decode (offset, length);
+	  if (!check (r, "copy", offset, length))
+	    return 1;
+	}
+    }
+
+  printf ("%s: %d rounds, ok\n", argv[0], rounds);
+  return 0;
+}
@@ -0,0 +1,234 @@
+/****************************************************************************
+*   NeoCDRX
+*   NeoGeo CD Emulator
+*   NeoCD Redux - Copyright (C) 2007 softdev
+****************************************************************************/
+
+/****************************************************************************
+* Z80 idle loop skip check
+*
+* Runs a small sound driver on the real Z80 ports, YM2610 and mixer, with
+* the CPU scheduled as neogeo_runframe does and sound commands sent from the
+* 68000 side at random points of the frame. The driver plays an FM and an
+* SSG note per command and waits on a RAM flag set by the NMI, on the timer
+* A flag under DI and in HALT. Between those it also has a wait loop that
+* changes registers, which must not be skipped.
+*
+* The mixer output of every frame is hashed sample for sample, along with
+* the Z80 RAM, which holds R as the last NMI saw it. Built with
+* IDLE_LOOP_SKIP on and off, the two hashes must match.
+*
+* Usage: z80_idle [frames] [seed]
+****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "neocdrx.h"
+#include "mixer.h"
+#include "sound.h"
+
+#define SLICES   264
+#define Z80FRAME (4000000 / 60)
+
+extern CPU CPU_Z80;
+
+static const UINT8 vectors[] = {
+  0xc3, 0x00, 0x01,		/* 0000 jp $0100 */
+};
+
+static const UINT8 irq[] = {
+  0xc3, 0x68, 0x01,		/* 0038 jp $0168 */
+};
+
+static const UINT8 nmi[] = {
+  0xc3, 0x89, 0x01,		/* 0066 jp $0189 */
+};
+
+static const UINT8 driver[] = {
+  0x31, 0x00, 0xf8,		/* 0100 ld sp,$f800 */
+  0xed, 0x56,			/* 0103 im 1 */
+  0x21, 0x00, 0x02,		/* 0105 ld hl,$0200 */
+  0xcd, 0x54, 0x01,		/* 0108 call $0154 */
+  0xfb,				/* 010b ei */
+  0x3a, 0x00, 0x80,		/* 010c ld a,($8000)  ; wait for a command */
+  0xb7,				/* 010f or a */
+  0x28, 0xfa,			/* 0110 jr z,$010c */
+  0xaf,				/* 0112 xor a */
+  0x32, 0x00, 0x80,		/* 0113 ld ($8000),a */
+  0x3a, 0x01, 0x80,		/* 0116 ld a,($8001) */
+  0x5f,				/* 0119 ld e,a */
+  0x16, 0xa1,			/* 011a ld d,$a1      ; FM 1 frequency */
+  0xcd, 0x61, 0x01,		/* 011c call $0161 */
+  0x11, 0xf1, 0x28,		/* 011f ld de,$28f1   ; FM 1 key on */
+  0xcd, 0x61, 0x01,		/* 0122 call $0161 */
+  0x3a, 0x01, 0x80,		/* 0125 ld a,($8001) */
+  0x5f,				/* 0128 ld e,a */
+  0x16, 0x00,			/* 0129 ld d,$00      ; SSG A tone */
+  0xcd, 0x61, 0x01,		/* 012b call $0161 */
+  0xf3,				/* 012e di */
+  0xdb, 0x04,			/* 012f in a,($04)    ; wait for timer A */
+  0xe6, 0x01,			/* 0131 and $01 */
+  0x28, 0xfa,			/* 0133 jr z,$012f */
+  0x11, 0x3f, 0x27,		/* 0135 ld de,$273f   ; reset the timer flags */
+  0xcd, 0x61, 0x01,		/* 0138 call $0161 */
+  0x11, 0x01, 0x28,		/* 013b ld de,$2801   ; FM 1 key off */
+  0xcd, 0x61, 0x01,		/* 013e call $0161 */
+  0xfb,				/* 0141 ei */
+  0x03,				/* 0142 inc bc        ; counts while waiting */
+  0x3a, 0x05, 0x80,		/* 0143 ld a,($8005)  ; for the next IRQ */
+  0xb7,				/* 0146 or a */
+  0x28, 0xf9,			/* 0147 jr z,$0142 */
+  0xaf,				/* 0149 xor a */
+  0x32, 0x05, 0x80,		/* 014a ld ($8005),a */
+  0xed, 0x43, 0x06, 0x80,	/* 014d ld ($8006),bc */
+  0x76,				/* 0151 halt */
+  0x18, 0xb8,			/* 0152 jr $010c */
+  0x7e,				/* 0154 ld a,(hl)     ; register, value pairs */
+  0xfe, 0xff,			/* 0155 cp $ff */
+  0xc8,				/* 0157 ret z */
+  0x57,				/* 0158 ld d,a */
+  0x23,				/* 0159 inc hl */
+  0x5e,				/* 015a ld e,(hl) */
+  0x23,				/* 015b inc hl */
+  0xcd, 0x61, 0x01,		/* 015c call $0161 */
+  0x18, 0xf3,			/* 015f jr $0154 */
+  0x7a,				/* 0161 ld a,d        ; YM2610 register d = e */
+  0xd3, 0x04,			/* 0162 out ($04),a */
+  0x7b,				/* 0164 ld a,e */
+  0xd3, 0x05,			/* 0165 out ($05),a */
+  0xc9,				/* 0167 ret */
+  0xf5,				/* 0168 push af       ; timer IRQ */
+  0xd5,				/* 0169 push de */
+  0x11, 0x3f, 0x27,		/* 016a ld de,$273f */
+  0xcd, 0x61, 0x01,		/* 016d call $0161 */
+  0x3a, 0x04, 0x80,		/* 0170 ld a,($8004) */
+  0x3c,				/* 0173 inc a */
+  0x32, 0x04, 0x80,		/* 0174 ld ($8004),a */
+  0xe6, 0x0f,			/* 0177 and $0f */
+  0x5f,				/* 0179 ld e,a */
+  0x16, 0x08,			/* 017a ld d,$08      ; SSG A volume */
+  0xcd, 0x61, 0x01,		/* 017c call $0161 */
+  0x3e, 0x01,			/* 017f ld a,$01 */
+  0x32, 0x05, 0x80,		/* 0181 ld ($8005),a */
+  0xd1,				/* 0184 pop de */
+  0xf1,				/* 0185 pop af */
+  0xfb,				/* 0186 ei */
+  0xed, 0x4d,			/* 0187 reti */
+  0xf5,				/* 0189 push af       ; sound command */
+  0xdb, 0x00,			/* 018a in a,($00) */
+  0x32, 0x01, 0x80,		/* 018c ld ($8001),a */
+  0x3e, 0x01,			/* 018f ld a,$01 */
+  0x32, 0x00, 0x80,		/* 0191 ld ($8000),a */
+  0xd3, 0x0c,			/* 0194 out ($0c),a */
+  0xed, 0x5f,			/* 0196 ld a,r */
+  0x32, 0x10, 0x80,		/* 0198 ld ($8010),a */
+  0xf1,				/* 019b pop af */
+  0xed, 0x45,			/* 019c retn */
+};
+
+static const UINT8 ymtab[] = {
+  0x00, 0x80, 0x01, 0x01,	/* 0200 SSG A tone */
+  0x07, 0x3e, 0x08, 0x0c,	/* 0204 SSG A alone, volume */
+  0x31, 0x01, 0x35, 0x01, 0x39, 0x01, 0x3d, 0x01,	/* 0208 FM 1 multiple */
+  0x41, 0x20, 0x45, 0x20, 0x49, 0x20, 0x4d, 0x20,	/* 0210 level */
+  0x51, 0x1f, 0x55, 0x1f, 0x59, 0x1f, 0x5d, 0x1f,	/* 0218 attack */
+  0x61, 0x05, 0x65, 0x05, 0x69, 0x05, 0x6d, 0x05,	/* 0220 decay */
+  0x71, 0x02, 0x75, 0x02, 0x79, 0x02, 0x7d, 0x02,	/* 0228 sustain */
+  0x81, 0x11, 0x85, 0x11, 0x89, 0x11, 0x8d, 0x11,	/* 0230 release */
+  0xa5, 0x22, 0xa1, 0x69,	/* 0238 FM 1 block, frequency */
+  0xb1, 0x07, 0xb5, 0xc0,	/* 023c algorithm 7, both sides */
+  0x24, 0xc0, 0x25, 0x00,	/* 0240 timer A */
+  0x26, 0xe0, 0x27, 0x3f,	/* 0244 timer B, run both with IRQs */
+  0xff,				/* 0248 end */
+};
+
+static unsigned long long hash = 1469598103934665603ULL;
+static unsigned int seed;
+
+static void
+mix (unsigned int v)
+{
+  hash = (hash ^ v) * 1099511628211ULL;
+}
+
+static unsigned int
+rnd (unsigned int n)
+{
+  seed = seed * 1103515245 + 12345;
+  return ((seed >> 8) & 0xffffff) % n;
+}
+
+int
+main (int argc, char *argv[])
+{
+  int frames = argc > 1 ? atoi (argv[1]) : 3000;
+  int f, s, cycles, cmd_at, loud = 0;
+  long long idle = 0, total = 0;
+  short *sample = (short *) mp3buffer;
+  int i;
+
+  seed = argc > 2 ? atoi (argv[2]) : 1;
+
+  neogeo_pcm_memory = calloc (1, 0x100000);
+  initialise_memmap ();
+  mixer_init ();
+  init_sdl_audio ();
+
+  memcpy (subcpu_memspace, vectors, sizeof (vectors));
+  memcpy (subcpu_memspace + 0x38, irq, sizeof (irq));
+  memcpy (subcpu_memspace + 0x66, nmi, sizeof (nmi));
+  memcpy (subcpu_memspace + 0x100, driver, sizeof (driver));
+  memcpy (subcpu_memspace + 0x200, ymtab, sizeof (ymtab));
+  mz80_init ();
+
+  for (f = 0; f < frames; f++)
+    {
+      CPU_Z80.cycles_done = 0;
+      z80_idle_cycles = 0;
+      cmd_at = rnd (2) ? rnd (SLICES) : -1;
+
+      /*** As neogeo_runframe ***/
+      for (s = SLICES - 1; s >= 0; s--)
+	{
+	  if (s == cmd_at)
+	    m68k_write_memory_16 (0x320000, (1 + rnd (255)) << 8);
+
+	  if (CPU_Z80.cycles_done < Z80FRAME)
+	    {
+	      if (s)
+		cycles = mz80exec (Z80FRAME / SLICES);
+	      else
+		cycles = mz80exec (Z80FRAME - CPU_Z80.cycles_done);
+
+	      CPU_Z80.cycles_done += cycles;
+	      CPU_Z80.total_cycles += cycles;
+	      my_timer ();
+	    }
+	}
+
+      idle += z80_idle_cycles;
+      total += CPU_Z80.cycles_done;
+
+      /*** No CD audio ***/
+      memset (mp3buffer, 0, 3200);
+      mixer_update_audio ();
+
+      for (i = 0; i < 1600; i++)
+	mix ((unsigned short) sample[i]);
+
+      for (i = 0; i < 1600; i++)
+	if (sample[i])
+	  {
+	    loud++;
+	    break;
+	  }
+    }
+
+  for (i = 0; i < 0x10000; i++)
+    mix (subcpu_memspace[i]);
+
+  printf ("hash %016llx\n", hash);
+  fprintf (stderr, "%s: %d frames, %d with sound, %.1f%% idle\n", argv[0],
+	   frames, loud, total ? 100.0 * idle / total : 0.0);
+  return 0;
+}